@@ -36,19 +36,22 @@ Tensor& add_out(
     const Scalar& alpha,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   static constexpr const char op_name[] = "add.out";
@@ -253,19 +256,21 @@ Tensor& add_scalar_out(
     const Scalar& alpha,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
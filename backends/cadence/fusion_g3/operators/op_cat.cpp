@@ -46,18 +46,19 @@ Tensor& cat_out(
   int kTensorDimensionLimit = executorch::runtime::kTensorDimensionLimit;
 
 #ifdef OP_ARG_CHECK
+  if (!ctx.args_validated()) {
+    Tensor::SizesType expected_out_size[kTensorDimensionLimit];
+    size_t expected_out_dim = 0;
+    torch::executor::get_cat_out_target_size(
+        tensors, dim, expected_out_size, &expected_out_dim);
 
-  Tensor::SizesType expected_out_size[kTensorDimensionLimit];
-  size_t expected_out_dim = 0;
-  torch::executor::get_cat_out_target_size(
-      tensors, dim, expected_out_size, &expected_out_dim);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(
-          out, {expected_out_size, expected_out_dim}) == Error::Ok,
-      InvalidArgument,
-      out);
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(
+            out, {expected_out_size, expected_out_dim}) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
   // Special handling when all inputs are 1D-empty tensors for aten
   // consistency In that case, just return an 1D-empty tensor without checking
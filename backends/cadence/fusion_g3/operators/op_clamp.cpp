@@ -120,19 +120,21 @@ Tensor& clamp_out(
   }
 
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -350,20 +352,22 @@ Tensor& clamp_Tensor_out(
   const Tensor& max = has_max ? max_opt.value() : in;
 
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, min, max, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, min, max, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(in, min, max, out) ==
-          Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(in, min, max, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   static constexpr const char op_name[] = "clamp.Tensor_out";
@@ -55,19 +55,22 @@ Tensor& div_out(
     const Tensor& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
   // @lint-ignore CLANGTIDY facebook-hte-CArray
   static constexpr const char op_name[] = "div.out";
@@ -240,19 +243,22 @@ Tensor& div_out_mode(
       ctx, mode_val == "trunc" || mode_val == "floor", InvalidArgument, out);
 
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -456,19 +462,21 @@ Tensor& div_scalar_out(
     const Scalar& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   bool optimized = true;
@@ -565,19 +573,21 @@ Tensor& div_scalar_mode_out(
       ctx, mode_val == "trunc" || mode_val == "floor", InvalidArgument, out);
 
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
 
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   const bool mode_is_trunc = mode_val == "trunc";
@@ -28,25 +28,27 @@ namespace native {
 
 Tensor& exp_out(KernelRuntimeContext& ctx, const Tensor& in, Tensor& out) {
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensor_is_floating_type(out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensor_is_floating_type(out),
+        InvalidArgument,
+        out);
 
-  // Resize for dynamic shape
-  ET_KERNEL_CHECK_MSG(
-      ctx,
-      executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
-      InvalidArgument,
-      out,
-      "Failed to resize output tensor.");
+    // Resize for dynamic shape
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
+        InvalidArgument,
+        out,
+        "Failed to resize output tensor.");
 
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+  }
 #endif
 
   if ((in.scalar_type() == ScalarType::Float) &&
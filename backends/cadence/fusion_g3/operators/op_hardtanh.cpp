@@ -39,19 +39,21 @@ Tensor& hardtanh_out(
   (void)ctx;
 
 #ifdef OP_ARG_CHECK
-  // Resize for dynamic shape
-  ET_KERNEL_CHECK_MSG(
-      ctx,
-      executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
-      InvalidArgument,
-      out,
-      "Failed to resize output tensor.");
+  if (!ctx.args_validated()) {
+    // Resize for dynamic shape
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
+        InvalidArgument,
+        out,
+        "Failed to resize output tensor.");
 
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+  }
 #endif
 
   ScalarType in_type = in.scalar_type();
@@ -30,19 +30,22 @@ Tensor& lt_Tensor_out(
     const Tensor& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   int kTensorDimensionLimit = 5;
@@ -147,19 +150,21 @@ Tensor& lt_Scalar_out(
     const Scalar& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   bool optimized = true;
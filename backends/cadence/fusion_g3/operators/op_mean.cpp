@@ -70,24 +70,26 @@ Tensor& mean_out(
   (void)ctx;
 
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensor_is_default_dim_order(in),
-      InvalidArgument,
-      out);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_reduction_out(in, dim_list, keepdim, out) ==
-          Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensor_is_default_dim_order(in),
+        InvalidArgument,
+        out);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_reduction_out(in, dim_list, keepdim, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   constexpr int kNnlibMaxDim = 5;
@@ -34,19 +34,22 @@ Tensor& mul_out(
     const Tensor& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -227,16 +230,18 @@ Tensor& mul_scalar_out(
     const Scalar& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx, resize_tensor(out, a.sizes()) == Error::Ok, InvalidArgument, out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx, resize_tensor(out, a.sizes()) == Error::Ok, InvalidArgument, out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -124,62 +124,64 @@ std::tuple<Tensor&, Tensor&, Tensor&> native_layer_norm_out(
   std::tuple<Tensor&, Tensor&, Tensor&> ret_val(out, mean_out, rstd_out);
   int kTensorDimensionLimit = executorch::runtime::kTensorDimensionLimit;
 #ifdef OP_ARG_CHECK
+  if (!ctx.args_validated()) {
+    // Only support default dim order for now.
+    // TODO: Support other dim orders.
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensor_is_default_dim_order(input),
+        InvalidArgument,
+        ret_val);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(
+            input, out, mean_out, rstd_out),
+        InvalidArgument,
+        ret_val);
 
-  // Only support default dim order for now.
-  // TODO: Support other dim orders.
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensor_is_default_dim_order(input),
-      InvalidArgument,
-      ret_val);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(
-          input, out, mean_out, rstd_out),
-      InvalidArgument,
-      ret_val);
+    if (weight.has_value()) {
+      ET_KERNEL_CHECK(
+          ctx,
+          executorch::runtime::tensors_have_same_dim_order(
+              input, weight.value()),
+          InvalidArgument,
+          ret_val);
+    }
+
+    if (bias.has_value()) {
+      ET_KERNEL_CHECK(
+          ctx,
+          executorch::runtime::tensors_have_same_dim_order(input, bias.value()),
+          InvalidArgument,
+          ret_val);
+    }
+
+    Tensor::SizesType mean_rstd_sizes[kTensorDimensionLimit];
+    size_t mean_rstd_ndim = 0;
+    torch::executor::get_layer_norm_out_target_size(
+        input, normalized_shape, mean_rstd_sizes, &mean_rstd_ndim);
 
-  if (weight.has_value()) {
     ET_KERNEL_CHECK(
         ctx,
-        executorch::runtime::tensors_have_same_dim_order(input, weight.value()),
+        resize_tensor(out, input.sizes()) == Error::Ok,
         InvalidArgument,
         ret_val);
-  }
 
-  if (bias.has_value()) {
     ET_KERNEL_CHECK(
         ctx,
-        executorch::runtime::tensors_have_same_dim_order(input, bias.value()),
+        executorch::runtime::resize_tensor(
+            mean_out, {mean_rstd_sizes, mean_rstd_ndim}) == Error::Ok,
         InvalidArgument,
         ret_val);
-  }
 
-  Tensor::SizesType mean_rstd_sizes[kTensorDimensionLimit];
-  size_t mean_rstd_ndim = 0;
-  torch::executor::get_layer_norm_out_target_size(
-      input, normalized_shape, mean_rstd_sizes, &mean_rstd_ndim);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      resize_tensor(out, input.sizes()) == Error::Ok,
-      InvalidArgument,
-      ret_val);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(
-          mean_out, {mean_rstd_sizes, mean_rstd_ndim}) == Error::Ok,
-      InvalidArgument,
-      ret_val);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(
-          rstd_out, {mean_rstd_sizes, mean_rstd_ndim}) == Error::Ok,
-      InvalidArgument,
-      ret_val);
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(
+            rstd_out, {mean_rstd_sizes, mean_rstd_ndim}) == Error::Ok,
+        InvalidArgument,
+        ret_val);
+  }
 #endif
 
   bool optimized = true;
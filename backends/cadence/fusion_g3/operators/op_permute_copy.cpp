@@ -65,23 +65,25 @@ Tensor& permute_copy_out(
    * the checks only in operator level(As there are no checks in kernel).
    */
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
-
-  Tensor::SizesType expected_out_size[kTensorDimensionLimit];
-  size_t expected_out_dim = 0;
-  torch::executor::get_permute_copy_out_target_size(
-      in, dims, expected_out_size, &expected_out_dim);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(
-          out, {expected_out_size, expected_out_dim}) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+
+    Tensor::SizesType expected_out_size[kTensorDimensionLimit];
+    size_t expected_out_dim = 0;
+    torch::executor::get_permute_copy_out_target_size(
+        in, dims, expected_out_size, &expected_out_dim);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(
+            out, {expected_out_size, expected_out_dim}) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   const ArrayRef<Tensor::SizesType> in_size = in.sizes();
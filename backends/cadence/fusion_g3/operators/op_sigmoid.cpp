@@ -31,25 +31,27 @@ Tensor& sigmoid_out(KernelRuntimeContext& ctx, const Tensor& in, Tensor& out) {
   (void)ctx;
 
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensor_is_floating_type(out),
-      InvalidArgument,
-      out);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
-
-  // Resize for dynamic shape
-  ET_KERNEL_CHECK_MSG(
-      ctx,
-      executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
-      InvalidArgument,
-      out,
-      "Failed to resize output tensor.");
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensor_is_floating_type(out),
+        InvalidArgument,
+        out);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+
+    // Resize for dynamic shape
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        executorch::runtime::resize_tensor(out, in.sizes()) == Error::Ok,
+        InvalidArgument,
+        out,
+        "Failed to resize output tensor.");
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -58,23 +58,25 @@ Tensor& slice_copy_Tensor_out(
   int kTensorDimensionLimit = executorch::runtime::kTensorDimensionLimit;
 
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
-
-  // @lint-ignore CLANGTIDY facebook-hte-CArray
-  Tensor::SizesType target_sizes[kTensorDimensionLimit];
-  size_t target_ndim = 0;
-  torch::executor::get_slice_copy_out_target_size(
-      in, dim, length, target_sizes, &target_ndim);
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, {target_sizes, target_ndim}) ==
-          Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+
+    // @lint-ignore CLANGTIDY facebook-hte-CArray
+    Tensor::SizesType target_sizes[kTensorDimensionLimit];
+    size_t target_ndim = 0;
+    torch::executor::get_slice_copy_out_target_size(
+        in, dim, length, target_sizes, &target_ndim);
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, {target_sizes, target_ndim}) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   const ::executorch::aten::ArrayRef<Tensor::SizesType> in_size = in.sizes();
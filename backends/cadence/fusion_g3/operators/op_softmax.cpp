@@ -40,14 +40,16 @@ Tensor& _softmax_out(
   // Adjust for negative dim
   dim = dim < 0 ? dim + executorch::runtime::nonzero_dim(in) : dim;
 #ifdef OP_ARG_CHECK
-  ET_KERNEL_CHECK(
-      ctx, resize_tensor(out, in.sizes()) == Error::Ok, InvalidArgument, out);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    ET_KERNEL_CHECK(
+        ctx, resize_tensor(out, in.sizes()) == Error::Ok, InvalidArgument, out);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+  }
 #endif
 
   int inp_shapes[in.dim()];
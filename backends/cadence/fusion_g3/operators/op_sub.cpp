@@ -35,19 +35,22 @@ Tensor& sub_out(
     const Scalar& alpha,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, b, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, b, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -407,19 +410,21 @@ Tensor& sub_scalar_out(
     const Scalar& alpha,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(a, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(a, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(out, a.sizes()) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   // @lint-ignore CLANGTIDY facebook-hte-CArray
@@ -50,24 +50,26 @@ Tensor& transpose_copy_int_out(
   }
 
 #ifdef OP_ARG_CHECK
-  Tensor::SizesType expected_out_size[kTensorDimensionLimit];
-  size_t expected_out_dim = 0;
-  torch::executor::get_transpose_out_target_size(
-      in, dim0, dim1, expected_out_size, &expected_out_dim);
-
-  // Resize for dynamic shape
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::resize_tensor(
-          out, {expected_out_size, expected_out_dim}) == Error::Ok,
-      InvalidArgument,
-      out);
-
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(in, out),
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    Tensor::SizesType expected_out_size[kTensorDimensionLimit];
+    size_t expected_out_dim = 0;
+    torch::executor::get_transpose_out_target_size(
+        in, dim0, dim1, expected_out_size, &expected_out_dim);
+
+    // Resize for dynamic shape
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::resize_tensor(
+            out, {expected_out_size, expected_out_dim}) == Error::Ok,
+        InvalidArgument,
+        out);
+
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(in, out),
+        InvalidArgument,
+        out);
+  }
 #endif
 
   int inp_shape[kTensorDimensionLimit];
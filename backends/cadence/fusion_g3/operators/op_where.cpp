@@ -31,20 +31,22 @@ Tensor& where_self_out(
     const Tensor& b,
     Tensor& out) {
 #ifdef OP_ARG_CHECK
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx,
-      executorch::runtime::tensors_have_same_dim_order(cond, a, b, out),
-      InvalidArgument,
-      out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      torch::executor::resize_to_broadcast_target_size(a, b, cond, out) ==
-          Error::Ok,
-      InvalidArgument,
-      out);
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx,
+        executorch::runtime::tensors_have_same_dim_order(cond, a, b, out),
+        InvalidArgument,
+        out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        torch::executor::resize_to_broadcast_target_size(a, b, cond, out) ==
+            Error::Ok,
+        InvalidArgument,
+        out);
+  }
 #endif
 
   static constexpr const char op_name[] = "where.self_out";
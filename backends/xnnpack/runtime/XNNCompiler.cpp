@@ -1760,6 +1760,78 @@ DefineNodeFunc getDefineNodeFunc(fb_xnnpack::XNodeUnion nodeType) {
 }
 #undef _DEFINE
 
+#define _OPERATOR_NAME(name, prefixes) \
+  case fb_xnnpack::XNodeUnion::XNN##name: \
+    return prefixes;
+#define _BINARY_OPERATOR_NAME(name, prefix) \
+  _OPERATOR_NAME(name, "binaryelementwise|" prefix)
+#define _UNARY_OPERATOR_NAME(name, prefix) \
+  _OPERATOR_NAME(name, "unaryelementwise|" prefix)
+
+/*
+Returns the names of the XNNPACK operators that run a node of the given type,
+as '|'-separated prefixes of the lowercase operator name without spaces or
+punctuation, or nullptr if they are not known. Used to check that profiled
+operators line up with nodes.
+*/
+const char* getOperatorNamePrefixes(fb_xnnpack::XNodeUnion nodeType) {
+  switch (nodeType) {
+    // Binary ops
+    _BINARY_OPERATOR_NAME(Add, "add")
+    _BINARY_OPERATOR_NAME(Subtract, "subtract")
+    _BINARY_OPERATOR_NAME(Multiply, "multiply")
+    _BINARY_OPERATOR_NAME(Div, "divide")
+    _BINARY_OPERATOR_NAME(Minimum, "minimum")
+    _BINARY_OPERATOR_NAME(Maximum, "maximum")
+
+    // Unary ops
+    _UNARY_OPERATOR_NAME(SquareRoot, "squareroot")
+    _UNARY_OPERATOR_NAME(ReciprocalSquareRoot, "reciprocalsquareroot")
+    _UNARY_OPERATOR_NAME(Ceiling, "ceiling")
+    _UNARY_OPERATOR_NAME(Gelu, "gelu")
+    _UNARY_OPERATOR_NAME(Hardswish, "hardswish")
+    _UNARY_OPERATOR_NAME(Log, "log")
+    _UNARY_OPERATOR_NAME(Tanh, "tanh")
+    _UNARY_OPERATOR_NAME(Negate, "negate")
+    _UNARY_OPERATOR_NAME(Square, "square")
+    _UNARY_OPERATOR_NAME(Clamp, "clamp")
+    _UNARY_OPERATOR_NAME(LeakyReLU, "leakyrelu")
+    _UNARY_OPERATOR_NAME(ELU, "elu")
+    _UNARY_OPERATOR_NAME(Exp, "exp")
+    _UNARY_OPERATOR_NAME(Abs, "abs")
+    _UNARY_OPERATOR_NAME(Floor, "floor")
+    _UNARY_OPERATOR_NAME(Sigmoid, "sigmoid")
+    _OPERATOR_NAME(Softmax, "softmax")
+    _OPERATOR_NAME(PReLU, "prelu")
+
+    // Others
+    _OPERATOR_NAME(FullyConnected, "fullyconnected|dynamicfullyconnected")
+    _OPERATOR_NAME(StaticTranspose, "transpose")
+    _OPERATOR_NAME(Conv2d, "convolution")
+    _OPERATOR_NAME(ConvTranspose2d, "deconvolution")
+    _OPERATOR_NAME(StaticResizeBilinear2D, "resizebilinear")
+    _OPERATOR_NAME(StaticConstantPad, "constantpad")
+    _OPERATOR_NAME(AvgPooling2d, "averagepooling")
+    _OPERATOR_NAME(DepthwiseConv2d, "convolution")
+    _OPERATOR_NAME(MaxPooling2d, "maxpooling")
+    _OPERATOR_NAME(Convert, "convert")
+    _OPERATOR_NAME(GlobalAvgPooling2d, "globalaveragepooling|mean")
+    _OPERATOR_NAME(StaticReshape, "copy")
+    _OPERATOR_NAME(ArgMaxPooling2d, "argmaxpooling")
+    _OPERATOR_NAME(Concatenate2, "concatenate|copy")
+    _OPERATOR_NAME(Concatenate3, "concatenate|copy")
+    _OPERATOR_NAME(Concatenate4, "concatenate|copy")
+    _OPERATOR_NAME(Concatenate5, "concatenate|copy")
+    _OPERATOR_NAME(StaticSlice, "slice")
+    _OPERATOR_NAME(BatchMatrixMultiply, "batchmatrixmultiply")
+    default:
+      return nullptr;
+  }
+}
+#undef _UNARY_OPERATOR_NAME
+#undef _BINARY_OPERATOR_NAME
+#undef _OPERATOR_NAME
+
 /*
 Builds the xnnpack runtime object using the buffer pointer. The buffer pointer
 must be a valid pointer to the serialized xnnpack object. It also fills the
@@ -1862,12 +1934,21 @@ ET_NODISCARD Error XNNCompiler::compileModel(
     }
   }
 
+  // Debug handles and operator names of the nodes, to attribute profiling
+  // events
+  std::vector<uint32_t> node_debug_handles;
+  std::vector<const char*> node_operator_names;
+  node_debug_handles.reserve(flatbuffer_graph->xnodes()->size());
+  node_operator_names.reserve(flatbuffer_graph->xnodes()->size());
   for (auto node : *flatbuffer_graph->xnodes()) {
     err = getDefineNodeFunc(node->xnode_union_type())(
         subgraph.get(), remapped_ids, node, flatbuffer_graph);
     if (err != Error::Ok) {
       return err;
     }
+    node_debug_handles.push_back(node->debug_handle());
+    node_operator_names.push_back(
+        getOperatorNamePrefixes(node->xnode_union_type()));
   }
   uint32_t runtime_flags = 0;
 
@@ -1934,7 +2015,9 @@ ET_NODISCARD Error XNNCompiler::compileModel(
       runtime_ptr,
       std::move(input_ids),
       std::move(output_ids),
-      std::move(packed_weights_names.get()));
+      std::move(packed_weights_names.get()),
+      node_debug_handles,
+      node_operator_names);
 
   return err;
 };
@@ -8,6 +8,8 @@
 
 #include <executorch/backends/xnnpack/runtime/XNNExecutor.h>
 
+#include <algorithm>
+
 namespace executorch {
 namespace backends {
 namespace xnnpack {
@@ -31,11 +33,14 @@ ET_NODISCARD Error XNNExecutor::initialize(
     xnn_runtime_t runtime,
     std::vector<uint32_t>&& input_ids,
     std::vector<uint32_t>&& output_ids,
-    std::vector<std::string>&& packed_data_names) {
+    std::vector<std::string>&& packed_data_names,
+    const std::vector<uint32_t>& node_debug_handles,
+    const std::vector<const char*>& node_operator_names) {
   runtime_ = std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)>(
       runtime, xnn_delete_runtime);
 
-  auto error = profiler_.initialize(runtime);
+  auto error = profiler_.initialize(
+      runtime, node_debug_handles, node_operator_names);
   if (error != Error::Ok) {
     ET_LOG(
         Error,
@@ -52,6 +57,20 @@ ET_NODISCARD Error XNNExecutor::initialize(
   std::sort(output_ids_.begin(), output_ids_.end());
 
   externals_.resize(input_ids_.size() + output_ids_.size());
+  for (uint32_t i = 0; i < externals_.size(); ++i) {
+    if (i < input_ids_.size()) {
+      externals_[i].id = input_ids_[i];
+    } else {
+      externals_[i].id = output_ids_[i - input_ids_.size()];
+    }
+    externals_[i].data = nullptr;
+  }
+  bound_shapes_.resize(input_ids_.size());
+  bound_data_.assign(externals_.size(), nullptr);
+  needs_reshape_ = true;
+  needs_setup_ = true;
+  num_reshapes_ = 0;
+  num_setups_ = 0;
   packed_data_names_ = std::move(packed_data_names);
 
   return Error::Ok;
@@ -68,6 +87,10 @@ ET_NODISCARD Error XNNExecutor::initialize(
  * Note: the external ids given to the external tensors in the XNNPACK
  * runtime correspond to their index in the list of arg passed into
  * delegate->execute()
+ *
+ * Inputs whose shape is unchanged since the last call are not reshaped, and
+ * the runtime is not reshaped at all if no input shape changed. The first
+ * call always reshapes the runtime, even if the delegate has no inputs.
  */
 ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
   ET_CHECK_OR_RETURN_ERROR(
@@ -78,11 +101,6 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
   // Create xnn_externals_value from evalue args
   xnn_status status;
   for (uint32_t i = 0; i < externals_.size(); ++i) {
-    if (i < input_ids_.size()) {
-      externals_[i].id = input_ids_[i];
-    } else {
-      externals_[i].id = output_ids_[i - input_ids_.size()];
-    }
     uint32_t ext_id = externals_[i].id;
 
     ET_CHECK_OR_RETURN_ERROR(
@@ -94,6 +112,9 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
 
     Tensor* tensor = &args[ext_id]->toTensor();
     externals_[i].data = tensor->mutable_data_ptr<float>();
+    if (externals_[i].data != bound_data_[i]) {
+      needs_setup_ = true;
+    }
 
     executorch::aten::DimOrderType dim_order[kTensorDimensionLimit];
 
@@ -117,6 +138,14 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
       for (int j = 0; j < num_dims; ++j) {
         dims[j] = tensor->size(static_cast<int>(dim_order[j]));
       }
+      BoundShape& bound = bound_shapes_[i];
+      if (bound.num_dims == num_dims &&
+          std::equal(dims, dims + num_dims, bound.dims)) {
+        continue;
+      }
+      // Forget the old shape first, so that a failure below leaves the input
+      // to be reshaped on the next call.
+      bound.num_dims = SIZE_MAX;
       status =
           xnn_reshape_external_value(runtime_.get(), ext_id, num_dims, dims);
       ET_CHECK_OR_RETURN_ERROR(
@@ -124,16 +153,31 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
           Internal,
           "Internal Error: Reshape Input Tensor Failed with code: %s",
           xnn_status_to_string(status));
+      bound.num_dims = num_dims;
+      std::copy(dims, dims + num_dims, bound.dims);
+      needs_reshape_ = true;
     }
   }
+  if (!needs_reshape_) {
+    return Error::Ok;
+  }
+
   // // Propagate Input Shape and Memory Plan for increased allocation
+  needs_setup_ = true;
   status = xnn_reshape_runtime(runtime_.get());
+  ++num_reshapes_;
 
+  if (status != xnn_status_success) {
+    for (BoundShape& bound : bound_shapes_) {
+      bound.num_dims = SIZE_MAX;
+    }
+  }
   ET_CHECK_OR_RETURN_ERROR(
       status == xnn_status_success,
       Internal,
       "Internal Error: Propagating input shapes failed with code: %s",
       xnn_status_to_string(status));
+  needs_reshape_ = false;
 
   return Error::Ok;
 }
@@ -141,8 +185,9 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
 /**
  * Runs the XNNPACK Runtime.
  *
- * We first setup the runtime by feeding the externals_ to runtime setup.
- * After which we then execute the runtime through invoke_runtime.
+ * We first setup the runtime by feeding the externals_ to runtime setup,
+ * unless nothing changed since the last setup. After which we then execute
+ * the runtime through invoke_runtime.
  */
 ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
   ET_CHECK_OR_RETURN_ERROR(
@@ -150,14 +195,26 @@ ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
       Internal,
       "XNNPACK Delegate did not compile correctly");
 
-  xnn_status status = xnn_setup_runtime_v2(
-      runtime_.get(), externals_.size(), externals_.data());
+  xnn_status status;
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+  // Another runtime may have moved the shared workspace since the last setup.
+  needs_setup_ = true;
+#endif
+  if (needs_setup_) {
+    status = xnn_setup_runtime_v2(
+        runtime_.get(), externals_.size(), externals_.data());
+    ++num_setups_;
 
-  ET_CHECK_OR_RETURN_ERROR(
-      status == xnn_status_success,
-      Internal,
-      "Internal Error: Setting up the runtime failed with code: %s",
-      xnn_status_to_string(status));
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Setting up the runtime failed with code: %s",
+        xnn_status_to_string(status));
+    for (size_t i = 0; i < externals_.size(); ++i) {
+      bound_data_[i] = externals_[i].data;
+    }
+    needs_setup_ = false;
+  }
 
   auto error = profiler_.start(context.event_tracer());
   if (error != Error::Ok) {
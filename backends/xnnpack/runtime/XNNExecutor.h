@@ -15,6 +15,7 @@
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
 
 #include <xnnpack.h>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <vector>
@@ -36,6 +37,26 @@ class XNNExecutor {
   std::vector<xnn_external_value> externals_;
   std::vector<std::string> packed_data_names_;
 
+  // Shape of an input as of the last successful xnn_reshape_runtime().
+  struct BoundShape {
+    size_t num_dims = SIZE_MAX;
+    size_t dims[XNN_MAX_TENSOR_DIMS];
+  };
+  std::vector<BoundShape> bound_shapes_;
+  // Data pointers of the externals as of the last successful
+  // xnn_setup_runtime_v2().
+  std::vector<void*> bound_data_;
+  // Whether the runtime must be reshaped, even if no input shape changed.
+  bool needs_reshape_ = true;
+  // Whether the runtime must be set up again before it is invoked.
+  bool needs_setup_ = true;
+  // Number of xnn_reshape_runtime() and xnn_setup_runtime_v2() calls.
+  size_t num_reshapes_ = 0;
+  size_t num_setups_ = 0;
+  // Index of the workspace this executor's runtime was created with, when
+  // workspaces are shared.
+  size_t workspace_slot_ = 0;
+
  public:
   XNNExecutor() = default;
 
@@ -51,22 +72,51 @@ class XNNExecutor {
     return packed_data_names_;
   }
 
+  inline size_t get_workspace_slot() const {
+    return workspace_slot_;
+  }
+
+  inline void set_workspace_slot(size_t slot) {
+    workspace_slot_ = slot;
+  }
+
+  /**
+   * Returns how many times the runtime has been reshaped, and set up, since
+   * initialize().
+   */
+  inline size_t get_num_reshapes() const {
+    return num_reshapes_;
+  }
+
+  inline size_t get_num_setups() const {
+    return num_setups_;
+  }
+
   /**
    * Initialize the XNNExecutor with a given runtime and input/output ids.
    * The input/output ids are expected to be sorted in order of their
-   * flatbuffer id_outs
+   * flatbuffer id_outs. node_debug_handles and node_operator_names describe
+   * the subgraph's nodes in definition order, and are used to attribute
+   * profiling events; see XNNProfiler::initialize().
    */
   ET_NODISCARD executorch::runtime::Error initialize(
       xnn_runtime_t runtime,
       std::vector<uint32_t>&& input_ids,
       std::vector<uint32_t>&& output_ids,
-      std::vector<std::string>&& packed_data_names);
+      std::vector<std::string>&& packed_data_names,
+      const std::vector<uint32_t>& node_debug_handles = {},
+      const std::vector<const char*>& node_operator_names = {});
 
   /**
    * Prepares the arguments for runtime graph execution.
    * args is an array of EValues that will be passed into the runtime.
    * input shapes will be propagated through the runtime, and perform
-   * any additional memory planning as needed
+   * any additional memory planning as needed.
+   *
+   * Shapes are only propagated on the first call or if an input shape
+   * changed since the last call, and the runtime is only set up again in
+   * forward() if a shape or a data pointer changed, so executing repeatedly
+   * with the same buffers costs no setup.
    */
   ET_NODISCARD executorch::runtime::Error prepare_args(
       executorch::runtime::EValue** args);
@@ -77,6 +127,14 @@ class XNNExecutor {
   ET_NODISCARD executorch::runtime::Error forward(
       executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext& context);
 
+  /**
+   * Logs the average time of each operator over all runs. Only logs when
+   * ENABLE_XNNPACK_PROFILING is defined.
+   */
+  inline void print_avg_op_timings() const {
+    profiler_.log_avg_op_timings();
+  }
+
   /**
    * Prepares the outputs to be returned by the delegate
    *
@@ -13,11 +13,26 @@
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/executor/pte_data_map.h>
 
+#include <array>
+#include <cstring>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <variant>
 
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 
+// Number of workspaces shared by delegate instances when
+// ENABLE_XNNPACK_SHARED_WORKSPACE is defined. Instances that use different
+// workspaces can execute concurrently.
+#ifndef XNNPACK_WORKSPACE_POOL_SIZE
+#define XNNPACK_WORKSPACE_POOL_SIZE 1
+#endif
+static_assert(
+    XNNPACK_WORKSPACE_POOL_SIZE >= 1,
+    "XNNPACK_WORKSPACE_POOL_SIZE must be at least 1");
+
 namespace executorch {
 namespace backends {
 
@@ -25,14 +40,18 @@ using executorch::backends::xnnpack::delegate::XNNWeightsCache;
 using executorch::ET_RUNTIME_NAMESPACE::Backend;
 using executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext;
 using executorch::ET_RUNTIME_NAMESPACE::BackendInitContext;
+using executorch::ET_RUNTIME_NAMESPACE::BackendOptionContext;
 using executorch::ET_RUNTIME_NAMESPACE::CompileSpec;
 using executorch::ET_RUNTIME_NAMESPACE::DelegateHandle;
 using executorch::ET_RUNTIME_NAMESPACE::NamedDataMap;
 using executorch::runtime::ArrayRef;
+using executorch::runtime::BackendOption;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
 using executorch::runtime::FreeableBuffer;
+using executorch::runtime::kMaxOptionValueLength;
 using executorch::runtime::Result;
+using executorch::runtime::Span;
 
 class XnnpackBackend final
     : public ::executorch::ET_RUNTIME_NAMESPACE::BackendInterface {
@@ -51,21 +70,22 @@ class XnnpackBackend final
     }
 
 #ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    // Create a workspace for the XNNExecutor to use. This workspace will be
-    // shared across all delegate instances.
-    ET_LOG(Debug, "Creating XNN workspace");
-    xnn_workspace_t workspace = nullptr;
-    status = xnn_create_workspace(&workspace);
-    if (status != xnn_status_success) {
-      ET_LOG(
-          Error,
-          "Failed to create XNN workspace, XNNPACK status: 0x%x",
-          (unsigned int)status);
-      workspace = nullptr;
-      return;
+    // Create the workspaces for the XNNExecutors to use. Each workspace is
+    // shared by the delegate instances assigned to it.
+    for (WorkspaceSlot& slot : workspaces_) {
+      ET_LOG(Debug, "Creating XNN workspace");
+      xnn_workspace_t workspace = nullptr;
+      status = xnn_create_workspace(&workspace);
+      if (status != xnn_status_success) {
+        ET_LOG(
+            Error,
+            "Failed to create XNN workspace, XNNPACK status: 0x%x",
+            (unsigned int)status);
+        return;
+      }
+      slot.workspace.reset(workspace);
+      ET_LOG(Debug, "Created XNN workspace: %p", workspace);
     }
-    workspace_.reset(workspace);
-    ET_LOG(Debug, "Created XNN workspace: %p", workspace_.get());
 #endif // ENABLE_XNNPACK_SHARED_WORKSPACE
   }
 
@@ -84,14 +104,20 @@ class XnnpackBackend final
     }
 
     const NamedDataMap* named_data_map = context.get_named_data_map();
-    // thread safe. This can heppen when multiple threads call init() on
-    // the same backend instance.
+    xnn_workspace_t workspace = nullptr;
+    // This is needed to serialize access to xnn_create_runtime, which is not
+    // thread safe with respect to the workspace it is given. This can happen
+    // when multiple threads call init() on the same backend instance.
 #ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
+    const size_t workspace_slot = acquire_workspace_slot();
+    WorkspaceSlot& slot = workspaces_[workspace_slot];
+    const std::lock_guard<std::mutex> lock(slot.mutex);
+    workspace = slot.workspace.get();
 #endif
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-    const std::lock_guard<std::mutex> lock_weight_cache(weights_cache_mutex_);
+    const std::lock_guard<std::shared_mutex> lock_weight_cache(
+        weights_cache_mutex_);
     weights_cache_->initialize_for_runtime(
         context.get_runtime_allocator(), named_data_map);
 #endif
@@ -101,12 +127,15 @@ class XnnpackBackend final
     // new and since this type is not trivially destructible, we must call the
     // destructor manually in destroy().
     new (executor) xnnpack::delegate::XNNExecutor;
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+    executor->set_workspace_slot(workspace_slot);
+#endif
     Error err = xnnpack::delegate::XNNCompiler::compileModel(
         processed->data(),
         processed->size(),
         executor,
         weights_cache_.get(),
-        workspace_.get(),
+        workspace,
         named_data_map);
     // This backend does not need its processed data after compiling the model.
     processed->Free();
@@ -115,6 +144,9 @@ class XnnpackBackend final
       // destroy() won't be called on this handle, so we need to clean it up
       // now.
       executor->~XNNExecutor();
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+      release_workspace_slot(workspace_slot);
+#endif
 
       ET_LOG(
           Error, "XNNCompiler::compileModel failed: 0x%x", (unsigned int)err);
@@ -129,12 +161,17 @@ class XnnpackBackend final
       EValue** args) const override {
     auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
 
+    // Only executors that share this executor's workspace are serialized.
 #ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
+    const std::lock_guard<std::mutex> lock(
+        workspaces_[executor->get_workspace_slot()].mutex);
 #endif
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-    const std::lock_guard<std::mutex> lock_weights_cache(weights_cache_mutex_);
+    // Reshape and setup look packed weights up in the cache, which init()
+    // and destroy() modify. Executions only read it, so they share the lock.
+    const std::shared_lock<std::shared_mutex> lock_weights_cache(
+        weights_cache_mutex_);
 #endif
 
     // Prepare Inputs/Outputs and Propagate Input Shapes
@@ -155,47 +192,126 @@ class XnnpackBackend final
     return err;
   }
 
+  /**
+   * Supported options:
+   * - "weights_cache_dir" (string): Directory in which to persist packed
+   *   weights across processes. See
+   *   XNNWeightsCache::enable_persistent_cache(). Requires
+   *   ENABLE_XNNPACK_WEIGHTS_CACHE, and only affects delegates initialized
+   *   afterwards.
+   * - "weights_cache_max_mb" (int): Size limit of that directory in MiB.
+   *   Zero, the default, means no limit.
+   */
+  Error set_option(
+      ET_UNUSED BackendOptionContext& context,
+      const Span<BackendOption>& backend_options) override {
+    const char* cache_dir = nullptr;
+    int cache_max_mb = 0;
+    for (const BackendOption& option : backend_options) {
+      using StringValue = std::array<char, kMaxOptionValueLength>;
+      if (std::strcmp(option.key, "weights_cache_dir") == 0 &&
+          std::holds_alternative<StringValue>(option.value)) {
+        cache_dir = std::get<StringValue>(option.value).data();
+      } else if (
+          std::strcmp(option.key, "weights_cache_max_mb") == 0 &&
+          std::holds_alternative<int>(option.value) &&
+          std::get<int>(option.value) >= 0) {
+        cache_max_mb = std::get<int>(option.value);
+      } else {
+        ET_LOG(Error, "Invalid XNNPACK backend option %s", option.key);
+        return Error::InvalidArgument;
+      }
+    }
+    if (cache_dir == nullptr) {
+      return Error::Ok;
+    }
+#ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
+    const std::lock_guard<std::shared_mutex> lock_weights_cache(
+        weights_cache_mutex_);
+    return weights_cache_->enable_persistent_cache(
+        cache_dir, static_cast<size_t>(cache_max_mb) << 20);
+#else
+    ET_LOG(
+        Error,
+        "weights_cache_dir requires the XNNPACK weights cache to be enabled");
+    return Error::NotSupported;
+#endif
+  }
+
   void destroy(DelegateHandle* handle) const override {
     if (handle != nullptr) {
+      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
+
       // This is needed to serialize access to xnn_delete_runtime which is not
       // thread safe. This can heppen when multiple threads call destroy() on
       // the same backend instance.
 #ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-      const std::lock_guard<std::mutex> lock(workspace_mutex_);
+      const size_t workspace_slot = executor->get_workspace_slot();
+      const std::lock_guard<std::mutex> lock(
+          workspaces_[workspace_slot].mutex);
 #endif
 
-      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
-
 #ifdef ENABLE_XNNPACK_PROFILING
       executor->print_avg_op_timings();
 #endif
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-      const std::lock_guard<std::mutex> lock_weights_cache(
+      const std::lock_guard<std::shared_mutex> lock_weights_cache(
           weights_cache_mutex_);
       weights_cache_->delete_packed_data(executor->get_packed_data_names());
 #endif
       // XNNExecutor is not trivially destructible. Since this was constructed
       // manually in init(), we must destroy it manually here.
       executor->~XNNExecutor();
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+      release_workspace_slot(workspace_slot);
+#endif
     }
   }
 
  private:
-  // This is a global workspace for all delegate instances.
-  mutable std::mutex workspace_mutex_;
-  std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)> workspace_{
-      nullptr,
-      &xnn_release_workspace};
-
-  // Weights cache is global to all delegate instances.
-  mutable std::mutex weights_cache_mutex_;
+  struct WorkspaceSlot {
+    std::mutex mutex;
+    std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)>
+        workspace{nullptr, &xnn_release_workspace};
+    /// Number of live delegate instances using this workspace. Guarded by
+    /// workspace_slots_mutex_.
+    size_t num_executors = 0;
+  };
+
+  /// Assigns a new delegate instance to the least used workspace.
+  size_t acquire_workspace_slot() const {
+    const std::lock_guard<std::mutex> lock(workspace_slots_mutex_);
+    size_t best = 0;
+    for (size_t i = 1; i < workspaces_.size(); ++i) {
+      if (workspaces_[i].num_executors < workspaces_[best].num_executors) {
+        best = i;
+      }
+    }
+    ++workspaces_[best].num_executors;
+    return best;
+  }
+
+  void release_workspace_slot(size_t slot) const {
+    const std::lock_guard<std::mutex> lock(workspace_slots_mutex_);
+    --workspaces_[slot].num_executors;
+  }
+
+  // Workspaces shared by the delegate instances; each instance uses one for
+  // its whole lifetime, since XNNPACK binds a runtime to its workspace.
+  mutable std::array<WorkspaceSlot, XNNPACK_WORKSPACE_POOL_SIZE> workspaces_;
+  mutable std::mutex workspace_slots_mutex_;
+
+  // Weights cache is global to all delegate instances. Held exclusively to
+  // modify the cache, and shared by executions.
+  mutable std::shared_mutex weights_cache_mutex_;
   std::unique_ptr<XNNWeightsCache> weights_cache_ =
       std::make_unique<XNNWeightsCache>();
 
   // Lock Hiearchy for Mutexes:
-  // workspace_mutex_
+  // WorkspaceSlot::mutex
   // weights_cache_mutex_
+  // workspace_slots_mutex_
 };
 
 namespace {
@@ -7,13 +7,33 @@
  */
 
 #include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/runtime/core/content_hash.h>
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/memory_allocator.h>
 #include <sys/stat.h>
 #include <xnnpack.h>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 
+#ifndef _WIN32
+#include <cpuinfo.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Identifies the XNNPACK build that packed the weights in the persistent
+// cache. Entries packed by a different XNNPACK may have a different layout,
+// so the build should define this to the XNNPACK revision it uses.
+#ifndef XNNPACK_COMMIT
+#define XNNPACK_COMMIT "unknown"
+#endif
+
 namespace executorch {
 namespace backends {
 namespace xnnpack {
@@ -21,6 +41,99 @@ namespace delegate {
 
 using executorch::ET_RUNTIME_NAMESPACE::NamedDataMap;
 using executorch::runtime::MemoryAllocator;
+using executorch::runtime::internal::hash_bytes;
+using executorch::runtime::internal::hash_combine;
+
+namespace {
+
+constexpr char kPersistentEntryMagic[8] =
+    {'X', 'N', 'N', 'W', 'C', 'A', 'C', 'H'};
+constexpr const char* kPersistentEntrySuffix = ".xnnw";
+// Seeds the hash that checks an entry's unpacked data, so that it is
+// independent of the hash in the entry's key.
+constexpr uint64_t kUnpackedCheckSeed = 0x5851f42d4c957f2dULL;
+
+/**
+ * Header of a persistent cache entry. The packed data follows it, and the
+ * header's size keeps the data aligned for XNNPACK in the mapped file.
+ */
+struct alignas(XNNWeightsCache::kPackedAllocationAlignment)
+    PersistentEntryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t packed_size;
+  uint64_t packed_hash;
+  uint64_t unpacked_size;
+  uint64_t unpacked_check;
+};
+
+#ifndef _WIN32
+/**
+ * Identifies the XNNPACK build and the ISA extensions that select its
+ * kernels, and so the layout of the weights it packs.
+ */
+uint64_t packing_signature() {
+  uint64_t features = 0;
+  int bit = 0;
+  auto add = [&](bool has_feature) {
+    features |= static_cast<uint64_t>(has_feature) << bit++;
+  };
+  if (cpuinfo_initialize()) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+    add(cpuinfo_has_x86_sse4_1());
+    add(cpuinfo_has_x86_avx());
+    add(cpuinfo_has_x86_f16c());
+    add(cpuinfo_has_x86_fma3());
+    add(cpuinfo_has_x86_avx2());
+    add(cpuinfo_has_x86_avx512f());
+    add(cpuinfo_has_x86_avx512bw());
+    add(cpuinfo_has_x86_avx512vl());
+    add(cpuinfo_has_x86_avx512vnni());
+#elif CPUINFO_ARCH_ARM || CPUINFO_ARCH_ARM64
+    add(cpuinfo_has_arm_neon());
+    add(cpuinfo_has_arm_neon_fp16_arith());
+    add(cpuinfo_has_arm_neon_dot());
+    add(cpuinfo_has_arm_i8mm());
+    add(cpuinfo_has_arm_sve());
+    add(cpuinfo_has_arm_sve2());
+#endif
+  }
+#ifdef ENABLE_XNNPACK_KLEIDI
+  add(true);
+#endif
+  uint64_t signature = hash_bytes(XNNPACK_COMMIT, std::strlen(XNNPACK_COMMIT));
+  signature = hash_combine(signature, features);
+  signature = hash_combine(signature, sizeof(void*));
+  return hash_combine(signature, XNNWeightsCache::kPersistentCacheVersion);
+}
+
+std::string persistent_entry_path(const std::string& directory, uint64_t key) {
+  char name[32];
+  snprintf(
+      name, sizeof(name), "%016" PRIx64 "%s", key, kPersistentEntrySuffix);
+  return directory + "/" + name;
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd, bytes, size);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+#endif // !_WIN32
+
+} // namespace
 
 XNNWeightsCache::XNNWeightsCache() {
   weights_cache_.context = this;
@@ -38,6 +151,61 @@ XNNWeightsCache::XNNWeightsCache() {
       (enum xnn_status(*)(void*))XNNWeightsCache::delete_cache;
 }
 
+XNNWeightsCache::~XNNWeightsCache() {
+#ifndef _WIN32
+  for (auto& entry : packed_pointer_to_mapping_) {
+    ::munmap(entry.second.base, entry.second.size);
+  }
+#endif
+}
+
+Error XNNWeightsCache::enable_persistent_cache(
+    const std::string& directory,
+    size_t max_bytes) {
+#ifdef _WIN32
+  (void)directory;
+  (void)max_bytes;
+  ET_LOG(Error, "The persistent weights cache is not supported on Windows");
+  return Error::NotSupported;
+#else
+  // Without the XNNPACK revision, entries packed by another XNNPACK build
+  // could be loaded with the wrong layout, so refuse to use the cache.
+  ET_CHECK_OR_RETURN_ERROR(
+      std::strcmp(XNNPACK_COMMIT, "unknown") != 0,
+      NotSupported,
+      "The persistent weights cache needs XNNPACK_COMMIT to be defined");
+  DIR* dir = ::opendir(directory.c_str());
+  if (dir == nullptr) {
+    ET_LOG(
+        Error,
+        "Failed to open weights cache directory %s: %s",
+        directory.c_str(),
+        strerror(errno));
+    return Error::AccessFailed;
+  }
+  // Count the existing entries against the size limit.
+  size_t total_bytes = 0;
+  const size_t suffix_length = std::strlen(kPersistentEntrySuffix);
+  while (struct dirent* entry = ::readdir(dir)) {
+    const size_t length = std::strlen(entry->d_name);
+    struct stat st;
+    if (length > suffix_length &&
+        std::strcmp(
+            entry->d_name + length - suffix_length, kPersistentEntrySuffix) ==
+            0 &&
+        ::fstatat(::dirfd(dir), entry->d_name, &st, 0) == 0) {
+      total_bytes += st.st_size;
+    }
+  }
+  ::closedir(dir);
+
+  persistent_cache_dir_ = directory;
+  persistent_cache_max_bytes_ = max_bytes;
+  persistent_cache_bytes_ = total_bytes;
+  return Error::Ok;
+#endif
+}
+
 Error XNNWeightsCache::initialize_for_runtime(
     MemoryAllocator* runtime_allocator,
     const NamedDataMap* named_data_map) {
@@ -58,6 +226,7 @@ Result<std::vector<std::string>> XNNWeightsCache::finalize_for_runtime() {
   }
   unpacked_data_.clear();
   unpacked_data_to_name_.clear();
+  unpacked_data_to_fingerprint_.clear();
 
   std::vector<std::string> packed_data_names;
   // update the reference count of all the packed data
@@ -82,6 +251,13 @@ Result<const uint8_t*> XNNWeightsCache::load_unpacked_data(
   }
   const uint8_t* data_pointer =
       static_cast<const uint8_t*>(named_data.get().data());
+  if (!persistent_cache_dir_.empty()) {
+    const size_t size = named_data.get().size();
+    unpacked_data_to_fingerprint_[data_pointer] = {
+        .hash = hash_bytes(data_pointer, size),
+        .check = hash_bytes(data_pointer, size, kUnpackedCheckSeed),
+        .size = size};
+  }
   unpacked_data_.push_back(std::move(named_data.get()));
   unpacked_data_to_name_[data_pointer] = name;
 
@@ -111,6 +287,13 @@ Error XNNWeightsCache::delete_packed_data(
         // Erase the key/value from the map frees the pointer holding the packed
         // data
         packed_pointer_to_container_.erase(packed_data_ptr);
+#ifndef _WIN32
+        auto mapping = packed_pointer_to_mapping_.find(packed_data_ptr);
+        if (mapping != packed_pointer_to_mapping_.end()) {
+          ::munmap(mapping->second.base, mapping->second.size);
+          packed_pointer_to_mapping_.erase(mapping);
+        }
+#endif
         // remove the pointer from the packed_data_ptrs_
         packed_data_ptrs_[entry->second.offset] = nullptr;
         // Erase the name to packed metadata entry
@@ -148,7 +331,20 @@ size_t XNNWeightsCache::look_up(
   auto packed_weight_entry =
       context->name_to_packed_data_metadata_.find(weight_bias_name);
   if (packed_weight_entry == context->name_to_packed_data_metadata_.end()) {
-    return SIZE_MAX;
+    // Otherwise check if it was packed by an earlier process
+    PersistentKey key;
+    if (!context->persistent_cache_key(cache_key, &key)) {
+      return SIZE_MAX;
+    }
+    void* packed_ptr = context->map_persistent_entry(key);
+    if (packed_ptr == nullptr) {
+      return SIZE_MAX;
+    }
+    size_t offset = context->packed_data_ptrs_.size();
+    context->packed_data_ptrs_.push_back(packed_ptr);
+    context->name_to_packed_data_metadata_[weight_bias_name] = {
+        .offset = offset, .ref_count = 0, .in_current_runtime = true};
+    return offset;
   }
   packed_weight_entry->second.in_current_runtime = true;
 
@@ -208,6 +404,11 @@ size_t XNNWeightsCache::look_up_or_insert(
         .in_current_runtime = true};
     context->name_to_packed_data_metadata_[weight_bias_name] =
         packed_data_metadata;
+
+    PersistentKey key;
+    if (context->persistent_cache_key(cache_key, &key)) {
+      context->write_persistent_entry(key, ptr, size);
+    }
   } else {
     ET_LOG(
         Info,
@@ -231,6 +432,131 @@ enum xnn_status XNNWeightsCache::delete_cache(XNNWeightsCache* context) {
   return xnn_status_success;
 }
 
+bool XNNWeightsCache::persistent_cache_key(
+    const xnn_weights_cache_look_up_key* cache_key,
+    PersistentKey* key) const {
+  if (persistent_cache_dir_.empty()) {
+    return false;
+  }
+  auto weight = unpacked_data_to_fingerprint_.find(cache_key->kernel);
+  if (weight == unpacked_data_to_fingerprint_.end()) {
+    return false;
+  }
+  static const uint64_t signature = packing_signature();
+  uint64_t hash = hash_combine(signature, cache_key->seed);
+  hash = hash_combine(hash, weight->second.hash);
+  uint64_t check = hash_combine(kUnpackedCheckSeed, weight->second.check);
+  uint64_t size = weight->second.size;
+  if (cache_key->bias != nullptr) {
+    auto bias = unpacked_data_to_fingerprint_.find(cache_key->bias);
+    if (bias == unpacked_data_to_fingerprint_.end()) {
+      return false;
+    }
+    hash = hash_combine(hash, bias->second.hash);
+    check = hash_combine(check, bias->second.check);
+    size += bias->second.size;
+  }
+  *key = {.key = hash, .unpacked_size = size, .unpacked_check = check};
+  return true;
+}
+
+void* XNNWeightsCache::map_persistent_entry(const PersistentKey& key) {
+#ifdef _WIN32
+  (void)key;
+  return nullptr;
+#else
+  const std::string path =
+      persistent_entry_path(persistent_cache_dir_, key.key);
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(PersistentEntryHeader)) {
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = st.st_size;
+  void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return nullptr;
+  }
+
+  PersistentEntryHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  uint8_t* packed_ptr = static_cast<uint8_t*>(base) + sizeof(header);
+  if (std::memcmp(header.magic, kPersistentEntryMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != kPersistentCacheVersion || header.key != key.key ||
+      header.unpacked_size != key.unpacked_size ||
+      header.unpacked_check != key.unpacked_check ||
+      header.packed_size != size - sizeof(header) ||
+      header.packed_hash != hash_bytes(packed_ptr, header.packed_size)) {
+    ET_LOG(Info, "Ignoring invalid weights cache entry %s", path.c_str());
+    ::munmap(base, size);
+    return nullptr;
+  }
+  packed_pointer_to_mapping_[packed_ptr] = {base, size};
+  return packed_ptr;
+#endif
+}
+
+void XNNWeightsCache::write_persistent_entry(
+    const PersistentKey& key,
+    const void* ptr,
+    size_t size) {
+#ifdef _WIN32
+  (void)key;
+  (void)ptr;
+  (void)size;
+#else
+  const size_t entry_size = sizeof(PersistentEntryHeader) + size;
+  if (persistent_cache_max_bytes_ != 0 &&
+      persistent_cache_bytes_ + entry_size > persistent_cache_max_bytes_) {
+    ET_LOG(
+        Debug,
+        "Weights cache is full, not storing %zu bytes of packed data",
+        size);
+    return;
+  }
+  PersistentEntryHeader header = {};
+  std::memcpy(header.magic, kPersistentEntryMagic, sizeof(header.magic));
+  header.version = kPersistentCacheVersion;
+  header.key = key.key;
+  header.packed_size = size;
+  header.packed_hash = hash_bytes(ptr, size);
+  header.unpacked_size = key.unpacked_size;
+  header.unpacked_check = key.unpacked_check;
+
+  // Write to a private file and rename it into place, so that concurrent
+  // readers never see a partial entry.
+  const std::string path =
+      persistent_entry_path(persistent_cache_dir_, key.key);
+  const std::string tmp_path = path + "." + std::to_string(::getpid()) + ".tmp";
+  int fd = ::open(
+      tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    ET_LOG(
+        Info,
+        "Failed to create weights cache entry %s: %s",
+        tmp_path.c_str(),
+        strerror(errno));
+    return;
+  }
+  bool ok =
+      write_all(fd, &header, sizeof(header)) && write_all(fd, ptr, size);
+  ok = ::close(fd) == 0 && ok;
+  if (!ok || ::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    ET_LOG(Info, "Failed to write weights cache entry %s", path.c_str());
+    ::unlink(tmp_path.c_str());
+    return;
+  }
+  persistent_cache_bytes_ += entry_size;
+#endif
+}
+
 } // namespace delegate
 } // namespace xnnpack
 } // namespace backends
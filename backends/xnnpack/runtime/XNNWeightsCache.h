@@ -14,6 +14,7 @@
 #include <executorch/runtime/core/memory_allocator.h>
 #include <executorch/runtime/core/result.h>
 #include <executorch/runtime/executor/pte_data_map.h>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -41,6 +42,37 @@ struct PackedDataMeta {
 class XNNWeightsCache {
  public:
   XNNWeightsCache();
+  ~XNNWeightsCache();
+
+  // Not safely copyable.
+  XNNWeightsCache(const XNNWeightsCache&) = delete;
+  XNNWeightsCache& operator=(const XNNWeightsCache&) = delete;
+
+  /**
+   * Stores packed weights in `directory` and maps them from there instead of
+   * packing them again, including in later processes.
+   *
+   * Entries are keyed by a hash of the unpacked weight and bias data, the
+   * packing parameters, the XNNPACK version and the ISA extensions of this
+   * CPU, and are checked against a hash of their contents before use. Only
+   * weights loaded through load_unpacked_data() are stored.
+   *
+   * @param[in] directory An existing directory. Entries for different models
+   *     and CPUs can share it.
+   * @param[in] max_bytes No entries are written once the directory holds this
+   *     many bytes of entries. Zero means no limit.
+   * @retval Error::NotSupported The backend was built without XNNPACK_COMMIT,
+   *     so entries from another XNNPACK build could not be told apart.
+   */
+  Error enable_persistent_cache(const std::string& directory, size_t max_bytes);
+
+  /**
+   * Returns the number of packed weights currently mapped from the persistent
+   * cache.
+   */
+  inline size_t get_num_mapped_packed_data() {
+    return packed_pointer_to_mapping_.size();
+  }
 
   /**
    * Initializes the XNNWeightsCache for the next xnn_create_runtime
@@ -107,6 +139,9 @@ class XNNWeightsCache {
    */
   Result<const uint8_t*> load_unpacked_data(const std::string& name);
 
+  // Format of persistent cache entries. Bump when the layout changes.
+  static constexpr uint32_t kPersistentCacheVersion = 2;
+
   /**
    * Deletes the packed data associated with the names given.
    * Decrements the ref_count if the packed data is used by other
@@ -137,6 +172,49 @@ class XNNWeightsCache {
   // whether or not the weight cache is finalized
   bool is_finalized_;
 
+  // Directory of the persistent cache, or empty if it is disabled
+  std::string persistent_cache_dir_;
+  // Maximum and current size in bytes of the persistent cache's entries
+  size_t persistent_cache_max_bytes_ = 0;
+  size_t persistent_cache_bytes_ = 0;
+  // Fingerprints of the unpacked data, only computed for the persistent
+  // cache. `hash` names the entry and `size` and `check` verify it.
+  struct UnpackedFingerprint {
+    uint64_t hash;
+    uint64_t check;
+    uint64_t size;
+  };
+  std::unordered_map<const void*, UnpackedFingerprint>
+      unpacked_data_to_fingerprint_;
+  // Mappings of persistent cache entries, keyed by their packed data pointer
+  struct Mapping {
+    void* base;
+    size_t size;
+  };
+  std::unordered_map<void*, Mapping> packed_pointer_to_mapping_;
+
+  // Identifies a persistent cache entry. `key` names the entry's file, and
+  // the unpacked size and check value, which come from a hash independent
+  // of `key`, are stored in the entry and compared before it is used.
+  struct PersistentKey {
+    uint64_t key;
+    uint64_t unpacked_size;
+    uint64_t unpacked_check;
+  };
+
+  // Returns the persistent cache key for the given look up key, or false if
+  // the unpacked data was not loaded through load_unpacked_data().
+  bool persistent_cache_key(
+      const xnn_weights_cache_look_up_key* cache_key,
+      PersistentKey* key) const;
+  // Maps the persistent cache entry for `key`, or returns nullptr.
+  void* map_persistent_entry(const PersistentKey& key);
+  // Writes `size` bytes of packed data at `ptr` as the entry for `key`.
+  void write_persistent_entry(
+      const PersistentKey& key,
+      const void* ptr,
+      size_t size);
+
   // Function pointers to override XNNPACK's default xnn_weights_cache_provider
   // functions.
   static size_t look_up(
@@ -16,6 +16,7 @@
 #include <executorch/runtime/platform/platform.h>
 #include <executorch/runtime/platform/types.h>
 
+#include <cctype>
 #include <cinttypes>
 #include <cstring>
 #include <string>
@@ -24,21 +25,95 @@
 
 namespace executorch::backends::xnnpack::delegate::profiling {
 
+using executorch::runtime::DebugHandle;
 using executorch::runtime::Error;
 using executorch::runtime::EventTracer;
 
 #if defined(ET_EVENT_TRACER_ENABLED) || defined(ENABLE_XNNPACK_PROFILING)
 
+namespace {
+
+/**
+ * Returns whether the operator name, e.g. "Fully Connected (NC, F32)",
+ * starts with one of the '|'-separated prefixes, e.g. "fullyconnected",
+ * ignoring case, spaces and punctuation.
+ */
+bool operator_name_matches(const std::string& op_name, const char* prefixes) {
+  if (prefixes == nullptr) {
+    return false;
+  }
+  std::string normalized;
+  for (char c : op_name) {
+    if (c == '(') {
+      break;
+    }
+    if (std::isalnum(static_cast<unsigned char>(c))) {
+      normalized.push_back(
+          static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+  }
+  const char* prefix = prefixes;
+  while (true) {
+    const char* end = std::strchr(prefix, '|');
+    const size_t length = end ? end - prefix : std::strlen(prefix);
+    if (length > 0 && normalized.compare(0, length, prefix, length) == 0) {
+      return true;
+    }
+    if (end == nullptr) {
+      return false;
+    }
+    prefix = end + 1;
+  }
+}
+
+} // namespace
+
 XNNProfiler::XNNProfiler()
     : state_(XNNProfilerState::Uninitialized), run_count_(0) {}
 
-Error XNNProfiler::initialize(xnn_runtime_t runtime) {
+Error XNNProfiler::initialize(
+    xnn_runtime_t runtime,
+    const std::vector<uint32_t>& node_debug_handles,
+    const std::vector<const char*>& node_operator_names) {
   runtime_ = runtime;
 
   // Fetch the runtime operator information from XNNPACK.
   ET_CHECK_OK_OR_RETURN_ERROR(get_runtime_num_operators());
   ET_CHECK_OK_OR_RETURN_ERROR(get_runtime_operator_names());
 
+  // XNNPACK reports operators, not nodes, and may fuse or split nodes when
+  // it creates the runtime. Only attribute operators to nodes when they line
+  // up one-to-one and each operator is of the kind its node creates.
+  bool matches_nodes = !node_debug_handles.empty() &&
+      node_debug_handles.size() == op_count_ &&
+      node_operator_names.size() == op_count_;
+
+  // Format the op names as {name} #{count} once, rather than on every run.
+  op_labels_.clear();
+  op_labels_.reserve(op_count_);
+  std::unordered_map<std::string, uint32_t> op_counts;
+  size_t name_len = 0;
+  for (size_t i = 0; i < op_count_; i++) {
+    std::string op_name(&op_names_[name_len]);
+    name_len += op_name.size() + 1;
+    const uint32_t count = ++op_counts[op_name];
+    op_labels_.push_back(op_name + " #" + std::to_string(count));
+    matches_nodes = matches_nodes &&
+        operator_name_matches(op_name, node_operator_names[i]);
+  }
+
+  op_debug_handles_.clear();
+  if (matches_nodes) {
+    op_debug_handles_.assign(
+        node_debug_handles.begin(), node_debug_handles.end());
+  } else if (!node_debug_handles.empty()) {
+    ET_LOG(
+        Debug,
+        "XNNPACK runtime operators do not match the %zu nodes, not "
+        "reporting debug handles",
+        node_debug_handles.size());
+  }
+
   state_ = XNNProfilerState::Ready;
 
   return Error::Ok;
@@ -158,52 +233,56 @@ Error XNNProfiler::get_runtime_operator_timings() {
 
 void XNNProfiler::log_operator_timings() {
 #ifdef ENABLE_XNNPACK_PROFILING
-  // Update running average state and log average timing for each op.
+  // Update running average state and log timing for each op.
   run_count_++;
-  size_t name_len = 0;
-  const char* op_name = nullptr;
-  auto total_time = 0.0f;
 
   if (op_timings_sum_.size() != op_count_) {
     op_timings_sum_ = std::vector<uint64_t>(op_count_, 0);
   }
 
   for (size_t i = 0; i < op_count_; i++) {
-    op_name = &op_names_[name_len];
-    name_len += strlen(op_name) + 1;
-
     op_timings_sum_[i] += op_timings_[i];
     auto avg_op_time = op_timings_sum_[i] / static_cast<float>(run_count_);
-    total_time += avg_op_time;
 
     ET_LOG(
-        Info, ">>, %s, %" PRId64 " (%f)", op_name, op_timings_[i], avg_op_time);
+        Debug,
+        ">>, %s, %" PRId64 " (%f)",
+        op_labels_[i].c_str(),
+        op_timings_[i],
+        avg_op_time);
   }
-  ET_LOG(Info, ">>, Total Time, %f", total_time);
 #else
   run_count_++;
 #endif
 }
 
+void XNNProfiler::log_avg_op_timings() const {
+#ifdef ENABLE_XNNPACK_PROFILING
+  if (run_count_ == 0 || op_timings_sum_.size() != op_count_) {
+    return;
+  }
+  auto total_time = 0.0f;
+  for (size_t i = 0; i < op_count_; i++) {
+    auto avg_op_time = op_timings_sum_[i] / static_cast<float>(run_count_);
+    total_time += avg_op_time;
+    ET_LOG(Info, ">>, %s, %f", op_labels_[i].c_str(), avg_op_time);
+  }
+  ET_LOG(
+      Info,
+      ">>, Total Time, %f (average of %" PRIu64 " runs)",
+      total_time,
+      run_count_);
+#endif
+}
+
 void XNNProfiler::submit_trace() {
   // Retrieve the system tick rate (ratio between ticks and nanoseconds).
   auto tick_ns_conv_multiplier = runtime::pal_ticks_to_ns_multiplier();
 
   ET_CHECK(op_timings_.size() == op_count_);
-  size_t name_len = 0;
   et_timestamp_t time = start_time_;
-  std::unordered_map<std::string, uint32_t> op_counts;
 
   for (auto i = 0u; i < op_count_; i++) {
-    auto op_name = &op_names_[name_len];
-    name_len += strlen(op_name) + 1;
-
-    // Format the op name as {name} #{count}.
-    auto op_name_str = std::string(op_name);
-    op_counts[op_name_str]++;
-    auto name_formatted =
-        op_name_str + " #" + std::to_string(op_counts[op_name_str]);
-
     // Convert from microseconds (XNNPACK) to PAL ticks (ET).
     // The tick_ns_conv_ratio is ns / tick. We want ticks:
     //  ticks = us * (ns / us) / conv_ratio
@@ -214,12 +293,26 @@ void XNNProfiler::submit_trace() {
 
     auto end_time = time + interval_ticks;
 
-    executorch::runtime::event_tracer_log_profiling_delegate(
-        event_tracer_,
-        name_formatted.c_str(),
-        /*delegate_debug_id=*/static_cast<executorch::runtime::DebugHandle>(-1),
-        time,
-        end_time);
+    const std::string& label = op_labels_[i];
+    if (!op_debug_handles_.empty()) {
+      // Events carry either a name or a debug id; pass the name along as
+      // metadata so that it is not lost.
+      executorch::runtime::event_tracer_log_profiling_delegate(
+          event_tracer_,
+          /*name=*/nullptr,
+          /*delegate_debug_id=*/op_debug_handles_[i],
+          time,
+          end_time,
+          label.data(),
+          label.size());
+    } else {
+      executorch::runtime::event_tracer_log_profiling_delegate(
+          event_tracer_,
+          label.c_str(),
+          /*delegate_debug_id=*/static_cast<DebugHandle>(-1),
+          time,
+          end_time);
+    }
 
     // Assume that the next op starts immediately after the previous op.
     // This may not be strictly true, but it should be close enough.
@@ -234,8 +327,13 @@ void XNNProfiler::submit_trace() {
 // Stub implementation for when profiling is disabled.
 XNNProfiler::XNNProfiler() {}
 
-Error XNNProfiler::initialize(xnn_runtime_t runtime) {
+Error XNNProfiler::initialize(
+    xnn_runtime_t runtime,
+    const std::vector<uint32_t>& node_debug_handles,
+    const std::vector<const char*>& node_operator_names) {
   (void)runtime;
+  (void)node_debug_handles;
+  (void)node_operator_names;
   return Error::Ok;
 }
 
@@ -248,6 +346,8 @@ Error XNNProfiler::end() {
   return Error::Ok;
 }
 
+void XNNProfiler::log_avg_op_timings() const {}
+
 #endif
 
 } // namespace executorch::backends::xnnpack::delegate::profiling
@@ -12,6 +12,7 @@
 #include <executorch/runtime/core/event_tracer_hooks_delegate.h>
 
 #include <xnnpack.h>
+#include <string>
 #include <vector>
 
 namespace executorch {
@@ -29,8 +30,21 @@ class XNNProfiler {
   /**
    * Initialize the profiler. This must be called after model is
    * compiled and before calling begin_execution.
+   *
+   * @param[in] runtime The runtime to profile.
+   * @param[in] node_debug_handles Debug handles of the subgraph's nodes, in
+   *     definition order.
+   * @param[in] node_operator_names For each node, the '|'-separated prefixes
+   *     that the name of the XNNPACK operator running it starts with, once
+   *     lowercased and stripped of spaces and punctuation, or nullptr if
+   *     unknown. Operator events are reported under the nodes' debug handles
+   *     only when every operator matches its node this way; otherwise nodes
+   *     were fused or split and events are reported by name only.
    */
-  executorch::runtime::Error initialize(xnn_runtime_t runtime);
+  executorch::runtime::Error initialize(
+      xnn_runtime_t runtime,
+      const std::vector<uint32_t>& node_debug_handles = {},
+      const std::vector<const char*>& node_operator_names = {});
 
   /**
    * Start a new profiling session. This is typically invoked
@@ -46,6 +60,12 @@ class XNNProfiler {
    */
   executorch::runtime::Error end();
 
+  /**
+   * Logs the average time of each operator over all runs so far. Only logs
+   * when ENABLE_XNNPACK_PROFILING is defined.
+   */
+  void log_avg_op_timings() const;
+
  private:
 #if defined(ET_EVENT_TRACER_ENABLED) || defined(ENABLE_XNNPACK_PROFILING)
   executorch::runtime::EventTracer* event_tracer_;
@@ -54,6 +74,11 @@ class XNNProfiler {
 
   size_t op_count_;
   std::vector<char> op_names_;
+  // Operator names formatted as "{name} #{count}", computed once.
+  std::vector<std::string> op_labels_;
+  // Debug handle of each operator, or empty if operators cannot be matched
+  // to nodes.
+  std::vector<executorch::runtime::DebugHandle> op_debug_handles_;
   std::vector<uint64_t> op_timings_;
   uint64_t run_count_;
   et_timestamp_t start_time_;
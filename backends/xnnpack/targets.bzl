@@ -10,9 +10,19 @@ def _get_preprocessor_flags():
     if native.read_config("executorch", "xnnpack_workspace_sharing", "0") != "0":
         preprocessor_flags.append("-DENABLE_XNNPACK_SHARED_WORKSPACE")
 
+    workspace_pool_size = native.read_config("executorch", "xnnpack_workspace_pool_size", "1")
+    if workspace_pool_size != "1":
+        preprocessor_flags.append("-DXNNPACK_WORKSPACE_POOL_SIZE=" + workspace_pool_size)
+
     if native.read_config("executorch", "xnnpack_weights_cache", "0") != "0":
         preprocessor_flags.append("-DENABLE_XNNPACK_WEIGHTS_CACHE")
 
+    # The persistent weights cache is only enabled when the XNNPACK revision
+    # that packs its entries is known.
+    xnnpack_commit = native.read_config("executorch", "xnnpack_commit", "")
+    if xnnpack_commit:
+        preprocessor_flags.append("-DXNNPACK_COMMIT=\"{}\"".format(xnnpack_commit))
+
     # Enable if not disabled through config
     return preprocessor_flags
 
@@ -63,8 +73,10 @@ def define_common_targets():
             ],
             deps = [
                 third_party_dep("XNNPACK"),
+                third_party_dep("cpuinfo"),
                 "//executorch/backends/xnnpack/serialization:xnnpack_flatbuffer_header",
                 "//executorch/extension/threadpool:threadpool",
+                "//executorch/runtime/core:content_hash",
                 "//executorch/runtime/core/exec_aten/util:tensor_util" + aten_suffix,
                 "//executorch/runtime/executor:pte_data_map" + aten_suffix,
             ],
@@ -19,6 +19,10 @@
 #include <gtest/gtest.h>
 #include <xnnpack.h>
 
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+
 using executorch::backends::xnnpack::delegate::XNNWeightsCache;
 using executorch::extension::FileDataLoader;
 using executorch::extension::testing::TempFile;
@@ -284,3 +288,66 @@ TEST_F(XNNWeightsCacheTest, ReusePackedWeights) {
   packed_data_names = weight_cache.get_packed_data_names();
   ASSERT_EQ(packed_data_names.size(), 0);
 }
+
+TEST_F(XNNWeightsCacheTest, PersistentCacheReusesPackedWeights) {
+  char dir_template[] = "/tmp/xnn_weights_cache_test.XXXXXX";
+  ASSERT_NE(::mkdtemp(dir_template), nullptr);
+  const std::string directory = dir_template;
+
+  std::vector<size_t> batches{1, 2, 3};
+  size_t input_channels = 3;
+  size_t output_channels = 4;
+  std::vector<float> input_tensor(6 * input_channels + 32, 1.0f);
+  std::vector<float> packed_output(6 * output_channels, 0.0f);
+  std::vector<float> mapped_output(6 * output_channels, 0.0f);
+
+  {
+    XNNWeightsCache weight_cache;
+    const Error enabled =
+        weight_cache.enable_persistent_cache(directory, /*max_bytes=*/0);
+    if (enabled == Error::NotSupported) {
+      ::rmdir(directory.c_str());
+      GTEST_SKIP() << "The backend was built without XNNPACK_COMMIT";
+    }
+    ASSERT_EQ(enabled, Error::Ok);
+    weight_cache.initialize_for_runtime(
+        memory_allocator_.get(), data_map_.get());
+    BuildAndRunGraphWithWeightsCache(
+        weight_cache,
+        batches,
+        input_channels,
+        output_channels,
+        input_tensor.data(),
+        packed_output.data());
+    EXPECT_EQ(weight_cache.get_num_mapped_packed_data(), 0);
+  }
+
+  // A new cache stands in for a later process.
+  XNNWeightsCache weight_cache;
+  ASSERT_EQ(
+      weight_cache.enable_persistent_cache(directory, /*max_bytes=*/0),
+      Error::Ok);
+  weight_cache.initialize_for_runtime(memory_allocator_.get(), data_map_.get());
+  BuildAndRunGraphWithWeightsCache(
+      weight_cache,
+      batches,
+      input_channels,
+      output_channels,
+      input_tensor.data(),
+      mapped_output.data());
+  EXPECT_EQ(weight_cache.get_num_mapped_packed_data(), 1);
+  EXPECT_EQ(packed_output, mapped_output);
+
+  weight_cache.delete_packed_data(weight_cache.get_packed_data_names());
+  EXPECT_EQ(weight_cache.get_num_mapped_packed_data(), 0);
+
+  DIR* dir = ::opendir(directory.c_str());
+  ASSERT_NE(dir, nullptr);
+  while (struct dirent* entry = ::readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ::unlink((directory + "/" + entry->d_name).c_str());
+    }
+  }
+  ::closedir(dir);
+  ::rmdir(directory.c_str());
+}
@@ -8,6 +8,7 @@
 
 #include <executorch/backends/xnnpack/runtime/XNNExecutor.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
 #include <gtest/gtest.h>
 #include <xnnpack.h>
 
@@ -93,3 +94,154 @@ TEST(XNNExecutorTest, ArgumentWithTooManyDimensions) {
   // Check for invalid number of dimensions should fail without stack overflow.
   EXPECT_EQ(executor.prepare_args(args.data()), Error::InvalidArgument);
 }
+
+TEST(XNNExecutorTest, RebindsOnlyChangedArguments) {
+  XNNExecutor executor;
+  xnn_subgraph_t subgraph = nullptr;
+  xnn_runtime_t rt = nullptr;
+  et_pal_init();
+  ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+  ASSERT_EQ(xnn_create_subgraph(2, 0, &subgraph), xnn_status_success);
+  std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> auto_subgraph(
+      subgraph, xnn_delete_subgraph);
+
+  std::vector<size_t> dims = {4};
+  auto input_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/0,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_INPUT,
+          &input_id));
+  auto output_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/1,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_OUTPUT,
+          &output_id));
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_clamp(subgraph, 0.0f, 6.0f, input_id, output_id, 0));
+
+  ASSERT_EQ(xnn_create_runtime(subgraph, &rt), xnn_status_success);
+  ASSERT_EQ(executor.initialize(rt, {0}, {1}, {}), Error::Ok);
+
+  TensorFactory<executorch::aten::ScalarType::Float> tf;
+  auto input_tensor = tf.make({4}, {-1.0f, 2.0f, 5.0f, 8.0f});
+  auto output_tensor = tf.zeros({4});
+  EValue input_ev(input_tensor);
+  EValue output_ev(output_tensor);
+  std::array<EValue*, 2> args = {&input_ev, &output_ev};
+  executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext context;
+
+  // Executing again with the same arguments reuses the previous setup.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+    ASSERT_EQ(executor.forward(context), Error::Ok);
+    ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+    EXPECT_TENSOR_EQ(output_tensor, tf.make({4}, {0.0f, 2.0f, 5.0f, 6.0f}));
+  }
+  EXPECT_EQ(executor.get_num_reshapes(), 1);
+#ifndef ENABLE_XNNPACK_SHARED_WORKSPACE
+  EXPECT_EQ(executor.get_num_setups(), 1);
+#endif
+
+  // New data pointers are bound before the next run.
+  auto other_input = tf.make({4}, {3.0f, -2.0f, 7.0f, 1.0f});
+  auto other_output = tf.zeros({4});
+  EValue other_input_ev(other_input);
+  EValue other_output_ev(other_output);
+  args = {&other_input_ev, &other_output_ev};
+  ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+  ASSERT_EQ(executor.forward(context), Error::Ok);
+  ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+  EXPECT_TENSOR_EQ(other_output, tf.make({4}, {3.0f, 0.0f, 6.0f, 1.0f}));
+  EXPECT_TENSOR_EQ(output_tensor, tf.make({4}, {0.0f, 2.0f, 5.0f, 6.0f}));
+  EXPECT_EQ(executor.get_num_reshapes(), 1);
+#ifndef ENABLE_XNNPACK_SHARED_WORKSPACE
+  EXPECT_EQ(executor.get_num_setups(), 2);
+#endif
+
+  // A new shape reshapes the runtime again.
+  auto short_input = tf.make({2}, {-4.0f, 9.0f});
+  auto short_output = tf.zeros({2});
+  EValue short_input_ev(short_input);
+  EValue short_output_ev(short_output);
+  args = {&short_input_ev, &short_output_ev};
+  ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+  ASSERT_EQ(executor.forward(context), Error::Ok);
+  ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+  EXPECT_TENSOR_EQ(short_output, tf.make({2}, {0.0f, 6.0f}));
+  EXPECT_EQ(executor.get_num_reshapes(), 2);
+}
+
+TEST(XNNExecutorTest, ReshapesDelegateWithoutInputs) {
+  XNNExecutor executor;
+  xnn_subgraph_t subgraph = nullptr;
+  xnn_runtime_t rt = nullptr;
+  et_pal_init();
+  ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+  ASSERT_EQ(xnn_create_subgraph(1, 0, &subgraph), xnn_status_success);
+  std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> auto_subgraph(
+      subgraph, xnn_delete_subgraph);
+
+  // The only external value is the output; the input is a constant.
+  std::vector<size_t> dims = {4};
+  const std::array<float, 4> constant = {-1.0f, 2.0f, 5.0f, 8.0f};
+  auto constant_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          constant.data(),
+          XNN_INVALID_VALUE_ID,
+          /*flags=*/0,
+          &constant_id));
+  auto output_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/0,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_OUTPUT,
+          &output_id));
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_clamp(subgraph, 0.0f, 6.0f, constant_id, output_id, 0));
+
+  ASSERT_EQ(xnn_create_runtime(subgraph, &rt), xnn_status_success);
+  ASSERT_EQ(executor.initialize(rt, {}, {0}, {}), Error::Ok);
+
+  TensorFactory<executorch::aten::ScalarType::Float> tf;
+  auto output_tensor = tf.zeros({4});
+  EValue output_ev(output_tensor);
+  std::array<EValue*, 1> args = {&output_ev};
+  executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext context;
+
+  // No input shape ever changes, but the first run must still reshape.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+    ASSERT_EQ(executor.forward(context), Error::Ok);
+    ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+    EXPECT_TENSOR_EQ(output_tensor, tf.make({4}, {0.0f, 2.0f, 5.0f, 6.0f}));
+  }
+  EXPECT_EQ(executor.get_num_reshapes(), 1);
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/profiling/XNNProfiler.h>
+#include <executorch/runtime/core/event_tracer.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <xnnpack.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+using executorch::aten::Tensor;
+using executorch::backends::xnnpack::delegate::profiling::XNNProfiler;
+using executorch::runtime::AllocatorID;
+using executorch::runtime::ArrayRef;
+using executorch::runtime::ChainID;
+using executorch::runtime::DebugHandle;
+using executorch::runtime::DelegateDebugIntId;
+using executorch::runtime::Error;
+using executorch::runtime::EValue;
+using executorch::runtime::EventTracer;
+using executorch::runtime::EventTracerEntry;
+using executorch::runtime::EventTracerFilterBase;
+using executorch::runtime::LoggedEValueType;
+using executorch::runtime::Result;
+
+namespace {
+
+struct DelegateEvent {
+  std::string name;
+  DelegateDebugIntId debug_id;
+  std::string metadata;
+};
+
+// Records the delegate profiling events logged by the profiler.
+class RecordingEventTracer : public EventTracer {
+ public:
+  void create_event_block(const char*) override {}
+  EventTracerEntry start_profiling(const char*, ChainID, DebugHandle)
+      override {
+    return EventTracerEntry();
+  }
+  void end_profiling(EventTracerEntry) override {}
+  void track_allocation(AllocatorID, size_t) override {}
+  AllocatorID track_allocator(const char*) override {
+    return 0;
+  }
+  EventTracerEntry start_profiling_delegate(const char*, DelegateDebugIntId)
+      override {
+    return EventTracerEntry();
+  }
+  void end_profiling_delegate(EventTracerEntry, const void*, size_t) override {}
+  void set_delegation_intermediate_output_filter(
+      EventTracerFilterBase*) override {}
+  Result<bool> log_evalue(const EValue&, LoggedEValueType) override {
+    return true;
+  }
+  Result<bool> log_intermediate_output_delegate(
+      const char*,
+      DelegateDebugIntId,
+      const Tensor&) override {
+    return true;
+  }
+  Result<bool> log_intermediate_output_delegate(
+      const char*,
+      DelegateDebugIntId,
+      const ArrayRef<Tensor>) override {
+    return true;
+  }
+  Result<bool> log_intermediate_output_delegate(
+      const char*,
+      DelegateDebugIntId,
+      const int&) override {
+    return true;
+  }
+  Result<bool> log_intermediate_output_delegate(
+      const char*,
+      DelegateDebugIntId,
+      const bool&) override {
+    return true;
+  }
+  Result<bool> log_intermediate_output_delegate(
+      const char*,
+      DelegateDebugIntId,
+      const double&) override {
+    return true;
+  }
+
+  void log_profiling_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_id,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time,
+      const void* metadata,
+      size_t metadata_len = 0) override {
+    (void)start_time;
+    (void)end_time;
+    events.push_back(
+        {name != nullptr ? name : "",
+         delegate_debug_id,
+         metadata != nullptr
+             ? std::string(static_cast<const char*>(metadata), metadata_len)
+             : ""});
+  }
+
+  std::vector<DelegateEvent> events;
+};
+
+class XNNProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+#ifndef ET_EVENT_TRACER_ENABLED
+    GTEST_SKIP() << "Profiling events need ET_EVENT_TRACER_ENABLED";
+#endif
+    executorch::runtime::runtime_init();
+    ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+    BuildRuntime();
+  }
+
+  // Builds a runtime for sigmoid((x + y) * y), whose nodes each run as one
+  // operator.
+  void BuildRuntime() {
+    xnn_subgraph_t subgraph = nullptr;
+    ASSERT_EQ(xnn_create_subgraph(3, 0, &subgraph), xnn_status_success);
+    std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)>
+        auto_subgraph(subgraph, xnn_delete_subgraph);
+
+    std::vector<size_t> dims = {4};
+    auto define_value = [&](uint32_t external_id, uint32_t flags) {
+      uint32_t id = XNN_INVALID_VALUE_ID;
+      EXPECT_EQ(
+          xnn_define_tensor_value(
+              subgraph,
+              xnn_datatype_fp32,
+              dims.size(),
+              dims.data(),
+              nullptr,
+              external_id,
+              flags,
+              &id),
+          xnn_status_success);
+      return id;
+    };
+    const uint32_t x_id = define_value(0, XNN_VALUE_FLAG_EXTERNAL_INPUT);
+    const uint32_t y_id = define_value(1, XNN_VALUE_FLAG_EXTERNAL_INPUT);
+    const uint32_t out_id = define_value(2, XNN_VALUE_FLAG_EXTERNAL_OUTPUT);
+    const uint32_t sum_id = define_value(XNN_INVALID_VALUE_ID, 0);
+    const uint32_t product_id = define_value(XNN_INVALID_VALUE_ID, 0);
+
+    ASSERT_EQ(
+        xnn_define_binary(
+            subgraph, xnn_binary_add, nullptr, x_id, y_id, sum_id, 0),
+        xnn_status_success);
+    ASSERT_EQ(
+        xnn_define_binary(
+            subgraph,
+            xnn_binary_multiply,
+            nullptr,
+            sum_id,
+            y_id,
+            product_id,
+            0),
+        xnn_status_success);
+    ASSERT_EQ(
+        xnn_define_unary(
+            subgraph, xnn_unary_sigmoid, nullptr, product_id, out_id, 0),
+        xnn_status_success);
+
+    xnn_runtime_t runtime = nullptr;
+    ASSERT_EQ(
+        xnn_create_runtime_v2(
+            subgraph, nullptr, XNN_FLAG_BASIC_PROFILING, &runtime),
+        xnn_status_success);
+    runtime_.reset(runtime);
+  }
+
+  void Run(XNNProfiler& profiler, RecordingEventTracer& tracer) {
+    std::array<float, 4> x = {1.0f, 2.0f, 3.0f, 4.0f};
+    std::array<float, 4> y = {0.5f, 0.5f, 0.5f, 0.5f};
+    std::array<float, 4> out = {};
+    const std::array<xnn_external_value, 3> external = {
+        xnn_external_value{0, x.data()},
+        xnn_external_value{1, y.data()},
+        xnn_external_value{2, out.data()},
+    };
+    ASSERT_EQ(xnn_reshape_runtime(runtime_.get()), xnn_status_success);
+    ASSERT_EQ(
+        xnn_setup_runtime_v2(runtime_.get(), external.size(), external.data()),
+        xnn_status_success);
+
+    ASSERT_EQ(profiler.start(&tracer), Error::Ok);
+    ASSERT_EQ(xnn_invoke_runtime(runtime_.get()), xnn_status_success);
+    ASSERT_EQ(profiler.end(), Error::Ok);
+  }
+
+  std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)> runtime_{
+      nullptr,
+      xnn_delete_runtime};
+};
+
+} // namespace
+
+TEST_F(XNNProfilerTest, ReportsEachOperatorUnderItsNodeDebugHandle) {
+  XNNProfiler profiler;
+  ASSERT_EQ(
+      profiler.initialize(
+          runtime_.get(),
+          {11, 12, 13},
+          {"binaryelementwise|add",
+           "binaryelementwise|multiply",
+           "unaryelementwise|sigmoid"}),
+      Error::Ok);
+
+  RecordingEventTracer tracer;
+  Run(profiler, tracer);
+
+  ASSERT_EQ(tracer.events.size(), 3);
+  const std::array<DelegateDebugIntId, 3> expected_ids = {11, 12, 13};
+  for (size_t i = 0; i < tracer.events.size(); ++i) {
+    EXPECT_EQ(tracer.events[i].debug_id, expected_ids[i]);
+    // The operator name is passed along as metadata.
+    EXPECT_TRUE(tracer.events[i].name.empty());
+    EXPECT_FALSE(tracer.events[i].metadata.empty());
+  }
+}
+
+TEST_F(XNNProfilerTest, ReportsByNameWhenOperatorsDoNotMatchNodes) {
+  XNNProfiler profiler;
+  // The operator counts match, but the operators are not of the kinds the
+  // nodes create, as when one node is fused and another is split.
+  ASSERT_EQ(
+      profiler.initialize(
+          runtime_.get(),
+          {11, 12, 13},
+          {"binaryelementwise|add",
+           "unaryelementwise|sigmoid",
+           "binaryelementwise|multiply"}),
+      Error::Ok);
+
+  RecordingEventTracer tracer;
+  Run(profiler, tracer);
+
+  ASSERT_EQ(tracer.events.size(), 3);
+  for (const auto& event : tracer.events) {
+    EXPECT_EQ(event.debug_id, static_cast<DelegateDebugIntId>(-1));
+    EXPECT_FALSE(event.name.empty());
+  }
+}
@@ -31,6 +31,16 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "xnnprofiler_test",
+        srcs = ["runtime/test_xnnprofiler.cpp"],
+        deps = [
+            third_party_dep("XNNPACK"),
+            "//executorch/backends/xnnpack:xnnpack_backend",
+            "//executorch/runtime/core:event_tracer",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_xnn_weights_cache",
         srcs = ["runtime/test_xnn_weights_cache.cpp"],
@@ -180,10 +180,18 @@ class XnnpackBackend(BackendDetails):
                 continue
             else:
                 raise RuntimeError(f"{node.op} is not supported in XNNPACK")
+
+        # The runtime reports per-operator profiling events under the debug
+        # handle of the node that defined the operator.
+        debug_handle_map = {
+            xnode.debug_handle: (xnode.debug_handle,)
+            for xnode in xnnpack_graph.xnodes
+            if xnode.debug_handle != DEFAULT_DEBUG_HANDLE
+        }
         return PreprocessResult(
             processed_bytes=serialize_xnnpack_binary(
                 xnnpack_graph, constant_data_bytes
             ),
-            debug_handle_map={},
+            debug_handle_map=debug_handle_map,
             data_store_output=named_data_store.get_named_data_store_output(),
         )
@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+
+#include <cinttypes>
+#include <cstring>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+#include <executorch/runtime/platform/platform.h>
+
+using ::executorch::aten::Tensor;
+using ::executorch::runtime::AllocatorID;
+using ::executorch::runtime::ArrayRef;
+using ::executorch::runtime::ChainID;
+using ::executorch::runtime::DebugHandle;
+using ::executorch::runtime::DelegateDebugIdType;
+using ::executorch::runtime::DelegateDebugIntId;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::EValue;
+using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::EventTracerFilterBase;
+using ::executorch::runtime::kUnsetDelegateDebugIntId;
+using ::executorch::runtime::LoggedEValueType;
+using ::executorch::runtime::Result;
+
+namespace executorch {
+namespace etdump {
+
+namespace {
+
+constexpr size_t kRecordSize = 64;
+constexpr size_t kMaxNameLength = sizeof(RingBufferName::name) - 1;
+
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & (value - 1)) == 0;
+}
+
+/// FNV-1a over the part of `name` that is stored. Never 0.
+uint64_t hash_name(const char* name) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < kMaxNameLength && name[i] != '\0'; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(name[i])) * 0x100000001b3ULL;
+  }
+  return hash | 1;
+}
+
+RingBufferEvent make_event(RingBufferEventKind kind) {
+  RingBufferEvent event{};
+  event.kind = kind;
+  event.value = -1;
+  event.name_id = -1;
+  return event;
+}
+
+} // namespace
+
+RingBufferEventTracer::RingBufferEventTracer(
+    DataSinkBase* data_sink,
+    size_t capacity,
+    size_t chunk_size,
+    size_t max_names)
+    : data_sink_(data_sink),
+      capacity_(capacity),
+      chunk_size_(chunk_size > 0 ? chunk_size : kDefaultChunkSize),
+      max_names_(max_names),
+      events_(new RingBufferEvent[capacity]),
+      published_(new std::atomic<uint64_t>[capacity]),
+      names_(new NameSlot[max_names]),
+      staging_(new uint8_t[kRecordSize * (chunk_size_ + 1)]),
+      name_written_(new bool[max_names]()) {
+  ET_CHECK_MSG(data_sink_ != nullptr, "data_sink cannot be null");
+  ET_CHECK_MSG(
+      is_power_of_2(capacity), "Capacity %zu is not a power of 2", capacity);
+  ET_CHECK_MSG(
+      is_power_of_2(max_names), "max_names %zu is not a power of 2", max_names);
+  for (size_t i = 0; i < capacity_; ++i) {
+    published_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+RingBufferEventTracer::~RingBufferEventTracer() {
+  stop_background_flush();
+}
+
+int32_t RingBufferEventTracer::intern(const char* name) {
+  if (name == nullptr) {
+    return -1;
+  }
+  const uint64_t hash = hash_name(name);
+  for (size_t probe = 0; probe < max_names_; ++probe) {
+    const size_t index = (hash + probe) & (max_names_ - 1);
+    NameSlot& slot = names_[index];
+    uint64_t current = slot.hash.load(std::memory_order_acquire);
+    if (current == 0 &&
+        slot.hash.compare_exchange_strong(
+            current, hash, std::memory_order_acq_rel)) {
+      std::strncpy(slot.name, name, kMaxNameLength);
+      slot.name[kMaxNameLength] = '\0';
+      slot.ready.store(true, std::memory_order_release);
+      return static_cast<int32_t>(index);
+    }
+    if (current == hash) {
+      // The thread that claimed the slot is copying the name.
+      while (!slot.ready.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      if (std::strncmp(slot.name, name, kMaxNameLength) == 0) {
+        return static_cast<int32_t>(index);
+      }
+    }
+  }
+  num_dropped_names_.fetch_add(1, std::memory_order_relaxed);
+  return -1;
+}
+
+void RingBufferEventTracer::record(RingBufferEvent& event) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  do {
+    // Acquire pairs with the release in flush() so that the slot is not
+    // overwritten while it is being copied out.
+    if (head - tail_.load(std::memory_order_acquire) >= capacity_) {
+      num_dropped_events_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!head_.compare_exchange_weak(
+      head, head + 1, std::memory_order_relaxed));
+
+  const size_t index = head & (capacity_ - 1);
+  event.sequence = head;
+  events_[index] = event;
+  published_[index].store(head + 1, std::memory_order_release);
+}
+
+Error RingBufferEventTracer::write_chunk_locked(
+    RingBufferChunkHeader::Type type,
+    size_t count) {
+  RingBufferChunkHeader header{};
+  std::memcpy(
+      header.magic, RingBufferChunkHeader::kMagic, sizeof(header.magic));
+  header.version = RingBufferChunkHeader::kVersion;
+  header.type = type;
+  header.count = static_cast<uint32_t>(count);
+  header.num_dropped_events = get_num_dropped_events();
+  std::memcpy(staging_.get(), &header, sizeof(header));
+  Result<size_t> offset =
+      data_sink_->write(staging_.get(), kRecordSize * (count + 1));
+  return offset.error();
+}
+
+Error RingBufferEventTracer::write_new_names_locked() {
+  size_t count = 0;
+  for (size_t i = 0; i < max_names_; ++i) {
+    if (name_written_[i] || !names_[i].ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+    RingBufferName entry{};
+    entry.id = static_cast<int32_t>(i);
+    std::memcpy(entry.name, names_[i].name, sizeof(entry.name));
+    std::memcpy(
+        staging_.get() + kRecordSize * (count + 1), &entry, sizeof(entry));
+    name_written_[i] = true;
+    if (++count == chunk_size_) {
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          write_chunk_locked(RingBufferChunkHeader::Type::Names, count));
+      count = 0;
+    }
+  }
+  if (count > 0) {
+    return write_chunk_locked(RingBufferChunkHeader::Type::Names, count);
+  }
+  return Error::Ok;
+}
+
+Result<size_t> RingBufferEventTracer::flush() {
+  std::lock_guard<std::mutex> lock(flush_mutex_);
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  size_t num_written = 0;
+  while (tail < head) {
+    // Count the published events in sequence order, stopping at the first one
+    // that is still being written.
+    size_t count = 0;
+    while (count < chunk_size_ && tail + count < head) {
+      const uint64_t sequence = tail + count;
+      const size_t index = sequence & (capacity_ - 1);
+      if (published_[index].load(std::memory_order_acquire) != sequence + 1) {
+        break;
+      }
+      ++count;
+    }
+    if (count == 0) {
+      break;
+    }
+    // Every name these events use was ready before they were published, so
+    // this writes any that the sink has not seen.
+    ET_CHECK_OK_OR_RETURN_ERROR(write_new_names_locked());
+
+    for (size_t i = 0; i < count; ++i) {
+      std::memcpy(
+          staging_.get() + kRecordSize * (i + 1),
+          &events_[(tail + i) & (capacity_ - 1)],
+          kRecordSize);
+    }
+    tail += count;
+    // Release pairs with the acquire in record(): the slots may be reused.
+    tail_.store(tail, std::memory_order_release);
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        write_chunk_locked(RingBufferChunkHeader::Type::Events, count));
+    num_written += count;
+  }
+  return num_written;
+}
+
+Error RingBufferEventTracer::start_background_flush(
+    std::chrono::milliseconds period) {
+  std::lock_guard<std::mutex> lock(background_mutex_);
+  ET_CHECK_OR_RETURN_ERROR(
+      !background_thread_.joinable(),
+      InvalidState,
+      "Background flush is already running");
+  background_stopping_ = false;
+  background_thread_ = std::thread([this, period] {
+    std::unique_lock<std::mutex> thread_lock(background_mutex_);
+    bool stopping = false;
+    while (!stopping) {
+      stopping = background_stop_.wait_for(
+          thread_lock, period, [this] { return background_stopping_; });
+      thread_lock.unlock();
+      Result<size_t> flushed = flush();
+      if (!flushed.ok()) {
+        ET_LOG(
+            Error,
+            "Background flush failed: 0x%" PRIx32,
+            static_cast<uint32_t>(flushed.error()));
+      }
+      thread_lock.lock();
+    }
+  });
+  return Error::Ok;
+}
+
+void RingBufferEventTracer::stop_background_flush() {
+  std::unique_lock<std::mutex> lock(background_mutex_);
+  if (!background_thread_.joinable()) {
+    return;
+  }
+  background_stopping_ = true;
+  background_stop_.notify_all();
+  std::thread thread = std::move(background_thread_);
+  // The thread needs the lock to notice the stop and finish its last flush.
+  lock.unlock();
+  thread.join();
+}
+
+void RingBufferEventTracer::create_event_block(const char* name) {
+  RingBufferEvent event = make_event(RingBufferEventKind::Block);
+  event.block = num_blocks_.fetch_add(1, std::memory_order_relaxed);
+  event.start_time = runtime::pal_current_ticks();
+  event.end_time = event.start_time;
+  event.name_id = intern(name);
+  record(event);
+}
+
+EventTracerEntry RingBufferEventTracer::start_profiling(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle) {
+  EventTracerEntry prof_entry;
+  prof_entry.event_id = intern(name);
+  prof_entry.delegate_event_id_type = DelegateDebugIdType::kNone;
+  if (chain_id == -1) {
+    prof_entry.chain_id = chain_id_;
+    prof_entry.debug_handle = debug_handle_;
+  } else {
+    prof_entry.chain_id = chain_id;
+    prof_entry.debug_handle = debug_handle;
+  }
+  prof_entry.start_time = runtime::pal_current_ticks();
+  return prof_entry;
+}
+
+void RingBufferEventTracer::end_profiling(EventTracerEntry prof_entry) {
+  const et_timestamp_t end_time = runtime::pal_current_ticks();
+  ET_CHECK_MSG(
+      prof_entry.delegate_event_id_type == DelegateDebugIdType::kNone,
+      "Delegate events must use end_profiling_delegate to mark the end of a delegate profiling event.");
+  RingBufferEvent event = make_event(RingBufferEventKind::Profile);
+  event.start_time = prof_entry.start_time;
+  event.end_time = end_time;
+  event.chain_id = prof_entry.chain_id;
+  event.debug_handle = prof_entry.debug_handle;
+  event.name_id = static_cast<int32_t>(prof_entry.event_id);
+  event.block = num_blocks_.load(std::memory_order_relaxed) - 1;
+  record(event);
+}
+
+EventTracerEntry RingBufferEventTracer::start_profiling_delegate(
+    const char* name,
+    DelegateDebugIntId delegate_debug_index) {
+  ET_CHECK_MSG(
+      (name == nullptr) ^ (delegate_debug_index == kUnsetDelegateDebugIntId),
+      "Only name or delegate_debug_index can be valid. Check DelegateMappingBuilder documentation for more details.");
+  EventTracerEntry prof_entry;
+  prof_entry.delegate_event_id_type =
+      name == nullptr ? DelegateDebugIdType::kInt : DelegateDebugIdType::kStr;
+  prof_entry.chain_id = chain_id_;
+  prof_entry.debug_handle = debug_handle_;
+  prof_entry.event_id =
+      name == nullptr ? delegate_debug_index : intern(name);
+  prof_entry.start_time = runtime::pal_current_ticks();
+  return prof_entry;
+}
+
+void RingBufferEventTracer::end_profiling_delegate(
+    EventTracerEntry prof_entry,
+    ET_UNUSED const void* metadata,
+    ET_UNUSED size_t metadata_len) {
+  const et_timestamp_t end_time = runtime::pal_current_ticks();
+  RingBufferEvent event = make_event(RingBufferEventKind::DelegateProfile);
+  event.start_time = prof_entry.start_time;
+  event.end_time = end_time;
+  event.chain_id = prof_entry.chain_id;
+  event.debug_handle = prof_entry.debug_handle;
+  if (prof_entry.delegate_event_id_type == DelegateDebugIdType::kInt) {
+    event.value = prof_entry.event_id;
+  } else {
+    event.name_id = static_cast<int32_t>(prof_entry.event_id);
+  }
+  event.block = num_blocks_.load(std::memory_order_relaxed) - 1;
+  record(event);
+}
+
+void RingBufferEventTracer::log_profiling_delegate(
+    const char* name,
+    DelegateDebugIntId delegate_debug_index,
+    et_timestamp_t start_time,
+    et_timestamp_t end_time,
+    ET_UNUSED const void* metadata,
+    ET_UNUSED size_t metadata_len) {
+  ET_CHECK_MSG(
+      (name == nullptr) ^ (delegate_debug_index == kUnsetDelegateDebugIntId),
+      "Only name or delegate_debug_index can be valid. Check DelegateMappingBuilder documentation for more details.");
+  RingBufferEvent event = make_event(RingBufferEventKind::DelegateProfile);
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.chain_id = chain_id_;
+  event.debug_handle = debug_handle_;
+  if (name == nullptr) {
+    event.value = delegate_debug_index;
+  } else {
+    event.name_id = intern(name);
+  }
+  event.block = num_blocks_.load(std::memory_order_relaxed) - 1;
+  record(event);
+}
+
+AllocatorID RingBufferEventTracer::track_allocator(const char* name) {
+  // Ids start at 1, as in ETDumpGen.
+  const AllocatorID id =
+      num_allocators_.fetch_add(1, std::memory_order_relaxed) + 1;
+  RingBufferEvent event = make_event(RingBufferEventKind::Allocator);
+  event.allocator_id = id;
+  event.name_id = intern(name);
+  event.block = num_blocks_.load(std::memory_order_relaxed) - 1;
+  record(event);
+  return id;
+}
+
+void RingBufferEventTracer::track_allocation(AllocatorID id, size_t size) {
+  RingBufferEvent event = make_event(RingBufferEventKind::Allocation);
+  event.start_time = runtime::pal_current_ticks();
+  event.end_time = event.start_time;
+  event.allocator_id = id;
+  event.value = static_cast<int64_t>(size);
+  event.block = num_blocks_.load(std::memory_order_relaxed) - 1;
+  record(event);
+}
+
+Result<bool> RingBufferEventTracer::log_evalue(
+    ET_UNUSED const EValue& evalue,
+    ET_UNUSED LoggedEValueType evalue_type) {
+  return false;
+}
+
+Result<bool> RingBufferEventTracer::log_intermediate_output_delegate(
+    ET_UNUSED const char* name,
+    ET_UNUSED DelegateDebugIntId delegate_debug_index,
+    ET_UNUSED const Tensor& output) {
+  return false;
+}
+
+Result<bool> RingBufferEventTracer::log_intermediate_output_delegate(
+    ET_UNUSED const char* name,
+    ET_UNUSED DelegateDebugIntId delegate_debug_index,
+    ET_UNUSED const ArrayRef<Tensor> output) {
+  return false;
+}
+
+Result<bool> RingBufferEventTracer::log_intermediate_output_delegate(
+    ET_UNUSED const char* name,
+    ET_UNUSED DelegateDebugIntId delegate_debug_index,
+    ET_UNUSED const int& output) {
+  return false;
+}
+
+Result<bool> RingBufferEventTracer::log_intermediate_output_delegate(
+    ET_UNUSED const char* name,
+    ET_UNUSED DelegateDebugIntId delegate_debug_index,
+    ET_UNUSED const bool& output) {
+  return false;
+}
+
+Result<bool> RingBufferEventTracer::log_intermediate_output_delegate(
+    ET_UNUSED const char* name,
+    ET_UNUSED DelegateDebugIntId delegate_debug_index,
+    ET_UNUSED const double& output) {
+  return false;
+}
+
+void RingBufferEventTracer::set_delegation_intermediate_output_filter(
+    ET_UNUSED EventTracerFilterBase* event_tracer_filter) {}
+
+} // namespace etdump
+} // namespace executorch
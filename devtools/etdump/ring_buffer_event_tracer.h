@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <executorch/devtools/etdump/data_sinks/data_sink_base.h>
+#include <executorch/runtime/core/event_tracer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace etdump {
+
+/// The kind of a RingBufferEvent, which decides how its fields are used.
+enum class RingBufferEventKind : uint32_t {
+  /// create_event_block(): `name_id` names the new block.
+  Block = 0,
+  /// end_profiling(): `name_id` is -1 if the event has no name.
+  Profile = 1,
+  /// A delegate event: `value` holds the integer delegate debug id, or is -1
+  /// and `name_id` names the event.
+  DelegateProfile = 2,
+  /// track_allocator(): `allocator_id` is the new id and `name_id` its name.
+  Allocator = 3,
+  /// track_allocation(): `value` bytes from allocator `allocator_id`.
+  Allocation = 4,
+};
+
+/**
+ * A fixed-size event record, as written to the data sink. Timestamps are in
+ * ticks of runtime::pal_current_ticks().
+ */
+struct RingBufferEvent {
+  /// Position of the event in the order in which events were recorded.
+  /// Dropped events are not numbered; see
+  /// RingBufferChunkHeader::num_dropped_events.
+  uint64_t sequence;
+  int64_t start_time;
+  int64_t end_time;
+  int64_t value;
+  int32_t chain_id;
+  uint32_t debug_handle;
+  /// Index into the names written to the sink, or -1.
+  int32_t name_id;
+  /// Index of the event block the event belongs to, or UINT32_MAX before the
+  /// first block.
+  uint32_t block;
+  RingBufferEventKind kind;
+  uint32_t allocator_id;
+  uint32_t reserved[2];
+};
+static_assert(sizeof(RingBufferEvent) == 64, "Events are one cache line");
+
+/// An entry of the name table, as written to the data sink.
+struct RingBufferName {
+  int32_t id;
+  /// Null-terminated, and truncated to fit.
+  char name[60];
+};
+static_assert(sizeof(RingBufferName) == 64, "Names are one cache line");
+
+/**
+ * Precedes each chunk of events or names written to the data sink. A stream
+ * is a sequence of chunks; names are always written before the first event
+ * that refers to them.
+ */
+struct RingBufferChunkHeader {
+  static constexpr char kMagic[4] = {'E', 'T', 'R', 'B'};
+  static constexpr uint32_t kVersion = 1;
+
+  enum class Type : uint32_t {
+    Events = 0,
+    Names = 1,
+  };
+
+  char magic[4];
+  uint32_t version;
+  Type type;
+  /// Number of 64-byte records that follow this header.
+  uint32_t count;
+  /// Total events dropped so far because the ring was full.
+  uint64_t num_dropped_events;
+  uint8_t reserved[40];
+};
+static_assert(sizeof(RingBufferChunkHeader) == 64, "Headers are 64 bytes");
+
+/**
+ * An EventTracer for long-running profiling sessions. Unlike ETDumpGen, which
+ * builds a single ETDump that can only be read at the end and whose buffer
+ * grows with the session, this tracer records profiling events into a
+ * fixed-capacity ring of RingBufferEvents and streams them to a DataSinkBase
+ * in chunks, either on an explicit flush() or periodically from a background
+ * thread.
+ *
+ * Recording an event is lock-free and may happen on any thread: it claims a
+ * slot with a compare-and-swap and publishes it with a release store. When
+ * the ring is full, new events are dropped and counted rather than blocking
+ * the caller. Names are interned into a fixed-size table the first time they
+ * are seen, so an event stores a name id rather than a copy of the string.
+ *
+ * Only profiling and allocation events are recorded. Delegate metadata,
+ * logged EValues and intermediate outputs are ignored; use ETDumpGen to
+ * capture those.
+ */
+class RingBufferEventTracer final : public ::executorch::runtime::EventTracer {
+ public:
+  static constexpr size_t kDefaultCapacity = 64 * 1024;
+  static constexpr size_t kDefaultChunkSize = 1024;
+  static constexpr size_t kDefaultMaxNames = 1024;
+
+  /**
+   * @param[in] data_sink Where flushed events are written. Must outlive this
+   *     tracer.
+   * @param[in] capacity Number of events the ring holds. Must be a power of
+   *     two; aborts otherwise.
+   * @param[in] chunk_size Maximum number of records per write to the sink.
+   * @param[in] max_names Number of distinct names that can be interned. Must
+   *     be a power of two; aborts otherwise.
+   */
+  explicit RingBufferEventTracer(
+      DataSinkBase* data_sink,
+      size_t capacity = kDefaultCapacity,
+      size_t chunk_size = kDefaultChunkSize,
+      size_t max_names = kDefaultMaxNames);
+
+  // Not copyable or movable: producers hold pointers into the ring.
+  RingBufferEventTracer(const RingBufferEventTracer&) = delete;
+  RingBufferEventTracer& operator=(const RingBufferEventTracer&) = delete;
+  RingBufferEventTracer(RingBufferEventTracer&&) = delete;
+  RingBufferEventTracer& operator=(RingBufferEventTracer&&) = delete;
+
+  /// Stops the background flush, if any, which flushes once more.
+  ~RingBufferEventTracer() override;
+
+  /**
+   * Writes the events recorded so far to the data sink, preceded by any names
+   * they use that were not written yet. Events that are still being recorded
+   * by other threads are left for the next flush. Thread-safe.
+   *
+   * @returns The number of events written, or the error from the data sink.
+   *     Events that were taken off the ring before a failed write are lost.
+   */
+  ::executorch::runtime::Result<size_t> flush();
+
+  /**
+   * Starts a thread that calls flush() every `period`, and once more when it
+   * is stopped. Returns InvalidState if a background flush is running.
+   */
+  ::executorch::runtime::Error start_background_flush(
+      std::chrono::milliseconds period);
+
+  /// Stops the background flush after a last flush. No-op if none runs.
+  void stop_background_flush();
+
+  /// Number of events dropped because the ring was full.
+  size_t get_num_dropped_events() const {
+    return num_dropped_events_.load(std::memory_order_relaxed);
+  }
+
+  /// Number of names that did not fit in the name table.
+  size_t get_num_dropped_names() const {
+    return num_dropped_names_.load(std::memory_order_relaxed);
+  }
+
+  void create_event_block(const char* name) override;
+  ::executorch::runtime::EventTracerEntry start_profiling(
+      const char* name,
+      ::executorch::runtime::ChainID chain_id = -1,
+      ::executorch::runtime::DebugHandle debug_handle = 0) override;
+  void end_profiling(::executorch::runtime::EventTracerEntry prof_entry)
+      override;
+  ::executorch::runtime::EventTracerEntry start_profiling_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index) override;
+  void end_profiling_delegate(
+      ::executorch::runtime::EventTracerEntry prof_entry,
+      const void* metadata,
+      size_t metadata_len) override;
+  void log_profiling_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time,
+      const void* metadata,
+      size_t metadata_len) override;
+  void track_allocation(::executorch::runtime::AllocatorID id, size_t size)
+      override;
+  ::executorch::runtime::AllocatorID track_allocator(const char* name) override;
+
+  ::executorch::runtime::Result<bool> log_evalue(
+      const ::executorch::runtime::EValue& evalue,
+      ::executorch::runtime::LoggedEValueType evalue_type) override;
+  ::executorch::runtime::Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      const executorch::aten::Tensor& output) override;
+  ::executorch::runtime::Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      const ::executorch::runtime::ArrayRef<executorch::aten::Tensor> output)
+      override;
+  ::executorch::runtime::Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      const int& output) override;
+  ::executorch::runtime::Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      const bool& output) override;
+  ::executorch::runtime::Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DelegateDebugIntId delegate_debug_index,
+      const double& output) override;
+  void set_delegation_intermediate_output_filter(
+      ::executorch::runtime::EventTracerFilterBase* event_tracer_filter)
+      override;
+
+ private:
+  struct NameSlot {
+    /// Hash of the name, or 0 if the slot is free.
+    std::atomic<uint64_t> hash{0};
+    /// Set once `name` has been written.
+    std::atomic<bool> ready{false};
+    char name[sizeof(RingBufferName::name)];
+  };
+
+  /// Returns the id of `name`, adding it to the table if needed, or -1.
+  int32_t intern(const char* name);
+
+  /// Records `event` unless the ring is full. Fills in its sequence number.
+  void record(RingBufferEvent& event);
+
+  /// Writes a chunk of `count` records staged after the header. Must hold
+  /// flush_mutex_.
+  ::executorch::runtime::Error write_chunk_locked(
+      RingBufferChunkHeader::Type type,
+      size_t count);
+
+  /// Writes the names that became ready since the last call. Must hold
+  /// flush_mutex_.
+  ::executorch::runtime::Error write_new_names_locked();
+
+  DataSinkBase* const data_sink_;
+  const size_t capacity_;
+  const size_t chunk_size_;
+  const size_t max_names_;
+
+  const std::unique_ptr<RingBufferEvent[]> events_;
+  /// published_[i] is the sequence number plus one of the event in events_[i]
+  /// once it has been written, so that a stale value never matches.
+  const std::unique_ptr<std::atomic<uint64_t>[]> published_;
+  const std::unique_ptr<NameSlot[]> names_;
+
+  /// Sequence number of the next event to record.
+  alignas(64) std::atomic<uint64_t> head_{0};
+  /// Sequence number of the next event to flush.
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  std::atomic<uint32_t> num_blocks_{0};
+  std::atomic<uint32_t> num_allocators_{0};
+  std::atomic<size_t> num_dropped_events_{0};
+  std::atomic<size_t> num_dropped_names_{0};
+
+  std::mutex flush_mutex_;
+  /// A header followed by up to chunk_size_ records. Guarded by flush_mutex_.
+  const std::unique_ptr<uint8_t[]> staging_;
+  /// Whether each name slot was written to the sink. Guarded by flush_mutex_.
+  const std::unique_ptr<bool[]> name_written_;
+
+  std::mutex background_mutex_;
+  std::condition_variable background_stop_;
+  bool background_stopping_ = false;
+  std::thread background_thread_;
+};
+
+} // namespace etdump
+} // namespace executorch
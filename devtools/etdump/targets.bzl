@@ -150,3 +150,24 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
         )
+
+        runtime.cxx_library(
+            name = "ring_buffer_event_tracer" + aten_suffix,
+            srcs = [
+                "ring_buffer_event_tracer.cpp",
+            ],
+            exported_headers = [
+                "ring_buffer_event_tracer.h",
+            ],
+            deps = [
+                "//executorch/runtime/platform:platform",
+            ],
+            exported_deps = [
+                "//executorch/devtools/etdump/data_sinks:data_sink_base" + aten_suffix,
+                "//executorch/runtime/core:event_tracer" + aten_suffix,
+            ],
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
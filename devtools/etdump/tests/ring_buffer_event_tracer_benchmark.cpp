@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Measures the cost of recording a profiling event with RingBufferEventTracer:
+ * a start_profiling() and end_profiling() pair, from 1 to `max_threads`
+ * threads at once, while a background thread flushes to a sink that discards
+ * its input. Reports the average time per event on each thread and the number
+ * of events dropped because the flush could not keep up.
+ *
+ * The "ticks only" row is the cost of the two timestamps that any tracer takes
+ * per event, as a lower bound.
+ *
+ * Usage: ring_buffer_event_tracer_benchmark [events_per_thread] [max_threads]
+ */
+
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+#include <executorch/runtime/platform/platform.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using executorch::etdump::DataSinkBase;
+using executorch::etdump::RingBufferEventTracer;
+using executorch::runtime::EventTracerEntry;
+using executorch::runtime::Result;
+
+namespace {
+
+class NullDataSink final : public DataSinkBase {
+ public:
+  Result<size_t> write(const void* ptr, size_t length) override {
+    (void)ptr;
+    const size_t offset = used_bytes_;
+    used_bytes_ += length;
+    return offset;
+  }
+
+  size_t get_used_bytes() const override {
+    return used_bytes_;
+  }
+
+ private:
+  size_t used_bytes_ = 0;
+};
+
+const char* const kNames[] = {
+    "native_call_add.out",
+    "native_call_mul.out",
+    "native_call_convolution.out",
+    "native_call_linear.out",
+};
+
+/// Calls `body(thread_index, event_index)` `events_per_thread` times on each
+/// of `num_threads` threads and returns the average time per call, in ns.
+template <typename Body>
+double run(size_t num_threads, size_t events_per_thread, Body body) {
+  std::atomic<size_t> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<double> ns_per_event(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      ready.fetch_add(1);
+      while (!go.load()) {
+      }
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < events_per_thread; ++i) {
+        body(t, i);
+      }
+      const auto end = std::chrono::steady_clock::now();
+      ns_per_event[t] =
+          std::chrono::duration<double, std::nano>(end - start).count() /
+          events_per_thread;
+    });
+  }
+  while (ready.load() < num_threads) {
+  }
+  go.store(true);
+  double total = 0;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads[t].join();
+    total += ns_per_event[t];
+  }
+  return total / num_threads;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  executorch::runtime::runtime_init();
+  const size_t events_per_thread =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const size_t max_threads = argc > 2
+      ? std::strtoull(argv[2], nullptr, 10)
+      : std::max(1u, std::thread::hardware_concurrency());
+
+  std::printf(
+      "%-12s %8s %12s %12s\n", "mode", "threads", "ns/event", "dropped");
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    std::atomic<et_timestamp_t> sink{0};
+    const double ns = run(threads, events_per_thread, [&](size_t, size_t) {
+      const et_timestamp_t start = executorch::runtime::pal_current_ticks();
+      const et_timestamp_t end = executorch::runtime::pal_current_ticks();
+      sink.fetch_add(end - start, std::memory_order_relaxed);
+    });
+    std::printf("%-12s %8zu %12.1f %12s\n", "ticks only", threads, ns, "-");
+  }
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    NullDataSink sink;
+    RingBufferEventTracer tracer(&sink);
+    tracer.start_background_flush(std::chrono::milliseconds(1));
+    tracer.create_event_block("benchmark");
+    const double ns = run(threads, events_per_thread, [&](size_t t, size_t i) {
+      EventTracerEntry entry = tracer.start_profiling(
+          kNames[i % 4], static_cast<int32_t>(t), static_cast<uint32_t>(i));
+      tracer.end_profiling(entry);
+    });
+    tracer.stop_background_flush();
+    std::printf(
+        "%-12s %8zu %12.1f %12zu\n",
+        "ring buffer",
+        threads,
+        ns,
+        tracer.get_num_dropped_events());
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/ring_buffer_event_tracer.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::etdump::DataSinkBase;
+using executorch::etdump::RingBufferChunkHeader;
+using executorch::etdump::RingBufferEvent;
+using executorch::etdump::RingBufferEventKind;
+using executorch::etdump::RingBufferEventTracer;
+using executorch::etdump::RingBufferName;
+using executorch::runtime::Error;
+using executorch::runtime::EventTracerEntry;
+using executorch::runtime::kUnsetDelegateDebugIntId;
+using executorch::runtime::Result;
+
+namespace {
+
+/// Keeps everything written to it, and fails writes once `fail` is set.
+class VectorDataSink final : public DataSinkBase {
+ public:
+  Result<size_t> write(const void* ptr, size_t length) override {
+    if (fail) {
+      return Error::OutOfResources;
+    }
+    const size_t offset = data.size();
+    const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+    data.insert(data.end(), bytes, bytes + length);
+    ++num_writes;
+    return offset;
+  }
+
+  size_t get_used_bytes() const override {
+    return data.size();
+  }
+
+  std::vector<uint8_t> data;
+  size_t num_writes = 0;
+  bool fail = false;
+};
+
+/// The decoded contents of a stream.
+struct Stream {
+  std::vector<RingBufferEvent> events;
+  std::map<int32_t, std::string> names;
+  uint64_t num_dropped_events = 0;
+};
+
+Stream parse(const std::vector<uint8_t>& data) {
+  Stream stream;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    RingBufferChunkHeader header;
+    std::memcpy(&header, data.data() + offset, sizeof(header));
+    EXPECT_EQ(std::memcmp(header.magic, "ETRB", 4), 0);
+    EXPECT_EQ(header.version, RingBufferChunkHeader::kVersion);
+    offset += sizeof(header);
+    for (uint32_t i = 0; i < header.count; ++i, offset += 64) {
+      if (header.type == RingBufferChunkHeader::Type::Names) {
+        RingBufferName name;
+        std::memcpy(&name, data.data() + offset, sizeof(name));
+        stream.names[name.id] = name.name;
+      } else {
+        RingBufferEvent event;
+        std::memcpy(&event, data.data() + offset, sizeof(event));
+        // Names come before the events that use them.
+        if (event.name_id != -1) {
+          EXPECT_EQ(stream.names.count(event.name_id), 1);
+        }
+        stream.events.push_back(event);
+      }
+    }
+    stream.num_dropped_events = header.num_dropped_events;
+  }
+  EXPECT_EQ(offset, data.size());
+  return stream;
+}
+
+} // namespace
+
+class RingBufferEventTracerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+
+  VectorDataSink sink_;
+};
+
+TEST_F(RingBufferEventTracerTest, FlushStreamsEventsInChunks) {
+  RingBufferEventTracer tracer(
+      &sink_, /*capacity=*/64, /*chunk_size=*/4, /*max_names=*/16);
+  tracer.create_event_block("block");
+  for (int i = 0; i < 10; ++i) {
+    EventTracerEntry entry = tracer.start_profiling("op", /*chain_id=*/1, i);
+    tracer.end_profiling(entry);
+  }
+  EventTracerEntry delegate =
+      tracer.start_profiling_delegate(nullptr, /*delegate_debug_index=*/7);
+  tracer.end_profiling_delegate(delegate, nullptr, 0);
+  tracer.log_profiling_delegate(
+      "delegate_op", kUnsetDelegateDebugIntId, 5, 9, nullptr, 0);
+
+  Result<size_t> flushed = tracer.flush();
+  ASSERT_EQ(flushed.error(), Error::Ok);
+  EXPECT_EQ(flushed.get(), 13);
+  // One chunk of names, then 13 events in chunks of at most 4.
+  EXPECT_EQ(sink_.num_writes, 5);
+
+  Stream stream = parse(sink_.data);
+  ASSERT_EQ(stream.events.size(), 13);
+  EXPECT_EQ(stream.num_dropped_events, 0);
+  for (size_t i = 0; i < stream.events.size(); ++i) {
+    EXPECT_EQ(stream.events[i].sequence, i);
+    EXPECT_EQ(stream.events[i].block, 0);
+  }
+  EXPECT_EQ(stream.events[0].kind, RingBufferEventKind::Block);
+  EXPECT_EQ(stream.names[stream.events[0].name_id], "block");
+
+  const RingBufferEvent& op = stream.events[4];
+  EXPECT_EQ(op.kind, RingBufferEventKind::Profile);
+  EXPECT_EQ(stream.names[op.name_id], "op");
+  EXPECT_EQ(op.chain_id, 1);
+  EXPECT_EQ(op.debug_handle, 3);
+  EXPECT_LE(op.start_time, op.end_time);
+
+  EXPECT_EQ(stream.events[11].kind, RingBufferEventKind::DelegateProfile);
+  EXPECT_EQ(stream.events[11].value, 7);
+  EXPECT_EQ(stream.events[11].name_id, -1);
+  EXPECT_EQ(stream.names[stream.events[12].name_id], "delegate_op");
+  EXPECT_EQ(stream.events[12].start_time, 5);
+  EXPECT_EQ(stream.events[12].end_time, 9);
+
+  // Nothing new to write.
+  EXPECT_EQ(tracer.flush().get(), 0);
+  EXPECT_EQ(sink_.num_writes, 5);
+}
+
+TEST_F(RingBufferEventTracerTest, FullRingDropsNewEvents) {
+  RingBufferEventTracer tracer(
+      &sink_, /*capacity=*/8, /*chunk_size=*/8, /*max_names=*/16);
+  tracer.create_event_block("block");
+  for (int i = 0; i < 11; ++i) {
+    tracer.track_allocation(/*id=*/1, /*size=*/i);
+  }
+  EXPECT_EQ(tracer.get_num_dropped_events(), 4);
+  ASSERT_EQ(tracer.flush().get(), 8);
+
+  // Flushing made room again.
+  tracer.track_allocation(/*id=*/1, /*size=*/100);
+  ASSERT_EQ(tracer.flush().get(), 1);
+
+  Stream stream = parse(sink_.data);
+  ASSERT_EQ(stream.events.size(), 9);
+  EXPECT_EQ(stream.num_dropped_events, 4);
+  EXPECT_EQ(stream.events[7].value, 6);
+  // The sequence number does not count dropped events.
+  EXPECT_EQ(stream.events[8].sequence, 8);
+  EXPECT_EQ(stream.events[8].kind, RingBufferEventKind::Allocation);
+  EXPECT_EQ(stream.events[8].allocator_id, 1);
+  EXPECT_EQ(stream.events[8].value, 100);
+}
+
+TEST_F(RingBufferEventTracerTest, NamesAreInternedOnce) {
+  RingBufferEventTracer tracer(
+      &sink_, /*capacity=*/64, /*chunk_size=*/16, /*max_names=*/2);
+  EXPECT_EQ(tracer.track_allocator("a"), 1);
+  EXPECT_EQ(tracer.track_allocator("a"), 2);
+  EXPECT_EQ(tracer.track_allocator("b"), 3);
+  // The table is full.
+  EXPECT_EQ(tracer.track_allocator("c"), 4);
+  EXPECT_EQ(tracer.get_num_dropped_names(), 1);
+  const std::string long_name(100, 'x');
+  tracer.track_allocator(long_name.c_str());
+  ASSERT_EQ(tracer.flush().get(), 5);
+
+  Stream stream = parse(sink_.data);
+  EXPECT_EQ(stream.names.size(), 2);
+  ASSERT_EQ(stream.events.size(), 5);
+  EXPECT_EQ(stream.events[0].name_id, stream.events[1].name_id);
+  EXPECT_EQ(stream.names[stream.events[2].name_id], "b");
+  EXPECT_EQ(stream.events[3].name_id, -1);
+  EXPECT_EQ(stream.events[3].allocator_id, 4);
+  EXPECT_EQ(stream.events[4].name_id, -1);
+}
+
+TEST_F(RingBufferEventTracerTest, LongNamesAreTruncated) {
+  RingBufferEventTracer tracer(&sink_, /*capacity=*/8);
+  const std::string long_name(100, 'x');
+  tracer.create_event_block(long_name.c_str());
+  ASSERT_EQ(tracer.flush().get(), 1);
+
+  Stream stream = parse(sink_.data);
+  ASSERT_EQ(stream.events.size(), 1);
+  EXPECT_EQ(
+      stream.names[stream.events[0].name_id],
+      long_name.substr(0, sizeof(RingBufferName::name) - 1));
+}
+
+TEST_F(RingBufferEventTracerTest, ConcurrentProducersWithBackgroundFlush) {
+  constexpr int kThreads = 4;
+  constexpr int kEventsPerThread = 20000;
+  RingBufferEventTracer tracer(
+      &sink_, /*capacity=*/1024, /*chunk_size=*/64, /*max_names=*/16);
+  ASSERT_EQ(
+      tracer.start_background_flush(std::chrono::milliseconds(1)), Error::Ok);
+  EXPECT_EQ(
+      tracer.start_background_flush(std::chrono::milliseconds(1)),
+      Error::InvalidState);
+
+  const char* names[kThreads] = {"t0", "t1", "t2", "t3"};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&tracer, name = names[t], t] {
+      for (int i = 0; i < kEventsPerThread; ++i) {
+        EventTracerEntry entry = tracer.start_profiling(name, t, i);
+        tracer.end_profiling(entry);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  tracer.stop_background_flush();
+
+  Stream stream = parse(sink_.data);
+  const size_t dropped = tracer.get_num_dropped_events();
+  ASSERT_EQ(stream.events.size() + dropped, kThreads * kEventsPerThread);
+  EXPECT_EQ(stream.num_dropped_events, dropped);
+
+  // Events keep their order within a thread, and the ring hands out
+  // sequence numbers without gaps.
+  std::vector<int64_t> last_handle(kThreads, -1);
+  for (size_t i = 0; i < stream.events.size(); ++i) {
+    const RingBufferEvent& event = stream.events[i];
+    ASSERT_EQ(event.sequence, i);
+    ASSERT_GE(event.chain_id, 0);
+    ASSERT_LT(event.chain_id, kThreads);
+    EXPECT_EQ(stream.names[event.name_id], names[event.chain_id]);
+    EXPECT_GT(int64_t(event.debug_handle), last_handle[event.chain_id]);
+    last_handle[event.chain_id] = event.debug_handle;
+  }
+}
+
+TEST_F(RingBufferEventTracerTest, SinkErrorsAreReported) {
+  RingBufferEventTracer tracer(&sink_, /*capacity=*/8);
+  tracer.create_event_block("block");
+  sink_.fail = true;
+  EXPECT_EQ(tracer.flush().error(), Error::OutOfResources);
+}
@@ -33,3 +33,25 @@ def define_common_targets():
             "//executorch/runtime/platform:platform",
         ],
     )
+
+    runtime.cxx_test(
+        name = "ring_buffer_event_tracer_test",
+        srcs = [
+            "ring_buffer_event_tracer_test.cpp",
+        ],
+        deps = [
+            "//executorch/devtools/etdump:ring_buffer_event_tracer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
+
+    runtime.cxx_binary(
+        name = "ring_buffer_event_tracer_benchmark",
+        srcs = [
+            "ring_buffer_event_tracer_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/devtools/etdump:ring_buffer_event_tracer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
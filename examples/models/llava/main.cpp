@@ -44,6 +44,11 @@ DEFINE_int32(
     -1,
     "Number of CPU threads for inference. Defaults to -1, which implies we'll use a heuristic to derive the # of performant cores for a specific device.");
 
+DEFINE_bool(
+    pipelined_image_prefill,
+    false,
+    "Encode images on a worker thread while the text before them is prefilled.");
+
 using executorch::extension::llm::Image;
 
 void load_image(const std::string& image_path, Image& image) {
@@ -129,6 +134,7 @@ int32_t main(int32_t argc, char** argv) {
 #endif
   // create llama runner
   example::LlavaRunner runner(model_path, tokenizer_path, temperature);
+  runner.set_pipelined_image_prefill(FLAGS_pipelined_image_prefill);
 
   Image image;
   load_image(image_path, image);
@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
+
 #include <executorch/extension/llm/runner/image_prefiller.h>
 #include <executorch/extension/tensor/tensor.h>
 
@@ -37,22 +40,47 @@ class ET_EXPERIMENTAL LlavaImagePrefiller
     auto image_encoder_outputs =
         ET_UNWRAP(module_->execute(kImageEncoderMethod, image_tensor));
 
-    // inputs:[start_pos, embeds]
-    auto start_pos_tensor = executorch::extension::from_blob(
-        &start_pos, {1}, ::executorch::aten::ScalarType::Long);
-
-    // Run text model
-    auto outputs_res = ET_UNWRAP(module_->execute(
-        kTextModelMethod, {start_pos_tensor, image_encoder_outputs[0]}));
-    ET_CHECK_MSG(
-        outputs_res[0].isTensor(),
-        "Non Tensor Output returned from executing image prefill");
+    return prefill_embeddings(image_encoder_outputs[0], start_pos);
+  }
 
-    // Update the start_pos, which is only available inside this function.
-    // outputs_res can have only one logits.
-    start_pos += image_encoder_outputs[0].toTensor().size(1);
+  /**
+   * Run the image encoder on a Module worker thread. Its instance of the
+   * encoder method is separate from the one prefill() uses, so the text
+   * model can run meanwhile.
+   * @param image The image input to LLaVa. Must stay valid until the
+   * returned future is ready.
+   * @return A deferred future with the image encoder outputs. Wait on it
+   * before dropping it, since the encoder may still be reading the image.
+   */
+  inline std::future<::executorch::runtime::Result<
+      ::executorch::extension::Module::AsyncOutputs>>
+  encode_async(::executorch::extension::llm::Image& image) override {
+    auto image_tensor = executorch::extension::from_blob(
+        image.data.data(),
+        {3, image.height, image.width},
+        ::executorch::aten::ScalarType::Byte);
+    auto encoded =
+        module_->execute_async(kImageEncoderMethod, {image_tensor});
+    // The continuation keeps image_tensor alive until the encoder is done
+    // with it.
+    return std::async(
+        std::launch::deferred,
+        [encoded = std::move(encoded), image_tensor]() mutable {
+          return encoded.get();
+        });
+  }
 
-    return outputs_res[0].toTensor();
+  /**
+   * Prefill an LLM Module with an image encoded by encode_async().
+   * @param encoded The image encoder outputs.
+   * @param start_pos The starting position in KV cache of the input in the LLM
+   * @return logits of the image prefill.
+   */
+  inline ::executorch::runtime::Result<executorch::aten::Tensor>
+  prefill_encoded(
+      const ::executorch::extension::Module::AsyncOutputs& encoded,
+      int64_t& start_pos) override {
+    return prefill_embeddings(encoded[0], start_pos);
   }
 
   /**
@@ -98,6 +126,31 @@ class ET_EXPERIMENTAL LlavaImagePrefiller
 
   inline static const std::string kImageEncoderMethod = "image_encoder";
   inline static const std::string kTextModelMethod = "text_model";
+
+ private:
+  // Run the text model on the image embeddings at start_pos, and advance
+  // start_pos past them.
+  inline ::executorch::runtime::Result<executorch::aten::Tensor>
+  prefill_embeddings(
+      const ::executorch::runtime::EValue& embeddings,
+      int64_t& start_pos) {
+    // inputs:[start_pos, embeds]
+    auto start_pos_tensor = executorch::extension::from_blob(
+        &start_pos, {1}, ::executorch::aten::ScalarType::Long);
+
+    // Run text model
+    auto outputs_res = ET_UNWRAP(
+        module_->execute(kTextModelMethod, {start_pos_tensor, embeddings}));
+    ET_CHECK_MSG(
+        outputs_res[0].isTensor(),
+        "Non Tensor Output returned from executing image prefill");
+
+    // Update the start_pos, which is only available inside this function.
+    // outputs_res can have only one logits.
+    start_pos += embeddings.toTensor().size(1);
+
+    return outputs_res[0].toTensor();
+  }
 };
 
 } // namespace example
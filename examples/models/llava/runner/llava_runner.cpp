@@ -63,6 +63,10 @@ Error LlavaRunner::load() {
   // Load the image prefiller
   image_prefiller_ = std::make_unique<LlavaImagePrefiller>(module_.get());
   image_prefiller_->load();
+  // Pipelined image prefill encodes one image ahead while the previous one
+  // is prefilled, so it needs two encoder instances at most, on one worker.
+  ET_CHECK_OK_OR_RETURN_ERROR(module_->configure_async(
+      {/*num_threads=*/1, /*max_in_flight=*/2}));
 
   // Load the text token generator
   text_token_generator_ = std::make_unique<llm::TextTokenGenerator>(
@@ -87,6 +91,33 @@ Error LlavaRunner::prefill_images(
   return Error::Ok;
 }
 
+Error LlavaRunner::prefill_images(
+    std::vector<llm::Image>& images,
+    int64_t& start_pos,
+    std::future<Result<::executorch::extension::Module::AsyncOutputs>>
+        first_image) {
+  auto encoded = std::move(first_image);
+  for (size_t i = 0; i < images.size(); ++i) {
+    auto outputs = encoded.get();
+    ET_CHECK_OK_OR_RETURN_ERROR(outputs.error());
+    if (i + 1 < images.size()) {
+      // Encode the next image while this one is prefilled.
+      encoded = image_prefiller_->encode_async(images[i + 1]);
+    }
+    // pos is updated inside image prefill.
+    const auto prefill_res =
+        image_prefiller_->prefill_encoded(outputs.get(), start_pos);
+    if (!prefill_res.ok()) {
+      // The encoder may still be reading the next image.
+      if (encoded.valid()) {
+        encoded.wait();
+      }
+      return prefill_res.error();
+    }
+  }
+  return Error::Ok;
+}
+
 Result<uint64_t> LlavaRunner::prefill_prompt(
     const std::string& prompt,
     int64_t& start_pos,
@@ -163,11 +194,29 @@ Error LlavaRunner::generate(
   int64_t pos = 0;
   stats_.inference_start_ms = llm::time_in_ms();
 
+  std::future<Result<::executorch::extension::Module::AsyncOutputs>>
+      first_image;
+  if (pipelined_image_prefill_ && !images.empty()) {
+    // Encode the first image while the preset prompt is prefilled.
+    first_image = image_prefiller_->encode_async(images[0]);
+  }
+
   // prefill preset prompt
-  prefill_prompt(kPresetPrompt, pos, /*bos=*/1, /*eos*/ 0);
+  const auto preset_res =
+      prefill_prompt(kPresetPrompt, pos, /*bos=*/1, /*eos*/ 0);
+  if (!preset_res.ok() && first_image.valid()) {
+    // The encoder may still be reading the first image.
+    first_image.wait();
+  }
+  ET_CHECK_OK_OR_RETURN_ERROR(preset_res.error());
 
   // prefill images
-  prefill_images(images, pos);
+  if (first_image.valid()) {
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        prefill_images(images, pos, std::move(first_image)));
+  } else {
+    ET_CHECK_OK_OR_RETURN_ERROR(prefill_images(images, pos));
+  }
 
   ET_LOG(
       Info,
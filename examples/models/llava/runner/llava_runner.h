@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -63,6 +64,14 @@ class ET_EXPERIMENTAL LlavaRunner
       bool echo = true) override;
 
  private:
+  // Prefill images while the next one is encoded. first_image is the
+  // pending encoding of images[0].
+  ::executorch::runtime::Error prefill_images(
+      std::vector<::executorch::extension::llm::Image>& images,
+      int64_t& start_pos,
+      std::future<::executorch::runtime::Result<
+          ::executorch::extension::Module::AsyncOutputs>> first_image);
+
   inline static const std::string kPresetPrompt =
       "A chat between a curious human and an artificial intelligence assistant. The assistant gives helpful, detailed, and polite answers to the human's questions. USER: ";
 };
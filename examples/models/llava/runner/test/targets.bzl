@@ -0,0 +1,18 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+    runtime.cxx_test(
+        name = "test_llava_runner",
+        srcs = [
+            "test_llava_runner.cpp",
+        ],
+        deps = [
+            "//executorch/examples/models/llava/runner:runner",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+        ],
+    )
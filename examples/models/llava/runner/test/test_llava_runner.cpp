@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/examples/models/llava/runner/llava_runner.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using executorch::extension::Module;
+using executorch::extension::llm::Image;
+using executorch::extension::llm::ImagePrefiller;
+using executorch::extension::llm::Stats;
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int64_t kPromptTokens = 7;
+constexpr int64_t kImageTokens = 100;
+
+// One step of the runner: what was requested, and for KV cache writes, the
+// position they started at.
+struct Event {
+  std::string what;
+  int64_t start_pos;
+
+  bool operator==(const Event& other) const {
+    return what == other.what && start_pos == other.start_pos;
+  }
+};
+
+std::ostream& operator<<(std::ostream& os, const Event& event) {
+  return os << event.what << "@" << event.start_pos;
+}
+
+// Records image encodes and prefills. Images are told apart by their width.
+class StubImagePrefiller : public ImagePrefiller {
+ public:
+  StubImagePrefiller(std::vector<Event>& events, Error encode_error)
+      : ImagePrefiller(nullptr), events_(events), encode_error_(encode_error) {}
+
+  Result<executorch::aten::Tensor> prefill(Image& image, int64_t& start_pos)
+      override {
+    if (encode_error_ != Error::Ok) {
+      return encode_error_;
+    }
+    return prefill_image(image.width, start_pos);
+  }
+
+  std::future<Result<Module::AsyncOutputs>> encode_async(
+      Image& image) override {
+    events_.push_back({"encode image " + std::to_string(image.width), -1});
+    if (encode_error_ == Error::Ok) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      encoded_.push_back(image.width);
+    }
+    return std::async(
+        std::launch::async,
+        [error = encode_error_]() -> Result<Module::AsyncOutputs> {
+          if (error != Error::Ok) {
+            return error;
+          }
+          return Module::AsyncOutputs();
+        });
+  }
+
+  Result<executorch::aten::Tensor> prefill_encoded(
+      const Module::AsyncOutputs& encoded,
+      int64_t& start_pos) override {
+    (void)encoded;
+    int32_t width = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      width = encoded_.front();
+      encoded_.pop_front();
+    }
+    return prefill_image(width, start_pos);
+  }
+
+  Error load() override {
+    return Error::Ok;
+  }
+
+  bool is_method_loaded() override {
+    return true;
+  }
+
+ private:
+  Result<executorch::aten::Tensor> prefill_image(
+      int32_t width,
+      int64_t& start_pos) {
+    events_.push_back({"image " + std::to_string(width), start_pos});
+    start_pos += kImageTokens;
+    return logits_;
+  }
+
+  std::vector<Event>& events_;
+  const Error encode_error_;
+  std::mutex mutex_;
+  std::deque<int32_t> encoded_;
+  TensorFactory<executorch::aten::ScalarType::Float> tf_;
+  executorch::aten::Tensor logits_ = tf_.zeros({1, 1});
+};
+
+// Runs LlavaRunner::generate() with the stub image prefiller, and text
+// prefill and generation that only record their KV cache positions.
+class TestLlavaRunner : public example::LlavaRunner {
+ public:
+  explicit TestLlavaRunner(Error encode_error = Error::Ok)
+      : LlavaRunner("", "") {
+    image_prefiller_ =
+        std::make_unique<StubImagePrefiller>(events, encode_error);
+  }
+
+  bool is_loaded() override {
+    return true;
+  }
+
+  Result<uint64_t> prefill_prompt(
+      const std::string& prompt,
+      int64_t& start_pos,
+      int8_t bos,
+      int8_t eos) override {
+    (void)eos;
+    events.push_back({bos > 0 ? "preset prompt" : prompt, start_pos});
+    start_pos += kPromptTokens;
+    return 0;
+  }
+
+  Error generate_from_pos(
+      const std::string& prompt,
+      int32_t seq_len,
+      int64_t start_pos,
+      std::function<void(const std::string&)> token_callback,
+      std::function<void(const Stats&)> stats_callback,
+      bool echo) override {
+    (void)seq_len;
+    (void)token_callback;
+    (void)stats_callback;
+    (void)echo;
+    return prefill_prompt(prompt, start_pos, 0, 0).error();
+  }
+
+  std::vector<Event> events;
+};
+
+std::vector<Image> make_images() {
+  std::vector<Image> images(2);
+  images[0].width = 1;
+  images[1].width = 2;
+  for (auto& image : images) {
+    image.height = 1;
+    image.channels = 3;
+    image.data.resize(3 * image.width);
+  }
+  return images;
+}
+
+class LlavaRunnerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+};
+
+} // namespace
+
+TEST_F(LlavaRunnerTest, PipelinedPrefillKeepsPromptOrder) {
+  TestLlavaRunner sequential;
+  ASSERT_EQ(
+      sequential.generate(make_images(), "user prompt", 1024, {}, {}, false),
+      Error::Ok);
+  const std::vector<Event> expected = {
+      {"preset prompt", 0},
+      {"image 1", kPromptTokens},
+      {"image 2", kPromptTokens + kImageTokens},
+      {"user prompt", kPromptTokens + 2 * kImageTokens},
+  };
+  EXPECT_EQ(sequential.events, expected);
+
+  // Each image is encoded before the text or image in front of it is
+  // prefilled, and the KV cache is filled at the same positions.
+  TestLlavaRunner pipelined;
+  pipelined.set_pipelined_image_prefill(true);
+  ASSERT_EQ(
+      pipelined.generate(make_images(), "user prompt", 1024, {}, {}, false),
+      Error::Ok);
+  const std::vector<Event> expected_pipelined = {
+      {"encode image 1", -1},
+      {"preset prompt", 0},
+      {"encode image 2", -1},
+      {"image 1", kPromptTokens},
+      {"image 2", kPromptTokens + kImageTokens},
+      {"user prompt", kPromptTokens + 2 * kImageTokens},
+  };
+  EXPECT_EQ(pipelined.events, expected_pipelined);
+}
+
+TEST_F(LlavaRunnerTest, EncoderErrorReachesGenerate) {
+  for (bool pipelined : {false, true}) {
+    TestLlavaRunner runner(Error::Internal);
+    runner.set_pipelined_image_prefill(pipelined);
+    EXPECT_EQ(
+        runner.generate(make_images(), "user prompt", 1024, {}, {}, false),
+        Error::Internal);
+    // Nothing after the failed image is prefilled.
+    ASSERT_FALSE(runner.events.empty());
+    EXPECT_NE(runner.events.back().what, "user prompt");
+  }
+}
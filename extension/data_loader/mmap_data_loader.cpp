@@ -8,9 +8,11 @@
 
 #include <executorch/extension/data_loader/mmap_data_loader.h>
 
+#include <atomic>
 #include <cerrno>
 #include <cstring>
 #include <limits>
+#include <thread>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -54,6 +56,142 @@ Range get_overlapping_pages(uintptr_t offset, size_t size, size_t page_size) {
   };
 }
 
+using LoadPolicy = MmapDataLoader::LoadPolicy;
+
+/**
+ * Applies the madvise() hints of `policy` to a mapping. Failures are ignored:
+ * the hints only affect performance.
+ */
+void advise(void* pages, size_t size, LoadPolicy policy) {
+  int advice = -1;
+  switch (policy) {
+#if defined(MADV_WILLNEED)
+    case LoadPolicy::WillNeed:
+    case LoadPolicy::HugePage:
+      advice = MADV_WILLNEED;
+      break;
+#endif
+#if defined(MADV_SEQUENTIAL)
+    case LoadPolicy::Sequential:
+      advice = MADV_SEQUENTIAL;
+      break;
+#endif
+    default:
+      break;
+  }
+#if !defined(_WIN32)
+  if (advice != -1 && ::madvise(pages, size, advice) < 0) {
+    ET_LOG(
+        Debug,
+        "madvise(%p, %zu, %d) failed: %s (%d) (ignored)",
+        pages,
+        size,
+        advice,
+        ::strerror(errno),
+        errno);
+  }
+#else
+  (void)pages;
+  (void)size;
+#endif
+}
+
+#if defined(MADV_HUGEPAGE) && defined(MAP_ANONYMOUS) && defined(MAP_FIXED)
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+/**
+ * Maps `size` bytes of `fd` at `offset` at an address that is congruent to
+ * `offset` modulo the huge page size, which is what lets the kernel back a
+ * file mapping with huge pages, and marks the mapping with MADV_HUGEPAGE.
+ */
+void* mmap_huge_page_aligned(
+    size_t size,
+    int flags,
+    int fd,
+    off_t offset,
+    size_t page_size) {
+  // Reserve enough address space to find an aligned start within it.
+  const size_t reserved_size = size + kHugePageSize;
+  void* reserved = ::mmap(
+      nullptr,
+      reserved_size,
+      PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      /*fd=*/-1,
+      /*offset=*/0);
+  if (reserved == MAP_FAILED) {
+    return ::mmap(nullptr, size, PROT_READ, flags, fd, offset);
+  }
+  const uintptr_t base = reinterpret_cast<uintptr_t>(reserved);
+  uintptr_t start = base - base % kHugePageSize + offset % kHugePageSize;
+  if (start < base) {
+    start += kHugePageSize;
+  }
+  void* pages = ::mmap(
+      reinterpret_cast<void*>(start),
+      size,
+      PROT_READ,
+      flags | MAP_FIXED,
+      fd,
+      offset);
+  if (pages == MAP_FAILED) {
+    ::munmap(reserved, reserved_size);
+    return MAP_FAILED;
+  }
+  // Give back the parts of the reservation on either side of the mapping.
+  const uintptr_t end = start + get_overlapping_pages(0, size, page_size).size;
+  if (start > base) {
+    ::munmap(reserved, start - base);
+  }
+  if (base + reserved_size > end) {
+    ::munmap(reinterpret_cast<void*>(end), base + reserved_size - end);
+  }
+  if (::madvise(pages, size, MADV_HUGEPAGE) < 0) {
+    ET_LOG(
+        Debug,
+        "madvise(%p, %zu, MADV_HUGEPAGE) failed: %s (%d) (ignored)",
+        pages,
+        size,
+        ::strerror(errno),
+        errno);
+  }
+  return pages;
+}
+#endif
+
+/**
+ * Touches the pages of a mapping on a background thread. Owned by the
+ * FreeableBuffer of the segment, whose free function stops the thread before
+ * unmapping the pages it reads.
+ */
+class Prefaulter final {
+ public:
+  Prefaulter(const void* pages, size_t size, size_t page_size)
+      : page_size_(page_size), thread_([this, pages, size] {
+          const volatile uint8_t* page =
+              static_cast<const volatile uint8_t*>(pages);
+          for (size_t offset = 0; offset < size && !cancelled_.load();
+               offset += page_size_) {
+            (void)page[offset];
+          }
+        }) {}
+
+  ~Prefaulter() {
+    cancelled_.store(true);
+    thread_.join();
+  }
+
+  size_t page_size() const {
+    return page_size_;
+  }
+
+ private:
+  const size_t page_size_;
+  std::atomic<bool> cancelled_{false};
+  // Declared last so that it starts after the other members are initialized.
+  std::thread thread_;
+};
+
 } // namespace
 
 MmapDataLoader::~MmapDataLoader() {
@@ -69,7 +207,8 @@ MmapDataLoader::~MmapDataLoader() {
 
 Result<MmapDataLoader> MmapDataLoader::from(
     const char* file_name,
-    MmapDataLoader::MlockConfig mlock_config) {
+    MmapDataLoader::MlockConfig mlock_config,
+    const SegmentLoadPolicies& load_policies) {
   // Cache the page size.
   long page_size = get_os_page_size();
   if (page_size < 0) {
@@ -121,7 +260,8 @@ Result<MmapDataLoader> MmapDataLoader::from(
       file_size,
       file_name_copy,
       static_cast<size_t>(page_size),
-      mlock_config);
+      mlock_config,
+      load_policies);
 }
 
 namespace {
@@ -148,6 +288,23 @@ void MunmapSegment(void* context, void* data, size_t size) {
         errno);
   }
 }
+
+/**
+ * FreeableBuffer::FreeFn-compatible callback for segments loaded with
+ * LoadPolicy::BackgroundPrefault.
+ *
+ * `context` is the Prefaulter that reads the segment's pages.
+ */
+void StopPrefaultAndMunmapSegment(void* context, void* data, size_t size) {
+  auto* prefaulter = static_cast<Prefaulter*>(context);
+  const size_t page_size = prefaulter->page_size();
+  delete prefaulter;
+  MunmapSegment(
+      // NOLINTNEXTLINE(performance-no-int-to-ptr)
+      reinterpret_cast<void*>(static_cast<uintptr_t>(page_size)),
+      data,
+      size);
+}
 } // namespace
 
 /**
@@ -179,7 +336,7 @@ Error MmapDataLoader::validate_input(size_t offset, size_t size) const {
 Result<FreeableBuffer> MmapDataLoader::load(
     size_t offset,
     size_t size,
-    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+    const DataLoader::SegmentInfo& segment_info) const {
   // Ensure read range is valid.
   auto validation_err = validate_input(offset, size);
   if (validation_err != Error::Ok) {
@@ -205,15 +362,32 @@ Result<FreeableBuffer> MmapDataLoader::load(
     map_size = file_size_ - range.start;
   }
 
+  const LoadPolicy policy = load_policies_.get(segment_info.segment_type);
+
   // Map the pages read-only. Use shared mappings so that other processes
   // can also map the same pages and share the same memory.
-  void* pages = ::mmap(
-      nullptr,
-      map_size,
-      PROT_READ,
-      MAP_SHARED,
-      fd_,
-      static_cast<off_t>(range.start));
+  int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+  if (policy == LoadPolicy::Populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif
+  void* pages = nullptr;
+#if defined(MADV_HUGEPAGE) && defined(MAP_ANONYMOUS) && defined(MAP_FIXED)
+  if (policy == LoadPolicy::HugePage) {
+    pages = mmap_huge_page_aligned(
+        map_size, flags, fd_, static_cast<off_t>(range.start), page_size_);
+  } else
+#endif
+  {
+    pages = ::mmap(
+        nullptr,
+        map_size,
+        PROT_READ,
+        flags,
+        fd_,
+        static_cast<off_t>(range.start));
+  }
   ET_CHECK_OR_RETURN_ERROR(
       pages != MAP_FAILED,
       AccessFailed,
@@ -254,10 +428,19 @@ Result<FreeableBuffer> MmapDataLoader::load(
     }
     // No need to keep track of this. munmap() will unlock as a side effect.
   }
+  advise(pages, map_size, policy);
 
   // The requested data is at an offset into the mapped pages.
   const void* data = static_cast<const uint8_t*>(pages) + offset - range.start;
 
+  if (policy == LoadPolicy::BackgroundPrefault) {
+    return FreeableBuffer(
+        data,
+        size,
+        StopPrefaultAndMunmapSegment,
+        /*free_fn_context=*/new Prefaulter(pages, map_size, page_size_));
+  }
+
   return FreeableBuffer(
       // The callback knows to unmap the whole pages that encompass this region.
       data,
@@ -282,7 +465,7 @@ Result<size_t> MmapDataLoader::size() const {
 Error MmapDataLoader::load_into(
     size_t offset,
     size_t size,
-    ET_UNUSED const SegmentInfo& segment_info,
+    const SegmentInfo& segment_info,
     void* buffer) const {
   ET_CHECK_OR_RETURN_ERROR(
       buffer != nullptr, InvalidArgument, "Buffer is null");
@@ -312,14 +495,24 @@ Error MmapDataLoader::load_into(
     map_size = file_size_ - range.start;
   }
 
+  // The mapping only lives for the copy below, so only the policies that
+  // speed up a single sequential read apply.
+  const LoadPolicy policy = load_policies_.get(segment_info.segment_type);
+
   // Map the pages read-only. MAP_PRIVATE vs. MAP_SHARED doesn't matter since
   // the data is read-only, but use PRIVATE just to further avoid accidentally
   // modifying the file.
+  int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+  if (policy == LoadPolicy::Populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif
   void* pages = ::mmap(
       nullptr,
       map_size,
       PROT_READ,
-      MAP_PRIVATE,
+      flags,
       fd_,
       static_cast<off_t>(range.start));
   ET_CHECK_OR_RETURN_ERROR(
@@ -331,6 +524,10 @@ Error MmapDataLoader::load_into(
       fd_,
       range.start);
 
+  if (policy == LoadPolicy::WillNeed || policy == LoadPolicy::Sequential) {
+    advise(pages, map_size, policy);
+  }
+
   // Offset into mapped region.
   const size_t map_delta = offset - range.start;
 
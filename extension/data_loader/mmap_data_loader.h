@@ -40,6 +40,76 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
     UseMlockIgnoreErrors,
   };
 
+  /**
+   * Describes when the pages of a loaded segment are read from the file.
+   *
+   * By default pages are faulted in one at a time as they are first touched,
+   * which for weights means during the first execution. The other policies
+   * move that cost to load() or to the background. Policies that the host
+   * does not support fall back to `Lazy`.
+   */
+  enum class LoadPolicy {
+    /// Fault pages in on first access.
+    Lazy,
+    /// Read the whole segment during load(), with `MAP_POPULATE`.
+    Populate,
+    /// Start asynchronous readahead of the whole segment with
+    /// `madvise(MADV_WILLNEED)`, and return without waiting for it.
+    WillNeed,
+    /// Use `madvise(MADV_SEQUENTIAL)` so that each fault reads far ahead.
+    Sequential,
+    /// Map the segment at a huge-page-aligned address and request
+    /// `madvise(MADV_HUGEPAGE)`, then start readahead like `WillNeed`. Huge
+    /// pages for file mappings need kernel support (on Linux,
+    /// CONFIG_READ_ONLY_THP_FOR_FS); without it this acts like `WillNeed`.
+    HugePage,
+    /// Touch every page of the segment on a background thread, so that the
+    /// faults are taken off the calling thread. The thread is stopped when
+    /// the segment is freed.
+    BackgroundPrefault,
+  };
+
+  /**
+   * The LoadPolicy to use for each DataLoader::SegmentInfo::Type, e.g. to
+   * populate constant weights eagerly but leave delegate blobs, which
+   * backends often copy once and discard, to fault in lazily.
+   */
+  struct SegmentLoadPolicies {
+    LoadPolicy program;
+    LoadPolicy constant;
+    LoadPolicy backend;
+    LoadPolicy mutable_data;
+    LoadPolicy external;
+
+    /// Uses `LoadPolicy::Lazy` for every segment type.
+    SegmentLoadPolicies() : SegmentLoadPolicies(LoadPolicy::Lazy) {}
+
+    /// Uses `policy` for every segment type.
+    explicit SegmentLoadPolicies(LoadPolicy policy)
+        : program(policy),
+          constant(policy),
+          backend(policy),
+          mutable_data(policy),
+          external(policy) {}
+
+    /// Returns the policy for segments of type `type`.
+    LoadPolicy get(DataLoader::SegmentInfo::Type type) const {
+      switch (type) {
+        case DataLoader::SegmentInfo::Type::Program:
+          return program;
+        case DataLoader::SegmentInfo::Type::Constant:
+          return constant;
+        case DataLoader::SegmentInfo::Type::Backend:
+          return backend;
+        case DataLoader::SegmentInfo::Type::Mutable:
+          return mutable_data;
+        case DataLoader::SegmentInfo::Type::External:
+          return external;
+      }
+      return LoadPolicy::Lazy;
+    }
+  };
+
   /**
    * Creates a new MmapDataLoader that wraps the named file. Fails if
    * the file can't be opened for reading or if its size can't be found.
@@ -49,10 +119,12 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
    *     overhead of opening it again for every load() call.
    * @param[in] mlock_config How and whether to lock loaded pages with
    *     `mlock()`.
+   * @param[in] load_policies When to read the pages of each type of segment.
    */
   static executorch::runtime::Result<MmapDataLoader> from(
       const char* file_name,
-      MlockConfig mlock_config = MlockConfig::UseMlock);
+      MlockConfig mlock_config = MlockConfig::UseMlock,
+      const SegmentLoadPolicies& load_policies = SegmentLoadPolicies());
 
   /// DEPRECATED: Use the lowercase `from()` instead.
   ET_DEPRECATED static executorch::runtime::Result<MmapDataLoader> From(
@@ -77,7 +149,8 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
         file_size_(rhs.file_size_),
         page_size_(rhs.page_size_),
         fd_(rhs.fd_),
-        mlock_config_(rhs.mlock_config_) {
+        mlock_config_(rhs.mlock_config_),
+        load_policies_(rhs.load_policies_) {
     const_cast<const char*&>(rhs.file_name_) = nullptr;
     const_cast<size_t&>(rhs.file_size_) = 0;
     const_cast<size_t&>(rhs.page_size_) = 0;
@@ -99,7 +172,7 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
   executorch::runtime::Error load_into(
       size_t offset,
       size_t size,
-      ET_UNUSED const SegmentInfo& segment_info,
+      const SegmentInfo& segment_info,
       void* buffer) const override;
 
  private:
@@ -108,12 +181,14 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
       size_t file_size,
       const char* file_name,
       size_t page_size,
-      MlockConfig mlock_config)
+      MlockConfig mlock_config,
+      const SegmentLoadPolicies& load_policies)
       : file_name_(file_name),
         file_size_(file_size),
         page_size_(page_size),
         fd_(fd),
-        mlock_config_(mlock_config) {}
+        mlock_config_(mlock_config),
+        load_policies_(load_policies) {}
 
   // Not safely copyable.
   MmapDataLoader(const MmapDataLoader&) = delete;
@@ -129,6 +204,7 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
   const size_t page_size_;
   const int fd_; // Owned by the instance.
   const MlockConfig mlock_config_;
+  const SegmentLoadPolicies load_policies_;
 };
 
 } // namespace extension
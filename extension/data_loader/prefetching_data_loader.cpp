@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & ~(value - 1)) == value;
+}
+
+/**
+ * FreeableBuffer::FreeFn-compatible callback.
+ *
+ * `data` is the original buffer pointer.
+ * `context` is the original alignment.
+ *
+ * `size` is unused.
+ */
+void free_segment(void* context, void* data, ET_UNUSED size_t size) {
+  ::operator delete(
+      data,
+      static_cast<std::align_val_t>(reinterpret_cast<uintptr_t>(context)));
+}
+
+} // namespace
+
+PrefetchingDataLoader::PrefetchingDataLoader(
+    std::unique_ptr<DataLoader> loader,
+    size_t num_threads,
+    size_t chunk_size,
+    size_t alignment)
+    : loader_(std::move(loader)),
+      chunk_size_(chunk_size),
+      alignment_{alignment},
+      workers_(num_threads) {
+  ET_CHECK_MSG(loader_ != nullptr, "loader cannot be null");
+  ET_CHECK_MSG(
+      is_power_of_2(alignment), "Alignment %zu is not a power of 2", alignment);
+}
+
+PrefetchingDataLoader::~PrefetchingDataLoader() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    range_done_.wait(lock, [this] { return pending_chunks_ == 0; });
+  }
+  for (auto& entry : ranges_) {
+    free_data(entry.second->data);
+  }
+}
+
+Error PrefetchingDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) {
+  Result<size_t> file_size = loader_->size();
+  if (!file_size.ok()) {
+    return file_size.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= file_size.get(),
+      InvalidArgument,
+      "Prefetch of offset %zu + size %zu > size %zu",
+      offset,
+      size,
+      file_size.get());
+  if (size == 0) {
+    return Error::Ok;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The only range that can overlap is the one starting at or before `offset`,
+  // or the first one starting after it.
+  auto next = ranges_.upper_bound(offset);
+  if (next != ranges_.begin()) {
+    const Range& prev = *std::prev(next)->second;
+    if (prev.offset == offset && prev.size == size) {
+      return Error::Ok;
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        prev.offset + prev.size <= offset,
+        InvalidArgument,
+        "Prefetch of offset %zu size %zu overlaps offset %zu size %zu",
+        offset,
+        size,
+        prev.offset,
+        prev.size);
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      next == ranges_.end() || offset + size <= next->second->offset,
+      InvalidArgument,
+      "Prefetch of offset %zu size %zu overlaps offset %zu size %zu",
+      offset,
+      size,
+      next->second->offset,
+      next->second->size);
+
+  void* data = ::operator new(size, alignment_, std::nothrow);
+  if (data == nullptr) {
+    ET_LOG(Error, "Failed to allocate %zu bytes for prefetch", size);
+    return Error::MemoryAllocationFailed;
+  }
+  const size_t chunk_size = chunk_size_ > 0 ? chunk_size_ : size;
+  const size_t num_chunks = (size + chunk_size - 1) / chunk_size;
+  auto range = std::make_unique<Range>(
+      Range{offset, size, data, num_chunks, Error::Ok});
+  Range* raw_range = range.get();
+  ranges_.emplace(offset, std::move(range));
+  pending_chunks_ += num_chunks;
+  lock.unlock();
+
+  for (size_t begin = 0; begin < size; begin += chunk_size) {
+    const size_t end = begin + chunk_size < size ? begin + chunk_size : size;
+    workers_.submit([this, raw_range, begin, end, segment_info] {
+      read_chunk(raw_range, begin, end, segment_info);
+    });
+  }
+  return Error::Ok;
+}
+
+void PrefetchingDataLoader::read_chunk(
+    Range* range,
+    size_t begin,
+    size_t end,
+    const SegmentInfo& segment_info) {
+  uint8_t* dst = static_cast<uint8_t*>(range->data) + begin;
+  Error err = Error::NotImplemented;
+  if (!load_into_unsupported_.load(std::memory_order_relaxed)) {
+    err = loader_->load_into(
+        range->offset + begin, end - begin, segment_info, dst);
+  }
+  if (err == Error::NotImplemented) {
+    load_into_unsupported_.store(true, std::memory_order_relaxed);
+    Result<FreeableBuffer> buffer =
+        loader_->load(range->offset + begin, end - begin, segment_info);
+    err = buffer.error();
+    if (buffer.ok()) {
+      std::memcpy(dst, buffer->data(), end - begin);
+      buffer->Free();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (err != Error::Ok && range->error == Error::Ok) {
+    range->error = err;
+  }
+  range->pending--;
+  pending_chunks_--;
+  // Notify with the lock held: once pending_chunks_ reaches zero the
+  // destructor may run as soon as the lock is released.
+  range_done_.notify_all();
+}
+
+Error PrefetchingDataLoader::wait() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  range_done_.wait(lock, [this] { return pending_chunks_ == 0; });
+  for (const auto& entry : ranges_) {
+    if (entry.second->error != Error::Ok) {
+      return entry.second->error;
+    }
+  }
+  return Error::Ok;
+}
+
+PrefetchingDataLoader::Range* PrefetchingDataLoader::find_locked(
+    size_t offset,
+    size_t size) const {
+  auto next = ranges_.upper_bound(offset);
+  if (next == ranges_.begin()) {
+    return nullptr;
+  }
+  Range* range = std::prev(next)->second.get();
+  if (offset + size > range->offset + range->size) {
+    return nullptr;
+  }
+  return range;
+}
+
+PrefetchingDataLoader::Range* PrefetchingDataLoader::wait_for_locked(
+    std::unique_lock<std::mutex>& lock,
+    size_t offset,
+    size_t size) const {
+  while (true) {
+    // Look the range up again after every wakeup: another thread may have
+    // claimed it in the meantime.
+    Range* range = find_locked(offset, size);
+    if (range == nullptr || range->pending == 0) {
+      return range;
+    }
+    range_done_.wait(lock);
+  }
+}
+
+Result<FreeableBuffer> PrefetchingDataLoader::load(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) const {
+  if (size == 0) {
+    return loader_->load(offset, size, segment_info);
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  Range* range = wait_for_locked(lock, offset, size);
+  if (range == nullptr) {
+    lock.unlock();
+    return loader_->load(offset, size, segment_info);
+  }
+  if (range->error != Error::Ok) {
+    return range->error;
+  }
+
+  if (range->offset == offset && range->size == size) {
+    // Hand over the buffer.
+    void* data = range->data;
+    ranges_.erase(offset);
+    return FreeableBuffer(
+        data,
+        size,
+        free_segment,
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        reinterpret_cast<void*>(static_cast<uintptr_t>(alignment_)));
+  }
+
+  // Copy out of the larger range. The lock stays held so that the range
+  // cannot be claimed and freed while it is being read.
+  void* data = ::operator new(size, alignment_, std::nothrow);
+  if (data == nullptr) {
+    ET_LOG(Error, "Failed to allocate %zu bytes", size);
+    return Error::MemoryAllocationFailed;
+  }
+  std::memcpy(
+      data,
+      static_cast<uint8_t*>(range->data) + (offset - range->offset),
+      size);
+  return FreeableBuffer(
+      data,
+      size,
+      free_segment,
+      // NOLINTNEXTLINE(performance-no-int-to-ptr)
+      reinterpret_cast<void*>(static_cast<uintptr_t>(alignment_)));
+}
+
+Error PrefetchingDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info,
+    void* buffer) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr, InvalidArgument, "Provided buffer cannot be null");
+  std::unique_lock<std::mutex> lock(mutex_);
+  Range* range = size > 0 ? wait_for_locked(lock, offset, size) : nullptr;
+  if (range == nullptr) {
+    lock.unlock();
+    return loader_->load_into(offset, size, segment_info, buffer);
+  }
+  if (range->error != Error::Ok) {
+    return range->error;
+  }
+  std::memcpy(
+      buffer,
+      static_cast<uint8_t*>(range->data) + (offset - range->offset),
+      size);
+  return Error::Ok;
+}
+
+Result<size_t> PrefetchingDataLoader::size() const {
+  return loader_->size();
+}
+
+} // namespace extension
+} // namespace executorch
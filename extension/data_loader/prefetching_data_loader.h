@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include <executorch/extension/threadpool/worker_pool.h>
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that reads ranges of another DataLoader ahead of time, in
+ * parallel.
+ *
+ * Program::load() and Method::init() request segments one at a time, so with
+ * a plain FileDataLoader the cold start of a large model is bounded by a
+ * single serial stream of reads. Callers that know the segment table up front
+ * can instead pass every range to prefetch(): its buffer is allocated
+ * immediately, and the range is read on a pool of worker threads in chunks of
+ * `chunk_size` bytes, so that both many small segments and a few large ones
+ * keep several reads in flight.
+ *
+ * load() of a range that exactly matches a prefetched one waits for its reads
+ * to finish and hands over the buffer without copying; the range is forgotten
+ * afterwards. load() and load_into() of a sub-range of a prefetched range copy
+ * out of it and leave it in place. Every other request is forwarded to the
+ * wrapped loader.
+ *
+ * The wrapped loader's load_into() must be thread-safe, as FileDataLoader's
+ * is. Loaders that do not implement load_into() are read through load()
+ * followed by a copy.
+ */
+class PrefetchingDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  static constexpr size_t kDefaultChunkSize = 4 * 1024 * 1024;
+
+  /**
+   * @param[in] loader The loader to read from.
+   * @param[in] num_threads Number of reads to keep in flight. Zero means
+   *     std::thread::hardware_concurrency().
+   * @param[in] chunk_size Prefetched ranges are split into reads of at most
+   *     this many bytes.
+   * @param[in] alignment Alignment in bytes of pointers returned by this
+   *     instance. Must be a power of two; aborts otherwise.
+   */
+  explicit PrefetchingDataLoader(
+      std::unique_ptr<executorch::runtime::DataLoader> loader,
+      size_t num_threads = 0,
+      size_t chunk_size = kDefaultChunkSize,
+      size_t alignment = alignof(std::max_align_t));
+
+  PrefetchingDataLoader(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader& operator=(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader(PrefetchingDataLoader&&) = delete;
+  PrefetchingDataLoader& operator=(PrefetchingDataLoader&&) = delete;
+
+  /// Waits for outstanding reads, then frees every unclaimed buffer.
+  ~PrefetchingDataLoader() override;
+
+  /**
+   * Starts reading `size` bytes at `offset` in the background. Returns once
+   * the buffer is allocated and the reads are queued.
+   *
+   * Prefetching a range that was already prefetched, and not yet claimed by
+   * load(), does nothing.
+   *
+   * @retval Error::InvalidArgument The range is out of bounds, or it partially
+   *     overlaps a range that was already prefetched.
+   * @retval Error::MemoryAllocationFailed The buffer could not be allocated.
+   */
+  ET_NODISCARD executorch::runtime::Error prefetch(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info);
+
+  /**
+   * Blocks until every prefetched range has been read.
+   *
+   * @returns The error of the first failed read, if any.
+   */
+  ET_NODISCARD executorch::runtime::Error wait() const;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+ private:
+  struct Range {
+    size_t offset;
+    size_t size;
+    void* data;
+    /// Chunks still being read. Guarded by mutex_.
+    size_t pending;
+    /// First error reported by a chunk. Guarded by mutex_.
+    executorch::runtime::Error error;
+  };
+
+  /// Returns the prefetched range that contains [offset, offset + size), or
+  /// nullptr. Must be called with mutex_ held.
+  Range* find_locked(size_t offset, size_t size) const;
+
+  /// Like find_locked(), but waits for the range's reads to finish first.
+  Range* wait_for_locked(
+      std::unique_lock<std::mutex>& lock,
+      size_t offset,
+      size_t size) const;
+
+  void read_chunk(
+      Range* range,
+      size_t begin,
+      size_t end,
+      const SegmentInfo& segment_info);
+
+  void free_data(void* data) const {
+    ::operator delete(data, alignment_);
+  }
+
+  const std::unique_ptr<executorch::runtime::DataLoader> loader_;
+  const size_t chunk_size_;
+  const std::align_val_t alignment_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable range_done_;
+  /// Prefetched ranges not yet claimed by load(), keyed by offset.
+  mutable std::map<size_t, std::unique_ptr<Range>> ranges_;
+  /// Chunks still being read across all ranges. Guarded by mutex_.
+  size_t pending_chunks_ = 0;
+  /// Set once the wrapped loader reports that it lacks load_into().
+  std::atomic<bool> load_into_unsupported_{false};
+
+  // Declared last so that its workers are joined before the state they use is
+  // destroyed.
+  threadpool::WorkerPool workers_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_weight_data_loader.h>
+
+#include <utility>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+SharedWeightDataLoader::SharedWeightDataLoader(
+    std::unique_ptr<DataLoader> loader,
+    std::shared_ptr<SharedWeightStore> store,
+    size_t min_size)
+    : loader_(std::move(loader)),
+      store_(std::move(store)),
+      min_size_(min_size > 0 ? min_size : 1) {
+  ET_CHECK_MSG(loader_ != nullptr, "loader cannot be null");
+  ET_CHECK_MSG(store_ != nullptr, "store cannot be null");
+}
+
+Result<FreeableBuffer> SharedWeightDataLoader::load(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) const {
+  Result<FreeableBuffer> buffer = loader_->load(offset, size, segment_info);
+  const bool shareable =
+      segment_info.segment_type == SegmentInfo::Type::Constant ||
+      segment_info.segment_type == SegmentInfo::Type::External;
+  if (!buffer.ok() || !shareable || size < min_size_) {
+    return buffer;
+  }
+
+  Result<FreeableBuffer> shared =
+      store_->get_or_insert(buffer->data(), buffer->size());
+  if (!shared.ok()) {
+    ET_LOG(
+        Debug,
+        "Not sharing offset %zu size %zu: error 0x%x",
+        offset,
+        size,
+        static_cast<unsigned int>(shared.error()));
+    return buffer;
+  }
+  buffer->Free();
+  return std::move(shared.get());
+}
+
+} // namespace extension
+} // namespace executorch
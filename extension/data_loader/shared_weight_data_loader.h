@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <executorch/extension/data_loader/shared_weight_store.h>
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that serves constant and external weight segments from a
+ * SharedWeightStore.
+ *
+ * Constant segments are what Program uses for get_constant_buffer_data(), and
+ * external segments are what FlatTensorDataMap returns from get_data(), so
+ * wrapping the program and data map loaders of several Modules with the same
+ * store makes identical weights share physical pages across those Modules and
+ * across processes. Each shared segment is read once from the wrapped loader
+ * to be hashed and is then released.
+ *
+ * Segments of other types, segments smaller than `min_size`, and segments
+ * the store fails to share are returned from the wrapped loader unchanged.
+ * load_into() copies into caller-owned memory, so it is always forwarded.
+ */
+class SharedWeightDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /// Segments smaller than this are not worth a file and a mapping each.
+  static constexpr size_t kDefaultMinSize = 64 * 1024;
+
+  /**
+   * @param[in] loader The loader to read from.
+   * @param[in] store The store to share weights through.
+   * @param[in] min_size Segments smaller than this are not shared.
+   */
+  SharedWeightDataLoader(
+      std::unique_ptr<executorch::runtime::DataLoader> loader,
+      std::shared_ptr<SharedWeightStore> store,
+      size_t min_size = kDefaultMinSize);
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override {
+    return loader_->load_into(offset, size, segment_info, buffer);
+  }
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override {
+    return loader_->size();
+  }
+
+ private:
+  const std::unique_ptr<executorch::runtime::DataLoader> loader_;
+  const std::shared_ptr<SharedWeightStore> store_;
+  const size_t min_size_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_weight_store.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <executorch/extension/data_loader/mman.h>
+#include <executorch/runtime/core/content_hash.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+using executorch::runtime::internal::hash_bytes;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+#if !defined(_WIN32)
+bool write_all(int fd, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (written == 0) {
+      // No progress and no error; retrying would spin forever.
+      errno = EIO;
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+#endif
+
+} // namespace
+
+struct SharedWeightStore::Entry {
+  Key key;
+  void* data;
+  /// Live buffers that point to `data`. Guarded by the store's mutex_.
+  size_t refs;
+  /// Keeps the store alive while any of its buffers are.
+  std::shared_ptr<SharedWeightStore> store;
+};
+
+Result<std::shared_ptr<SharedWeightStore>> SharedWeightStore::from(
+    const char* directory) {
+  ET_CHECK_OR_RETURN_ERROR(
+      directory != nullptr, InvalidArgument, "Directory cannot be null");
+#if defined(_WIN32)
+  ET_LOG(Error, "SharedWeightStore is not supported on this platform");
+  return Error::NotSupported;
+#else
+  struct stat st;
+  if (::stat(directory, &st) < 0 || !S_ISDIR(st.st_mode) ||
+      ::access(directory, W_OK) < 0) {
+    ET_LOG(Error, "%s is not a writable directory", directory);
+    return Error::AccessFailed;
+  }
+  // The constructor is private, so std::make_shared cannot call it.
+  return std::shared_ptr<SharedWeightStore>(new SharedWeightStore(directory));
+#endif
+}
+
+Result<void*> SharedWeightStore::map_entry(const Key& key, const void* data) {
+#if defined(_WIN32)
+  (void)key;
+  (void)data;
+  return Error::NotSupported;
+#else
+  char name[64];
+  snprintf(
+      name, sizeof(name), "%016" PRIx64 "-%zu.bin", key.hash, key.size);
+  const std::string path = directory_ + "/" + name;
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0 && errno == ENOENT) {
+    // Write to a private file and publish it with an atomic rename(), so
+    // that other processes never map a partially written entry. If several
+    // processes race, they rename identical contents over each other.
+    static std::atomic<uint32_t> counter{0};
+    char tmp_name[96];
+    snprintf(
+        tmp_name,
+        sizeof(tmp_name),
+        ".%s.%d.%u.tmp",
+        name,
+        static_cast<int>(::getpid()),
+        counter.fetch_add(1));
+    const std::string tmp_path = directory_ + "/" + tmp_name;
+    int tmp_fd =
+        ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (tmp_fd < 0) {
+      ET_LOG(
+          Error,
+          "Failed to create %s: %s (%d)",
+          tmp_path.c_str(),
+          ::strerror(errno),
+          errno);
+      return Error::AccessFailed;
+    }
+    const bool written = write_all(tmp_fd, data, key.size);
+    ::close(tmp_fd);
+    if (!written || ::rename(tmp_path.c_str(), path.c_str()) < 0) {
+      ET_LOG(
+          Error,
+          "Failed to write %s: %s (%d)",
+          path.c_str(),
+          ::strerror(errno),
+          errno);
+      ::unlink(tmp_path.c_str());
+      return Error::AccessFailed;
+    }
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+  if (fd < 0) {
+    ET_LOG(
+        Error,
+        "Failed to open %s: %s (%d)",
+        path.c_str(),
+        ::strerror(errno),
+        errno);
+    return Error::AccessFailed;
+  }
+
+  struct stat st;
+  void* pages = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == key.size) {
+    pages = ::mmap(nullptr, key.size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (pages == MAP_FAILED) {
+    ET_LOG(Error, "Failed to map %s", path.c_str());
+    return Error::AccessFailed;
+  }
+  if (std::memcmp(pages, data, key.size) != 0) {
+    ET_LOG(Info, "%s does not match the data it was looked up for", name);
+    ::munmap(pages, key.size);
+    return Error::NotFound;
+  }
+  return pages;
+#endif
+}
+
+FreeableBuffer SharedWeightStore::make_buffer(Entry* entry) {
+  entry->refs++;
+  return FreeableBuffer(entry->data, entry->key.size, release, entry);
+}
+
+Result<FreeableBuffer> SharedWeightStore::get_or_insert(
+    const void* data,
+    size_t size) {
+  ET_CHECK_OR_RETURN_ERROR(
+      size > 0, InvalidArgument, "Cannot store an empty buffer");
+  const Key key{hash_bytes(data, size), size};
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    if (std::memcmp(it->second->data, data, size) != 0) {
+      return Error::NotFound;
+    }
+    return make_buffer(it->second);
+  }
+
+  Result<void*> pages = map_entry(key, data);
+  if (!pages.ok()) {
+    return pages.error();
+  }
+  Entry* entry = new Entry{key, pages.get(), 0, shared_from_this()};
+  entries_.emplace(key, entry);
+  return make_buffer(entry);
+}
+
+void SharedWeightStore::release(
+    void* context,
+    ET_UNUSED void* data,
+    ET_UNUSED size_t size) {
+  Entry* entry = static_cast<Entry*>(context);
+  std::shared_ptr<SharedWeightStore> store;
+  {
+    std::lock_guard<std::mutex> lock(entry->store->mutex_);
+    if (--entry->refs > 0) {
+      return;
+    }
+    entry->store->entries_.erase(entry->key);
+    ::munmap(entry->data, entry->key.size);
+    // Drop the store's last reference, if this is it, after unlocking.
+    store = std::move(entry->store);
+  }
+  delete entry;
+}
+
+size_t SharedWeightStore::num_mapped_entries() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A content-addressed store of read-only weight data, backed by files in a
+ * directory that several processes on the same host may share.
+ *
+ * get_or_insert() hashes the given bytes and returns a read-only, shared
+ * mapping of the store file that holds the same bytes, writing that file
+ * first if no process has done so yet. Model variants that contain identical
+ * weights, e.g. LoRA variants of one base model or two heads sharing an
+ * encoder, then all map the same physical pages instead of each holding a
+ * private copy. Within one process, identical data is mapped only once.
+ *
+ * Hashes only select the candidate file: its contents are compared with the
+ * given bytes before a mapping is returned, so a hash collision or a corrupt
+ * file makes get_or_insert() fail rather than return the wrong data.
+ *
+ * Entries are never removed from the directory by this class; the directory
+ * can be deleted whenever no process is using it.
+ *
+ * Instances are thread-safe. Buffers returned by get_or_insert() keep the
+ * store alive until they are freed.
+ */
+class SharedWeightStore final
+    : public std::enable_shared_from_this<SharedWeightStore> {
+ public:
+  /**
+   * Creates a store in `directory`, which must already exist and be
+   * writable.
+   *
+   * @retval Error::AccessFailed The directory is not a writable directory.
+   * @retval Error::NotSupported The host does not support shared mappings.
+   */
+  static executorch::runtime::Result<std::shared_ptr<SharedWeightStore>> from(
+      const char* directory);
+
+  SharedWeightStore(const SharedWeightStore&) = delete;
+  SharedWeightStore& operator=(const SharedWeightStore&) = delete;
+  SharedWeightStore(SharedWeightStore&&) = delete;
+  SharedWeightStore& operator=(SharedWeightStore&&) = delete;
+
+  /**
+   * Returns a read-only mapping of a store entry with the same contents as
+   * `data`, creating the entry if needed. The returned data is page-aligned.
+   *
+   * @retval Error::InvalidArgument `size` is zero.
+   * @retval Error::NotFound An entry with the same hash exists but holds
+   *     different data.
+   * @retval Error::AccessFailed The entry could not be written or mapped.
+   */
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer>
+  get_or_insert(const void* data, size_t size);
+
+  /// Number of distinct entries currently mapped by this process.
+  size_t num_mapped_entries() const;
+
+ private:
+  struct Entry;
+
+  struct Key {
+    uint64_t hash;
+    size_t size;
+
+    bool operator==(const Key& other) const {
+      return hash == other.hash && size == other.size;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return static_cast<size_t>(key.hash ^ key.size);
+    }
+  };
+
+  explicit SharedWeightStore(std::string directory)
+      : directory_(std::move(directory)) {}
+
+  /// Maps the entry file for `key`, writing it from `data` if it is missing.
+  executorch::runtime::Result<void*>
+  map_entry(const Key& key, const void* data);
+
+  executorch::runtime::FreeableBuffer make_buffer(Entry* entry);
+
+  static void release(void* context, void* data, size_t size);
+
+  const std::string directory_;
+
+  mutable std::mutex mutex_;
+  /// Entries mapped by this process, keyed by content. Guarded by mutex_.
+  std::unordered_map<Key, Entry*, KeyHash> entries_;
+};
+
+} // namespace extension
+} // namespace executorch
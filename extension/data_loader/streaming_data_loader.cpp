@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/streaming_data_loader.h>
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & ~(value - 1)) == value;
+}
+
+} // namespace
+
+/**
+ * A constant segment whose buffer is being filled. Queued reads hold a
+ * reference, so the buffer outlives any read that is in progress when it is
+ * freed.
+ */
+struct StreamingDataLoader::Stream {
+  const StreamingDataLoader* loader;
+  size_t offset;
+  size_t size;
+  void* data;
+  SegmentInfo segment_info;
+  /// Guarded by loader->mutex_.
+  std::vector<ChunkState> chunks;
+  /// First error reported by a chunk. Guarded by loader->mutex_.
+  Error error;
+  /// Set when the buffer is freed; queued reads are skipped. Guarded by
+  /// loader->mutex_.
+  bool freed;
+
+  ~Stream() {
+    ::operator delete(data, loader->alignment_);
+  }
+};
+
+StreamingDataLoader::StreamingDataLoader(
+    std::unique_ptr<DataLoader> loader,
+    size_t num_threads,
+    size_t chunk_size,
+    size_t alignment)
+    : loader_(std::move(loader)),
+      chunk_size_(chunk_size > 0 ? chunk_size : kDefaultChunkSize),
+      alignment_{alignment},
+      workers_(num_threads) {
+  ET_CHECK_MSG(loader_ != nullptr, "loader cannot be null");
+  ET_CHECK_MSG(
+      is_power_of_2(alignment), "Alignment %zu is not a power of 2", alignment);
+}
+
+Result<FreeableBuffer> StreamingDataLoader::load(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info) const {
+  if (segment_info.segment_type != SegmentInfo::Type::Constant || size == 0) {
+    return loader_->load(offset, size, segment_info);
+  }
+  Result<size_t> file_size = loader_->size();
+  if (!file_size.ok()) {
+    return file_size.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= file_size.get(),
+      InvalidArgument,
+      "Load of offset %zu + size %zu > size %zu",
+      offset,
+      size,
+      file_size.get());
+
+  void* data = ::operator new(size, alignment_, std::nothrow);
+  if (data == nullptr) {
+    ET_LOG(Error, "Failed to allocate %zu bytes", size);
+    return Error::MemoryAllocationFailed;
+  }
+  const size_t num_chunks = (size + chunk_size_ - 1) / chunk_size_;
+  // Not make_shared(Stream{...}): the temporary would free `data`.
+  std::shared_ptr<Stream> stream(new Stream{
+      this,
+      offset,
+      size,
+      data,
+      segment_info,
+      std::vector<ChunkState>(num_chunks, ChunkState::Queued),
+      Error::Ok,
+      /*freed=*/false});
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.emplace(reinterpret_cast<uintptr_t>(data), stream);
+  }
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    workers_.submit([this, stream, chunk] { run_chunk(stream, chunk); });
+  }
+  return FreeableBuffer(data, size, free_stream, stream.get());
+}
+
+Error StreamingDataLoader::read_chunk(const Stream& stream, size_t chunk)
+    const {
+  const size_t begin = chunk * chunk_size_;
+  const size_t length =
+      begin + chunk_size_ < stream.size ? chunk_size_ : stream.size - begin;
+  uint8_t* dst = static_cast<uint8_t*>(stream.data) + begin;
+  Error err = Error::NotImplemented;
+  if (!load_into_unsupported_.load(std::memory_order_relaxed)) {
+    err = loader_->load_into(
+        stream.offset + begin, length, stream.segment_info, dst);
+  }
+  if (err == Error::NotImplemented) {
+    load_into_unsupported_.store(true, std::memory_order_relaxed);
+    Result<FreeableBuffer> buffer =
+        loader_->load(stream.offset + begin, length, stream.segment_info);
+    err = buffer.error();
+    if (buffer.ok()) {
+      std::memcpy(dst, buffer->data(), length);
+      buffer->Free();
+    }
+  }
+  return err;
+}
+
+void StreamingDataLoader::finish_chunk_locked(
+    Stream& stream,
+    size_t chunk,
+    Error error) const {
+  stream.chunks[chunk] = ChunkState::Done;
+  if (error != Error::Ok && stream.error == Error::Ok) {
+    stream.error = error;
+  }
+  chunk_done_.notify_all();
+}
+
+void StreamingDataLoader::run_chunk(
+    const std::shared_ptr<Stream>& stream,
+    size_t chunk) const {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stream->freed || stream->chunks[chunk] != ChunkState::Queued) {
+      return;
+    }
+    stream->chunks[chunk] = ChunkState::Reading;
+  }
+  const Error err = read_chunk(*stream, chunk);
+  std::lock_guard<std::mutex> lock(mutex_);
+  finish_chunk_locked(*stream, chunk, err);
+}
+
+Error StreamingDataLoader::wait_for_data(const void* data, size_t size) const {
+  if (size == 0) {
+    return Error::Ok;
+  }
+  const uintptr_t address = reinterpret_cast<uintptr_t>(data);
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto next = streams_.upper_bound(address);
+  if (next == streams_.begin()) {
+    return Error::Ok;
+  }
+  // Keep the stream alive while the lock is released below.
+  std::shared_ptr<Stream> stream = std::prev(next)->second;
+  const uintptr_t base = reinterpret_cast<uintptr_t>(stream->data);
+  if (address >= base + stream->size) {
+    // Not in a streamed buffer, so it is already resident.
+    return Error::Ok;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      address + size <= base + stream->size,
+      InvalidArgument,
+      "Range of %zu bytes at %p extends past its buffer",
+      size,
+      data);
+
+  const size_t first = (address - base) / chunk_size_;
+  const size_t last = (address + size - 1 - base) / chunk_size_;
+  for (size_t chunk = first; chunk <= last; ++chunk) {
+    while (stream->chunks[chunk] != ChunkState::Done) {
+      if (stream->chunks[chunk] == ChunkState::Queued) {
+        // Read it here rather than wait for the workers to reach it.
+        stream->chunks[chunk] = ChunkState::Reading;
+        lock.unlock();
+        const Error err = read_chunk(*stream, chunk);
+        lock.lock();
+        finish_chunk_locked(*stream, chunk, err);
+      } else {
+        chunk_done_.wait(lock);
+      }
+    }
+  }
+  return stream->error;
+}
+
+void StreamingDataLoader::free_stream(
+    void* context,
+    ET_UNUSED void* data,
+    ET_UNUSED size_t size) {
+  Stream* stream = static_cast<Stream*>(context);
+  const StreamingDataLoader* self = stream->loader;
+  std::shared_ptr<Stream> owned;
+  {
+    std::lock_guard<std::mutex> lock(self->mutex_);
+    stream->freed = true;
+    auto it = self->streams_.find(reinterpret_cast<uintptr_t>(stream->data));
+    owned = std::move(it->second);
+    self->streams_.erase(it);
+  }
+  // The buffer is freed here, or by the last read still using it.
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include <executorch/extension/threadpool/worker_pool.h>
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that returns constant segments before they have been read, so
+ * that a Method can start executing while its weights are still loading.
+ *
+ * load() of a `Constant` segment allocates its buffer, queues reads of it in
+ * chunks of `chunk_size` bytes on a pool of worker threads, and returns
+ * immediately. Chunks are read in file order, which is the order in which the
+ * exporter lays out constants and so roughly the order in which instructions
+ * use them. Method calls wait_for_data() before each instruction that reads
+ * constant data; it returns once the chunks holding that data are read, and
+ * reads chunks that no worker has started yet on the calling thread instead
+ * of waiting behind the rest of the queue.
+ *
+ * Other segment types are loaded synchronously through the wrapped loader:
+ * backends read their segments during Method::init, which must not see
+ * partial data. Code other than Method that reads constant data, e.g. through
+ * Program::get_constant_buffer_data(), must call wait_for_data() first.
+ *
+ * The wrapped loader's load_into() must be thread-safe, as FileDataLoader's
+ * is. Loaders that do not implement load_into() are read through load()
+ * followed by a copy. Buffers returned by this loader must be freed before it
+ * is destroyed.
+ */
+class StreamingDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1024 * 1024;
+
+  /**
+   * @param[in] loader The loader to read from.
+   * @param[in] num_threads Number of reads to keep in flight. Zero means
+   *     std::thread::hardware_concurrency().
+   * @param[in] chunk_size Constant segments are read, and waited for, in
+   *     units of at most this many bytes.
+   * @param[in] alignment Alignment in bytes of pointers returned by this
+   *     instance. Must be a power of two; aborts otherwise.
+   */
+  explicit StreamingDataLoader(
+      std::unique_ptr<executorch::runtime::DataLoader> loader,
+      size_t num_threads = 0,
+      size_t chunk_size = kDefaultChunkSize,
+      size_t alignment = alignof(std::max_align_t));
+
+  StreamingDataLoader(const StreamingDataLoader&) = delete;
+  StreamingDataLoader& operator=(const StreamingDataLoader&) = delete;
+  StreamingDataLoader(StreamingDataLoader&&) = delete;
+  StreamingDataLoader& operator=(StreamingDataLoader&&) = delete;
+
+  ~StreamingDataLoader() override = default;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override {
+    return loader_->load_into(offset, size, segment_info, buffer);
+  }
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override {
+    return loader_->size();
+  }
+
+  bool loads_constants_asynchronously() const override {
+    return true;
+  }
+
+  ET_NODISCARD executorch::runtime::Error wait_for_data(
+      const void* data,
+      size_t size) const override;
+
+ private:
+  enum class ChunkState : uint8_t {
+    Queued,
+    Reading,
+    Done,
+  };
+
+  struct Stream;
+
+  /// Reads one chunk of `stream` into its buffer. Does not lock.
+  executorch::runtime::Error read_chunk(const Stream& stream, size_t chunk)
+      const;
+
+  /// Reads one chunk unless it was claimed already, then marks it done.
+  void run_chunk(const std::shared_ptr<Stream>& stream, size_t chunk) const;
+
+  /// Marks a chunk claimed by the caller as done. Must hold mutex_.
+  void finish_chunk_locked(
+      Stream& stream,
+      size_t chunk,
+      executorch::runtime::Error error) const;
+
+  static void free_stream(void* context, void* data, size_t size);
+
+  const std::unique_ptr<executorch::runtime::DataLoader> loader_;
+  const size_t chunk_size_;
+  const std::align_val_t alignment_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable chunk_done_;
+  /// Streams whose buffers have not been freed, keyed by buffer address.
+  mutable std::map<uintptr_t, std::shared_ptr<Stream>> streams_;
+  /// Set once the wrapped loader reports that it lacks load_into().
+  mutable std::atomic<bool> load_into_unsupported_{false};
+
+  // Declared last so that its workers are joined before the state they use is
+  // destroyed.
+  mutable threadpool::WorkerPool workers_;
+};
+
+} // namespace extension
+} // namespace executorch
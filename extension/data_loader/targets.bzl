@@ -94,3 +94,57 @@ def define_common_targets():
             "//executorch/runtime/core:core",
         ],
     )
+
+    runtime.cxx_library(
+        name = "prefetching_data_loader",
+        srcs = ["prefetching_data_loader.cpp"],
+        exported_headers = ["prefetching_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "//executorch/extension/module/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/extension/threadpool:worker_pool",
+            "//executorch/runtime/core:core",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "streaming_data_loader",
+        srcs = ["streaming_data_loader.cpp"],
+        exported_headers = ["streaming_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "//executorch/extension/module/...",
+            "//executorch/runtime/executor/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/extension/threadpool:worker_pool",
+            "//executorch/runtime/core:core",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "shared_weight_store",
+        srcs = [
+            "shared_weight_data_loader.cpp",
+            "shared_weight_store.cpp",
+        ],
+        exported_headers = [
+            "shared_weight_data_loader.h",
+            "shared_weight_store.h",
+        ],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        deps = [
+            ":mmap_data_loader",
+            "//executorch/runtime/core:content_hash",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+        ],
+    )
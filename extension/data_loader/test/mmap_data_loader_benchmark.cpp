@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Compares the MmapDataLoader load policies on a real model: for each policy,
+ * evicts the file from the page cache, then reports the time to load the
+ * program and method, the latency of the first execution, and the resident
+ * set size afterwards.
+ *
+ * Eviction uses posix_fadvise(POSIX_FADV_DONTNEED), which drops only clean,
+ * unmapped pages; for fully cold numbers, drop the system caches instead
+ * and run one policy per process with [policy_index].
+ *
+ * Usage: mmap_data_loader_benchmark model.pte [method_name] [policy_index]
+ */
+
+#include <executorch/extension/data_loader/mmap_data_loader.h>
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/extension/runner_util/inputs.h>
+#include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/executor/program.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using executorch::extension::MallocMemoryAllocator;
+using executorch::extension::MmapDataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::HierarchicalAllocator;
+using executorch::runtime::MemoryManager;
+using executorch::runtime::Method;
+using executorch::runtime::MethodMeta;
+using executorch::runtime::Program;
+using executorch::runtime::Result;
+using executorch::runtime::Span;
+
+namespace {
+
+struct NamedPolicy {
+  const char* name;
+  MmapDataLoader::LoadPolicy policy;
+};
+
+constexpr NamedPolicy kPolicies[] = {
+    {"Lazy", MmapDataLoader::LoadPolicy::Lazy},
+    {"Populate", MmapDataLoader::LoadPolicy::Populate},
+    {"WillNeed", MmapDataLoader::LoadPolicy::WillNeed},
+    {"Sequential", MmapDataLoader::LoadPolicy::Sequential},
+    {"HugePage", MmapDataLoader::LoadPolicy::HugePage},
+    {"BackgroundPrefault", MmapDataLoader::LoadPolicy::BackgroundPrefault},
+};
+
+/// Resident set size of this process in bytes, or 0 if unknown.
+size_t resident_bytes() {
+  size_t rss_pages = 0;
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  if (std::fscanf(statm, "%*s %zu", &rss_pages) != 1) {
+    rss_pages = 0;
+  }
+  std::fclose(statm);
+  return rss_pages * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+void evict_from_page_cache(const char* path) {
+#if defined(POSIX_FADV_DONTNEED)
+  int fd = ::open(path, O_RDONLY);
+  if (fd >= 0) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+#else
+  (void)path;
+#endif
+}
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+bool run_policy(
+    const char* path,
+    const char* method_name,
+    const NamedPolicy& policy) {
+  evict_from_page_cache(path);
+  const size_t rss_before = resident_bytes();
+
+  const auto load_start = std::chrono::steady_clock::now();
+  Result<MmapDataLoader> loader = MmapDataLoader::from(
+      path,
+      MmapDataLoader::MlockConfig::NoMlock,
+      MmapDataLoader::SegmentLoadPolicies(policy.policy));
+  if (!loader.ok()) {
+    std::fprintf(stderr, "Failed to open %s\n", path);
+    return false;
+  }
+  Result<Program> program = Program::load(&loader.get());
+  if (!program.ok()) {
+    std::fprintf(
+        stderr, "Program::load failed: 0x%x\n", (unsigned)program.error());
+    return false;
+  }
+  Result<MethodMeta> method_meta = program->method_meta(method_name);
+  if (!method_meta.ok()) {
+    std::fprintf(stderr, "No method %s\n", method_name);
+    return false;
+  }
+  std::vector<std::unique_ptr<uint8_t[]>> planned_buffers;
+  std::vector<Span<uint8_t>> planned_spans;
+  for (size_t id = 0; id < method_meta->num_memory_planned_buffers(); ++id) {
+    const size_t size =
+        static_cast<size_t>(method_meta->memory_planned_buffer_size(id).get());
+    planned_buffers.push_back(std::make_unique<uint8_t[]>(size));
+    planned_spans.push_back({planned_buffers.back().get(), size});
+  }
+  HierarchicalAllocator planned_memory(
+      {planned_spans.data(), planned_spans.size()});
+  MallocMemoryAllocator method_allocator;
+  MemoryManager memory_manager(&method_allocator, &planned_memory);
+  Result<Method> method = program->load_method(method_name, &memory_manager);
+  if (!method.ok()) {
+    std::fprintf(
+        stderr, "load_method failed: 0x%x\n", (unsigned)method.error());
+    return false;
+  }
+  auto inputs = executorch::extension::prepare_input_tensors(*method);
+  if (!inputs.ok()) {
+    std::fprintf(
+        stderr, "Preparing inputs failed: 0x%x\n", (unsigned)inputs.error());
+    return false;
+  }
+  const double load_ms = ms_since(load_start);
+
+  const auto execute_start = std::chrono::steady_clock::now();
+  const Error err = method->execute();
+  const double execute_ms = ms_since(execute_start);
+  if (err != Error::Ok) {
+    std::fprintf(stderr, "execute failed: 0x%x\n", (unsigned)err);
+    return false;
+  }
+  const size_t rss_after = resident_bytes();
+
+  std::printf(
+      "%-20s %10.2f %12.2f %12.2f %10.1f\n",
+      policy.name,
+      load_ms,
+      execute_ms,
+      load_ms + execute_ms,
+      (static_cast<double>(rss_after) - static_cast<double>(rss_before)) /
+          (1024.0 * 1024.0));
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(
+        stderr, "Usage: %s model.pte [method_name] [policy_index]\n", argv[0]);
+    return 1;
+  }
+  const char* path = argv[1];
+  const char* method_name = argc > 2 ? argv[2] : "forward";
+  constexpr size_t kNumPolicies = sizeof(kPolicies) / sizeof(kPolicies[0]);
+  size_t first = 0;
+  size_t last = kNumPolicies;
+  if (argc > 3) {
+    first = std::strtoul(argv[3], nullptr, 10);
+    last = first + 1;
+    if (first >= kNumPolicies) {
+      std::fprintf(stderr, "policy_index must be < %zu\n", kNumPolicies);
+      return 1;
+    }
+  }
+
+  executorch::runtime::runtime_init();
+
+  std::printf(
+      "%-20s %10s %12s %12s %10s\n",
+      "policy",
+      "load ms",
+      "1st exec ms",
+      "total ms",
+      "RSS MiB");
+  for (size_t i = first; i < last; ++i) {
+    if (!run_policy(path, method_name, kPolicies[i])) {
+      return 1;
+    }
+  }
+  return 0;
+}
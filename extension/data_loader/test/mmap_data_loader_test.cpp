@@ -9,6 +9,8 @@
 #include <executorch/extension/data_loader/mmap_data_loader.h>
 
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -428,4 +430,79 @@ TEST_F(MmapDataLoaderTest, LoadIntoCopiesOffsetCorrectly) {
 
   // Verify memory copied correctly.
   EXPECT_EQ(0, std::memcmp(dst, contents + offset, size));
-}
\ No newline at end of file
+}
+TEST_F(MmapDataLoaderTest, LoadPoliciesLoadCorrectData) {
+  // A file whose length is not a multiple of the page size, where each 4-byte
+  // word has a different value.
+  const size_t contents_size = 5 * page_size_ + page_size_ / 2;
+  auto contents = std::make_unique<uint8_t[]>(contents_size);
+  for (size_t i = 0; i < contents_size / sizeof(uint32_t); ++i) {
+    (reinterpret_cast<uint32_t*>(contents.get()))[i] = i;
+  }
+  TempFile tf(contents.get(), contents_size);
+
+  for (auto policy :
+       {MmapDataLoader::LoadPolicy::Lazy,
+        MmapDataLoader::LoadPolicy::Populate,
+        MmapDataLoader::LoadPolicy::WillNeed,
+        MmapDataLoader::LoadPolicy::Sequential,
+        MmapDataLoader::LoadPolicy::HugePage,
+        MmapDataLoader::LoadPolicy::BackgroundPrefault}) {
+    SCOPED_TRACE(static_cast<int>(policy));
+    Result<MmapDataLoader> mdl = MmapDataLoader::from(
+        tf.path().c_str(),
+        MmapDataLoader::MlockConfig::NoMlock,
+        MmapDataLoader::SegmentLoadPolicies(policy));
+    ASSERT_EQ(mdl.error(), Error::Ok);
+
+    // Whole file, an unaligned range, and the partial final page.
+    const std::pair<size_t, size_t> ranges[] = {
+        {0, contents_size},
+        {page_size_ + 12, 2 * page_size_},
+        {5 * page_size_, page_size_ / 2},
+    };
+    for (const auto& range : ranges) {
+      Result<FreeableBuffer> fb = mdl->load(
+          range.first,
+          range.second,
+          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Constant));
+      ASSERT_EQ(fb.error(), Error::Ok);
+      ASSERT_EQ(fb->size(), range.second);
+      EXPECT_EQ(
+          0,
+          std::memcmp(
+              fb->data(), contents.get() + range.first, range.second));
+      fb->Free();
+
+      std::vector<uint8_t> dst(range.second);
+      ASSERT_EQ(
+          mdl->load_into(
+              range.first,
+              range.second,
+              DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Mutable),
+              dst.data()),
+          Error::Ok);
+      EXPECT_EQ(
+          0,
+          std::memcmp(dst.data(), contents.get() + range.first, range.second));
+    }
+  }
+}
+
+TEST_F(MmapDataLoaderTest, SegmentLoadPoliciesSelectByType) {
+  using LoadPolicy = MmapDataLoader::LoadPolicy;
+  using Type = DataLoader::SegmentInfo::Type;
+
+  MmapDataLoader::SegmentLoadPolicies defaults;
+  EXPECT_EQ(defaults.get(Type::Constant), LoadPolicy::Lazy);
+  EXPECT_EQ(defaults.get(Type::Backend), LoadPolicy::Lazy);
+
+  MmapDataLoader::SegmentLoadPolicies policies(LoadPolicy::WillNeed);
+  policies.constant = LoadPolicy::Populate;
+  policies.backend = LoadPolicy::Lazy;
+  EXPECT_EQ(policies.get(Type::Program), LoadPolicy::WillNeed);
+  EXPECT_EQ(policies.get(Type::Constant), LoadPolicy::Populate);
+  EXPECT_EQ(policies.get(Type::Backend), LoadPolicy::Lazy);
+  EXPECT_EQ(policies.get(Type::Mutable), LoadPolicy::WillNeed);
+  EXPECT_EQ(policies.get(Type::External), LoadPolicy::WillNeed);
+}
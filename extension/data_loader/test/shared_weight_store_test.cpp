@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_weight_data_loader.h>
+#include <executorch/extension/data_loader/shared_weight_store.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::BufferDataLoader;
+using executorch::extension::SharedWeightDataLoader;
+using executorch::extension::SharedWeightStore;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+const DataLoader::SegmentInfo kConstant(
+    DataLoader::SegmentInfo::Type::Constant);
+const DataLoader::SegmentInfo kExternal(
+    DataLoader::SegmentInfo::Type::External);
+const DataLoader::SegmentInfo kMutable(DataLoader::SegmentInfo::Type::Mutable);
+
+constexpr size_t kWeightSize = 8192;
+
+} // namespace
+
+class SharedWeightStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    char dir_template[] = "/tmp/shared_weight_store_test.XXXXXX";
+    ASSERT_NE(::mkdtemp(dir_template), nullptr);
+    directory_ = dir_template;
+
+    weights_.resize(kWeightSize);
+    for (size_t i = 0; i < weights_.size(); ++i) {
+      weights_[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+  }
+
+  void TearDown() override {
+    for (const std::string& name : entry_names()) {
+      ::unlink((directory_ + "/" + name).c_str());
+    }
+    ::rmdir(directory_.c_str());
+  }
+
+  std::vector<std::string> entry_names() const {
+    std::vector<std::string> names;
+    DIR* dir = ::opendir(directory_.c_str());
+    if (dir == nullptr) {
+      return names;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        names.emplace_back(entry->d_name);
+      }
+    }
+    ::closedir(dir);
+    return names;
+  }
+
+  /// A model file with `prefix_size` bytes of its own, then the weights.
+  std::vector<uint8_t> make_file(size_t prefix_size, uint8_t fill) const {
+    std::vector<uint8_t> file(prefix_size, fill);
+    file.insert(file.end(), weights_.begin(), weights_.end());
+    return file;
+  }
+
+  std::shared_ptr<SharedWeightStore> make_store() const {
+    Result<std::shared_ptr<SharedWeightStore>> store =
+        SharedWeightStore::from(directory_.c_str());
+    EXPECT_EQ(store.error(), Error::Ok);
+    return store.ok() ? store.get() : nullptr;
+  }
+
+  std::string directory_;
+  std::vector<uint8_t> weights_;
+};
+
+TEST_F(SharedWeightStoreTest, IdenticalWeightsShareOneMapping) {
+  const std::vector<uint8_t> file_a = make_file(100, 0xaa);
+  const std::vector<uint8_t> file_b = make_file(300, 0xbb);
+  auto store = make_store();
+  SharedWeightDataLoader loader_a(
+      std::make_unique<BufferDataLoader>(file_a.data(), file_a.size()),
+      store,
+      /*min_size=*/1024);
+  SharedWeightDataLoader loader_b(
+      std::make_unique<BufferDataLoader>(file_b.data(), file_b.size()),
+      store,
+      /*min_size=*/1024);
+
+  Result<FreeableBuffer> a = loader_a.load(100, kWeightSize, kConstant);
+  ASSERT_EQ(a.error(), Error::Ok);
+  Result<FreeableBuffer> b = loader_b.load(300, kWeightSize, kExternal);
+  ASSERT_EQ(b.error(), Error::Ok);
+
+  EXPECT_EQ(a->data(), b->data());
+  EXPECT_NE(a->data(), file_a.data() + 100);
+  EXPECT_EQ(std::memcmp(a->data(), weights_.data(), kWeightSize), 0);
+  EXPECT_EQ(store->num_mapped_entries(), 1);
+  EXPECT_EQ(entry_names().size(), 1);
+
+  a->Free();
+  EXPECT_EQ(store->num_mapped_entries(), 1);
+  b->Free();
+  EXPECT_EQ(store->num_mapped_entries(), 0);
+  // The entry stays on disk for other processes.
+  EXPECT_EQ(entry_names().size(), 1);
+}
+
+TEST_F(SharedWeightStoreTest, OtherSegmentsAreNotShared) {
+  const std::vector<uint8_t> file = make_file(0, 0);
+  auto store = make_store();
+  SharedWeightDataLoader loader(
+      std::make_unique<BufferDataLoader>(file.data(), file.size()),
+      store,
+      /*min_size=*/1024);
+
+  Result<FreeableBuffer> mutable_data = loader.load(0, kWeightSize, kMutable);
+  ASSERT_EQ(mutable_data.error(), Error::Ok);
+  EXPECT_EQ(mutable_data->data(), file.data());
+
+  Result<FreeableBuffer> small = loader.load(0, 512, kConstant);
+  ASSERT_EQ(small.error(), Error::Ok);
+  EXPECT_EQ(small->data(), file.data());
+
+  EXPECT_EQ(store->num_mapped_entries(), 0);
+  EXPECT_TRUE(entry_names().empty());
+}
+
+TEST_F(SharedWeightStoreTest, EntriesAreReusedByOtherStores) {
+  // A second store on the same directory stands in for another process.
+  {
+    auto first = make_store();
+    Result<FreeableBuffer> buffer =
+        first->get_or_insert(weights_.data(), weights_.size());
+    ASSERT_EQ(buffer.error(), Error::Ok);
+  }
+  ASSERT_EQ(entry_names().size(), 1);
+
+  auto second = make_store();
+  Result<FreeableBuffer> buffer =
+      second->get_or_insert(weights_.data(), weights_.size());
+  ASSERT_EQ(buffer.error(), Error::Ok);
+  EXPECT_EQ(std::memcmp(buffer->data(), weights_.data(), kWeightSize), 0);
+  EXPECT_EQ(entry_names().size(), 1);
+}
+
+TEST_F(SharedWeightStoreTest, MismatchedEntriesFallBackToTheLoader) {
+  {
+    auto store = make_store();
+    ASSERT_EQ(
+        store->get_or_insert(weights_.data(), weights_.size()).error(),
+        Error::Ok);
+  }
+  // Corrupt the entry, keeping its name and size.
+  const std::vector<std::string> names = entry_names();
+  ASSERT_EQ(names.size(), 1);
+  const std::string path = directory_ + "/" + names[0];
+  FILE* f = std::fopen(path.c_str(), "r+b");
+  ASSERT_NE(f, nullptr);
+  std::fputc(~weights_[0] & 0xff, f);
+  std::fclose(f);
+
+  auto store = make_store();
+  EXPECT_EQ(
+      store->get_or_insert(weights_.data(), weights_.size()).error(),
+      Error::NotFound);
+
+  const std::vector<uint8_t> file = make_file(0, 0);
+  SharedWeightDataLoader loader(
+      std::make_unique<BufferDataLoader>(file.data(), file.size()),
+      store,
+      /*min_size=*/1024);
+  Result<FreeableBuffer> buffer = loader.load(0, kWeightSize, kConstant);
+  ASSERT_EQ(buffer.error(), Error::Ok);
+  EXPECT_EQ(buffer->data(), file.data());
+}
+
+TEST_F(SharedWeightStoreTest, BuffersKeepTheStoreAlive) {
+  auto store = make_store();
+  Result<FreeableBuffer> buffer =
+      store->get_or_insert(weights_.data(), weights_.size());
+  ASSERT_EQ(buffer.error(), Error::Ok);
+  store.reset();
+  EXPECT_EQ(std::memcmp(buffer->data(), weights_.data(), kWeightSize), 0);
+  buffer->Free();
+}
+
+TEST_F(SharedWeightStoreTest, InvalidDirectoryFails) {
+  const std::string missing = directory_ + "/missing";
+  EXPECT_EQ(
+      SharedWeightStore::from(missing.c_str()).error(), Error::AccessFailed);
+}
@@ -59,3 +59,52 @@ def define_common_targets():
             "//executorch/extension/data_loader:mmap_data_loader",
         ],
     )
+
+    runtime.cxx_test(
+        name = "prefetching_data_loader_test",
+        srcs = [
+            "prefetching_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/data_loader:file_data_loader",
+            "//executorch/extension/data_loader:prefetching_data_loader",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "streaming_data_loader_test",
+        srcs = [
+            "streaming_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/data_loader:streaming_data_loader",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "shared_weight_store_test",
+        srcs = [
+            "shared_weight_store_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/data_loader:shared_weight_store",
+        ],
+    )
+
+    runtime.cxx_binary(
+        name = "mmap_data_loader_benchmark",
+        srcs = [
+            "mmap_data_loader_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:mmap_data_loader",
+            "//executorch/extension/memory_allocator:malloc_memory_allocator",
+            "//executorch/extension/runner_util:inputs",
+            "//executorch/kernels/portable:generated_lib",
+            "//executorch/runtime/executor:program",
+        ],
+    )
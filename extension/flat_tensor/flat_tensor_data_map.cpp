@@ -19,6 +19,9 @@
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/compiler.h>
 
+#include <algorithm>
+#include <cinttypes>
+
 using executorch::runtime::Error;
 using executorch::runtime::FreeableBuffer;
 using executorch::runtime::Result;
@@ -44,46 +47,83 @@ bool is_aligned(const void* data) {
   return addr % kMinimumAlignment == 0;
 }
 
+using NamedDataVector =
+    flatbuffers::Vector<flatbuffers::Offset<flat_tensor_flatbuffer::NamedData>>;
+
+executorch::aten::string_view key_at(
+    const NamedDataVector* named_data,
+    uint32_t index) {
+  const auto* key = named_data->Get(index)->key();
+  return executorch::aten::string_view(key->c_str(), key->size());
+}
+
+/**
+ * Returns the indices of `named_data` ordered by key. Entries with equal keys
+ * keep their original order, so lookups find the first of them.
+ */
+Result<std::vector<uint32_t>> build_key_index(
+    const NamedDataVector* named_data) {
+  std::vector<uint32_t> index(named_data->size());
+  for (uint32_t i = 0; i < index.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        named_data->Get(i) != nullptr && named_data->Get(i)->key() != nullptr,
+        InvalidExternalData,
+        "NamedData entry %" PRIu32 " has no key, malformed PTD file.",
+        i);
+    index[i] = i;
+  }
+  auto less = [named_data](uint32_t a, uint32_t b) {
+    return key_at(named_data, a) < key_at(named_data, b);
+  };
+  // Serializers usually emit keys in order already, which makes this O(n).
+  if (!std::is_sorted(index.begin(), index.end(), less)) {
+    std::stable_sort(index.begin(), index.end(), less);
+  }
+  return index;
+}
+
 Result<const flat_tensor_flatbuffer::NamedData*> get_named_data(
     executorch::aten::string_view key,
-    const flatbuffers::Vector<
-        flatbuffers::Offset<flat_tensor_flatbuffer::NamedData>>* named_data,
+    const NamedDataVector* named_data,
+    const std::vector<uint32_t>& key_index,
     const flatbuffers::Vector<
         flatbuffers::Offset<flat_tensor_flatbuffer::DataSegment>>* segments,
     size_t segment_end_offset) {
-  // Linear search by name.
+  // Binary search by name.
   if (named_data == nullptr) {
     return Error::NotFound;
   }
-  for (int i = 0; i < named_data->size(); i++) {
-    if (std::strncmp(
-            named_data->Get(i)->key()->c_str(),
-            key.data(),
-            named_data->Get(i)->key()->size()) == 0) {
-      const auto* found = named_data->Get(i);
-      // Validate the named_data.
-      size_t segment_index = found->segment_index();
-      ET_CHECK_OR_RETURN_ERROR(
-          segment_index >= 0 && segment_index < segments->size(),
-          InvalidExternalData,
-          "Segment index %zu for key %.*s is out of bounds for segment size %d. Malformed PTD file.",
-          segment_index,
-          static_cast<int>(key.size()),
-          key.data(),
-          segments->size());
-      // Validate the segment.
-      ET_CHECK_OR_RETURN_ERROR(
-          segments->Get(segment_index)->offset() < segment_end_offset,
-          InvalidExternalData,
-          "Invalid segment offset %" PRIu64
-          " is larger than the segment_base_offset + segment_data_size %" PRIu64
-          "; malformed PTD file.",
-          segments->Get(segment_index)->offset(),
-          static_cast<uint64_t>(segment_end_offset));
-      return found;
-    }
+  auto it = std::lower_bound(
+      key_index.begin(),
+      key_index.end(),
+      key,
+      [named_data](uint32_t index, executorch::aten::string_view key) {
+        return key_at(named_data, index) < key;
+      });
+  if (it == key_index.end() || key_at(named_data, *it) != key) {
+    return Error::NotFound;
   }
-  return Error::NotFound;
+  const auto* found = named_data->Get(*it);
+  // Validate the named_data.
+  size_t segment_index = found->segment_index();
+  ET_CHECK_OR_RETURN_ERROR(
+      segment_index >= 0 && segment_index < segments->size(),
+      InvalidExternalData,
+      "Segment index %zu for key %.*s is out of bounds for segment size %d. Malformed PTD file.",
+      segment_index,
+      static_cast<int>(key.size()),
+      key.data(),
+      segments->size());
+  // Validate the segment.
+  ET_CHECK_OR_RETURN_ERROR(
+      segments->Get(segment_index)->offset() < segment_end_offset,
+      InvalidExternalData,
+      "Invalid segment offset %" PRIu64
+      " is larger than the segment_base_offset + segment_data_size %" PRIu64
+      "; malformed PTD file.",
+      segments->Get(segment_index)->offset(),
+      static_cast<uint64_t>(segment_end_offset));
+  return found;
 }
 
 Result<const TensorLayout> create_tensor_layout(
@@ -106,6 +146,7 @@ ET_NODISCARD Result<const TensorLayout> FlatTensorDataMap::get_tensor_layout(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      key_index_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -119,6 +160,7 @@ ET_NODISCARD Result<FreeableBuffer> FlatTensorDataMap::get_data(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      key_index_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -143,6 +185,7 @@ ET_NODISCARD Error FlatTensorDataMap::load_data_into(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      key_index_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -261,8 +304,18 @@ ET_NODISCARD Result<const char*> FlatTensorDataMap::get_key(
       InvalidExternalData,
       "FlatTensor segments is nullptr, malformed PTD file.");
 
+  Result<std::vector<uint32_t>> key_index =
+      build_key_index(flat_tensor->named_data());
+  if (!key_index.ok()) {
+    return key_index.error();
+  }
+
   return FlatTensorDataMap(
-      fh.get(), std::move(flat_tensor_data.get()), flat_tensor, loader);
+      fh.get(),
+      std::move(flat_tensor_data.get()),
+      flat_tensor,
+      loader,
+      std::move(key_index.get()));
 }
 
 } // namespace extension
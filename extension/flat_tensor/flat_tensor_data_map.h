@@ -18,7 +18,9 @@
 #include <executorch/runtime/core/tensor_layout.h>
 #include <executorch/runtime/platform/compiler.h>
 
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 // Forward declare flatbuffer types. This is a public header and must not
 // include the generated flatbuffer header.
@@ -103,11 +105,13 @@ class FlatTensorDataMap final
       const FlatTensorHeader& header,
       executorch::runtime::FreeableBuffer&& flat_tensor_data,
       const flat_tensor_flatbuffer::FlatTensor* flat_tensor,
-      executorch::runtime::DataLoader* loader)
+      executorch::runtime::DataLoader* loader,
+      std::vector<uint32_t>&& key_index)
       : header_(header),
         flat_tensor_data_(std::move(flat_tensor_data)),
         flat_tensor_(flat_tensor),
-        loader_(loader) {}
+        loader_(loader),
+        key_index_(std::move(key_index)) {}
 
   // Not copyable or assignable.
   FlatTensorDataMap(const FlatTensorDataMap& rhs) = delete;
@@ -125,6 +129,10 @@ class FlatTensorDataMap final
 
   // Data loader, used to load segment data.
   executorch::runtime::DataLoader* loader_;
+
+  // Indices into flat_tensor_->named_data(), ordered by key, so that lookups
+  // are a binary search instead of a scan over every entry.
+  std::vector<uint32_t> key_index_;
 };
 
 } // namespace extension
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Measures FlatTensorDataMap load and lookup time on a synthetic .ptd file
+ * with many small tensors: reports the time for FlatTensorDataMap::load(),
+ * and for looking up the layout of every key.
+ *
+ * Usage: flat_tensor_data_map_benchmark [num_tensors] [iterations]
+ */
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
+#include <executorch/extension/flat_tensor/serialize/serialize.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using executorch::extension::BufferDataLoader;
+using executorch::extension::FlatTensorDataMap;
+using executorch::extension::TensorPtr;
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+using executorch::runtime::TensorLayout;
+
+namespace {
+
+double elapsed_us(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_tensors =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+  if (num_tensors == 0 || iterations == 0) {
+    std::fprintf(stderr, "Usage: %s [num_tensors] [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  executorch::runtime::runtime_init();
+
+  // Names shaped like the parameters of a large model, e.g.
+  // "layers.12.attention.wq.weight".
+  const char* kSuffixes[] = {
+      "attention.wq.weight",
+      "attention.wk.weight",
+      "attention.wv.weight",
+      "attention.wo.weight",
+      "feed_forward.w1.weight",
+      "feed_forward.w2.weight",
+      "feed_forward.w3.weight",
+      "attention_norm.weight",
+  };
+  constexpr size_t kNumSuffixes = sizeof(kSuffixes) / sizeof(kSuffixes[0]);
+  std::vector<std::string> keys;
+  keys.reserve(num_tensors);
+  for (size_t i = 0; i < num_tensors; ++i) {
+    keys.push_back(
+        "layers." + std::to_string(i / kNumSuffixes) + "." +
+        kSuffixes[i % kNumSuffixes]);
+  }
+
+  std::vector<float> data(num_tensors * 4, 1.0f);
+  std::vector<TensorPtr> tensors;
+  std::map<std::string, executorch::aten::Tensor> tensor_map;
+  tensors.reserve(num_tensors);
+  for (size_t i = 0; i < num_tensors; ++i) {
+    tensors.push_back(
+        executorch::extension::make_tensor_ptr({2, 2}, &data[i * 4]));
+    tensor_map.emplace(keys[i], *tensors.back());
+  }
+  std::ostringstream out;
+  if (executorch::extension::flat_tensor::save_ptd(out, tensor_map, 16) !=
+      Error::Ok) {
+    std::fprintf(stderr, "save_ptd failed\n");
+    return 1;
+  }
+  const std::string serialized = out.str();
+  // FlatTensorDataMap requires aligned data.
+  std::vector<std::max_align_t> file(
+      serialized.size() / sizeof(std::max_align_t) + 1);
+  std::memcpy(file.data(), serialized.data(), serialized.size());
+  BufferDataLoader loader(file.data(), serialized.size());
+
+  double load_us = 0;
+  double lookup_us = 0;
+  for (size_t it = 0; it < iterations; ++it) {
+    auto start = std::chrono::steady_clock::now();
+    Result<FlatTensorDataMap> data_map = FlatTensorDataMap::load(&loader);
+    load_us += elapsed_us(start);
+    if (!data_map.ok()) {
+      std::fprintf(
+          stderr,
+          "FlatTensorDataMap::load failed: 0x%x\n",
+          (unsigned)data_map.error());
+      return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& key : keys) {
+      Result<const TensorLayout> layout =
+          data_map->get_tensor_layout(key.c_str());
+      if (!layout.ok()) {
+        std::fprintf(stderr, "Lookup of %s failed\n", key.c_str());
+        return 1;
+      }
+    }
+    lookup_us += elapsed_us(start);
+  }
+
+  std::printf(
+      "%zu tensors, %zu B file, %zu iterations\n",
+      num_tensors,
+      serialized.size(),
+      iterations);
+  std::printf("load():         %.1f us\n", load_us / iterations);
+  std::printf(
+      "look up all:    %.1f us (%.1f ns/key)\n",
+      lookup_us / iterations,
+      lookup_us * 1000 / (iterations * num_tensors));
+  return 0;
+}
@@ -23,6 +23,8 @@ def define_common_targets(is_fbcode=False):
             "test_serialize.cpp",
         ],
         deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/flat_tensor:flat_tensor_data_map",
             "//executorch/extension/flat_tensor/serialize:serialize_cpp",
             "//executorch/extension/flat_tensor/serialize:generated_headers",
             "//executorch/extension/flat_tensor/serialize:flat_tensor_header",
@@ -30,6 +32,19 @@ def define_common_targets(is_fbcode=False):
         ],
     )
 
+    runtime.cxx_binary(
+        name = "flat_tensor_data_map_benchmark",
+        srcs = [
+            "flat_tensor_data_map_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/flat_tensor:flat_tensor_data_map",
+            "//executorch/extension/flat_tensor/serialize:serialize_cpp",
+            "//executorch/extension/tensor:tensor",
+        ],
+    )
+
     if not runtime.is_oss and is_fbcode:
         modules_env = {
             # The tests use this var to find the program file to load. This uses
@@ -8,6 +8,8 @@
 
 #include <executorch/extension/flat_tensor/serialize/serialize.h>
 
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
 #include <executorch/extension/flat_tensor/serialize/flat_tensor_generated.h>
 #include <executorch/extension/flat_tensor/serialize/flat_tensor_header.h>
 #include <executorch/extension/flat_tensor/serialize/scalar_type_generated.h>
@@ -17,12 +19,18 @@
 #include <executorch/runtime/platform/runtime.h>
 
 #include <gtest/gtest.h>
+#include <cstddef>
+#include <cstring>
 #include <map>
 #include <sstream>
+#include <vector>
 
 using namespace ::testing;
+using executorch::extension::BufferDataLoader;
+using executorch::extension::FlatTensorDataMap;
 using executorch::runtime::Error;
 using executorch::runtime::Result;
+using executorch::runtime::TensorLayout;
 
 class FlatTensorSerializeTest : public ::testing::Test {
  protected:
@@ -132,3 +140,60 @@ TEST_F(FlatTensorSerializeTest, ValidFlatTensorSerialized) {
   EXPECT_EQ(*(float*)(data + 0), linear_bias);
   EXPECT_EQ(*(float*)(data + 16), linear_weight);
 }
+
+TEST_F(FlatTensorSerializeTest, DataMapLooksUpExactKeys) {
+  // Keys that are prefixes of one another must not match each other.
+  float a_data[1] = {1.0f};
+  float ab_data[2] = {2.0f, 2.0f};
+  float b_data[3] = {3.0f, 3.0f, 3.0f};
+  auto a = executorch::extension::make_tensor_ptr({1}, a_data);
+  auto ab = executorch::extension::make_tensor_ptr({2}, ab_data);
+  auto b = executorch::extension::make_tensor_ptr({3}, b_data);
+  std::map<std::string, executorch::aten::Tensor> flat_tensor_map = {
+      {"a", *a}, {"ab", *ab}, {"b", *b}};
+
+  std::ostringstream buf;
+  ASSERT_EQ(
+      executorch::extension::flat_tensor::save_ptd(buf, flat_tensor_map, 16),
+      Error::Ok);
+  // FlatTensorDataMap requires aligned data.
+  const std::string serialized = buf.str();
+  std::vector<std::max_align_t> aligned(
+      serialized.size() / sizeof(std::max_align_t) + 1);
+  std::memcpy(aligned.data(), serialized.data(), serialized.size());
+  BufferDataLoader loader(aligned.data(), serialized.size());
+
+  Result<FlatTensorDataMap> data_map = FlatTensorDataMap::load(&loader);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+
+  for (const auto& entry : flat_tensor_map) {
+    Result<const TensorLayout> layout =
+        data_map->get_tensor_layout(entry.first.c_str());
+    ASSERT_EQ(layout.error(), Error::Ok);
+    EXPECT_EQ(layout->sizes()[0], entry.second.size(0));
+  }
+  EXPECT_EQ(data_map->get_tensor_layout("").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_tensor_layout("abc").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_tensor_layout("c").error(), Error::NotFound);
+
+  // Keys are still reported in file order, which is the order they were
+  // inserted in, and each tensor's data follows the previous one's.
+  auto flat_tensor = ::flat_tensor_flatbuffer::GetFlatTensor(aligned.data());
+  ASSERT_EQ(flat_tensor->named_data()->size(), flat_tensor_map.size());
+  uint32_t index = 0;
+  uint64_t previous_offset = 0;
+  for (const auto& entry : flat_tensor_map) {
+    Result<const char*> key = data_map->get_key(index);
+    ASSERT_EQ(key.error(), Error::Ok);
+    EXPECT_STREQ(key.get(), entry.first.c_str());
+    const auto* named_data = flat_tensor->named_data()->Get(index);
+    EXPECT_STREQ(named_data->key()->c_str(), entry.first.c_str());
+    const uint64_t offset =
+        flat_tensor->segments()->Get(named_data->segment_index())->offset();
+    if (index > 0) {
+      EXPECT_GT(offset, previous_offset);
+    }
+    previous_offset = offset;
+    index++;
+  }
+}
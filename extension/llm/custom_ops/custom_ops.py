@@ -180,6 +180,75 @@ def custom_sdpa(
     return torch.empty_like(query)
 
 
+@impl(custom_ops_lib, "custom_sdpa_with_positions", "Meta")
+def custom_sdpa_with_positions(
+    query,
+    key_cache,
+    value_cache,
+    start_pos,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    assert (
+        start_pos.dim() == 1 and start_pos.size(0) == query.size(0)
+    ), f"Expected one start position per batch row but got shape {start_pos.shape}"
+    assert (
+        start_pos.dtype == torch.long
+    ), f"Expected start_pos to be of type torch.long but got {start_pos.dtype}"
+    assert is_causal, "Per-row start positions require is_causal=True"
+    assert attn_mask is None, "Per-row start positions do not support attn_mask"
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "custom_sdpa_paged", "Meta")
+def custom_sdpa_paged(
+    query,
+    key_cache,
+    value_cache,
+    block_table,
+    start_pos,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    assert (
+        key_cache.shape == value_cache.shape
+    ), f"Expected key and value caches of the same shape but got {key_cache.shape} and {value_cache.shape}"
+    _validate_paged_cache_params(query, key_cache, block_table, start_pos)
+    assert is_causal, "Paged attention requires is_causal=True"
+    assert attn_mask is None, "Paged attention does not support attn_mask"
+    return torch.empty_like(query)
+
+
+def _validate_paged_cache_params(value, cache, block_table, start_pos):
+    assert (
+        value.dim() == 4 and cache.dim() == 4
+    ), f"Expected 4 dimensional value and cache but got {value.dim()} and {cache.dim()} dimensions."
+    for i in [2, 3]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+    block_size = cache.size(1)
+    assert block_size > 0 and (
+        block_size % 16 == 0 or block_size & (block_size - 1) == 0
+    ), f"Expected block_size to be a power of two or a multiple of 16 but got {block_size}"
+    assert (
+        block_table.dim() == 2 and block_table.size(0) == value.size(0)
+    ), f"Expected block_table of shape [batch, max_blocks_per_seq] but got {block_table.shape}"
+    assert (
+        block_table.dtype == torch.int64
+    ), f"Expected block_table to be int64 but got {block_table.dtype}"
+    assert (
+        start_pos.dim() == 1 and start_pos.size(0) == value.size(0)
+    ), f"Expected one start position per batch row but got shape {start_pos.shape}"
+    assert (
+        start_pos.dtype == torch.int64
+    ), f"Expected start_pos to be int64 but got {start_pos.dtype}"
+
+
 def _validate_update_cache_params(
     value,
     cache,
@@ -265,6 +334,66 @@ def update_cache_with_indices_meta(
     return torch.empty((1,), dtype=value.dtype, device="meta")
 
 
+@impl(custom_ops_lib, "update_cache_paged", "Meta")
+def update_cache_paged_meta(
+    value,
+    cache,
+    block_table,
+    start_pos,
+):
+    assert (
+        value.dtype == cache.dtype
+    ), f"Expected value and cache to be of the same type but got value type {value.dtype} and cache type {cache.dtype}"
+    _validate_paged_cache_params(value, cache, block_table, start_pos)
+
+    # Same placeholder output as update_cache.
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+@impl(custom_ops_lib, "update_quantized_cache", "Meta")
+def update_quantized_cache_meta(
+    value,
+    cache,
+    scales,
+    zero_points,
+    start_pos,
+):
+    assert (
+        value.dtype == torch.float32
+    ), f"Expected value to be float32 but got {value.dtype}"
+    assert cache.dtype in (
+        torch.int8,
+        torch.uint8,
+    ), f"Expected cache to be int8, or uint8 with packed int4 pairs, but got {cache.dtype}"
+    assert (
+        value.dim() == 4 and cache.dim() == 4
+    ), f"Expected 4 dimensional value and cache but got {value.dim()} and {cache.dim()} dimensions."
+    packing = 2 if cache.dtype == torch.uint8 else 1
+    for i in [0, 2]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+    assert (
+        value.size(3) == cache.size(3) * packing
+    ), f"Expected value head dim {value.size(3)} to be {packing} times cache head dim {cache.size(3)}"
+    assert (
+        scales.dtype == torch.float32
+    ), f"Expected scales to be float32 but got {scales.dtype}"
+    assert (
+        zero_points.dtype == torch.int8
+    ), f"Expected zero_points to be int8 but got {zero_points.dtype}"
+    for qparams in [scales, zero_points]:
+        assert (
+            qparams.size()[:-1] == cache.size()[:-1] and qparams.size(-1) == 1
+        ), f"Expected scales and zero_points of shape {cache.size()[:-1]} + (1,) but got {qparams.size()}"
+
+    torch._check_is_size(start_pos)
+    torch._check((start_pos + value.size(1)) <= cache.size(1))
+
+    # Same placeholder output as update_cache.
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
 def _validate_quantized_sdpa_params(
     query,
     key,
@@ -293,9 +422,24 @@ def _validate_quantized_sdpa_params(
         value.dim() == 4
     ), f"Expected value to be 4 dimensional but got {value.dim()} dimensions."
 
-    assert (q_scale is not None) and (
-        q_zero_point is not None
-    ), "q_scale and q_zero_point must be provided"
+    # A float query can also attend over an int8 KV cache, or over an int4
+    # one packed two values per uint8, as written by update_quantized_cache.
+    is_kv_quantized = query.dtype == torch.float32
+    if is_kv_quantized:
+        assert (q_scale is None) and (
+            q_zero_point is None
+        ), "q_scale and q_zero_point must not be provided for a float query"
+        assert key.dtype in (
+            torch.int8,
+            torch.uint8,
+        ), f"Expected key to be int8 or uint8 but got {key.dtype}"
+        assert (
+            value.dtype == key.dtype
+        ), f"Expected value to be {key.dtype} but got {value.dtype}"
+    else:
+        assert (q_scale is not None) and (
+            q_zero_point is not None
+        ), "q_scale and q_zero_point must be provided"
     assert (k_scale is not None) and (
         k_zero_point is not None
     ), "k_scale and k_zero_point must be provided"
@@ -303,16 +447,27 @@ def _validate_quantized_sdpa_params(
         v_zero_point is not None
     ), "v_scale and v_zero_point must be provided"
 
-    assert query.dtype == torch.int8, f"Expected query to be int8 but got {query.dtype}"
-    assert key.dtype == torch.int8, f"Expected key to be int8 but got {key.dtype}"
-    assert value.dtype == torch.int8, f"Expected value to be int8 but got {value.dtype}"
+    if not is_kv_quantized:
+        assert (
+            query.dtype == torch.int8
+        ), f"Expected query to be int8 but got {query.dtype}"
+        assert key.dtype == torch.int8, f"Expected key to be int8 but got {key.dtype}"
+        assert (
+            value.dtype == torch.int8
+        ), f"Expected value to be int8 but got {value.dtype}"
 
-    assert (
-        q_scale.dtype == torch.float32
-    ), f"Expected q_scale to be float32 but got {q_scale.dtype}"
-    assert (
-        q_zero_point.dtype == torch.int8
-    ), f"Expected q_zero_point to be int8 but got {q_zero_point.dtype}"
+        assert (
+            q_scale.dtype == torch.float32
+        ), f"Expected q_scale to be float32 but got {q_scale.dtype}"
+        assert (
+            q_zero_point.dtype == torch.int8
+        ), f"Expected q_zero_point to be int8 but got {q_zero_point.dtype}"
+        assert (
+            query.size()[:-1] == q_scale.size()[:-1]
+        ), f"Expected query and q_scale to have same size except last dimensions but got {query.size()} and {q_scale.size()}"
+        assert (
+            query.size()[:-1] == q_zero_point.size()[:-1]
+        ), f"Expected query and q_zero_point to have same size except last dimensions but got {query.size()} and {q_zero_point.size()}"
     assert (
         k_scale.dtype == torch.float32
     ), f"Expected k_scale to be float32 but got {k_scale.dtype}"
@@ -326,13 +481,6 @@ def _validate_quantized_sdpa_params(
         v_zero_point.dtype == torch.int8
     ), f"Expected v_zero_point to be int8 but got {v_zero_point.dtype}"
 
-    assert (
-        query.size()[:-1] == q_scale.size()[:-1]
-    ), f"Expected query and q_scale to have same size except last dimensions but got {query.size()} and {q_scale.size()}"
-    assert (
-        query.size()[:-1] == q_zero_point.size()[:-1]
-    ), f"Expected query and q_zero_point to have same size except last dimensions but got {query.size()} and {q_zero_point.size()}"
-
     assert (
         key.size()[:-1] == k_scale.size()[:-1]
     ), f"Expected key and k_scale to have same size except last dimensions but got {key.size()} and {k_scale.size()}"
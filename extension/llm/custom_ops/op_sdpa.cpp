@@ -9,6 +9,8 @@
 #include <executorch/extension/llm/custom_ops/op_sdpa.h>
 #include <executorch/extension/llm/custom_ops/op_sdpa_impl.h>
 
+#include <algorithm>
+
 #include <ATen/cpu/vec/functional.h>
 #include <ATen/cpu/vec/vec.h>
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
@@ -38,9 +40,17 @@ bool validate_flash_attention_args(
   ET_CHECK_OR_RETURN_FALSE(key.dim() == 4, "key must be a 4D tensor");
   ET_CHECK_OR_RETURN_FALSE(value.dim() == 4, "value must be a 4D tensor");
 
+  // A float query can attend over an int8 cache, or over an int4 cache
+  // packed two values per uint8.
+  const bool is_kv_quantized = query.scalar_type() == ScalarType::Float &&
+      (key.scalar_type() == ScalarType::Char ||
+       key.scalar_type() == ScalarType::Byte);
+  const int64_t kv_packing = key.scalar_type() == ScalarType::Byte ? 2 : 1;
+
   // Sizes
   ET_CHECK_OR_RETURN_FALSE(
-      (query.size(3) == value.size(3)) && (key.size(3) == value.size(3)),
+      (query.size(3) == value.size(3) * kv_packing) &&
+          (key.size(3) == value.size(3)),
       "scaled_dot_product_attention_flash_attention: Q/K/V should have the same head size");
 
   ET_CHECK_OR_RETURN_FALSE(
@@ -49,8 +59,8 @@ bool validate_flash_attention_args(
       "Query must be Float type");
 
   ET_CHECK_OR_RETURN_FALSE(
-      (query.scalar_type() == key.scalar_type()) &&
-          (query.scalar_type() == value.scalar_type()),
+      (is_kv_quantized || query.scalar_type() == key.scalar_type()) &&
+          (key.scalar_type() == value.scalar_type()),
       "Key and Value must have the same data type as Query");
 
   ET_CHECK_OR_RETURN_FALSE(
@@ -96,7 +106,9 @@ bool validate_cache_quant_params_args(
       "Quantized tensor and scales must have the same number of dimensions");
 
   ET_CHECK_OR_RETURN_FALSE(
-      (t.scalar_type() == ScalarType::Char), "Tensor must be of int8_t type");
+      (t.scalar_type() == ScalarType::Char) ||
+          (t.scalar_type() == ScalarType::Byte),
+      "Tensor must be of int8_t type, or uint8_t with packed int4 pairs");
 
   ET_CHECK_OR_RETURN_FALSE(
       (t_scales.scalar_type() == ScalarType::Float),
@@ -178,6 +190,80 @@ bool validate_cache_params(
   return true;
 }
 
+bool validate_start_pos_per_batch(
+    const Tensor& q,
+    const Tensor& start_pos,
+    int64_t seq_length,
+    int64_t kv_size) {
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.scalar_type() == ScalarType::Long,
+      "start_pos must be of Long (int64_t) type");
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.dim() == 1 && start_pos.size(0) == q.size(0),
+      "start_pos must be a 1D tensor with one position per batch row");
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  for (int64_t i = 0; i < start_pos.numel(); ++i) {
+    ET_CHECK_OR_RETURN_FALSE(
+        start_pos_data[i] >= 0 && start_pos_data[i] + seq_length <= kv_size,
+        "start_pos[%" PRId64 "] + seq_length = %" PRId64
+        " must be in [0, %" PRId64 "]",
+        i,
+        start_pos_data[i] + seq_length,
+        kv_size);
+  }
+  return true;
+}
+
+// Checks that every block that the attention for each batch row reads, up to
+// start_pos[b] + seq_length, is a valid block of the pool.
+bool validate_block_table(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    int64_t seq_length) {
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.scalar_type() == ScalarType::Long,
+      "block_table must be of Long (int64_t) type");
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.dim() == 2 && block_table.size(0) == q.size(0),
+      "block_table must be a 2D tensor [batch_size, max_blocks_per_seq]");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(
+          block_table.dim_order().data(), block_table.dim()),
+      "block_table must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      k.size(0) == v.size(0) && k.size(1) == v.size(1),
+      "key and value caches must have the same number and size of blocks");
+
+  const int64_t num_blocks = k.size(0);
+  const int64_t block_size = k.size(1);
+  ET_CHECK_OR_RETURN_FALSE(
+      sdpa::impl::PagedKVCache::is_valid_block_size(block_size),
+      "block_size %" PRId64 " must be a power of two or a multiple of 16",
+      block_size);
+  const int64_t max_blocks_per_seq = block_table.size(1);
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < block_table.size(0); ++b) {
+    const int64_t num_used_blocks =
+        (start_pos_data[b] + seq_length + block_size - 1) / block_size;
+    for (int64_t n = 0; n < num_used_blocks; ++n) {
+      const int64_t block = block_table_data[b * max_blocks_per_seq + n];
+      ET_CHECK_OR_RETURN_FALSE(
+          block >= 0 && block < num_blocks,
+          "block_table[%" PRId64 "][%" PRId64 "] = %" PRId64
+          " must be in [0, %" PRId64 ")",
+          b,
+          n,
+          block,
+          num_blocks);
+    }
+  }
+  return true;
+}
+
 // TODO: seq_length is not yet used for copy
 void update_cache(
     const Tensor& projected_value,
@@ -342,7 +428,9 @@ Tensor& custom_sdpa_out_impl(
     const optional<Tensor>& k_scales = nullopt,
     const optional<Tensor>& v_zero_points = nullopt,
     const optional<Tensor>& v_scales = nullopt,
-    bool is_seq_at_dim_2 = false) {
+    bool is_seq_at_dim_2 = false,
+    const optional<Tensor>& start_pos_per_batch = nullopt,
+    const optional<Tensor>& block_table = nullopt) {
   ET_KERNEL_CHECK_MSG(
       ctx,
       !attn_mask.has_value() || !is_causal,
@@ -396,12 +484,92 @@ Tensor& custom_sdpa_out_impl(
         InvalidArgument,
         output,
         "Invalid arguments for quantized value");
+  } else if (k.scalar_type() != q.scalar_type()) {
+    // Float query over a quantized KV cache.
+    if (seq_dim == SeqDim::TWO) {
+      seq_len = q.size(2);
+    }
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        !q_scales.has_value() && !q_zero_points.has_value() &&
+            k_scales.has_value() && k_zero_points.has_value() &&
+            v_scales.has_value() && v_zero_points.has_value(),
+        InvalidArgument,
+        output,
+        "A quantized KV cache needs k and v quant params, and a float q none");
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        validate_cache_quant_params_args(
+            k, k_zero_points.value(), k_scales.value()),
+        InvalidArgument,
+        output,
+        "Invalid arguments for quantized key");
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        validate_cache_quant_params_args(
+            v, v_zero_points.value(), v_scales.value()),
+        InvalidArgument,
+        output,
+        "Invalid arguments for quantized value");
   }
 
   ET_CHECK_MSG(q.dim() == 4, "query must be a 4D tensor");
 
-  const int64_t num_keys_for_causal_attention =
+  int64_t num_keys_for_causal_attention =
       attn_mask.has_value() ? -1 : start_pos + seq_len;
+  const int64_t* start_pos_data = nullptr;
+  if (start_pos_per_batch.has_value()) {
+    int64_t kv_size = seq_dim == SeqDim::ONE ? k.size(1) : k.size(2);
+    if (block_table.has_value()) {
+      // Logical length of each row of a paged cache; the shape of the block
+      // table is checked below.
+      kv_size = block_table.value().dim() == 2
+          ? block_table.value().size(1) * k.size(1)
+          : 0;
+    }
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        validate_start_pos_per_batch(
+            q, start_pos_per_batch.value(), seq_len, kv_size),
+        InvalidArgument,
+        output,
+        "Invalid start positions");
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        is_causal,
+        InvalidArgument,
+        output,
+        "Per-batch start positions require is_causal");
+    start_pos_data = start_pos_per_batch.value().const_data_ptr<int64_t>();
+    num_keys_for_causal_attention =
+        *std::max_element(
+            start_pos_data, start_pos_data + start_pos_per_batch->numel()) +
+        seq_len;
+  }
+
+  sdpa::impl::PagedKVCache paged_kv{};
+  const sdpa::impl::PagedKVCache* paged_kv_ptr = nullptr;
+  if (block_table.has_value()) {
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        start_pos_per_batch.has_value() && seq_dim == SeqDim::ONE &&
+            q.scalar_type() == ScalarType::Float &&
+            k.scalar_type() == ScalarType::Float,
+        InvalidArgument,
+        output,
+        "Paged KV cache requires per-batch start positions and float inputs");
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        validate_block_table(
+            q, k, v, block_table.value(), start_pos_per_batch.value(), seq_len),
+        InvalidArgument,
+        output,
+        "Invalid block table");
+    paged_kv.block_table = block_table.value().const_data_ptr<int64_t>();
+    paged_kv.max_blocks_per_seq = block_table.value().size(1);
+    paged_kv.block_size = k.size(1);
+    paged_kv_ptr = &paged_kv;
+  }
 
   ET_KERNEL_CHECK(
       ctx,
@@ -409,6 +577,13 @@ Tensor& custom_sdpa_out_impl(
       InvalidArgument,
       output);
 
+  // A single query token, as in a decode step, goes to a kernel that reads
+  // each KV head once for all the query heads sharing it and splits long
+  // caches across threads.
+  const int64_t q_len = seq_dim == SeqDim::ONE ? q.size(1) : q.size(2);
+  const bool use_decode_kernel = q_len == 1 && !attn_mask.has_value() &&
+      q.scalar_type() != ScalarType::Char;
+
   // TODO(task): replace the template param selection logic
   // with whatever apprpriately makes more sense for
   ET_SWITCH_FLOAT_TYPES(
@@ -416,7 +591,24 @@ Tensor& custom_sdpa_out_impl(
         // TODO we need to re-evaluate this for ARM CPUs
         // And there can be many so instead of templatizing
         // we might consider another appraoch
-        if (seq_len >= 768) {
+        if (use_decode_kernel) {
+          sdpa::impl::cpu_flash_attention_decode<CTYPE>(
+              output,
+              q,
+              k,
+              v,
+              is_causal,
+              scale,
+              k_zero_points,
+              k_scales,
+              v_zero_points,
+              v_scales,
+              seq_dim,
+              start_pos,
+              num_keys_for_causal_attention,
+              start_pos_data,
+              paged_kv_ptr);
+        } else if (seq_len >= 768) {
           sdpa::impl::cpu_flash_attention<CTYPE, 256, 512>(
               output,
               q,
@@ -434,7 +626,9 @@ Tensor& custom_sdpa_out_impl(
               v_scales, // v_scales
               seq_dim, /* seq_dim */
               start_pos,
-              num_keys_for_causal_attention);
+              num_keys_for_causal_attention,
+              start_pos_data,
+              paged_kv_ptr);
         } else if (seq_len >= 192) {
           sdpa::impl::cpu_flash_attention<CTYPE, 64, 512>(
               output,
@@ -453,7 +647,9 @@ Tensor& custom_sdpa_out_impl(
               v_scales, // v_scales
               seq_dim, /* seq_dim */
               start_pos,
-              num_keys_for_causal_attention);
+              num_keys_for_causal_attention,
+              start_pos_data,
+              paged_kv_ptr);
         } else {
           sdpa::impl::cpu_flash_attention<CTYPE, 32, 512>(
               output,
@@ -472,7 +668,9 @@ Tensor& custom_sdpa_out_impl(
               v_scales, // v_scales
               seq_dim, /* seq_dim */
               start_pos,
-              num_keys_for_causal_attention);
+              num_keys_for_causal_attention,
+              start_pos_data,
+              paged_kv_ptr);
         }
       });
   return output;
@@ -547,6 +745,91 @@ Tensor& custom_sdpa_out(
   return custom_sdpa_out_impl(
       ctx, q, k, v, start_pos, attn_mask, dropout_p, is_causal, scale, output);
 }
+/*
+  Same as custom_sdpa_out, but each batch row of q is at its own position.
+  Used to decode several independent sequences in one batch.
+  ....
+  @param[in] start_pos: [batch size] Long tensor with the sequence position
+  of each batch row.
+*/
+Tensor& custom_sdpa_with_positions_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  return custom_sdpa_out_impl(
+      ctx,
+      q,
+      k,
+      v,
+      /*start_pos=*/0,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      /*is_seq_at_dim_2=*/false,
+      start_pos);
+}
+
+/*
+  Same as custom_sdpa_with_positions_out, but key and value are pools of
+  fixed-size blocks shared by all sequences, read through a block table.
+  ....
+  @param[in] k: Key cache, [num blocks, block size, num heads, head dim]
+  @param[in] v: Value cache, same shape as k.
+  @param[in] block_table: [batch size, max blocks per seq] Long tensor. Row b
+  maps logical block n of batch row b to a block of k and v.
+  @param[in] start_pos: [batch size] Long tensor with the sequence position
+  of each batch row.
+*/
+Tensor& custom_sdpa_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  return custom_sdpa_out_impl(
+      ctx,
+      q,
+      k,
+      v,
+      /*start_pos=*/0,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      nullopt,
+      /*is_seq_at_dim_2=*/false,
+      start_pos,
+      block_table);
+}
 /*
   Input params
   @param[in] q_projected Projected query with query weights.
@@ -618,6 +901,16 @@ EXECUTORCH_LIBRARY(
     "custom_sdpa.out",
     torch::executor::native::custom_sdpa_out);
 
+EXECUTORCH_LIBRARY(
+    llama,
+    "custom_sdpa_with_positions.out",
+    torch::executor::native::custom_sdpa_with_positions_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "custom_sdpa_paged.out",
+    torch::executor::native::custom_sdpa_paged_out);
+
 EXECUTORCH_LIBRARY(
     llama,
     "custom_quantized_sdpa.out",
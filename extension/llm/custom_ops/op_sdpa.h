@@ -44,6 +44,33 @@ Tensor& custom_sdpa_out(
     const optional<double> scale,
     Tensor& output);
 
+Tensor& custom_sdpa_with_positions_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output);
+
+Tensor& custom_sdpa_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output);
+
 Tensor& flash_attention_kernel_out(
     KernelRuntimeContext& ctx,
     const Tensor& query,
@@ -56,6 +83,10 @@ Tensor& flash_attention_kernel_out(
     const optional<double> scale,
     Tensor& output);
 
+// Either q, k and v are all int8, or q is float and k and v are an int8 KV
+// cache, or an int4 one packed two values per uint8 (see
+// update_quantized_cache_out). In the second case, q_zero_points and
+// q_scales must be empty, and K/V tiles are dequantized as they are loaded.
 Tensor& custom_quantized_sdpa_out(
     RuntimeContext& ctx,
     const Tensor& q,
@@ -77,6 +77,62 @@ at::Tensor custom_sdpa_aten(
     // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
     const std::optional<double> scale);
 
+Tensor& custom_sdpa_with_positions_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output);
+
+at::Tensor custom_sdpa_with_positions_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale);
+
+Tensor& custom_sdpa_paged_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output);
+
+at::Tensor custom_sdpa_paged_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale);
+
 Tensor& custom_quantized_sdpa_out_no_context(
     const Tensor& q,
     const Tensor& k,
@@ -143,6 +199,34 @@ at::Tensor update_cache_with_indices_aten(
     const int64_t start_pos,
     const at::Tensor& indices);
 
+Tensor& update_cache_paged_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output);
+
+at::Tensor update_cache_paged_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos);
+
+Tensor& update_quantized_cache_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output);
+
+at::Tensor update_quantized_cache_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const int64_t start_pos);
+
 Tensor& sdpa_with_kv_cache_out_no_context(
     const Tensor& q_projected,
     const Tensor& k_projected,
@@ -253,6 +337,100 @@ at::Tensor custom_sdpa_aten(
   return output;
 }
 
+Tensor& custom_sdpa_with_positions_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::custom_sdpa_with_positions_out(
+      context,
+      q,
+      k,
+      v,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor custom_sdpa_with_positions_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(custom_sdpa_with_positions_out_no_context, 8)
+  (q, k, v, start_pos, attn_mask, dropout_p, is_causal, scale, output);
+  return output;
+}
+
+Tensor& custom_sdpa_paged_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::custom_sdpa_paged_out(
+      context,
+      q,
+      k,
+      v,
+      block_table,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor custom_sdpa_paged_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(custom_sdpa_paged_out_no_context, 9)
+  (q, k, v, block_table, start_pos, attn_mask, dropout_p, is_causal, scale,
+   output);
+  return output;
+}
+
 Tensor& custom_quantized_sdpa_out_no_context(
     const Tensor& q,
     const Tensor& k,
@@ -377,6 +555,52 @@ at::Tensor update_cache_with_indices_aten(
   return output;
 }
 
+Tensor& update_cache_paged_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_cache_paged_out(
+      context, value, cache, block_table, start_pos, output);
+}
+
+at::Tensor update_cache_paged_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_cache_paged_out_no_context, 4)
+  (value, cache, block_table, start_pos, output);
+  return output;
+}
+
+Tensor& update_quantized_cache_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_quantized_cache_out(
+      context, value, cache, scales, zero_points, start_pos, output);
+}
+
+at::Tensor update_quantized_cache_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const int64_t start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_quantized_cache_out_no_context, 5)
+  (value, cache, scales, zero_points, start_pos, output);
+  return output;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -398,6 +622,23 @@ TORCH_LIBRARY_FRAGMENT(llama, m) {
       "custom_sdpa.out(Tensor query, Tensor key, Tensor value, SymInt start_pos, "
       "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
       "float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
+  m.def(
+      "custom_sdpa_with_positions(Tensor query, Tensor key, Tensor value, "
+      "Tensor start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "custom_sdpa_with_positions.out(Tensor query, Tensor key, Tensor value, "
+      "Tensor start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
+  m.def(
+      "custom_sdpa_paged(Tensor query, Tensor key_cache, Tensor value_cache, "
+      "Tensor block_table, Tensor start_pos, Tensor? attn_mask=None, "
+      "float drpout_p=0.0, bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "custom_sdpa_paged.out(Tensor query, Tensor key_cache, "
+      "Tensor value_cache, Tensor block_table, Tensor start_pos, "
+      "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
   m.def(
       "update_cache(Tensor value, Tensor(a!) cache, "
       "SymInt start_pos) -> Tensor");
@@ -410,6 +651,19 @@ TORCH_LIBRARY_FRAGMENT(llama, m) {
   m.def(
       "update_cache_with_indices.out(Tensor value, Tensor(a!) cache, "
       "SymInt start_pos, Tensor indices, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "update_cache_paged(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, Tensor start_pos) -> Tensor");
+  m.def(
+      "update_cache_paged.out(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, Tensor start_pos, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "update_quantized_cache(Tensor value, Tensor(a!) cache, "
+      "Tensor(b!) scales, Tensor(c!) zero_points, SymInt start_pos) -> Tensor");
+  m.def(
+      "update_quantized_cache.out(Tensor value, Tensor(a!) cache, "
+      "Tensor(b!) scales, Tensor(c!) zero_points, SymInt start_pos, *, "
+      "Tensor(d!) out) -> Tensor(d!)");
   m.def(
       "custom_quantized_sdpa(Tensor query, Tensor key, Tensor value, SymInt start_pos, "
       "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
@@ -436,6 +690,19 @@ TORCH_LIBRARY_IMPL(llama, CompositeExplicitAutograd, m) {
   m.impl(
       "custom_sdpa.out",
       WRAP_TO_ATEN(torch::executor::native::custom_sdpa_out_no_context, 8));
+  m.impl(
+      "custom_sdpa_with_positions",
+      torch::executor::native::custom_sdpa_with_positions_aten);
+  m.impl(
+      "custom_sdpa_with_positions.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::custom_sdpa_with_positions_out_no_context,
+          8));
+  m.impl("custom_sdpa_paged", torch::executor::native::custom_sdpa_paged_aten);
+  m.impl(
+      "custom_sdpa_paged.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::custom_sdpa_paged_out_no_context, 9));
   m.impl("update_cache", torch::executor::native::update_cache_aten);
   m.impl(
       "update_cache.out",
@@ -448,6 +715,19 @@ TORCH_LIBRARY_IMPL(llama, CompositeExplicitAutograd, m) {
       WRAP_TO_ATEN(
           torch::executor::native::update_cache_with_indices_out_no_context,
           4));
+  m.impl(
+      "update_cache_paged", torch::executor::native::update_cache_paged_aten);
+  m.impl(
+      "update_cache_paged.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_cache_paged_out_no_context, 4));
+  m.impl(
+      "update_quantized_cache",
+      torch::executor::native::update_quantized_cache_aten);
+  m.impl(
+      "update_quantized_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_quantized_cache_out_no_context, 5));
   m.impl(
       "custom_quantized_sdpa",
       torch::executor::native::custom_quantized_sdpa_aten);
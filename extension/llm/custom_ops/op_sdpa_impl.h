@@ -16,6 +16,8 @@
 // @lint-ignore CLANGTIDY facebook-unused-include-check
 #include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
 
+#include <algorithm>
+#include <numeric>
 #include <vector>
 
 #ifdef ET_USE_THREADPOOL
@@ -35,6 +37,40 @@ enum class SeqDim { ONE = 1, TWO };
 
 namespace sdpa::impl {
 
+/**
+ * Describes K/V caches stored as a pool of fixed-size blocks of shape
+ * [num_blocks, block_size, num_heads_kv, head_dim]. Logical position p of
+ * batch row b lives at row p % block_size of physical block
+ * block_table[b * max_blocks_per_seq + p / block_size].
+ */
+struct PagedKVCache {
+  const int64_t* block_table;
+  int64_t max_blocks_per_seq;
+  int64_t block_size;
+
+  int64_t block_for(int64_t batch, int64_t pos) const {
+    return block_table[batch * max_blocks_per_seq + pos / block_size];
+  }
+
+  /**
+   * Block sizes must be a power of two or a multiple of 16, so that the
+   * kernels can split the keys into tiles of at least 16 positions, or of
+   * the whole block, that never straddle two blocks.
+   */
+  static bool is_valid_block_size(int64_t size) {
+    return size > 0 && (size % 16 == 0 || (size & (size - 1)) == 0);
+  }
+
+  /**
+   * Returns the largest tile size up to `split_size`, a power of two of at
+   * least 16, that divides block_size.
+   */
+  int64_t split_size_for(int64_t split_size) const {
+    return block_size <= split_size ? block_size
+                                    : std::gcd(split_size, block_size);
+  }
+};
+
 struct MaybeQuantizedMatrixData {
   const void* data{nullptr};
   const int8_t* zero_points{nullptr};
@@ -203,6 +239,54 @@ void dequantize_per_channel_optimized(
   }
 }
 
+// Dequantizes a tile of `rows` rows of head_dim values from an int8 KV
+// cache, or from an int4 one with element 2i of a row in the low nibble of
+// byte i, into out [rows, head_dim]. Rows are row_stride bytes apart and
+// have their own scale and zero point, qparams_stride apart.
+void dequantize_kv_tile(
+    const void* in,
+    ScalarType dtype,
+    int64_t rows,
+    int64_t row_stride,
+    const float* scales,
+    const int8_t* zero_points,
+    int64_t qparams_stride,
+    int64_t head_dim,
+    float* out) {
+  if (dtype == ScalarType::Char) {
+    dequantize_per_channel_optimized(
+        static_cast<const int8_t*>(in),
+        scales,
+        zero_points,
+        out,
+        -128,
+        127,
+        1,
+        0,
+        0,
+        rows,
+        row_stride,
+        head_dim,
+        head_dim,
+        qparams_stride);
+    return;
+  }
+  const uint8_t* in_data = static_cast<const uint8_t*>(in);
+  for (int64_t row = 0; row < rows; ++row) {
+    const uint8_t* in_row = in_data + row * row_stride;
+    const float scale = scales[row * qparams_stride];
+    const int32_t zero_point = zero_points[row * qparams_stride];
+    float* out_row = out + row * head_dim;
+    for (int64_t i = 0; i < head_dim / 2; ++i) {
+      // Sign-extend both nibbles.
+      const int32_t low = static_cast<int8_t>(in_row[i] << 4) >> 4;
+      const int32_t high = static_cast<int8_t>(in_row[i]) >> 4;
+      out_row[2 * i] = (low - zero_point) * scale;
+      out_row[2 * i + 1] = (high - zero_point) * scale;
+    }
+  }
+}
+
 void dequant_and_gemm(
     const int64_t m,
     const int64_t n,
@@ -538,6 +622,18 @@ TODO: Just handle conversion of bool mask to float
  * @param start_pos Starting position for causal masking in generation
  * @param num_keys_for_causal_attention Number of keys to consider for causal
  attention (-1 for all)
+ * @param start_pos_per_batch Optional [Batch] array that overrides start_pos
+ for each batch row, so that rows of a batch can be at different positions.
+ Requires is_causal, and num_keys_for_causal_attention must cover the largest
+ start position plus Q_seq_len.
+ * @param paged_kv Optional block table. If set, key and value are block pools
+ read through it (see PagedKVCache), seq_dim must be SeqDim::ONE and the
+ inputs must not be quantized.
+ *
+ * If query is float and key and value are an int8 or packed int4 cache (see
+ dequantize_kv_tile), each K and V tile is dequantized into a per-thread
+ buffer right before its gemm, so the cache is read once in its quantized
+ form.
  */
 template <typename scalar_t, int64_t q_split_size, int64_t kv_split_size>
 void cpu_flash_attention(
@@ -557,7 +653,9 @@ void cpu_flash_attention(
     const optional<Tensor>& v_scales,
     const SeqDim seq_dim = SeqDim::TWO,
     const int64_t start_pos = 0,
-    const int64_t num_keys_for_causal_attention = -1) {
+    const int64_t num_keys_for_causal_attention = -1,
+    const int64_t* start_pos_per_batch = nullptr,
+    const PagedKVCache* paged_kv = nullptr) {
   (void)dropout_p;
 
   // Without this we have out-of-bounds writes for
@@ -591,6 +689,17 @@ void cpu_flash_attention(
     kvSize = value.size(1);
   }
 
+  if (paged_kv != nullptr) {
+    ET_CHECK_MSG(
+        seq_dim == SeqDim::ONE && query.scalar_type() != ScalarType::Char &&
+            key.scalar_type() == query.scalar_type(),
+        "Paged KV cache requires SeqDim::ONE and unquantized inputs");
+    ET_CHECK_MSG(
+        value.size(1) == paged_kv->block_size,
+        "Paged KV cache block size mismatch");
+    kvSize = paged_kv->max_blocks_per_seq * paged_kv->block_size;
+  }
+
   if (num_keys_for_causal_attention > 0) {
     ET_CHECK_MSG(
         num_keys_for_causal_attention <= kvSize,
@@ -638,6 +747,8 @@ void cpu_flash_attention(
 
   bool is_quantized_sdpa = false;
   is_quantized_sdpa = query.scalar_type() == ScalarType::Char;
+  const bool is_kv_quantized =
+      !is_quantized_sdpa && key.scalar_type() != query.scalar_type();
 
   auto strides = query.strides();
   int64_t qStrideB = strides[0];
@@ -707,6 +818,24 @@ void cpu_flash_attention(
       k_quant_params_StrideH = k_strides[2];
       k_quant_params_StrideN = k_strides[1];
 
+      v_quant_params_StrideH = v_strides[2];
+      v_quant_params_StrideN = v_strides[1];
+    }
+  } else if (is_kv_quantized) {
+    auto k_strides = k_zero_points.value().strides();
+    k_quant_params_StrideB = k_strides[0];
+    k_quant_params_StrideH = k_strides[1];
+    k_quant_params_StrideN = k_strides[2];
+
+    auto v_strides = v_zero_points.value().strides();
+    v_quant_params_StrideB = v_strides[0];
+    v_quant_params_StrideH = v_strides[1];
+    v_quant_params_StrideN = v_strides[2];
+
+    if (seq_dim == SeqDim::ONE) {
+      k_quant_params_StrideH = k_strides[2];
+      k_quant_params_StrideN = k_strides[1];
+
       v_quant_params_StrideH = v_strides[2];
       v_quant_params_StrideN = v_strides[1];
     }
@@ -740,6 +869,10 @@ void cpu_flash_attention(
 
   int64_t qSplitSize = q_split_size > qSize ? qSize : q_split_size;
   int64_t kvSplitSize = kv_split_size > kvSize ? kvSize : kv_split_size;
+  if (paged_kv != nullptr) {
+    // Each KV split must lie within one block, so that it is contiguous.
+    kvSplitSize = paged_kv->split_size_for(kv_split_size);
+  }
   int64_t qSlice = (qSize - 1) / qSplitSize + 1;
 #ifdef ET_USE_THREADPOOL
   int64_t num_thread =
@@ -757,7 +890,8 @@ void cpu_flash_attention(
       /* qk     */ qSplitSize * kvSplitSize +
       /* qk_max */ qSplitSize +
       /* qk_sum */ qSplitSize +
-      /* dst    */ qSplitSize * headSize;
+      /* dst    */ qSplitSize * headSize +
+      /* kv_dequant */ (is_kv_quantized ? kvSplitSize * headSize : 0);
 
   // Since all intermediate compute is accum_t, we need to
   // allocate a buffer accordingly.
@@ -794,6 +928,8 @@ void cpu_flash_attention(
     accum_t* qk_max_data = qk_data + qSplitSize * kvSplitSize;
     accum_t* qk_sum_data = qk_max_data + qSplitSize;
     accum_t* dst_data = qk_sum_data + qSplitSize;
+    // Dequantized K tile, then V tile, of a quantized KV cache.
+    accum_t* kv_dequant_data = dst_data + qSplitSize * headSize;
     scalar_t* qk_reduced_data = is_reduced_type
         ? buf_reduced_data + ompIdx * qSplitSize * kvSplitSize
         : nullptr;
@@ -831,9 +967,12 @@ void cpu_flash_attention(
       // but that requires storing attention mask in float as the current
       // code doesnt support bool attention mask.
       // However, lets just fix that as well.
-      int64_t num_keys =
-          is_causal ? std::min(m + start_pos + qBlockSize, kvSize) : kvSize;
-      int64_t m_start_pos = m + start_pos;
+      const int64_t row_start_pos =
+          start_pos_per_batch != nullptr ? start_pos_per_batch[i] : start_pos;
+      int64_t num_keys = is_causal
+          ? std::min(m + row_start_pos + qBlockSize, kvSize)
+          : kvSize;
+      int64_t m_start_pos = m + row_start_pos;
       auto j_kv = j / num_reps;
       for (int64_t n = 0; n < num_keys; n += kvSplitSize) {
         int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
@@ -847,7 +986,10 @@ void cpu_flash_attention(
         const int8_t* q_zero_points_ptr = nullptr;
         const int8_t* k_zero_points_ptr = nullptr;
         int64_t q_offset = i * qStrideB + j * qStrideH + m * qStrideM;
-        int64_t k_offset = i * kStrideB + j_kv * kStrideH + n * kStrideN;
+        int64_t k_offset = paged_kv != nullptr
+            ? paged_kv->block_for(i, n) * kStrideB + j_kv * kStrideH +
+                (n % paged_kv->block_size) * kStrideN
+            : i * kStrideB + j_kv * kStrideH + n * kStrideN;
         if (is_quantized_sdpa) {
           int64_t q_quant_params_offset = i * q_quant_params_StrideB +
               j * q_quant_params_StrideH + m * q_quant_params_StrideM;
@@ -863,6 +1005,27 @@ void cpu_flash_attention(
               k_quant_params_offset;
           q_sub_matrix_data_ptr = (const int8_t*)(q_data) + q_offset;
           k_sub_matrix_data_ptr = (const int8_t*)(k_data) + k_offset;
+        } else if (is_kv_quantized) {
+          if constexpr (std::is_same<accum_t, float>::value) {
+            int64_t k_quant_params_offset = i * k_quant_params_StrideB +
+                j_kv * k_quant_params_StrideH + n * k_quant_params_StrideN;
+            dequantize_kv_tile(
+                (const uint8_t*)(k_data) + k_offset,
+                key.scalar_type(),
+                kvBlockSize,
+                kStrideN,
+                k_scales.value().const_data_ptr<float>() +
+                    k_quant_params_offset,
+                k_zero_points.value().const_data_ptr<int8_t>() +
+                    k_quant_params_offset,
+                k_quant_params_StrideN,
+                headSize,
+                kv_dequant_data);
+          } else {
+            ET_CHECK_MSG(false, "Quantized KV cache requires a float query");
+          }
+          q_sub_matrix_data_ptr = (const scalar_t*)(q_data) + q_offset;
+          k_sub_matrix_data_ptr = kv_dequant_data;
         } else {
           q_sub_matrix_data_ptr = (const scalar_t*)(q_data) + q_offset;
           k_sub_matrix_data_ptr = (const scalar_t*)(k_data) + k_offset;
@@ -882,7 +1045,7 @@ void cpu_flash_attention(
             kvBlockSize,
             headSize,
             k_quant_params_StrideN,
-            key.scalar_type());
+            is_kv_quantized ? query.scalar_type() : key.scalar_type());
         _q_at_k_gemm<accum_t>(
             qBlockSize,
             kvBlockSize,
@@ -890,7 +1053,7 @@ void cpu_flash_attention(
             q_sub_matrix_data,
             qStrideM,
             k_sub_matrix_data,
-            kStrideN,
+            is_kv_quantized ? headSize : kStrideN,
             qk_data);
 
         // There are 4 cases that is_causal has to cover to fill
@@ -1022,7 +1185,10 @@ void cpu_flash_attention(
         const void* v_sub_matrix_data_ptr;
         const float* v_scales_ptr = nullptr;
         const int8_t* v_zero_points_ptr = nullptr;
-        int64_t v_offset = i * vStrideB + j_kv * vStrideH + n * vStrideN;
+        int64_t v_offset = paged_kv != nullptr
+            ? paged_kv->block_for(i, n) * vStrideB + j_kv * vStrideH +
+                (n % paged_kv->block_size) * vStrideN
+            : i * vStrideB + j_kv * vStrideH + n * vStrideN;
         if (is_quantized_sdpa) {
           int64_t v_quant_params_offset = i * v_quant_params_StrideB +
               j_kv * v_quant_params_StrideH + n * v_quant_params_StrideN;
@@ -1031,6 +1197,25 @@ void cpu_flash_attention(
           v_zero_points_ptr = v_zero_points.value().const_data_ptr<int8_t>() +
               v_quant_params_offset;
           v_sub_matrix_data_ptr = (const int8_t*)(v_data) + v_offset;
+        } else if (is_kv_quantized) {
+          // The K tile in kv_dequant_data is no longer needed.
+          if constexpr (std::is_same<accum_t, float>::value) {
+            int64_t v_quant_params_offset = i * v_quant_params_StrideB +
+                j_kv * v_quant_params_StrideH + n * v_quant_params_StrideN;
+            dequantize_kv_tile(
+                (const uint8_t*)(v_data) + v_offset,
+                value.scalar_type(),
+                kvBlockSize,
+                vStrideN,
+                v_scales.value().const_data_ptr<float>() +
+                    v_quant_params_offset,
+                v_zero_points.value().const_data_ptr<int8_t>() +
+                    v_quant_params_offset,
+                v_quant_params_StrideN,
+                headSize,
+                kv_dequant_data);
+          }
+          v_sub_matrix_data_ptr = kv_dequant_data;
         } else {
           v_sub_matrix_data_ptr = (const scalar_t*)(v_data) + v_offset;
         }
@@ -1041,7 +1226,7 @@ void cpu_flash_attention(
             kvBlockSize,
             headSize,
             v_quant_params_StrideN,
-            value.scalar_type());
+            is_kv_quantized ? query.scalar_type() : value.scalar_type());
         // Calculate Softmax(q @ k.T) @ v
         _qk_at_v_gemm<accum_t>(
             qBlockSize,
@@ -1050,7 +1235,7 @@ void cpu_flash_attention(
             qk_data,
             kvBlockSize,
             v_sub_matrix_data,
-            vStrideN,
+            is_kv_quantized ? headSize : vStrideN,
             dst_data,
             headSize,
             n == 0 ? static_cast<accum_t>(0) : static_cast<accum_t>(1));
@@ -1073,6 +1258,385 @@ void cpu_flash_attention(
   torch::executor::parallel_for(
       0, batchSize * num_head * qSlice, 1, compute_lambda);
 }
+
+// Keys per tile of cpu_flash_attention_decode.
+constexpr int64_t kDecodeTileSize = 64;
+// Fewest keys a split of cpu_flash_attention_decode gets, so that the extra
+// reduction stays small next to the split itself.
+constexpr int64_t kDecodeMinKeysPerSplit = 256;
+
+// sum(a * b)
+template <typename T>
+inline T _dot(const T* a, const T* b, int64_t size) {
+  using Vec = vec::Vectorized<T>;
+  Vec vec_sum(static_cast<T>(0));
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    vec_sum = vec::fmadd(Vec::loadu(a + d), Vec::loadu(b + d), vec_sum);
+  }
+  // Reduced through memory rather than vec_reduce_all; see the NOTE in
+  // _exp_reduce_sum_fusion_kernel.
+  __at_align__ T vec_sum_array[Vec::size()];
+  vec_sum.store(vec_sum_array);
+  T sum = 0;
+  for (const auto i : c10::irange(Vec::size())) {
+    sum += vec_sum_array[i];
+  }
+  for (; d < size; ++d) {
+    sum += a[d] * b[d];
+  }
+  return sum;
+}
+
+// y <- y + alpha * x
+template <typename T>
+inline void _axpy(T alpha, const T* x, T* y, int64_t size) {
+  using Vec = vec::Vectorized<T>;
+  const Vec vec_alpha(alpha);
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    vec::fmadd(vec_alpha, Vec::loadu(x + d), Vec::loadu(y + d)).store(y + d);
+  }
+  for (; d < size; ++d) {
+    y[d] += alpha * x[d];
+  }
+}
+
+/**
+ * @brief Attention for a single query token, e.g. a decode step
+ *
+ * Computes the same result as cpu_flash_attention for Q_seq_len = 1 without
+ * an attention mask, and takes the same arguments, except that the query
+ * must not be quantized. It is organized around the KV cache instead of the
+ * query:
+ * - the num_reps query heads that share a KV head are computed together, so
+ *   each K and V row is read once per group instead of once per query head,
+ * - when there are fewer groups than threads, the keys of each group are
+ *   split across threads (split-K). Each split keeps the running max, sum
+ *   and unnormalized output of its online softmax, and a final pass combines
+ *   the splits of each query head,
+ * - scores and outputs are accumulated with SIMD dot products and axpys,
+ *   with no gemm setup per tile.
+ */
+template <typename scalar_t>
+void cpu_flash_attention_decode(
+    Tensor& output,
+    const Tensor& query,
+    const Tensor& key,
+    const Tensor& value,
+    bool is_causal,
+    const optional<double>& scale,
+    const optional<Tensor>& k_zero_points,
+    const optional<Tensor>& k_scales,
+    const optional<Tensor>& v_zero_points,
+    const optional<Tensor>& v_scales,
+    const SeqDim seq_dim = SeqDim::TWO,
+    const int64_t start_pos = 0,
+    const int64_t num_keys_for_causal_attention = -1,
+    const int64_t* start_pos_per_batch = nullptr,
+    const PagedKVCache* paged_kv = nullptr) {
+  constexpr bool is_reduced_type =
+      ::executorch::runtime::is_reduced_floating_point_v<scalar_t>;
+  ET_CHECK_MSG(
+      !is_reduced_type, "FlashAttention does not support reduced types.");
+  using accum_t = scalar_t;
+  using Vec = vec::Vectorized<accum_t>;
+  const accum_t scaling_factor =
+      static_cast<accum_t>(calculate_scale(query, scale));
+
+  const int64_t batchSize = query.size(0);
+  int64_t num_head = query.size(1);
+  int64_t qSize = query.size(2);
+  const int64_t headSize = query.size(3);
+  int64_t kvSize = value.size(2);
+  int64_t num_heads_kv = key.size(1);
+  if (seq_dim == SeqDim::ONE) {
+    num_head = query.size(2);
+    num_heads_kv = key.size(2);
+    qSize = query.size(1);
+    kvSize = value.size(1);
+  }
+  ET_CHECK_MSG(qSize == 1, "Decode attention takes a single query token");
+  ET_CHECK_MSG(
+      query.scalar_type() != ScalarType::Char,
+      "Decode attention does not support a quantized query");
+
+  if (paged_kv != nullptr) {
+    ET_CHECK_MSG(
+        seq_dim == SeqDim::ONE && key.scalar_type() == query.scalar_type(),
+        "Paged KV cache requires SeqDim::ONE and unquantized inputs");
+    ET_CHECK_MSG(
+        value.size(1) == paged_kv->block_size,
+        "Paged KV cache block size mismatch");
+    kvSize = paged_kv->max_blocks_per_seq * paged_kv->block_size;
+  }
+  if (num_keys_for_causal_attention > 0) {
+    ET_CHECK_MSG(
+        num_keys_for_causal_attention <= kvSize,
+        "num_keys_for_causal_attention must be <= kvSize");
+    kvSize = num_keys_for_causal_attention;
+  }
+  ET_CHECK_MSG(
+      num_heads_kv <= num_head && num_head % num_heads_kv == 0,
+      "num query heads=%" PRId64
+      " must be a multiple of num kv heads=%" PRId64,
+      num_head,
+      num_heads_kv);
+  const int64_t num_reps = num_head / num_heads_kv;
+  const bool is_kv_quantized = key.scalar_type() != query.scalar_type();
+
+  const int64_t h_dim = seq_dim == SeqDim::ONE ? 2 : 1;
+  const int64_t n_dim = seq_dim == SeqDim::ONE ? 1 : 2;
+  const int64_t qStrideB = query.strides()[0];
+  const int64_t qStrideH = query.strides()[h_dim];
+  const int64_t kStrideB = key.strides()[0];
+  const int64_t kStrideH = key.strides()[h_dim];
+  const int64_t kStrideN = key.strides()[n_dim];
+  const int64_t vStrideB = value.strides()[0];
+  const int64_t vStrideH = value.strides()[h_dim];
+  const int64_t vStrideN = value.strides()[n_dim];
+  const int64_t oStrideB = output.strides()[0];
+  const int64_t oStrideH = output.strides()[h_dim];
+
+  int64_t k_quant_params_StrideB = 0;
+  int64_t k_quant_params_StrideH = 0;
+  int64_t k_quant_params_StrideN = 0;
+  int64_t v_quant_params_StrideB = 0;
+  int64_t v_quant_params_StrideH = 0;
+  int64_t v_quant_params_StrideN = 0;
+  if (is_kv_quantized) {
+    auto k_strides = k_zero_points.value().strides();
+    k_quant_params_StrideB = k_strides[0];
+    k_quant_params_StrideH = k_strides[h_dim];
+    k_quant_params_StrideN = k_strides[n_dim];
+    auto v_strides = v_zero_points.value().strides();
+    v_quant_params_StrideB = v_strides[0];
+    v_quant_params_StrideH = v_strides[h_dim];
+    v_quant_params_StrideN = v_strides[n_dim];
+  }
+
+  // With a paged cache, each tile must lie within one block, so that it is
+  // contiguous.
+  int64_t tileSize = kDecodeTileSize;
+  if (paged_kv != nullptr) {
+    tileSize = paged_kv->split_size_for(kDecodeTileSize);
+  }
+
+#ifdef ET_USE_THREADPOOL
+  int64_t num_thread =
+      ::executorch::extension::threadpool::get_threadpool()->get_thread_count();
+#else
+  int64_t num_thread = 1;
+#endif
+
+  // Split the keys only as far as needed to give every thread work.
+  int64_t max_start_pos = start_pos;
+  if (start_pos_per_batch != nullptr) {
+    max_start_pos =
+        *std::max_element(start_pos_per_batch, start_pos_per_batch + batchSize);
+  }
+  const int64_t max_keys =
+      is_causal ? std::min(max_start_pos + 1, kvSize) : kvSize;
+  const int64_t num_groups = batchSize * num_heads_kv;
+  int64_t num_splits = 1;
+  if (num_groups < num_thread) {
+    num_splits = std::min(
+        (num_thread + num_groups - 1) / num_groups,
+        std::max<int64_t>(max_keys / kDecodeMinKeysPerSplit, 1));
+  }
+  // Whole tiles per split, so that paged splits start on a block boundary.
+  int64_t split_size = (max_keys + num_splits - 1) / num_splits;
+  split_size = (split_size + tileSize - 1) / tileSize * tileSize;
+
+  // For each split and each query head of its group: the running max, the
+  // running sum and the unnormalized output.
+  const int64_t partial_size = headSize + 2;
+  std::vector<accum_t> partials(
+      num_groups * num_splits * num_reps * partial_size);
+  // Per thread: the scores of a tile for every query head of the group, and
+  // a dequantized K or V tile.
+  const int64_t size_per_thread =
+      num_reps * tileSize + (is_kv_quantized ? tileSize * headSize : 0);
+  std::vector<accum_t> buf(num_thread * size_per_thread);
+
+  const scalar_t* q_data = query.const_data_ptr<scalar_t>();
+  const char* k_data = reinterpret_cast<const char*>(key.const_data_ptr());
+  const char* v_data = reinterpret_cast<const char*>(value.const_data_ptr());
+  const int64_t kv_element_size = key.element_size();
+  scalar_t* out_data = output.mutable_data_ptr<scalar_t>();
+
+  // Returns the tile of `rows` K or V rows at position n of group (b, h_kv),
+  // dequantized into `dequant_data` if the cache is quantized, and sets
+  // row_stride to the distance between its rows.
+  auto load_tile = [&](bool is_key,
+                       int64_t b,
+                       int64_t h_kv,
+                       int64_t n,
+                       int64_t rows,
+                       accum_t* dequant_data,
+                       int64_t& row_stride) -> const accum_t* {
+    const int64_t strideB = is_key ? kStrideB : vStrideB;
+    const int64_t strideH = is_key ? kStrideH : vStrideH;
+    const int64_t strideN = is_key ? kStrideN : vStrideN;
+    const int64_t offset = paged_kv != nullptr
+        ? paged_kv->block_for(b, n) * strideB + h_kv * strideH +
+            (n % paged_kv->block_size) * strideN
+        : b * strideB + h_kv * strideH + n * strideN;
+    const char* data = is_key ? k_data : v_data;
+    if (!is_kv_quantized) {
+      row_stride = strideN;
+      return reinterpret_cast<const accum_t*>(data) + offset;
+    }
+    if constexpr (std::is_same<accum_t, float>::value) {
+      const int64_t quant_params_offset = is_key
+          ? b * k_quant_params_StrideB + h_kv * k_quant_params_StrideH +
+              n * k_quant_params_StrideN
+          : b * v_quant_params_StrideB + h_kv * v_quant_params_StrideH +
+              n * v_quant_params_StrideN;
+      const auto& scales = is_key ? k_scales : v_scales;
+      const auto& zero_points = is_key ? k_zero_points : v_zero_points;
+      dequantize_kv_tile(
+          data + offset * kv_element_size,
+          is_key ? key.scalar_type() : value.scalar_type(),
+          rows,
+          strideN * kv_element_size,
+          scales.value().const_data_ptr<float>() + quant_params_offset,
+          zero_points.value().const_data_ptr<int8_t>() + quant_params_offset,
+          is_key ? k_quant_params_StrideN : v_quant_params_StrideN,
+          headSize,
+          dequant_data);
+    } else {
+      ET_CHECK_MSG(false, "Quantized KV cache requires a float query");
+    }
+    row_stride = headSize;
+    return dequant_data;
+  };
+
+  auto compute_split = [&](int64_t begin, int64_t end) {
+    accum_t* scores = buf.data() + torch::executor::get_thread_num() *
+        size_per_thread;
+    accum_t* dequant_data = scores + num_reps * tileSize;
+    for (int64_t z = begin; z < end; ++z) {
+      const int64_t split = z % num_splits;
+      const int64_t group = z / num_splits;
+      const int64_t b = group / num_heads_kv;
+      const int64_t h_kv = group % num_heads_kv;
+      const int64_t row_start_pos =
+          start_pos_per_batch != nullptr ? start_pos_per_batch[b] : start_pos;
+      const int64_t num_keys =
+          is_causal ? std::min(row_start_pos + 1, kvSize) : kvSize;
+      const int64_t n_end = std::min((split + 1) * split_size, num_keys);
+
+      accum_t* partial = partials.data() + z * num_reps * partial_size;
+      for (int64_t r = 0; r < num_reps; ++r) {
+        partial[r * partial_size] = -std::numeric_limits<accum_t>::infinity();
+        partial[r * partial_size + 1] = 0;
+        fill_stub(
+            partial + r * partial_size + 2, static_cast<accum_t>(0), headSize);
+      }
+      // Query heads h_kv * num_reps ... (h_kv + 1) * num_reps - 1 share this
+      // KV head.
+      const scalar_t* q_group =
+          q_data + b * qStrideB + h_kv * num_reps * qStrideH;
+
+      for (int64_t n = split * split_size; n < n_end; n += tileSize) {
+        const int64_t tile_len = std::min(tileSize, n_end - n);
+
+        // scores <- scale * q @ k.T, reading each key row once.
+        int64_t k_row_stride = 0;
+        const accum_t* k_tile =
+            load_tile(true, b, h_kv, n, tile_len, dequant_data, k_row_stride);
+        for (int64_t t = 0; t < tile_len; ++t) {
+          const accum_t* k_row = k_tile + t * k_row_stride;
+          for (int64_t r = 0; r < num_reps; ++r) {
+            scores[r * tileSize + t] = scaling_factor *
+                _dot<accum_t>(q_group + r * qStrideH, k_row, headSize);
+          }
+        }
+
+        // Online softmax: scores <- exp(scores - max), and rescale what was
+        // accumulated under the previous max.
+        for (int64_t r = 0; r < num_reps; ++r) {
+          accum_t* row_scores = scores + r * tileSize;
+          accum_t* row_partial = partial + r * partial_size;
+          accum_t tile_max = vec::reduce_all<accum_t>(
+              [](Vec& x, Vec& y) { return vec::maximum(x, y); },
+              row_scores,
+              tile_len);
+          const accum_t new_max = std::max(row_partial[0], tile_max);
+          accum_t tile_sum = new_max;
+          _exp_reduce_sum_fusion_kernel(
+              row_scores, static_cast<int>(tile_len), row_scores, tile_sum);
+          const accum_t exp_tmp = std::exp(row_partial[0] - new_max);
+          row_partial[0] = new_max;
+          row_partial[1] = row_partial[1] * exp_tmp + tile_sum;
+          if (exp_tmp != static_cast<accum_t>(1)) {
+            vec::map<accum_t>(
+                [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
+                row_partial + 2,
+                row_partial + 2,
+                headSize);
+          }
+        }
+
+        // out <- out + scores @ v, reading each value row once. The K tile in
+        // dequant_data is no longer needed.
+        int64_t v_row_stride = 0;
+        const accum_t* v_tile =
+            load_tile(false, b, h_kv, n, tile_len, dequant_data, v_row_stride);
+        for (int64_t t = 0; t < tile_len; ++t) {
+          const accum_t* v_row = v_tile + t * v_row_stride;
+          for (int64_t r = 0; r < num_reps; ++r) {
+            _axpy<accum_t>(
+                scores[r * tileSize + t],
+                v_row,
+                partial + r * partial_size + 2,
+                headSize);
+          }
+        }
+      }
+    }
+  };
+  torch::executor::parallel_for(0, num_groups * num_splits, 1, compute_split);
+
+  // Combine the splits of each query head: every split's output and sum are
+  // rescaled to the overall max.
+  auto reduce_splits = [&](int64_t begin, int64_t end) {
+    for (int64_t z = begin; z < end; ++z) {
+      const int64_t b = z / num_head;
+      const int64_t j = z % num_head;
+      const int64_t group = b * num_heads_kv + j / num_reps;
+      const accum_t* first = partials.data() +
+          (group * num_splits * num_reps + j % num_reps) * partial_size;
+      const int64_t split_stride = num_reps * partial_size;
+
+      accum_t max = -std::numeric_limits<accum_t>::infinity();
+      for (int64_t s = 0; s < num_splits; ++s) {
+        max = std::max(max, first[s * split_stride]);
+      }
+      accum_t sum = 0;
+      for (int64_t s = 0; s < num_splits; ++s) {
+        sum += std::exp(first[s * split_stride] - max) *
+            first[s * split_stride + 1];
+      }
+      scalar_t* out = out_data + b * oStrideB + j * oStrideH;
+      fill_stub(out, static_cast<scalar_t>(0), headSize);
+      for (int64_t s = 0; s < num_splits; ++s) {
+        const accum_t* split_partial = first + s * split_stride;
+        if (split_partial[0] == -std::numeric_limits<accum_t>::infinity()) {
+          // No keys in this split.
+          continue;
+        }
+        _axpy<accum_t>(
+            std::exp(split_partial[0] - max) / sum,
+            split_partial + 2,
+            out,
+            headSize);
+      }
+    }
+  };
+  torch::executor::parallel_for(0, batchSize * num_head, 1, reduce_splits);
+}
 } // namespace sdpa::impl
 } // namespace native
 } // namespace executor
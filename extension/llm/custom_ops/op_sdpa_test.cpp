@@ -6,9 +6,14 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
 
 #include <executorch/extension/llm/custom_ops/op_sdpa.h>
+#include <executorch/extension/llm/custom_ops/op_update_cache.h>
+#include <executorch/extension/threadpool/threadpool.h>
 
 #include <executorch/kernels/test/TestUtil.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
@@ -513,3 +518,777 @@ TEST(OpScaledDotProductAttentionTest, CorrectnessTest_51) {
       query, key, value, attn_mask, dropout_p, is_causal, scale, out);
   EXPECT_TENSOR_CLOSE(ret, ret_expected);
 }
+
+TEST(OpCustomSdpaWithPositionsTest, EachRowAttendsUpToItsOwnPosition) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  // [batch, seq_len, heads, head_dim] for q and [batch, max_seq_len, heads,
+  // head_dim] for the caches.
+  constexpr int32_t kBatch = 3;
+  constexpr int32_t kMaxSeqLen = 5;
+  constexpr int32_t kRowSize = 2 * 4;
+  std::vector<float> q_data(kBatch * kRowSize);
+  std::vector<float> k_data(kBatch * kMaxSeqLen * kRowSize);
+  std::vector<float> v_data(k_data.size());
+  for (size_t i = 0; i < q_data.size(); ++i) {
+    q_data[i] = 0.1f * static_cast<float>((i * 7) % 11);
+  }
+  for (size_t i = 0; i < k_data.size(); ++i) {
+    k_data[i] = 0.1f * static_cast<float>((i * 5) % 13);
+    v_data[i] = 0.1f * static_cast<float>((i * 3) % 17) - 0.5f;
+  }
+  const std::vector<int64_t> positions = {0, 4, 2};
+
+  executorch::aten::Tensor q = tfFloat.make({kBatch, 1, 2, 4}, q_data);
+  executorch::aten::Tensor k = tfFloat.make({kBatch, kMaxSeqLen, 2, 4}, k_data);
+  executorch::aten::Tensor v = tfFloat.make({kBatch, kMaxSeqLen, 2, 4}, v_data);
+  executorch::aten::Tensor start_pos = tfLong.make({kBatch}, positions);
+  executorch::aten::Tensor out = tfFloat.zeros({kBatch, 1, 2, 4});
+  torch::executor::native::custom_sdpa_with_positions_out(
+      context, q, k, v, start_pos, {}, 0.0, true, {}, out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  // Each row must match a batch-1 custom_sdpa at that row's position.
+  const size_t kv_row_size = kMaxSeqLen * kRowSize;
+  for (int32_t b = 0; b < kBatch; ++b) {
+    executorch::aten::Tensor row_q = tfFloat.make(
+        {1, 1, 2, 4},
+        std::vector<float>(
+            q_data.begin() + b * kRowSize,
+            q_data.begin() + (b + 1) * kRowSize));
+    executorch::aten::Tensor row_k = tfFloat.make(
+        {1, kMaxSeqLen, 2, 4},
+        std::vector<float>(
+            k_data.begin() + b * kv_row_size,
+            k_data.begin() + (b + 1) * kv_row_size));
+    executorch::aten::Tensor row_v = tfFloat.make(
+        {1, kMaxSeqLen, 2, 4},
+        std::vector<float>(
+            v_data.begin() + b * kv_row_size,
+            v_data.begin() + (b + 1) * kv_row_size));
+    executorch::aten::Tensor row_out = tfFloat.zeros({1, 1, 2, 4});
+    torch::executor::native::custom_sdpa_out(
+        context,
+        row_q,
+        row_k,
+        row_v,
+        positions[b],
+        {},
+        0.0,
+        true,
+        {},
+        row_out);
+    const float* expected = row_out.const_data_ptr<float>();
+    const float* actual = out.const_data_ptr<float>() + b * kRowSize;
+    for (int32_t i = 0; i < kRowSize; ++i) {
+      EXPECT_NEAR(actual[i], expected[i], 1e-5) << "row " << b << " i " << i;
+    }
+  }
+}
+
+TEST(OpCustomSdpaWithPositionsTest, OutOfRangePositionFails) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  executorch::aten::Tensor q = tfFloat.ones({2, 1, 1, 4});
+  executorch::aten::Tensor k = tfFloat.ones({2, 3, 1, 4});
+  executorch::aten::Tensor v = tfFloat.ones({2, 3, 1, 4});
+  executorch::aten::Tensor start_pos = tfLong.make({2}, {0, 3});
+  executorch::aten::Tensor out = tfFloat.zeros({2, 1, 1, 4});
+  torch::executor::native::custom_sdpa_with_positions_out(
+      context, q, k, v, start_pos, {}, 0.0, true, {}, out);
+  EXPECT_EQ(
+      context.failure_state(), executorch::runtime::Error::InvalidArgument);
+}
+
+TEST(OpCustomSdpaPagedTest, MatchesContiguousCache) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  // Two rows with 2 query tokens each, over caches of 3 blocks of 4
+  // positions per row. The pool holds the blocks of both rows in a
+  // shuffled order, plus an unused block.
+  constexpr int32_t kBatch = 2;
+  constexpr int32_t kSeqLen = 2;
+  constexpr int32_t kBlockSize = 4;
+  constexpr int32_t kBlocksPerSeq = 3;
+  constexpr int32_t kMaxSeqLen = kBlockSize * kBlocksPerSeq;
+  constexpr int32_t kRowSize = 2 * 4;
+  const std::vector<int64_t> block_table_data = {6, 0, 3, 2, 5, 1};
+  const std::vector<int64_t> positions = {9, 3};
+
+  std::vector<float> q_data(kBatch * kSeqLen * kRowSize);
+  std::vector<float> k_data(kBatch * kMaxSeqLen * kRowSize);
+  std::vector<float> v_data(k_data.size());
+  for (size_t i = 0; i < q_data.size(); ++i) {
+    q_data[i] = 0.1f * static_cast<float>((i * 7) % 11);
+  }
+  for (size_t i = 0; i < k_data.size(); ++i) {
+    k_data[i] = 0.1f * static_cast<float>((i * 5) % 13);
+    v_data[i] = 0.1f * static_cast<float>((i * 3) % 17) - 0.5f;
+  }
+  const int32_t num_pool_blocks = kBatch * kBlocksPerSeq + 1;
+  std::vector<float> k_pool(num_pool_blocks * kBlockSize * kRowSize);
+  std::vector<float> v_pool(k_pool.size());
+  const size_t block_elems = kBlockSize * kRowSize;
+  for (int32_t b = 0; b < kBatch; ++b) {
+    for (int32_t n = 0; n < kBlocksPerSeq; ++n) {
+      const size_t src = (b * kBlocksPerSeq + n) * block_elems;
+      const size_t dst = block_table_data[b * kBlocksPerSeq + n] * block_elems;
+      std::copy_n(k_data.begin() + src, block_elems, k_pool.begin() + dst);
+      std::copy_n(v_data.begin() + src, block_elems, v_pool.begin() + dst);
+    }
+  }
+
+  executorch::aten::Tensor q = tfFloat.make({kBatch, kSeqLen, 2, 4}, q_data);
+  executorch::aten::Tensor start_pos = tfLong.make({kBatch}, positions);
+
+  executorch::aten::Tensor k = tfFloat.make({kBatch, kMaxSeqLen, 2, 4}, k_data);
+  executorch::aten::Tensor v = tfFloat.make({kBatch, kMaxSeqLen, 2, 4}, v_data);
+  executorch::aten::Tensor expected = tfFloat.zeros({kBatch, kSeqLen, 2, 4});
+  torch::executor::native::custom_sdpa_with_positions_out(
+      context, q, k, v, start_pos, {}, 0.0, true, {}, expected);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  executorch::aten::Tensor k_cache =
+      tfFloat.make({num_pool_blocks, kBlockSize, 2, 4}, k_pool);
+  executorch::aten::Tensor v_cache =
+      tfFloat.make({num_pool_blocks, kBlockSize, 2, 4}, v_pool);
+  executorch::aten::Tensor block_table =
+      tfLong.make({kBatch, kBlocksPerSeq}, block_table_data);
+  executorch::aten::Tensor out = tfFloat.zeros({kBatch, kSeqLen, 2, 4});
+  torch::executor::native::custom_sdpa_paged_out(
+      context,
+      q,
+      k_cache,
+      v_cache,
+      block_table,
+      start_pos,
+      {},
+      0.0,
+      true,
+      {},
+      out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+  EXPECT_TENSOR_CLOSE(out, expected);
+}
+
+TEST(OpCustomSdpaPagedTest, OutOfRangeBlockFails) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  executorch::aten::Tensor q = tfFloat.ones({1, 1, 1, 4});
+  executorch::aten::Tensor k_cache = tfFloat.ones({2, 4, 1, 4});
+  executorch::aten::Tensor v_cache = tfFloat.ones({2, 4, 1, 4});
+  // Position 5 is in the second block of the row, which is not in the pool.
+  executorch::aten::Tensor block_table = tfLong.make({1, 2}, {0, 2});
+  executorch::aten::Tensor start_pos = tfLong.make({1}, {5});
+  executorch::aten::Tensor out = tfFloat.zeros({1, 1, 1, 4});
+  torch::executor::native::custom_sdpa_paged_out(
+      context,
+      q,
+      k_cache,
+      v_cache,
+      block_table,
+      start_pos,
+      {},
+      0.0,
+      true,
+      {},
+      out);
+  EXPECT_EQ(
+      context.failure_state(), executorch::runtime::Error::InvalidArgument);
+}
+
+TEST(OpCustomSdpaPagedTest, UnsupportedBlockSizeFails) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  // Blocks of 6 positions are neither a power of two nor a multiple of 16.
+  executorch::aten::Tensor q = tfFloat.ones({1, 1, 1, 4});
+  executorch::aten::Tensor k_cache = tfFloat.ones({2, 6, 1, 4});
+  executorch::aten::Tensor v_cache = tfFloat.ones({2, 6, 1, 4});
+  executorch::aten::Tensor block_table = tfLong.make({1, 1}, {1});
+  executorch::aten::Tensor start_pos = tfLong.make({1}, {0});
+  executorch::aten::Tensor out = tfFloat.zeros({1, 1, 1, 4});
+  torch::executor::native::custom_sdpa_paged_out(
+      context,
+      q,
+      k_cache,
+      v_cache,
+      block_table,
+      start_pos,
+      {},
+      0.0,
+      true,
+      {},
+      out);
+  EXPECT_EQ(
+      context.failure_state(), executorch::runtime::Error::InvalidArgument);
+}
+
+TEST(OpUpdateQuantizedCacheTest, QuantizesPerTokenAndPacksInt4) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Char> tfChar;
+  TensorFactory<executorch::aten::ScalarType::Byte> tfByte;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  // One token with one head, written at position 1 of a 2 token cache. The
+  // row spans [-1, 0.75], so the scale is 1.75 / (quant_max - quant_min) and
+  // the zero point maps 0.75 to just under quant_max.
+  executorch::aten::Tensor value =
+      tfFloat.make({1, 1, 1, 4}, {-1, 0, 0.25, 0.75});
+  executorch::aten::Tensor scales = tfFloat.zeros({1, 2, 1, 1});
+  executorch::aten::Tensor zero_points = tfChar.zeros({1, 2, 1, 1});
+  executorch::aten::Tensor out = tfFloat.zeros({1});
+
+  executorch::aten::Tensor int8_cache = tfChar.zeros({1, 2, 1, 4});
+  torch::executor::native::update_quantized_cache_out(
+      context, value, int8_cache, scales, zero_points, 1, out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+  EXPECT_TENSOR_EQ(
+      int8_cache, tfChar.make({1, 2, 1, 4}, {0, 0, 0, 0, -128, 18, 54, 127}));
+  EXPECT_TENSOR_CLOSE(scales, tfFloat.make({1, 2, 1, 1}, {0, 1.75f / 255}));
+  EXPECT_TENSOR_EQ(zero_points, tfChar.make({1, 2, 1, 1}, {0, 18}));
+
+  // -8 and 1 go to the first byte, 3 and 7 to the second.
+  executorch::aten::Tensor int4_cache = tfByte.zeros({1, 2, 1, 2});
+  torch::executor::native::update_quantized_cache_out(
+      context, value, int4_cache, scales, zero_points, 1, out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+  EXPECT_TENSOR_EQ(int4_cache, tfByte.make({1, 2, 1, 2}, {0, 0, 0x18, 0x73}));
+  EXPECT_TENSOR_CLOSE(scales, tfFloat.make({1, 2, 1, 1}, {0, 1.75f / 15}));
+  EXPECT_TENSOR_EQ(zero_points, tfChar.make({1, 2, 1, 1}, {0, 1}));
+
+  // Past the end of the cache.
+  torch::executor::native::update_quantized_cache_out(
+      context, value, int4_cache, scales, zero_points, 2, out);
+  EXPECT_EQ(
+      context.failure_state(), executorch::runtime::Error::InvalidArgument);
+}
+
+namespace {
+
+// Dequantizes an int8 or packed int4 cache written by
+// update_quantized_cache_out back to float.
+std::vector<float> dequantize_cache(
+    const executorch::aten::Tensor& cache,
+    const executorch::aten::Tensor& scales,
+    const executorch::aten::Tensor& zero_points,
+    int64_t head_dim) {
+  const bool is_int4 =
+      cache.scalar_type() == executorch::aten::ScalarType::Byte;
+  const int64_t num_rows = scales.numel();
+  std::vector<float> out(num_rows * head_dim);
+  for (int64_t row = 0; row < num_rows; ++row) {
+    const float scale = scales.const_data_ptr<float>()[row];
+    const int32_t zero_point = zero_points.const_data_ptr<int8_t>()[row];
+    for (int64_t d = 0; d < head_dim; ++d) {
+      int32_t q = 0;
+      if (is_int4) {
+        const uint8_t byte =
+            cache.const_data_ptr<uint8_t>()[row * head_dim / 2 + d / 2];
+        const int32_t nibble = d % 2 == 0 ? byte & 0x0F : byte >> 4;
+        q = nibble >= 8 ? nibble - 16 : nibble;
+      } else {
+        q = cache.const_data_ptr<int8_t>()[row * head_dim + d];
+      }
+      out[row * head_dim + d] = (q - zero_point) * scale;
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(OpCustomQuantizedSdpaTest, FloatQueryOverQuantizedKVCache) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Char> tfChar;
+  TensorFactory<executorch::aten::ScalarType::Byte> tfByte;
+
+  // Two query tokens at position 3 over a cache holding 5 tokens, with 4
+  // query heads sharing 2 KV heads.
+  constexpr int32_t kMaxSeqLen = 8;
+  constexpr int32_t kNumTokens = 5;
+  constexpr int32_t kHeadDim = 8;
+  constexpr int64_t kStartPos = 3;
+  std::vector<float> q_data(2 * 4 * kHeadDim);
+  std::vector<float> k_data(kNumTokens * 2 * kHeadDim);
+  std::vector<float> v_data(k_data.size());
+  for (size_t i = 0; i < q_data.size(); ++i) {
+    q_data[i] = 0.1f * static_cast<float>((i * 7) % 11) - 0.5f;
+  }
+  for (size_t i = 0; i < k_data.size(); ++i) {
+    k_data[i] = 0.1f * static_cast<float>((i * 5) % 13) - 0.6f;
+    v_data[i] = 0.1f * static_cast<float>((i * 3) % 17) - 0.8f;
+  }
+  executorch::aten::Tensor q = tfFloat.make({1, 2, 4, kHeadDim}, q_data);
+  executorch::aten::Tensor k =
+      tfFloat.make({1, kNumTokens, 2, kHeadDim}, k_data);
+  executorch::aten::Tensor v =
+      tfFloat.make({1, kNumTokens, 2, kHeadDim}, v_data);
+
+  // The float cache holds the same tokens, so this is the unquantized
+  // result.
+  executorch::runtime::KernelRuntimeContext context{};
+  std::vector<float> k_cache_data(kMaxSeqLen * 2 * kHeadDim, 0.0f);
+  std::vector<float> v_cache_data(k_cache_data.size(), 0.0f);
+  std::copy(k_data.begin(), k_data.end(), k_cache_data.begin());
+  std::copy(v_data.begin(), v_data.end(), v_cache_data.begin());
+  executorch::aten::Tensor float_out = tfFloat.zeros({1, 2, 4, kHeadDim});
+  torch::executor::native::custom_sdpa_out(
+      context,
+      q,
+      tfFloat.make({1, kMaxSeqLen, 2, kHeadDim}, k_cache_data),
+      tfFloat.make({1, kMaxSeqLen, 2, kHeadDim}, v_cache_data),
+      kStartPos,
+      {},
+      0.0,
+      true,
+      {},
+      float_out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  for (bool is_int4 : {false, true}) {
+    const int32_t packing = is_int4 ? 2 : 1;
+    executorch::aten::Tensor k_cache = is_int4
+        ? tfByte.zeros({1, kMaxSeqLen, 2, kHeadDim / packing})
+        : tfChar.zeros({1, kMaxSeqLen, 2, kHeadDim});
+    executorch::aten::Tensor v_cache = is_int4
+        ? tfByte.zeros({1, kMaxSeqLen, 2, kHeadDim / packing})
+        : tfChar.zeros({1, kMaxSeqLen, 2, kHeadDim});
+    executorch::aten::Tensor k_scales = tfFloat.zeros({1, kMaxSeqLen, 2, 1});
+    executorch::aten::Tensor v_scales = tfFloat.zeros({1, kMaxSeqLen, 2, 1});
+    executorch::aten::Tensor k_zero_points =
+        tfChar.zeros({1, kMaxSeqLen, 2, 1});
+    executorch::aten::Tensor v_zero_points =
+        tfChar.zeros({1, kMaxSeqLen, 2, 1});
+    executorch::aten::Tensor unused = tfFloat.zeros({1});
+    torch::executor::native::update_quantized_cache_out(
+        context, k, k_cache, k_scales, k_zero_points, 0, unused);
+    torch::executor::native::update_quantized_cache_out(
+        context, v, v_cache, v_scales, v_zero_points, 0, unused);
+    ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+    executorch::aten::Tensor out = tfFloat.zeros({1, 2, 4, kHeadDim});
+    torch::executor::native::custom_quantized_sdpa_out(
+        context,
+        q,
+        k_cache,
+        v_cache,
+        kStartPos,
+        {},
+        0.0,
+        true,
+        {},
+        {},
+        {},
+        k_zero_points,
+        k_scales,
+        v_zero_points,
+        v_scales,
+        false,
+        out);
+    ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+    // Dequantizing inside the tiles matches attention over the dequantized
+    // cache.
+    executorch::aten::Tensor expected = tfFloat.zeros({1, 2, 4, kHeadDim});
+    torch::executor::native::custom_sdpa_out(
+        context,
+        q,
+        tfFloat.make(
+            {1, kMaxSeqLen, 2, kHeadDim},
+            dequantize_cache(k_cache, k_scales, k_zero_points, kHeadDim)),
+        tfFloat.make(
+            {1, kMaxSeqLen, 2, kHeadDim},
+            dequantize_cache(v_cache, v_scales, v_zero_points, kHeadDim)),
+        kStartPos,
+        {},
+        0.0,
+        true,
+        {},
+        expected);
+    ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+    EXPECT_TENSOR_CLOSE(out, expected);
+
+    // And stays close to the unquantized result: K/V values span 1.2 and 1.6,
+    // so an int8 step is under 0.007 and an int4 step under 0.11.
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, float_out, 0, is_int4 ? 0.1 : 0.01);
+  }
+}
+
+TEST(OpCustomQuantizedSdpaTest, FloatQueryRejectsQueryQuantParams) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Char> tfChar;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  executorch::aten::Tensor q = tfFloat.ones({1, 1, 1, 4});
+  executorch::aten::Tensor k_cache = tfChar.ones({1, 2, 1, 4});
+  executorch::aten::Tensor v_cache = tfChar.ones({1, 2, 1, 4});
+  executorch::aten::Tensor scales = tfFloat.ones({1, 2, 1, 1});
+  executorch::aten::Tensor zero_points = tfChar.zeros({1, 2, 1, 1});
+  executorch::aten::Tensor q_scales = tfFloat.ones({1, 1, 1, 1});
+  executorch::aten::Tensor q_zero_points = tfChar.zeros({1, 1, 1, 1});
+  executorch::aten::Tensor out = tfFloat.zeros({1, 1, 1, 4});
+  torch::executor::native::custom_quantized_sdpa_out(
+      context,
+      q,
+      k_cache,
+      v_cache,
+      0,
+      {},
+      0.0,
+      true,
+      {},
+      q_zero_points,
+      q_scales,
+      zero_points,
+      scales,
+      zero_points,
+      scales,
+      false,
+      out);
+  EXPECT_EQ(
+      context.failure_state(), executorch::runtime::Error::InvalidArgument);
+}
+
+namespace {
+
+// softmax(q @ k.T / sqrt(head_dim)) @ v for one query token per row, over
+// positions 0 ... positions[b] of [batch, max_seq_len, kv_heads, head_dim]
+// caches, with query head h reading KV head h / (heads / kv_heads).
+std::vector<float> decode_attention_reference(
+    const std::vector<float>& q_data,
+    const std::vector<float>& k_data,
+    const std::vector<float>& v_data,
+    int32_t batch,
+    int32_t heads,
+    int32_t kv_heads,
+    int32_t head_dim,
+    int32_t max_seq_len,
+    const std::vector<int64_t>& positions) {
+  const float scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+  std::vector<float> expected(q_data.size());
+  for (int32_t b = 0; b < batch; ++b) {
+    for (int32_t h = 0; h < heads; ++h) {
+      const int32_t h_kv = h / (heads / kv_heads);
+      const float* q_row = q_data.data() + (b * heads + h) * head_dim;
+      const int64_t num_keys = positions[b] + 1;
+      std::vector<double> weights(num_keys);
+      double max = -std::numeric_limits<double>::infinity();
+      for (int64_t n = 0; n < num_keys; ++n) {
+        const float* k_row = k_data.data() +
+            ((b * max_seq_len + n) * kv_heads + h_kv) * head_dim;
+        double score = 0;
+        for (int32_t d = 0; d < head_dim; ++d) {
+          score += q_row[d] * k_row[d];
+        }
+        weights[n] = score * scale;
+        max = std::max(max, weights[n]);
+      }
+      double sum = 0;
+      for (auto& weight : weights) {
+        weight = std::exp(weight - max);
+        sum += weight;
+      }
+      for (int32_t d = 0; d < head_dim; ++d) {
+        double value = 0;
+        for (int64_t n = 0; n < num_keys; ++n) {
+          value += weights[n] *
+              v_data[((b * max_seq_len + n) * kv_heads + h_kv) * head_dim + d];
+        }
+        expected[(b * heads + h) * head_dim + d] = value / sum;
+      }
+    }
+  }
+  return expected;
+}
+
+// Fills q, k and v with small values that differ between heads and
+// positions.
+void fill_decode_inputs(
+    std::vector<float>& q_data,
+    std::vector<float>& k_data,
+    std::vector<float>& v_data) {
+  for (size_t i = 0; i < q_data.size(); ++i) {
+    q_data[i] = 0.1f * static_cast<float>((i * 7) % 11) - 0.5f;
+  }
+  for (size_t i = 0; i < k_data.size(); ++i) {
+    k_data[i] = 0.1f * static_cast<float>((i * 5) % 13) - 0.6f;
+    v_data[i] = 0.1f * static_cast<float>((i * 3) % 17) - 0.8f;
+  }
+}
+
+// Sets the number of threads for the lifetime of the guard. Decode attention
+// splits the keys of each KV group across threads only when there are fewer
+// groups than threads, so a single group over enough threads is always
+// split.
+class ThreadCountGuard {
+ public:
+  explicit ThreadCountGuard(uint32_t num_threads)
+      : saved_(::executorch::extension::threadpool::get_threadpool()
+                   ->get_thread_count()) {
+    ::executorch::extension::threadpool::get_threadpool()
+        ->_unsafe_reset_threadpool(num_threads);
+  }
+  ~ThreadCountGuard() {
+    ::executorch::extension::threadpool::get_threadpool()
+        ->_unsafe_reset_threadpool(saved_);
+  }
+
+ private:
+  const uint32_t saved_;
+};
+
+// One query token over a single KV group: 4 query heads share one KV head.
+// With 4 threads and keys up to position 900, the keys are split 3 ways
+// (at least 256 keys per split).
+constexpr int32_t kSplitHeads = 4;
+constexpr int32_t kSplitHeadDim = 20;
+constexpr int32_t kSplitMaxSeqLen = 1024;
+constexpr int64_t kSplitPosition = 900;
+constexpr uint32_t kSplitThreads = 4;
+
+} // namespace
+
+TEST(OpCustomSdpaDecodeTest, GroupedQueryHeadsOverLongCache) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+
+  // One query token per row, with 4 query heads per KV head, over caches
+  // long enough to be split across threads.
+  constexpr int32_t kBatch = 2;
+  constexpr int32_t kHeads = 8;
+  constexpr int32_t kKVHeads = 2;
+  constexpr int32_t kHeadDim = 20;
+  constexpr int32_t kMaxSeqLen = 1024;
+  const std::vector<int64_t> positions = {900, 517};
+
+  std::vector<float> q_data(kBatch * kHeads * kHeadDim);
+  std::vector<float> k_data(kBatch * kMaxSeqLen * kKVHeads * kHeadDim);
+  std::vector<float> v_data(k_data.size());
+  fill_decode_inputs(q_data, k_data, v_data);
+
+  executorch::aten::Tensor q =
+      tfFloat.make({kBatch, 1, kHeads, kHeadDim}, q_data);
+  executorch::aten::Tensor k =
+      tfFloat.make({kBatch, kMaxSeqLen, kKVHeads, kHeadDim}, k_data);
+  executorch::aten::Tensor v =
+      tfFloat.make({kBatch, kMaxSeqLen, kKVHeads, kHeadDim}, v_data);
+  executorch::aten::Tensor start_pos = tfLong.make({kBatch}, positions);
+  executorch::aten::Tensor out = tfFloat.zeros({kBatch, 1, kHeads, kHeadDim});
+  torch::executor::native::custom_sdpa_with_positions_out(
+      context, q, k, v, start_pos, {}, 0.0, true, {}, out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  const std::vector<float> expected = decode_attention_reference(
+      q_data,
+      k_data,
+      v_data,
+      kBatch,
+      kHeads,
+      kKVHeads,
+      kHeadDim,
+      kMaxSeqLen,
+      positions);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out, tfFloat.make({kBatch, 1, kHeads, kHeadDim}, expected), 0, 1e-5);
+}
+
+TEST(OpCustomSdpaDecodeTest, SplitsSingleKVGroup) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  executorch::runtime::KernelRuntimeContext context{};
+  ThreadCountGuard threads(kSplitThreads);
+
+  std::vector<float> q_data(kSplitHeads * kSplitHeadDim);
+  std::vector<float> k_data(kSplitMaxSeqLen * kSplitHeadDim);
+  std::vector<float> v_data(k_data.size());
+  fill_decode_inputs(q_data, k_data, v_data);
+
+  executorch::aten::Tensor out =
+      tfFloat.zeros({1, 1, kSplitHeads, kSplitHeadDim});
+  torch::executor::native::custom_sdpa_out(
+      context,
+      tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, q_data),
+      tfFloat.make({1, kSplitMaxSeqLen, 1, kSplitHeadDim}, k_data),
+      tfFloat.make({1, kSplitMaxSeqLen, 1, kSplitHeadDim}, v_data),
+      kSplitPosition,
+      {},
+      0.0,
+      true,
+      {},
+      out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  const std::vector<float> expected = decode_attention_reference(
+      q_data,
+      k_data,
+      v_data,
+      1,
+      kSplitHeads,
+      1,
+      kSplitHeadDim,
+      kSplitMaxSeqLen,
+      {kSplitPosition});
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out, tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, expected), 0, 1e-5);
+}
+
+TEST(OpCustomSdpaDecodeTest, SplitsPagedCache) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Long> tfLong;
+  executorch::runtime::KernelRuntimeContext context{};
+  ThreadCountGuard threads(kSplitThreads);
+
+  // The row's 16 blocks of 64 positions sit in the pool in reverse order,
+  // after an unused block, so every split reads blocks out of order.
+  constexpr int32_t kBlockSize = 64;
+  constexpr int32_t kBlocksPerSeq = kSplitMaxSeqLen / kBlockSize;
+  constexpr int32_t kNumPoolBlocks = kBlocksPerSeq + 1;
+  std::vector<int64_t> block_table_data(kBlocksPerSeq);
+  for (int32_t n = 0; n < kBlocksPerSeq; ++n) {
+    block_table_data[n] = kBlocksPerSeq - n;
+  }
+
+  std::vector<float> q_data(kSplitHeads * kSplitHeadDim);
+  std::vector<float> k_data(kSplitMaxSeqLen * kSplitHeadDim);
+  std::vector<float> v_data(k_data.size());
+  fill_decode_inputs(q_data, k_data, v_data);
+  const size_t block_elems = kBlockSize * kSplitHeadDim;
+  std::vector<float> k_pool(kNumPoolBlocks * block_elems, 0.0f);
+  std::vector<float> v_pool(k_pool.size(), 0.0f);
+  for (int32_t n = 0; n < kBlocksPerSeq; ++n) {
+    const size_t src = n * block_elems;
+    const size_t dst = block_table_data[n] * block_elems;
+    std::copy_n(k_data.begin() + src, block_elems, k_pool.begin() + dst);
+    std::copy_n(v_data.begin() + src, block_elems, v_pool.begin() + dst);
+  }
+
+  executorch::aten::Tensor out =
+      tfFloat.zeros({1, 1, kSplitHeads, kSplitHeadDim});
+  torch::executor::native::custom_sdpa_paged_out(
+      context,
+      tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, q_data),
+      tfFloat.make({kNumPoolBlocks, kBlockSize, 1, kSplitHeadDim}, k_pool),
+      tfFloat.make({kNumPoolBlocks, kBlockSize, 1, kSplitHeadDim}, v_pool),
+      tfLong.make({1, kBlocksPerSeq}, block_table_data),
+      tfLong.make({1}, {kSplitPosition}),
+      {},
+      0.0,
+      true,
+      {},
+      out);
+  ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+  const std::vector<float> expected = decode_attention_reference(
+      q_data,
+      k_data,
+      v_data,
+      1,
+      kSplitHeads,
+      1,
+      kSplitHeadDim,
+      kSplitMaxSeqLen,
+      {kSplitPosition});
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out, tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, expected), 0, 1e-5);
+}
+
+TEST(OpCustomSdpaDecodeTest, SplitsQuantizedCache) {
+  TensorFactory<executorch::aten::ScalarType::Float> tfFloat;
+  TensorFactory<executorch::aten::ScalarType::Char> tfChar;
+  TensorFactory<executorch::aten::ScalarType::Byte> tfByte;
+  executorch::runtime::KernelRuntimeContext context{};
+  ThreadCountGuard threads(kSplitThreads);
+
+  std::vector<float> q_data(kSplitHeads * kSplitHeadDim);
+  std::vector<float> k_data(kSplitMaxSeqLen * kSplitHeadDim);
+  std::vector<float> v_data(k_data.size());
+  fill_decode_inputs(q_data, k_data, v_data);
+  executorch::aten::Tensor q =
+      tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, q_data);
+
+  for (bool is_int4 : {false, true}) {
+    const int32_t packed_dim = is_int4 ? kSplitHeadDim / 2 : kSplitHeadDim;
+    executorch::aten::Tensor k_cache = is_int4
+        ? tfByte.zeros({1, kSplitMaxSeqLen, 1, packed_dim})
+        : tfChar.zeros({1, kSplitMaxSeqLen, 1, packed_dim});
+    executorch::aten::Tensor v_cache = is_int4
+        ? tfByte.zeros({1, kSplitMaxSeqLen, 1, packed_dim})
+        : tfChar.zeros({1, kSplitMaxSeqLen, 1, packed_dim});
+    executorch::aten::Tensor k_scales =
+        tfFloat.zeros({1, kSplitMaxSeqLen, 1, 1});
+    executorch::aten::Tensor v_scales =
+        tfFloat.zeros({1, kSplitMaxSeqLen, 1, 1});
+    executorch::aten::Tensor k_zero_points =
+        tfChar.zeros({1, kSplitMaxSeqLen, 1, 1});
+    executorch::aten::Tensor v_zero_points =
+        tfChar.zeros({1, kSplitMaxSeqLen, 1, 1});
+    executorch::aten::Tensor unused = tfFloat.zeros({1});
+    torch::executor::native::update_quantized_cache_out(
+        context,
+        tfFloat.make({1, kSplitMaxSeqLen, 1, kSplitHeadDim}, k_data),
+        k_cache,
+        k_scales,
+        k_zero_points,
+        0,
+        unused);
+    torch::executor::native::update_quantized_cache_out(
+        context,
+        tfFloat.make({1, kSplitMaxSeqLen, 1, kSplitHeadDim}, v_data),
+        v_cache,
+        v_scales,
+        v_zero_points,
+        0,
+        unused);
+    ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+    executorch::aten::Tensor out =
+        tfFloat.zeros({1, 1, kSplitHeads, kSplitHeadDim});
+    torch::executor::native::custom_quantized_sdpa_out(
+        context,
+        q,
+        k_cache,
+        v_cache,
+        kSplitPosition,
+        {},
+        0.0,
+        true,
+        {},
+        {},
+        {},
+        k_zero_points,
+        k_scales,
+        v_zero_points,
+        v_scales,
+        false,
+        out);
+    ASSERT_EQ(context.failure_state(), executorch::runtime::Error::Ok);
+
+    // Dequantizing inside the tiles matches attention over the dequantized
+    // cache.
+    const std::vector<float> expected = decode_attention_reference(
+        q_data,
+        dequantize_cache(k_cache, k_scales, k_zero_points, kSplitHeadDim),
+        dequantize_cache(v_cache, v_scales, v_zero_points, kSplitHeadDim),
+        1,
+        kSplitHeads,
+        1,
+        kSplitHeadDim,
+        kSplitMaxSeqLen,
+        {kSplitPosition});
+    EXPECT_TENSOR_CLOSE_WITH_TOL(
+        out,
+        tfFloat.make({1, 1, kSplitHeads, kSplitHeadDim}, expected),
+        0,
+        1e-5);
+  }
+}
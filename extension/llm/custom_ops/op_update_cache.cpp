@@ -8,6 +8,11 @@
 
 #include <executorch/extension/llm/custom_ops/op_update_cache.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
 // @lint-ignore CLANGTIDY facebook-unused-include-check
 #include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
@@ -87,6 +92,160 @@ bool validate_cache_params(
   return true;
 }
 
+bool validate_paged_cache_params(
+    const Tensor& value,
+    const Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos) {
+  ET_CHECK_OR_RETURN_FALSE(cache.dim() == 4, "cache must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(value.dim() == 4, "value must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(
+      value.size(2) == cache.size(2) && value.size(3) == cache.size(3),
+      "value and cache must have the same number of heads and head dim");
+  ET_CHECK_OR_RETURN_FALSE(
+      value.scalar_type() == cache.scalar_type(),
+      "value and cache must have the same dtype");
+
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.dim() == 2 && block_table.size(0) == value.size(0),
+      "block_table must be a 2D tensor [batch_size, max_blocks_per_seq]");
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.scalar_type() == ScalarType::Long,
+      "block_table must be of Long (int64_t) type");
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.dim() == 1 && start_pos.size(0) == value.size(0),
+      "start_pos must be a 1D tensor [batch_size]");
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.scalar_type() == ScalarType::Long,
+      "start_pos must be of Long (int64_t) type");
+
+  // The attention kernels split blocks into tiles of at least 16 positions.
+  const int64_t block_size = cache.size(1);
+  ET_CHECK_OR_RETURN_FALSE(
+      block_size > 0 &&
+          (block_size % 16 == 0 || (block_size & (block_size - 1)) == 0),
+      "block_size %" PRId64 " must be a power of two or a multiple of 16",
+      block_size);
+
+  const int64_t max_pos = block_table.size(1) * block_size;
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < start_pos.size(0); ++b) {
+    ET_CHECK_OR_RETURN_FALSE(
+        start_pos_data[b] >= 0 && start_pos_data[b] + value.size(1) <= max_pos,
+        "start_pos[%" PRId64 "] + seq_length = %" PRId64
+        " must be in [0, %" PRId64 "]",
+        b,
+        start_pos_data[b] + static_cast<int64_t>(value.size(1)),
+        max_pos);
+  }
+
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "cache must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      "value must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(
+          block_table.dim_order().data(), block_table.dim()),
+      "block_table must be in contiguous dim order");
+  return true;
+}
+
+bool validate_quantized_cache_params(
+    const Tensor& value,
+    const Tensor& cache,
+    const Tensor& scales,
+    const Tensor& zero_points,
+    int64_t start_pos) {
+  ET_CHECK_OR_RETURN_FALSE(value.dim() == 4, "value must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(cache.dim() == 4, "cache must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(
+      value.scalar_type() == ScalarType::Float, "value must be float");
+  ET_CHECK_OR_RETURN_FALSE(
+      cache.scalar_type() == ScalarType::Char ||
+          cache.scalar_type() == ScalarType::Byte,
+      "cache must be int8, or uint8 holding packed int4 pairs");
+  const int64_t packing = cache.scalar_type() == ScalarType::Byte ? 2 : 1;
+  ET_CHECK_OR_RETURN_FALSE(
+      value.size(0) == cache.size(0) && value.size(2) == cache.size(2) &&
+          value.size(3) == cache.size(3) * packing,
+      "value and cache must have the same batch size, heads and head dim");
+
+  ET_CHECK_OR_RETURN_FALSE(
+      scales.scalar_type() == ScalarType::Float, "scales must be float");
+  ET_CHECK_OR_RETURN_FALSE(
+      zero_points.scalar_type() == ScalarType::Char,
+      "zero_points must be int8");
+  for (const Tensor* qparams : {&scales, &zero_points}) {
+    ET_CHECK_OR_RETURN_FALSE(
+        qparams->dim() == 4 && qparams->size(0) == cache.size(0) &&
+            qparams->size(1) == cache.size(1) &&
+            qparams->size(2) == cache.size(2) && qparams->size(3) == 1,
+        "scales and zero_points must be [batch, max_seq_len, heads, 1]");
+    ET_CHECK_OR_RETURN_FALSE(
+        is_contiguous_dim_order(qparams->dim_order().data(), qparams->dim()),
+        "scales and zero_points must be in contiguous dim order");
+  }
+
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos >= 0 && start_pos + value.size(1) <= cache.size(1),
+      "start_pos + seq_length = %" PRId64 " must be in [0, %zd]",
+      start_pos + static_cast<int64_t>(value.size(1)),
+      cache.size(1));
+
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "cache must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      "value must be in contiguous dim order");
+  return true;
+}
+
+// Quantizes one row of head_dim values the way
+// torch.ops.quantized_decomposed.choose_qparams_per_token_asymmetric and
+// quantize_per_token do, into [quant_min, quant_max].
+void quantize_row(
+    const float* row,
+    int64_t head_dim,
+    int32_t quant_min,
+    int32_t quant_max,
+    int8_t* out,
+    float* scale_out,
+    int8_t* zero_point_out) {
+  float min_val = 0.0f;
+  float max_val = 0.0f;
+  for (int64_t i = 0; i < head_dim; ++i) {
+    min_val = std::min(min_val, row[i]);
+    max_val = std::max(max_val, row[i]);
+  }
+  const float scale = std::max(
+      (max_val - min_val) / static_cast<float>(quant_max - quant_min),
+      std::numeric_limits<float>::epsilon());
+  const float descaled_min = min_val / scale;
+  const float descaled_max = max_val / scale;
+  // Pick the zero point whose rounding error is smaller.
+  const float zero_point_from_min_error = quant_min + descaled_min;
+  const float zero_point_from_max_error = quant_max + descaled_max;
+  float zero_point = zero_point_from_min_error + zero_point_from_max_error > 0
+      ? quant_min - descaled_min
+      : quant_max - descaled_max;
+  zero_point = std::nearbyint(std::min(
+      std::max(zero_point, static_cast<float>(quant_min)),
+      static_cast<float>(quant_max)));
+
+  const float inv_scale = 1.0f / scale;
+  for (int64_t i = 0; i < head_dim; ++i) {
+    const float q = std::nearbyint(row[i] * inv_scale + zero_point);
+    out[i] = static_cast<int8_t>(std::min(
+        std::max(q, static_cast<float>(quant_min)),
+        static_cast<float>(quant_max)));
+  }
+  *scale_out = scale;
+  *zero_point_out = static_cast<int8_t>(zero_point);
+}
+
 // Helper function for the actual update operation
 Tensor& update_cache_impl(
     RuntimeContext& ctx,
@@ -242,6 +401,120 @@ Tensor& update_cache_with_indices_out(
   return update_cache_impl(ctx, value, cache, start_pos, output, indices);
 }
 
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_paged_cache_params(value, cache, block_table, start_pos),
+      InvalidArgument,
+      output);
+
+  const int64_t num_blocks = cache.size(0);
+  const int64_t block_size = cache.size(1);
+  const int64_t max_blocks_per_seq = block_table.size(1);
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  const int64_t* start_pos_data = start_pos.const_data_ptr<int64_t>();
+
+  const uint8_t* value_data =
+      static_cast<const uint8_t*>(value.const_data_ptr());
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+  const size_t bytes_per_token = value.strides()[1] * value.element_size();
+  const size_t cache_block_bytes = cache.strides()[0] * cache.element_size();
+
+  for (int64_t batch_line = 0; batch_line < value.size(0); ++batch_line) {
+    const int64_t* row_table =
+        block_table_data + batch_line * max_blocks_per_seq;
+    for (int64_t seq_idx = 0; seq_idx < value.size(1); ++seq_idx) {
+      const int64_t pos = start_pos_data[batch_line] + seq_idx;
+      const int64_t block = row_table[pos / block_size];
+      ET_KERNEL_CHECK_MSG(
+          ctx,
+          block >= 0 && block < num_blocks,
+          InvalidArgument,
+          output,
+          "Block index out of bounds: %" PRId64 " not in [0, %" PRId64 ")",
+          block,
+          num_blocks);
+      std::memcpy(
+          cache_data + block * cache_block_bytes +
+              (pos % block_size) * bytes_per_token,
+          value_data +
+              (batch_line * value.size(1) + seq_idx) * bytes_per_token,
+          bytes_per_token);
+    }
+  }
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
+Tensor& update_quantized_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_quantized_cache_params(
+          value, cache, scales, zero_points, start_pos),
+      InvalidArgument,
+      output);
+
+  const bool is_int4 = cache.scalar_type() == ScalarType::Byte;
+  const int32_t quant_min = is_int4 ? -8 : -128;
+  const int32_t quant_max = is_int4 ? 7 : 127;
+  const int64_t batch_size = value.size(0);
+  const int64_t seq_len = value.size(1);
+  const int64_t num_heads = value.size(2);
+  const int64_t head_dim = value.size(3);
+  const int64_t max_seq_len = cache.size(1);
+  const int64_t cache_row_size = cache.size(3);
+
+  const float* value_data = value.const_data_ptr<float>();
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+  float* scales_data = scales.mutable_data_ptr<float>();
+  int8_t* zero_points_data = zero_points.mutable_data_ptr<int8_t>();
+
+  std::vector<int8_t> quantized(is_int4 ? head_dim : 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t s = 0; s < seq_len; ++s) {
+      for (int64_t h = 0; h < num_heads; ++h) {
+        const int64_t value_row = (b * seq_len + s) * num_heads + h;
+        const int64_t cache_row =
+            (b * max_seq_len + start_pos + s) * num_heads + h;
+        uint8_t* cache_row_data = cache_data + cache_row * cache_row_size;
+        int8_t* out = is_int4 ? quantized.data()
+                              : reinterpret_cast<int8_t*>(cache_row_data);
+        quantize_row(
+            value_data + value_row * head_dim,
+            head_dim,
+            quant_min,
+            quant_max,
+            out,
+            scales_data + cache_row,
+            zero_points_data + cache_row);
+        if (is_int4) {
+          // Element 2i goes to the low nibble of byte i, element 2i + 1 to
+          // the high nibble.
+          for (int64_t i = 0; i < cache_row_size; ++i) {
+            cache_row_data[i] = (quantized[2 * i] & 0x0F) |
+                ((quantized[2 * i + 1] & 0x0F) << 4);
+          }
+        }
+      }
+    }
+  }
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -262,3 +535,15 @@ EXECUTORCH_LIBRARY(
     llama,
     "update_cache_with_indices.out",
     torch::executor::native::update_cache_with_indices_out);
+
+// Register the paged variant, which writes through a block table
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_cache_paged.out",
+    torch::executor::native::update_cache_paged_out);
+
+// Register the variant that quantizes on write
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_quantized_cache.out",
+    torch::executor::native::update_quantized_cache_out);
@@ -31,6 +31,32 @@ Tensor& update_cache_with_indices_out(
     const int64_t start_pos,
     const Tensor& indices,
     Tensor& output);
+
+// Writes into a paged cache of shape [num_blocks, block_size, heads, dim].
+// Token s of batch row b goes to logical position start_pos[b] + s, which
+// lives in physical block block_table[b][pos / block_size].
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output);
+
+// Quantizes value [batch, seq_len, heads, dim] per token and head, and
+// writes it at start_pos of an int8 cache [batch, max_seq_len, heads, dim],
+// or of a packed int4 cache [batch, max_seq_len, heads, dim / 2] of uint8.
+// In the int4 cache, element 2i of a row is the low nibble of byte i. The
+// float scales and int8 zero points of each row go to the same position of
+// scales and zero_points, which are [batch, max_seq_len, heads, 1].
+Tensor& update_quantized_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output);
 } // namespace native
 } // namespace executor
 } // namespace torch
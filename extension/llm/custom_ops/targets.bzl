@@ -121,6 +121,7 @@ def define_common_targets():
             "//executorch/runtime/core/exec_aten:lib",
             "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
             "//executorch/kernels/test:test_util",
+            "//executorch/extension/threadpool:threadpool",
             ":custom_ops",
         ],
     )
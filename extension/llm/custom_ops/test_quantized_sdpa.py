@@ -542,3 +542,97 @@ class SDPATestForCustomQuantizedSDPA(unittest.TestCase):
             seq_len,
             is_seq_at_dim_2=False,
         )
+
+
+class SDPATestForQuantizedKVCache(unittest.TestCase):
+    """
+    Float query over an int8 or packed int4 KV cache written by
+    update_quantized_cache. Tensors are in [B, S, H, D] format.
+    """
+
+    def setUp(self):
+        torch.manual_seed(42)
+        self.n_heads_kv = 4
+        self.n_heads_q = 8
+        self.head_dim = 64
+        self.max_seq_len = 256
+
+    def _dequantize(self, cache, scales, zero_points):
+        if cache.dtype == torch.uint8:
+            low = cache & 0x0F
+            high = cache >> 4
+            cache = torch.stack([low, high], dim=-1).flatten(-2).to(torch.int32)
+            cache = torch.where(cache >= 8, cache - 16, cache)
+        return (cache.to(torch.int32) - zero_points.to(torch.int32)) * scales
+
+    def _test_quantized_kv_cache(self, dtype, start_pos, seq_len):
+        num_tokens = start_pos + seq_len
+        packing = 2 if dtype == torch.uint8 else 1
+        q = torch.randn((1, seq_len, self.n_heads_q, self.head_dim))
+        k = torch.randn((1, num_tokens, self.n_heads_kv, self.head_dim))
+        v = torch.randn((1, num_tokens, self.n_heads_kv, self.head_dim))
+
+        caches = []
+        for value in [k, v]:
+            cache = torch.zeros(
+                (1, self.max_seq_len, self.n_heads_kv, self.head_dim // packing),
+                dtype=dtype,
+            )
+            scales = torch.zeros((1, self.max_seq_len, self.n_heads_kv, 1))
+            zero_points = torch.zeros(
+                (1, self.max_seq_len, self.n_heads_kv, 1), dtype=torch.int8
+            )
+            torch.ops.llama.update_quantized_cache(
+                value, cache, scales, zero_points, 0
+            )
+            caches.append((cache, scales, zero_points))
+        (k_cache, k_scales, k_zero_points), (v_cache, v_scales, v_zero_points) = (
+            caches
+        )
+
+        out = torch.ops.llama.custom_quantized_sdpa(
+            q,
+            k_cache,
+            v_cache,
+            start_pos,
+            None,
+            0,
+            True,
+            None,
+            None,
+            None,
+            k_zero_points,
+            k_scales,
+            v_zero_points,
+            v_scales,
+            False,
+        )
+
+        # Attention over the dequantized cache.
+        k_dq = self._dequantize(k_cache, k_scales, k_zero_points)
+        v_dq = self._dequantize(v_cache, v_scales, v_zero_points)
+        expected = torch.ops.llama.custom_sdpa(
+            q, k_dq, v_dq, start_pos, None, 0, True, None
+        )
+        self.assertTrue(torch.allclose(out, expected, atol=1e-5))
+
+        float_k = torch.zeros((1, self.max_seq_len, self.n_heads_kv, self.head_dim))
+        float_v = torch.zeros_like(float_k)
+        float_k[:, :num_tokens] = k
+        float_v[:, :num_tokens] = v
+        float_out = torch.ops.llama.custom_sdpa(
+            q, float_k, float_v, start_pos, None, 0, True, None
+        )
+        # Early query tokens attend to few keys and see most of the error, so
+        # compare on average.
+        return (out - float_out).abs().mean().item()
+
+    def test_int8_kv_cache(self):
+        for start_pos, seq_len in [(0, 40), (130, 1)]:
+            error = self._test_quantized_kv_cache(torch.int8, start_pos, seq_len)
+            self.assertLess(error, 0.01)
+
+    def test_int4_kv_cache(self):
+        for start_pos, seq_len in [(0, 40), (130, 1)]:
+            error = self._test_quantized_kv_cache(torch.uint8, start_pos, seq_len)
+            self.assertLess(error, 0.1)
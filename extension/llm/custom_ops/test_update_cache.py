@@ -431,3 +431,156 @@ class UpdateQuantizedKVCacheTest(unittest.TestCase):
         self._update_and_validate(
             k, v, k_scales, v_scales, k_zero_points, v_zero_points, start_pos
         )
+
+
+class UpdatePagedKVCacheTest(unittest.TestCase):
+
+    def setUp(self):
+        torch.manual_seed(42)
+        self.num_blocks = 6
+        self.block_size = 4
+        self.cache = torch.zeros((self.num_blocks, self.block_size, 2, 3))
+
+    def test_rows_are_written_through_block_table(self):
+        value = torch.rand((2, 3, 2, 3))
+        # Row 0 spans the end of block 5 and the start of block 1; row 1 is
+        # at the start of block 2.
+        block_table = torch.tensor([[5, 1, 0], [2, 0, 0]], dtype=torch.int64)
+        start_pos = torch.tensor([3, 0], dtype=torch.int64)
+        expected = self.cache.clone()
+        expected[5, 3] = value[0, 0]
+        expected[1, 0] = value[0, 1]
+        expected[1, 1] = value[0, 2]
+        expected[2, 0:3] = value[1]
+
+        torch.ops.llama.update_cache_paged(
+            value, self.cache, block_table, start_pos
+        )
+        self.assertTrue(torch.allclose(self.cache, expected))
+
+    def test_out_of_range_block_fails(self):
+        value = torch.rand((1, 1, 2, 3))
+        block_table = torch.tensor([[self.num_blocks]], dtype=torch.int64)
+        start_pos = torch.tensor([0], dtype=torch.int64)
+
+        @run_in_subprocess
+        def run_and_catch(value, cache, block_table, start_pos):
+            torch.ops.llama.update_cache_paged(value, cache, block_table, start_pos)
+
+        exception_raised = False
+        try:
+            run_and_catch(value, self.cache, block_table, start_pos)
+        except Exception:
+            exception_raised = True
+        self.assertTrue(exception_raised)
+
+    def test_unsupported_block_size_fails(self):
+        # Blocks of 6 positions are neither a power of two nor a multiple of 16.
+        cache = torch.zeros((self.num_blocks, 6, 2, 3))
+        value = torch.rand((1, 1, 2, 3))
+        block_table = torch.tensor([[1]], dtype=torch.int64)
+        start_pos = torch.tensor([0], dtype=torch.int64)
+
+        @run_in_subprocess
+        def run_and_catch(value, cache, block_table, start_pos):
+            torch.ops.llama.update_cache_paged(value, cache, block_table, start_pos)
+
+        exception_raised = False
+        try:
+            run_and_catch(value, cache, block_table, start_pos)
+        except Exception:
+            exception_raised = True
+        self.assertTrue(exception_raised)
+
+
+class UpdateQuantizedCacheOnWriteTest(unittest.TestCase):
+
+    def setUp(self):
+        from torch.ao.quantization.fx._decomposed import (  # noqa: F401
+            quantized_decomposed_lib,
+        )
+
+        torch.manual_seed(42)
+        self.max_seq_len = 10
+        self.num_heads = 4
+        self.head_dim = 8
+        self.scales = torch.zeros((1, self.max_seq_len, self.num_heads, 1))
+        self.zero_points = torch.zeros(
+            (1, self.max_seq_len, self.num_heads, 1), dtype=torch.int8
+        )
+
+    def _dequantize_int4(self, cache, scales, zero_points):
+        # Element 2i of a row is the low nibble of byte i.
+        low = cache & 0x0F
+        high = cache >> 4
+        unpacked = torch.stack([low, high], dim=-1).flatten(-2).to(torch.int32)
+        unpacked = torch.where(unpacked >= 8, unpacked - 16, unpacked)
+        return (unpacked - zero_points.to(torch.int32)) * scales
+
+    def test_int8_matches_quantize_per_token(self):
+        value = torch.randn((1, 3, self.num_heads, self.head_dim))
+        cache = torch.zeros(
+            (1, self.max_seq_len, self.num_heads, self.head_dim), dtype=torch.int8
+        )
+        start_pos = 4
+        torch.ops.llama.update_quantized_cache(
+            value, cache, self.scales, self.zero_points, start_pos
+        )
+
+        scales, zero_points = (
+            torch.ops.quantized_decomposed.choose_qparams_per_token_asymmetric.default(
+                value, torch.int8
+            )
+        )
+        expected = torch.ops.quantized_decomposed.quantize_per_token(
+            value, scales, zero_points, -128, 127, torch.int8
+        )
+        written = slice(start_pos, start_pos + 3)
+        self.assertTrue(torch.allclose(self.scales[:, written], scales))
+        self.assertTrue(
+            torch.equal(self.zero_points[:, written], zero_points.to(torch.int8))
+        )
+        # Values that land on a rounding tie may round either way.
+        diff = (cache[:, written].to(torch.int32) - expected.to(torch.int32)).abs()
+        self.assertLessEqual(diff.max().item(), 1)
+        self.assertEqual(cache[:, :start_pos].abs().sum().item(), 0)
+
+    def test_int4_round_trip(self):
+        value = torch.randn((1, 2, self.num_heads, self.head_dim))
+        cache = torch.zeros(
+            (1, self.max_seq_len, self.num_heads, self.head_dim // 2),
+            dtype=torch.uint8,
+        )
+        start_pos = 1
+        torch.ops.llama.update_quantized_cache(
+            value, cache, self.scales, self.zero_points, start_pos
+        )
+
+        written = slice(start_pos, start_pos + 2)
+        scales = self.scales[:, written]
+        dequantized = self._dequantize_int4(
+            cache[:, written], scales, self.zero_points[:, written]
+        )
+        error = (dequantized - value).abs()
+        self.assertTrue(torch.all(error <= scales / 2 + 1e-6))
+
+    def test_out_of_range_start_pos_fails(self):
+        value = torch.randn((1, 2, self.num_heads, self.head_dim))
+        cache = torch.zeros(
+            (1, self.max_seq_len, self.num_heads, self.head_dim), dtype=torch.int8
+        )
+
+        @run_in_subprocess
+        def run_and_catch(value, cache, scales, zero_points, start_pos):
+            torch.ops.llama.update_quantized_cache(
+                value, cache, scales, zero_points, start_pos
+            )
+
+        exception_raised = False
+        try:
+            run_and_catch(
+                value, cache, self.scales, self.zero_points, self.max_seq_len - 1
+            )
+        except Exception:
+            exception_raised = True
+        self.assertTrue(exception_raised)
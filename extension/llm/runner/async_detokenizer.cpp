@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Decodes generated tokens and runs the token callback on a separate thread.
+
+#include <executorch/extension/llm/runner/async_detokenizer.h>
+
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+namespace {
+
+size_t round_up_to_power_of_two(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+// Length of the UTF-8 sequence that starts with `lead`, or 1 for bytes that
+// cannot start one.
+size_t utf8_sequence_length(unsigned char lead) {
+  if (lead >= 0xF0 && lead < 0xF8) {
+    return 4;
+  }
+  if (lead >= 0xE0 && lead < 0xF0) {
+    return 3;
+  }
+  if (lead >= 0xC0 && lead < 0xE0) {
+    return 2;
+  }
+  return 1;
+}
+
+} // namespace
+
+AsyncDetokenizer::AsyncDetokenizer(
+    const ::tokenizers::Tokenizer* tokenizer,
+    std::function<void(const std::string&)> callback,
+    size_t capacity)
+    : tokenizer_(tokenizer),
+      callback_(std::move(callback)),
+      ring_(round_up_to_power_of_two(capacity > 0 ? capacity : 1)),
+      mask_(ring_.size() - 1) {
+  worker_ = std::thread(&AsyncDetokenizer::run, this);
+}
+
+AsyncDetokenizer::~AsyncDetokenizer() {
+  finish();
+}
+
+void AsyncDetokenizer::push(uint64_t prev, uint64_t cur) {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail - head_.load(std::memory_order_acquire) > mask_) {
+    std::this_thread::yield();
+  }
+  ring_[tail & mask_] = {prev, cur};
+  // Sequentially consistent, like the worker's store to sleeping_ and load
+  // of tail_: either the worker sees the new token before it waits, or this
+  // sees that it is waiting.
+  tail_.store(tail + 1, std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_seq_cst)) {
+    // Taking the lock orders the store before the worker's check for new
+    // tokens, so the notification cannot arrive before the worker waits.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    wake_.notify_one();
+  }
+}
+
+::executorch::runtime::Error AsyncDetokenizer::finish() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_.store(true, std::memory_order_release);
+    }
+    wake_.notify_one();
+    worker_.join();
+  }
+  return error_ == ::tokenizers::Error::Ok
+      ? ::executorch::runtime::Error::Ok
+      : ::executorch::runtime::Error::InvalidArgument;
+}
+
+size_t AsyncDetokenizer::complete_utf8_prefix(const std::string& text) {
+  const size_t size = text.size();
+  // Look for the lead byte of the last sequence among the last 3 bytes; a
+  // longer run of continuation bytes is invalid and passed through.
+  for (size_t back = 1; back <= 3 && back <= size; ++back) {
+    const auto byte = static_cast<unsigned char>(text[size - back]);
+    if ((byte & 0xC0) != 0x80) {
+      return utf8_sequence_length(byte) > back ? size - back : size;
+    }
+  }
+  return size;
+}
+
+void AsyncDetokenizer::run() {
+  while (true) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_.store(true, std::memory_order_seq_cst);
+      wake_.wait(lock, [&] {
+        return head != tail_.load(std::memory_order_seq_cst) ||
+            done_.load(std::memory_order_acquire);
+      });
+      sleeping_.store(false, std::memory_order_relaxed);
+      // push() happens before done_ is set, so tail_ is final once done_ is
+      // seen.
+      if (head == tail_.load(std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    const auto [prev, cur] = ring_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+
+    auto piece = tokenizer_->decode(prev, cur);
+    if (!piece.ok()) {
+      ET_LOG(
+          Error,
+          "Tokenizers error code %d",
+          static_cast<uint32_t>(piece.error()));
+      if (error_ == ::tokenizers::Error::Ok) {
+        error_ = piece.error();
+      }
+      continue;
+    }
+    emit(*piece);
+  }
+  if (!pending_.empty() && callback_) {
+    callback_(pending_);
+    pending_.clear();
+  }
+}
+
+void AsyncDetokenizer::emit(const std::string& piece) {
+  if (!callback_) {
+    return;
+  }
+  pending_ += piece;
+  const size_t complete = complete_utf8_prefix(pending_);
+  if (complete == 0) {
+    return;
+  }
+  if (complete == pending_.size()) {
+    callback_(pending_);
+    pending_.clear();
+  } else {
+    callback_(pending_.substr(0, complete));
+    pending_.erase(0, complete);
+  }
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Decodes generated tokens and runs the token callback on a separate thread.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/platform/compiler.h>
+#include <pytorch/tokenizers/tokenizer.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Takes decoding and the token callback off the generation loop. The loop
+ * pushes (previous, current) token pairs into a single-producer,
+ * single-consumer lock-free ring buffer, and a worker thread decodes them
+ * and calls the callback.
+ *
+ * The worker also assembles UTF-8: when a token ends in the middle of a
+ * multi-byte character, its last bytes are held back and passed to the
+ * callback together with the next piece. Bytes that can never form a valid
+ * character are passed through as they are. The callback is therefore
+ * called at most once per token, only with non-empty text, and always from
+ * the worker thread.
+ *
+ * push() only waits when the ring buffer is full, and only takes a lock to
+ * wake the worker, which blocks while the ring buffer is empty.
+ */
+class ET_EXPERIMENTAL AsyncDetokenizer {
+ public:
+  /**
+   * @param tokenizer Tokenizer to decode with. Not owned; must outlive the
+   * detokenizer.
+   * @param callback Called with the decoded text.
+   * @param capacity Number of token pairs the ring buffer holds. Rounded up
+   * to a power of two.
+   */
+  AsyncDetokenizer(
+      const ::tokenizers::Tokenizer* tokenizer,
+      std::function<void(const std::string&)> callback,
+      size_t capacity = 256);
+
+  AsyncDetokenizer(const AsyncDetokenizer&) = delete;
+  AsyncDetokenizer& operator=(const AsyncDetokenizer&) = delete;
+
+  ~AsyncDetokenizer();
+
+  /**
+   * Queues the token `cur` to be decoded after `prev`. Must not be called
+   * after finish().
+   */
+  void push(uint64_t prev, uint64_t cur);
+
+  /**
+   * Waits until every queued token has been decoded and passed to the
+   * callback, flushes any held back bytes and stops the worker thread. Safe
+   * to call more than once.
+   *
+   * @return Error::InvalidArgument if any token failed to decode. Tokens
+   * that fail are skipped.
+   */
+  ::executorch::runtime::Error finish();
+
+  /**
+   * Returns how many bytes at the start of `text` form complete UTF-8
+   * characters, i.e. everything except an incomplete trailing multi-byte
+   * sequence.
+   */
+  static size_t complete_utf8_prefix(const std::string& text);
+
+ private:
+  void run();
+  void emit(const std::string& piece);
+
+  const ::tokenizers::Tokenizer* tokenizer_;
+  std::function<void(const std::string&)> callback_;
+
+  std::vector<std::pair<uint64_t, uint64_t>> ring_;
+  size_t mask_;
+  // Next slot the worker reads. Only the worker writes it.
+  alignas(64) std::atomic<size_t> head_{0};
+  // Next slot push() writes. Only the producer writes it.
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<bool> done_{false};
+  // Set by the worker, under mutex_, while it waits for tokens. push() only
+  // takes the lock and notifies when it is set, so that it stays lock-free
+  // while the worker keeps up.
+  std::atomic<bool> sleeping_{false};
+  // Wakes the worker when the ring buffer was empty. push() and finish()
+  // notify it; the ring buffer itself stays lock-free.
+  std::mutex mutex_;
+  std::condition_variable wake_;
+
+  // Owned by the worker until it is joined.
+  std::string pending_;
+  ::tokenizers::Error error_ = ::tokenizers::Error::Ok;
+
+  std::thread worker_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
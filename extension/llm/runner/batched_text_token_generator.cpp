@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for several sequences at once, with continuous batching.
+
+#include <executorch/extension/llm/runner/batched_text_token_generator.h>
+
+#include <executorch/extension/llm/runner/util.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+// Fed to slots without a sequence. Any valid token works.
+constexpr int64_t kPadToken = 0;
+} // namespace
+
+BatchedTextTokenGenerator::BatchedTextTokenGenerator(
+    ::tokenizers::Tokenizer* tokenizer,
+    TextDecoderRunner* text_decoder_runner,
+    int32_t batch_size,
+    int64_t max_seq_len,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    Stats* stats,
+    KVCacheBlockAllocator* block_allocator)
+    : tokenizer_(tokenizer),
+      text_decoder_runner_(text_decoder_runner),
+      batch_size_(batch_size),
+      max_seq_len_(max_seq_len),
+      eos_ids_(std::move(eos_ids)),
+      block_allocator_(block_allocator),
+      slots_(batch_size),
+      token_data_(batch_size, kPadToken),
+      pos_data_(batch_size, 0),
+      stats_(stats) {
+  ET_CHECK_MSG(batch_size > 0, "batch_size must be positive");
+  tokens_ = from_blob(
+      token_data_.data(),
+      {batch_size, 1},
+      ::executorch::aten::ScalarType::Long);
+  positions_ = from_blob(
+      pos_data_.data(), {batch_size}, ::executorch::aten::ScalarType::Long);
+}
+
+Result<int64_t> BatchedTextTokenGenerator::add_sequence(
+    std::vector<uint64_t> prompt_tokens,
+    int32_t max_new_tokens,
+    float temperature,
+    std::function<void(const std::string&)> token_callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt_tokens.empty(), InvalidArgument, "Prompt must not be empty");
+  ET_CHECK_OR_RETURN_ERROR(
+      static_cast<int64_t>(prompt_tokens.size()) < max_seq_len_,
+      InvalidArgument,
+      "Prompt of %zu tokens does not fit in max_seq_len %" PRId64,
+      prompt_tokens.size(),
+      max_seq_len_);
+  ET_CHECK_OR_RETURN_ERROR(
+      max_new_tokens > 0, InvalidArgument, "max_new_tokens must be positive");
+
+  Sequence sequence;
+  sequence.id = next_id_++;
+  sequence.prompt_tokens = std::move(prompt_tokens);
+  sequence.max_new_tokens = max_new_tokens;
+  sequence.temperature = temperature;
+  sequence.token_callback = std::move(token_callback);
+  pending_.push_back(std::move(sequence));
+  return pending_.back().id;
+}
+
+Result<int32_t> BatchedTextTokenGenerator::step() {
+  for (auto& slot : slots_) {
+    if (!slot.has_value() && !pending_.empty()) {
+      slot = std::move(pending_.front());
+      pending_.pop_front();
+    }
+  }
+
+  if (block_allocator_ != nullptr) {
+    for (int32_t i = 0; i < batch_size_; ++i) {
+      if (!slots_[i].has_value()) {
+        continue;
+      }
+      const Error error = block_allocator_->reserve(i, slots_[i]->pos + 1);
+      if (error != Error::Ok) {
+        ET_LOG(
+            Error,
+            "Ending sequence %" PRId64 " at position %" PRId64
+            ": no KV cache block (error 0x%" PRIx32 ")",
+            slots_[i]->id,
+            slots_[i]->pos,
+            static_cast<uint32_t>(error));
+        finish(i);
+      }
+    }
+  }
+
+  bool any_active = false;
+  for (int32_t i = 0; i < batch_size_; ++i) {
+    const auto& slot = slots_[i];
+    if (!slot.has_value()) {
+      token_data_[i] = kPadToken;
+      pos_data_[i] = 0;
+      continue;
+    }
+    any_active = true;
+    const bool in_prompt =
+        slot->num_prompt_tokens_fed < slot->prompt_tokens.size();
+    token_data_[i] = static_cast<int64_t>(
+        in_prompt ? slot->prompt_tokens[slot->num_prompt_tokens_fed]
+                  : slot->cur_token);
+    pos_data_[i] = slot->pos;
+  }
+  if (!any_active) {
+    return 0;
+  }
+
+  auto logits_res = text_decoder_runner_->step_batch(
+      tokens_,
+      positions_,
+      block_allocator_ != nullptr ? &block_allocator_->block_table() : nullptr);
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  executorch::aten::Tensor& logits_tensor = logits_res.get();
+
+  int32_t num_generated = 0;
+  for (int32_t i = 0; i < batch_size_; ++i) {
+    auto& slot = slots_[i];
+    if (!slot.has_value()) {
+      continue;
+    }
+    const uint64_t prev_token = static_cast<uint64_t>(token_data_[i]);
+    slot->pos++;
+    if (slot->num_prompt_tokens_fed < slot->prompt_tokens.size()) {
+      slot->num_prompt_tokens_fed++;
+      if (slot->num_prompt_tokens_fed < slot->prompt_tokens.size()) {
+        // Still feeding the prompt; the logits are not needed.
+        continue;
+      }
+    }
+
+    stats_->on_sampling_begin();
+    slot->cur_token = text_decoder_runner_->logits_to_token(
+        logits_tensor, slot->temperature, i);
+    stats_->on_sampling_end();
+    slot->num_generated_tokens++;
+    num_generated++;
+
+    if (slot->token_callback) {
+      slot->token_callback(
+          ET_UNWRAP_TOKENIZER(tokenizer_->decode(prev_token, slot->cur_token)));
+    }
+
+    if (eos_ids_->find(slot->cur_token) != eos_ids_->end() ||
+        slot->num_generated_tokens >= slot->max_new_tokens ||
+        slot->pos >= max_seq_len_) {
+      ET_LOG(
+          Info,
+          "Sequence %" PRId64 " finished after %" PRId32 " tokens",
+          slot->id,
+          slot->num_generated_tokens);
+      finish(i);
+    }
+  }
+  stats_->num_generated_tokens += num_generated;
+  return num_generated;
+}
+
+Result<int64_t> BatchedTextTokenGenerator::run() {
+  should_stop_ = false;
+  int64_t num_generated = 0;
+  while (!should_stop_ && (num_active() > 0 || !pending_.empty())) {
+    num_generated += ET_UNWRAP(step());
+  }
+  return num_generated;
+}
+
+bool BatchedTextTokenGenerator::cancel(int64_t id) {
+  for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+    if (it->id == id) {
+      pending_.erase(it);
+      return true;
+    }
+  }
+  for (int32_t i = 0; i < batch_size_; ++i) {
+    if (slots_[i].has_value() && slots_[i]->id == id) {
+      finish(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void BatchedTextTokenGenerator::finish(int32_t slot) {
+  slots_[slot].reset();
+  if (block_allocator_ != nullptr) {
+    block_allocator_->release(slot);
+  }
+}
+
+size_t BatchedTextTokenGenerator::num_active() const {
+  size_t count = 0;
+  for (const auto& slot : slots_) {
+    count += slot.has_value() ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for several sequences at once, with continuous batching.
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <executorch/extension/llm/runner/kv_cache_block_allocator.h>
+#include <executorch/extension/llm/runner/stats.h>
+#include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <pytorch/tokenizers/tokenizer.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Decodes up to `batch_size` independent sequences per
+ * TextDecoderRunner::step_batch() call. Each batch row is a slot that holds
+ * one sequence at its own position in its own row of the KV cache. When a
+ * sequence finishes, its slot is given to the next queued sequence on the
+ * following step, so the batch stays full while there is work queued.
+ *
+ * Prompts are fed one token per step, in the same batch as the tokens being
+ * generated for other slots, so a new sequence never stalls the others.
+ * Sampling starts once the last prompt token has been fed. Slots without a
+ * sequence feed a padding token at position 0; their output is ignored and
+ * the next sequence in that slot overwrites the cache from position 0.
+ *
+ * Requires a Module exported with a batch dimension of `batch_size` and one
+ * input position per row; see TextDecoderRunner::step_batch().
+ *
+ * With a paged KV cache, each row grows its blocks one position ahead of the
+ * token it feeds and gives them back when its sequence ends. A sequence that
+ * cannot get a block because the pool is exhausted is ended early.
+ */
+class ET_EXPERIMENTAL BatchedTextTokenGenerator {
+ public:
+  /**
+   * @param tokenizer Used to decode generated tokens for the callbacks.
+   * @param text_decoder_runner Runs the batched model.
+   * @param batch_size Number of sequences decoded per step. Must match the
+   * batch dimension the model was exported with.
+   * @param max_seq_len Size of the KV cache of each row. A sequence stops when
+   * it fills its row.
+   * @param eos_ids Tokens that end a sequence.
+   * @param stats Collects sampling time and the number of generated tokens.
+   * @param block_allocator For a Module exported with a paged KV cache, the
+   * allocator for its block table, with `batch_size` rows. Null otherwise.
+   */
+  BatchedTextTokenGenerator(
+      ::tokenizers::Tokenizer* tokenizer,
+      TextDecoderRunner* text_decoder_runner,
+      int32_t batch_size,
+      int64_t max_seq_len,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      Stats* stats,
+      KVCacheBlockAllocator* block_allocator = nullptr);
+
+  virtual ~BatchedTextTokenGenerator() = default;
+
+  /**
+   * Queues a sequence. It starts on the next step() that finds a free slot.
+   * @param prompt_tokens The prompt, including BOS if the model needs one.
+   * Must not be empty, and must be shorter than max_seq_len.
+   * @param max_new_tokens Maximum number of tokens to generate.
+   * @param temperature Sampling temperature for this sequence.
+   * @param token_callback Called with each generated token, as text.
+   * @return An id for cancel(), or InvalidArgument.
+   */
+  ::executorch::runtime::Result<int64_t> add_sequence(
+      std::vector<uint64_t> prompt_tokens,
+      int32_t max_new_tokens,
+      float temperature = 0.0f,
+      std::function<void(const std::string&)> token_callback = {});
+
+  /**
+   * Fills free slots from the queue and runs one batched decode step.
+   * @return The number of tokens generated by this step, which may be 0 while
+   * all active sequences are still feeding their prompts.
+   */
+  ::executorch::runtime::Result<int32_t> step();
+
+  /**
+   * Calls step() until no sequence is active or queued, or until stop().
+   * @return The total number of tokens generated.
+   */
+  ::executorch::runtime::Result<int64_t> run();
+
+  /**
+   * Makes run() return after the current step. Active and queued sequences
+   * are kept, so run() can be called again to resume.
+   */
+  inline void stop() {
+    should_stop_ = true;
+  }
+
+  /**
+   * Drops a queued or active sequence.
+   * @return False if there is no such sequence, e.g. because it finished.
+   */
+  bool cancel(int64_t id);
+
+  /// Number of sequences that occupy a slot.
+  size_t num_active() const;
+
+  /// Number of sequences waiting for a slot.
+  size_t num_pending() const {
+    return pending_.size();
+  }
+
+  ::executorch::runtime::Error load() {
+    return text_decoder_runner_->load();
+  }
+
+  bool inline is_loaded() const {
+    return tokenizer_->is_loaded() && text_decoder_runner_->is_method_loaded();
+  }
+
+ private:
+  struct Sequence {
+    int64_t id;
+    std::vector<uint64_t> prompt_tokens;
+    int32_t max_new_tokens;
+    float temperature;
+    std::function<void(const std::string&)> token_callback;
+    /// Number of prompt tokens fed so far.
+    size_t num_prompt_tokens_fed = 0;
+    /// Position of the next token to feed.
+    int64_t pos = 0;
+    /// The last sampled token, fed on the next step once the prompt is done.
+    uint64_t cur_token = 0;
+    int32_t num_generated_tokens = 0;
+  };
+
+  /// Ends the sequence in slot `slot`, if any, and frees its blocks.
+  void finish(int32_t slot);
+
+  /**
+   * Note: BatchedTextTokenGenerator does not own the tokenizer_,
+   * text_decoder_runner_ and block_allocator_. Their lifecycle should be
+   * managed externally, likely in the Runner.
+   */
+  ::tokenizers::Tokenizer* tokenizer_;
+  TextDecoderRunner* text_decoder_runner_;
+  const int32_t batch_size_;
+  const int64_t max_seq_len_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  KVCacheBlockAllocator* block_allocator_;
+
+  std::deque<Sequence> pending_;
+  std::vector<std::optional<Sequence>> slots_;
+  int64_t next_id_ = 0;
+
+  // Input buffers, reused across steps.
+  std::vector<int64_t> token_data_;
+  std::vector<int64_t> pos_data_;
+  TensorPtr tokens_;
+  TensorPtr positions_;
+
+  // state machine
+  bool should_stop_ = false;
+
+  // stats
+  Stats* stats_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
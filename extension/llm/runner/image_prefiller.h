@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <future>
+
 #include <executorch/extension/llm/runner/image.h>
 #include <executorch/extension/module/module.h>
 #include <executorch/runtime/platform/compiler.h>
@@ -35,6 +37,43 @@ class ET_EXPERIMENTAL ImagePrefiller {
       Image& image,
       int64_t& start_pos) = 0;
 
+  /**
+   * Start encoding an image on a Module worker thread, without touching the
+   * KV cache, so that the caller can prefill text meanwhile. Pass the
+   * outputs to prefill_encoded() once the text before the image is in the
+   * KV cache.
+   * @param image The image input to the multimodal LLM. Must stay valid
+   * until the returned future is ready.
+   * @return A future with the image encoder outputs, or with
+   * Error::NotSupported if this prefiller cannot encode separately.
+   */
+  virtual std::future<::executorch::runtime::Result<
+      ::executorch::extension::Module::AsyncOutputs>>
+  encode_async(Image& image) {
+    (void)image;
+    std::promise<::executorch::runtime::Result<
+        ::executorch::extension::Module::AsyncOutputs>>
+        promise;
+    promise.set_value(::executorch::runtime::Error::NotSupported);
+    return promise.get_future();
+  }
+
+  /**
+   * Prefill an LLM Module with an image encoded by encode_async().
+   * @param encoded The image encoder outputs.
+   * @param start_pos The starting position in KV cache of the input in the LLM.
+   * It's passed as reference and will be updated inside this function.
+   * @return The next token of the LLM Module after prefill.
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor>
+  prefill_encoded(
+      const ::executorch::extension::Module::AsyncOutputs& encoded,
+      int64_t& start_pos) {
+    (void)encoded;
+    (void)start_pos;
+    return ::executorch::runtime::Error::NotSupported;
+  }
+
   virtual ::executorch::runtime::Error load() = 0;
   virtual bool is_method_loaded() = 0;
 
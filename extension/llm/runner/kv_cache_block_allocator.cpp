@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Hands out blocks of a paged KV cache to the rows of a batch.
+
+#include <executorch/extension/llm/runner/kv_cache_block_allocator.h>
+
+#include <cinttypes>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+
+namespace {
+// Backs the table entries of rows that do not own a block there.
+constexpr int64_t kScratchBlock = 0;
+} // namespace
+
+KVCacheBlockAllocator::KVCacheBlockAllocator(
+    int64_t num_blocks,
+    int64_t block_size,
+    int32_t batch_size,
+    int64_t max_blocks_per_seq)
+    : block_size_(block_size),
+      max_blocks_per_seq_(max_blocks_per_seq),
+      num_row_blocks_(batch_size, 0),
+      block_table_data_(batch_size * max_blocks_per_seq, kScratchBlock) {
+  ET_CHECK_MSG(
+      num_blocks > 1, "Need at least one block besides the scratch block");
+  // The paged attention kernels split blocks into tiles of at least 16
+  // positions.
+  ET_CHECK_MSG(
+      block_size > 0 &&
+          (block_size % 16 == 0 || (block_size & (block_size - 1)) == 0),
+      "block_size %" PRId64 " must be a power of two or a multiple of 16",
+      block_size);
+  ET_CHECK_MSG(
+      batch_size > 0 && max_blocks_per_seq > 0,
+      "The block table must not be empty");
+  // Hand out low block ids first.
+  free_blocks_.reserve(num_blocks - 1);
+  for (int64_t block = num_blocks - 1; block > kScratchBlock; --block) {
+    free_blocks_.push_back(block);
+  }
+  block_table_ = from_blob(
+      block_table_data_.data(),
+      {batch_size, static_cast<::executorch::aten::SizesType>(
+                       max_blocks_per_seq)},
+      ::executorch::aten::ScalarType::Long);
+}
+
+Error KVCacheBlockAllocator::reserve(int32_t row, int64_t num_tokens) {
+  ET_CHECK_OR_RETURN_ERROR(
+      row >= 0 && row < static_cast<int32_t>(num_row_blocks_.size()),
+      InvalidArgument,
+      "Row %" PRId32 " is out of range",
+      row);
+  const int64_t num_needed = (num_tokens + block_size_ - 1) / block_size_;
+  ET_CHECK_OR_RETURN_ERROR(
+      num_needed <= max_blocks_per_seq_,
+      InvalidArgument,
+      "%" PRId64 " tokens need more than %" PRId64 " blocks",
+      num_tokens,
+      max_blocks_per_seq_);
+  int64_t& num_row_blocks = num_row_blocks_[row];
+  if (num_needed - num_row_blocks > num_free_blocks()) {
+    return Error::OutOfResources;
+  }
+  int64_t* row_table = block_table_data_.data() + row * max_blocks_per_seq_;
+  for (; num_row_blocks < num_needed; ++num_row_blocks) {
+    row_table[num_row_blocks] = free_blocks_.back();
+    free_blocks_.pop_back();
+  }
+  return Error::Ok;
+}
+
+void KVCacheBlockAllocator::release(int32_t row) {
+  int64_t* row_table = block_table_data_.data() + row * max_blocks_per_seq_;
+  for (int64_t n = num_row_blocks_[row] - 1; n >= 0; --n) {
+    free_blocks_.push_back(row_table[n]);
+    row_table[n] = kScratchBlock;
+  }
+  num_row_blocks_[row] = 0;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
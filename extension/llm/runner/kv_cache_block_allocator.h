@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Hands out blocks of a paged KV cache to the rows of a batch.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Manages the block table of a model exported with a paged KV cache, i.e. one
+ * that keeps K/V in pools of `num_blocks` blocks of `block_size` positions
+ * and reads them through llama::custom_sdpa_paged and
+ * llama::update_cache_paged.
+ *
+ * Each batch row owns the blocks listed in its row of the block table. Blocks
+ * are taken from a free list as the row's sequence grows, and go back to it
+ * when the row is released, so cache memory follows the tokens actually in
+ * use rather than max_seq_len for every row.
+ *
+ * Block 0 is never handed out. Entries of the table that are not backed by a
+ * block point to it, so that idle rows, which the model still writes to, only
+ * ever touch that scratch block.
+ */
+class ET_EXPERIMENTAL KVCacheBlockAllocator {
+ public:
+  /**
+   * @param num_blocks Number of blocks in the model's K/V pools, including
+   * the scratch block.
+   * @param block_size Number of positions per block. Must be a power of two
+   * or a multiple of 16.
+   * @param batch_size Number of rows in the block table.
+   * @param max_blocks_per_seq Number of columns in the block table.
+   */
+  KVCacheBlockAllocator(
+      int64_t num_blocks,
+      int64_t block_size,
+      int32_t batch_size,
+      int64_t max_blocks_per_seq);
+
+  /**
+   * Makes sure that row `row` has blocks for positions [0, num_tokens).
+   * @return InvalidArgument if num_tokens exceeds what the table can map, or
+   * OutOfResources if the pool has run out of blocks. The row keeps the
+   * blocks it already had in both cases.
+   */
+  ::executorch::runtime::Error reserve(int32_t row, int64_t num_tokens);
+
+  /// Returns all blocks of row `row` to the free list.
+  void release(int32_t row);
+
+  /// The [batch_size, max_blocks_per_seq] Long block table, for the model.
+  TensorPtr& block_table() {
+    return block_table_;
+  }
+
+  /// Number of positions that row `row` has blocks for.
+  int64_t reserved_tokens(int32_t row) const {
+    return num_row_blocks_[row] * block_size_;
+  }
+
+  /// Number of blocks that can still be handed out.
+  int64_t num_free_blocks() const {
+    return static_cast<int64_t>(free_blocks_.size());
+  }
+
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+ private:
+  const int64_t block_size_;
+  const int64_t max_blocks_per_seq_;
+  std::vector<int64_t> free_blocks_;
+  std::vector<int64_t> num_row_blocks_;
+  std::vector<int64_t> block_table_data_;
+  TensorPtr block_table_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -109,6 +109,17 @@ class ET_EXPERIMENTAL MultimodalRunner {
     text_token_generator_->stop();
   }
 
+  /**
+   * Encode each image on a Module worker thread while the text before it,
+   * or the previous image, is prefilled, instead of encoding and prefilling
+   * strictly in turn. The KV cache is still filled in prompt order. Only
+   * takes effect with an image prefiller that implements encode_async().
+   * Off by default.
+   */
+  void set_pipelined_image_prefill(bool enabled) {
+    pipelined_image_prefill_ = enabled;
+  }
+
   virtual ~MultimodalRunner() = default;
 
  protected:
@@ -120,6 +131,7 @@ class ET_EXPERIMENTAL MultimodalRunner {
   int32_t n_eos_;
   int32_t max_seq_len_;
   float temperature_;
+  bool pipelined_image_prefill_ = false;
 
   // model
   std::unordered_set<std::string> model_methods_;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Encodes long prompts on several threads.
+
+#include <executorch/extension/llm/runner/parallel_encoder.h>
+
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+ParallelEncoder::ParallelEncoder(
+    const ::tokenizers::Tokenizer* tokenizer,
+    size_t min_chunk_size,
+    size_t max_threads)
+    : tokenizer_(tokenizer),
+      min_chunk_size_(std::max<size_t>(min_chunk_size, 1)),
+      max_chunks_(
+          max_threads > 0
+              ? max_threads
+              : std::max<size_t>(std::thread::hardware_concurrency(), 1)) {}
+
+std::vector<size_t> ParallelEncoder::chunk_starts(
+    const std::string& text) const {
+  std::vector<size_t> starts = {0};
+  if (max_chunks_ < 2 || text.size() < 2 * min_chunk_size_) {
+    return starts;
+  }
+  // Spread the text evenly over the threads, but no thinner than
+  // min_chunk_size.
+  const size_t target_size = std::max(
+      min_chunk_size_, (text.size() + max_chunks_ - 1) / max_chunks_);
+  size_t pos = target_size;
+  while (starts.size() < max_chunks_ && pos < text.size()) {
+    // The next line start at or after pos.
+    size_t newline = text.find('\n', pos - 1);
+    while (newline != std::string::npos && newline + 1 < text.size() &&
+           std::isspace(static_cast<unsigned char>(text[newline + 1]))) {
+      newline = text.find('\n', newline + 1);
+    }
+    if (newline == std::string::npos || newline + 1 >= text.size()) {
+      break;
+    }
+    const size_t start = newline + 1;
+    if (text.size() - start < min_chunk_size_) {
+      // Too little left for a chunk of its own.
+      break;
+    }
+    starts.push_back(start);
+    pos = start + target_size;
+  }
+  return starts;
+}
+
+::tokenizers::Result<std::vector<uint64_t>>
+ParallelEncoder::encode(const std::string& text, int8_t bos, int8_t eos) const {
+  const std::vector<size_t> starts = chunk_starts(text);
+  if (starts.size() == 1) {
+    return tokenizer_->encode(text, bos, eos);
+  }
+
+  const size_t num_chunks = starts.size();
+  std::vector<std::vector<uint64_t>> chunk_tokens(num_chunks);
+  std::vector<::tokenizers::Error> errors(num_chunks, ::tokenizers::Error::Ok);
+  auto encode_chunk = [&](size_t i) {
+    const size_t end = i + 1 < num_chunks ? starts[i + 1] : text.size();
+    auto result = tokenizer_->encode(
+        text.substr(starts[i], end - starts[i]),
+        i == 0 ? bos : 0,
+        i + 1 == num_chunks ? eos : 0);
+    if (result.ok()) {
+      chunk_tokens[i] = std::move(*result);
+    } else {
+      errors[i] = result.error();
+    }
+  };
+  // The calling thread encodes the first chunk.
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (size_t i = 1; i < num_chunks; ++i) {
+    threads.emplace_back(encode_chunk, i);
+  }
+  encode_chunk(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  size_t num_tokens = 0;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    if (errors[i] != ::tokenizers::Error::Ok) {
+      return errors[i];
+    }
+    num_tokens += chunk_tokens[i].size();
+  }
+  std::vector<uint64_t> tokens;
+  tokens.reserve(num_tokens);
+  for (const auto& chunk : chunk_tokens) {
+    tokens.insert(tokens.end(), chunk.begin(), chunk.end());
+  }
+  return tokens;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Encodes long prompts on several threads.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <executorch/runtime/platform/compiler.h>
+#include <pytorch/tokenizers/tokenizer.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Encodes a prompt by cutting it into chunks at line starts, right after a
+ * '\n' that is followed by a non-whitespace character, and encoding the
+ * chunks on separate threads. Prompts shorter than two chunks are encoded
+ * directly.
+ *
+ * The result equals encoding the whole prompt only if the tokenizer never
+ * merges text across such a line start. That holds for tokenizers whose
+ * pre-tokenizer ends a piece at a newline, like tiktoken and most
+ * byte-level BPE tokenizers. It does not hold for SentencePiece, which adds
+ * a dummy prefix to every input, so callers opt in per tokenizer.
+ *
+ * The tokenizer's encode() must be safe to call from several threads at
+ * once.
+ */
+class ET_EXPERIMENTAL ParallelEncoder {
+ public:
+  static constexpr size_t kDefaultMinChunkSize = 64 * 1024;
+
+  /**
+   * @param tokenizer Tokenizer to encode chunks with. Not owned; must
+   * outlive the encoder.
+   * @param min_chunk_size Chunks are at least this many bytes, except the
+   * last one.
+   * @param max_threads Maximum number of chunks, and of threads. 0 uses the
+   * number of hardware threads.
+   */
+  explicit ParallelEncoder(
+      const ::tokenizers::Tokenizer* tokenizer,
+      size_t min_chunk_size = kDefaultMinChunkSize,
+      size_t max_threads = 0);
+
+  /**
+   * Encodes `text`, with `bos` BOS tokens before the first chunk and `eos`
+   * EOS tokens after the last one.
+   */
+  ::tokenizers::Result<std::vector<uint64_t>>
+  encode(const std::string& text, int8_t bos = 0, int8_t eos = 0) const;
+
+  /**
+   * Returns the offsets where the chunks of `text` start, beginning with 0.
+   */
+  std::vector<size_t> chunk_starts(const std::string& text) const;
+
+ private:
+  const ::tokenizers::Tokenizer* tokenizer_;
+  size_t min_chunk_size_;
+  size_t max_chunks_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Reuses the KV cache of prompt prefixes across generate() calls.
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <limits>
+
+#include <executorch/runtime/core/content_hash.h>
+#include <executorch/runtime/core/exec_aten/util/tensor_util.h>
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+using ::executorch::runtime::internal::hash_bytes;
+using ::executorch::runtime::internal::hash_combine;
+
+namespace {
+// Parent hash and id of the first block of every prefix.
+constexpr uint64_t kRootHash = 0xcbf29ce484222325ULL;
+constexpr uint64_t kRootId = 0;
+// last_used of blocks that must not be evicted yet.
+constexpr uint64_t kInUse = std::numeric_limits<uint64_t>::max();
+} // namespace
+
+PrefixCache::PrefixCache(
+    std::vector<executorch::aten::Tensor> kv_caches,
+    int64_t seq_dim,
+    int64_t block_size,
+    size_t max_blocks)
+    : block_size_(block_size),
+      max_blocks_(max_blocks),
+      max_cached_tokens_(std::numeric_limits<int64_t>::max()) {
+  ET_CHECK_MSG(!kv_caches.empty(), "No KV cache tensors given");
+  ET_CHECK_MSG(block_size > 0, "block_size must be positive");
+  layouts_.reserve(kv_caches.size());
+  for (const auto& cache : kv_caches) {
+    ET_CHECK_MSG(
+        seq_dim >= 0 && seq_dim < cache.dim(),
+        "seq_dim %" PRId64 " is out of range for a %zd-D KV cache",
+        seq_dim,
+        cache.dim());
+    ET_CHECK_MSG(
+        ::executorch::runtime::tensor_is_contiguous(cache),
+        "KV cache must be contiguous");
+    CacheLayout layout;
+    layout.data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+    layout.outer = 1;
+    for (int64_t d = 0; d < seq_dim; ++d) {
+      layout.outer *= cache.size(d);
+    }
+    layout.position_nbytes = cache.element_size();
+    for (int64_t d = seq_dim + 1; d < cache.dim(); ++d) {
+      layout.position_nbytes *= cache.size(d);
+    }
+    const int64_t seq_len = cache.size(seq_dim);
+    layout.outer_stride_nbytes = seq_len * layout.position_nbytes;
+    layouts_.push_back(layout);
+
+    max_cached_tokens_ =
+        std::min(max_cached_tokens_, seq_len / block_size * block_size);
+    block_nbytes_ += layout.outer * block_size * layout.position_nbytes;
+  }
+}
+
+int64_t PrefixCache::restore(const std::vector<uint64_t>& tokens) {
+  const int64_t max_tokens = std::min(
+      static_cast<int64_t>(tokens.size()) - 1, max_cached_tokens_);
+  std::vector<Block*> chain;
+  uint64_t hash = kRootHash;
+  for (int64_t start = 0; start + block_size_ <= max_tokens;
+       start += block_size_) {
+    const uint64_t parent_id = chain.empty() ? kRootId : chain.back()->id;
+    const uint64_t* block_tokens = tokens.data() + start;
+    hash = hash_block(hash, block_tokens);
+    auto it = blocks_.find(hash);
+    if (it == blocks_.end() ||
+        !matches(it->second, parent_id, block_tokens)) {
+      break;
+    }
+    chain.push_back(&it->second);
+  }
+  for (size_t i = 0; i < chain.size(); ++i) {
+    copy_in(i, *chain[i]);
+  }
+  touch(chain);
+  return static_cast<int64_t>(chain.size()) * block_size_;
+}
+
+void PrefixCache::insert(
+    const std::vector<uint64_t>& tokens,
+    int64_t num_tokens) {
+  num_tokens = std::min(
+      {num_tokens, static_cast<int64_t>(tokens.size()), max_cached_tokens_});
+  std::vector<Block*> chain;
+  uint64_t hash = kRootHash;
+  for (int64_t start = 0; start + block_size_ <= num_tokens;
+       start += block_size_) {
+    const uint64_t parent_id = chain.empty() ? kRootId : chain.back()->id;
+    const uint64_t* block_tokens = tokens.data() + start;
+    hash = hash_block(hash, block_tokens);
+    auto it = blocks_.find(hash);
+    if (it != blocks_.end() && matches(it->second, parent_id, block_tokens)) {
+      chain.push_back(&it->second);
+    } else {
+      if (it != blocks_.end()) {
+        // Another prefix with the same hash, or a block whose parent was
+        // evicted, owns this key. Replace it, unless this prefix uses it.
+        if (it->second.last_used == kInUse) {
+          break;
+        }
+        blocks_.erase(it);
+      }
+      if (blocks_.size() >= max_blocks_ && !evict_one()) {
+        break;
+      }
+      Block& block = blocks_[hash];
+      block.id = next_block_id_++;
+      block.parent_id = parent_id;
+      block.tokens.assign(block_tokens, block_tokens + block_size_);
+      block.data.resize(block_nbytes_);
+      copy_out(start / block_size_, block);
+      chain.push_back(&block);
+    }
+    chain.back()->last_used = kInUse;
+  }
+  touch(chain);
+}
+
+void PrefixCache::record_prefill(int64_t num_tokens, long elapsed_ms) {
+  num_prefilled_tokens_ += num_tokens;
+  prefill_time_ms_ += elapsed_ms;
+}
+
+double PrefixCache::estimate_prefill_ms(int64_t num_tokens) const {
+  if (num_prefilled_tokens_ == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(prefill_time_ms_) * num_tokens /
+      num_prefilled_tokens_;
+}
+
+void PrefixCache::clear() {
+  blocks_.clear();
+}
+
+uint64_t PrefixCache::hash_block(uint64_t parent_hash, const uint64_t* tokens)
+    const {
+  return hash_combine(
+      parent_hash, hash_bytes(tokens, block_size_ * sizeof(uint64_t)));
+}
+
+bool PrefixCache::matches(
+    const Block& block,
+    uint64_t parent_id,
+    const uint64_t* tokens) const {
+  return block.parent_id == parent_id &&
+      std::equal(block.tokens.begin(), block.tokens.end(), tokens);
+}
+
+void PrefixCache::copy_out(int64_t block_index, Block& block) const {
+  uint8_t* dst = block.data.data();
+  for (const auto& layout : layouts_) {
+    const size_t nbytes = block_size_ * layout.position_nbytes;
+    const uint8_t* src = layout.data + block_index * nbytes;
+    for (size_t o = 0; o < layout.outer; ++o) {
+      std::memcpy(dst, src + o * layout.outer_stride_nbytes, nbytes);
+      dst += nbytes;
+    }
+  }
+}
+
+void PrefixCache::copy_in(int64_t block_index, const Block& block) const {
+  const uint8_t* src = block.data.data();
+  for (const auto& layout : layouts_) {
+    const size_t nbytes = block_size_ * layout.position_nbytes;
+    uint8_t* dst = layout.data + block_index * nbytes;
+    for (size_t o = 0; o < layout.outer; ++o) {
+      std::memcpy(dst + o * layout.outer_stride_nbytes, src, nbytes);
+      src += nbytes;
+    }
+  }
+}
+
+void PrefixCache::touch(const std::vector<Block*>& chain) {
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    (*it)->last_used = ++clock_;
+  }
+}
+
+bool PrefixCache::evict_one() {
+  auto victim = blocks_.end();
+  for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+    if (it->second.last_used != kInUse &&
+        (victim == blocks_.end() ||
+         it->second.last_used < victim->second.last_used)) {
+      victim = it;
+    }
+  }
+  if (victim == blocks_.end()) {
+    return false;
+  }
+  blocks_.erase(victim);
+  return true;
+}
+
+Result<std::unique_ptr<PrefixCache>> create_prefix_cache(
+    Module* module,
+    const std::vector<std::string>& cache_names,
+    int64_t seq_dim,
+    int64_t block_size,
+    size_t max_blocks,
+    const std::string& method_name) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !cache_names.empty(), InvalidArgument, "No KV cache names given");
+  ET_CHECK_OR_RETURN_ERROR(
+      block_size > 0, InvalidArgument, "block_size must be positive");
+  ET_CHECK_OK_OR_RETURN_ERROR(module->load_method(method_name));
+  auto* method = ET_UNWRAP(module->method(method_name));
+  std::vector<executorch::aten::Tensor> kv_caches;
+  kv_caches.reserve(cache_names.size());
+  for (const auto& name : cache_names) {
+    auto cache = method->get_attribute(name);
+    if (!cache.ok()) {
+      ET_LOG(
+          Error,
+          "KV cache %s not found in %s",
+          name.c_str(),
+          method_name.c_str());
+      return cache.error();
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        seq_dim >= 0 && seq_dim < cache->dim(),
+        InvalidArgument,
+        "seq_dim %" PRId64 " is out of range for KV cache %s",
+        seq_dim,
+        name.c_str());
+    ET_CHECK_OR_RETURN_ERROR(
+        ::executorch::runtime::tensor_is_contiguous(cache.get()),
+        InvalidArgument,
+        "KV cache %s must be contiguous",
+        name.c_str());
+    kv_caches.push_back(cache.get());
+  }
+  return std::make_unique<PrefixCache>(
+      std::move(kv_caches), seq_dim, block_size, max_blocks);
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Reuses the KV cache of prompt prefixes across generate() calls.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Keeps snapshots of a model's KV cache for token prefixes it has already
+ * prefilled, so that a prompt starting with one of those prefixes only needs
+ * the rest of its tokens prefilled.
+ *
+ * Snapshots are taken in blocks of `block_size` positions. A block is keyed by
+ * a hash of all token ids from position 0 to the end of the block, so prompts
+ * that share a prefix share the blocks for it, and each block is stored once
+ * however many prompts use it. Each block keeps its own token ids and the id
+ * of the block it follows, and both are compared on lookup. Since a block
+ * only matches after the block before it did, a hash collision is a miss,
+ * never a wrong restore.
+ *
+ * Restoring copies the blocks back into positions [0, n) of the live cache.
+ * This assumes the cache maps position p to index p along `seq_dim`, i.e. it
+ * is not a ring buffer, and that the prefix starts at position 0.
+ *
+ * Beyond `max_blocks` blocks, the least recently used ones are evicted.
+ * Blocks that end a prefix go before the blocks that prefix depends on.
+ */
+class ET_EXPERIMENTAL PrefixCache {
+ public:
+  /**
+   * @param kv_caches The model's K and V cache tensors. Their data is read
+   * and written in place, so they must outlive the PrefixCache. Must be
+   * contiguous.
+   * @param seq_dim The dimension of the cache tensors that indexes positions.
+   * @param block_size Number of positions per block.
+   * @param max_blocks Maximum number of blocks to keep.
+   */
+  PrefixCache(
+      std::vector<executorch::aten::Tensor> kv_caches,
+      int64_t seq_dim,
+      int64_t block_size,
+      size_t max_blocks);
+
+  /**
+   * Copies the longest cached prefix of `tokens` into the KV cache. At least
+   * one token is always left uncached, since prefill needs to run on some
+   * token to produce logits.
+   * @return The number of tokens restored, a multiple of block_size.
+   */
+  int64_t restore(const std::vector<uint64_t>& tokens);
+
+  /**
+   * Takes snapshots of the blocks of `tokens[0, num_tokens)` that are not
+   * cached yet. The KV cache must hold those tokens at positions
+   * [0, num_tokens). A partial last block is not stored.
+   */
+  void insert(const std::vector<uint64_t>& tokens, int64_t num_tokens);
+
+  /**
+   * Records how long prefilling `num_tokens` tokens took, for
+   * estimate_prefill_ms().
+   */
+  void record_prefill(int64_t num_tokens, long elapsed_ms);
+
+  /// Estimated time to prefill `num_tokens` tokens, from record_prefill().
+  double estimate_prefill_ms(int64_t num_tokens) const;
+
+  /// Drops all blocks.
+  void clear();
+
+  /// Number of blocks currently stored.
+  size_t num_blocks() const {
+    return blocks_.size();
+  }
+
+  /// Bytes of snapshot data per block.
+  size_t block_nbytes() const {
+    return block_nbytes_;
+  }
+
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+ private:
+  struct CacheLayout {
+    uint8_t* data;
+    // Product of the sizes before seq_dim.
+    size_t outer;
+    // Bytes from one position to the next.
+    size_t position_nbytes;
+    // Bytes from one outer index to the next.
+    size_t outer_stride_nbytes;
+  };
+
+  struct Block {
+    // Unique among all blocks ever stored, so that a block that is evicted
+    // and stored again does not match the children of the old one.
+    uint64_t id;
+    uint64_t parent_id;
+    std::vector<uint64_t> tokens;
+    std::vector<uint8_t> data;
+    uint64_t last_used;
+  };
+
+  uint64_t hash_block(uint64_t parent_hash, const uint64_t* tokens) const;
+  bool matches(const Block& block, uint64_t parent_id, const uint64_t* tokens)
+      const;
+  void copy_out(int64_t block_index, Block& block) const;
+  void copy_in(int64_t block_index, const Block& block) const;
+  // Marks `chain` as used, deepest block first, so that a prefix's last
+  // block is evicted before the blocks it depends on.
+  void touch(const std::vector<Block*>& chain);
+  // Evicts the least recently used block that is not in use. Returns false
+  // if there is none.
+  bool evict_one();
+
+  std::vector<CacheLayout> layouts_;
+  const int64_t block_size_;
+  const size_t max_blocks_;
+  // Longest prefix the cache tensors can hold, in whole blocks.
+  int64_t max_cached_tokens_;
+  size_t block_nbytes_ = 0;
+  std::unordered_map<uint64_t, Block> blocks_;
+  uint64_t clock_ = 0;
+  uint64_t next_block_id_ = 1;
+
+  int64_t num_prefilled_tokens_ = 0;
+  long prefill_time_ms_ = 0;
+};
+
+/**
+ * Creates a PrefixCache over the KV cache buffers of a method.
+ * @param module The module, which must outlive the returned cache.
+ * @param cache_names Fully qualified names of the K and V cache buffers, as
+ * found by Method::get_attribute().
+ * @param seq_dim The dimension of the cache buffers that indexes positions.
+ * @param block_size Number of positions per block.
+ * @param max_blocks Maximum number of blocks to keep.
+ * @param method_name The method that owns the cache buffers.
+ */
+ET_EXPERIMENTAL ::executorch::runtime::Result<std::unique_ptr<PrefixCache>>
+create_prefix_cache(
+    Module* module,
+    const std::vector<std::string>& cache_names,
+    int64_t seq_dim,
+    int64_t block_size,
+    size_t max_blocks,
+    const std::string& method_name = "forward");
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
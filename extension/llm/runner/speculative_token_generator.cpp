@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens in a loop, with a draft model proposing tokens for the
+// target model to verify.
+
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
+#include <executorch/extension/llm/runner/util.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+// Copies row `row` of [1, seq_len, vocab_size] logits, or the only row of
+// [1, vocab_size] logits, to `out` as float.
+void logits_row(
+    const executorch::aten::Tensor& logits,
+    int64_t row,
+    std::vector<float>& out) {
+  const int64_t vocab_size = logits.size(logits.dim() - 1);
+  const int64_t num_rows = logits.dim() == 3 ? logits.size(1) : 1;
+  ET_CHECK_MSG(
+      row < num_rows, "Row %" PRId64 " of %" PRId64 " rows", row, num_rows);
+  out.resize(vocab_size);
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      logits.scalar_type(),
+      unused,
+      "logits_row",
+      CTYPE,
+      [&]() {
+        const CTYPE* data = logits.const_data_ptr<CTYPE>() + row * vocab_size;
+        for (int64_t i = 0; i < vocab_size; ++i) {
+          out[i] = static_cast<float>(data[i]);
+        }
+      });
+}
+
+// The row of the last input token.
+int64_t last_row(const executorch::aten::Tensor& logits) {
+  return logits.dim() == 3 ? logits.size(1) - 1 : 0;
+}
+
+uint64_t argmax(const std::vector<float>& values) {
+  return std::max_element(values.begin(), values.end()) - values.begin();
+}
+
+// Turns logits into probabilities at the given temperature, in place.
+void softmax(std::vector<float>& values, float temperature) {
+  const float max_value = *std::max_element(values.begin(), values.end());
+  float sum = 0.0f;
+  for (auto& value : values) {
+    value = std::exp((value - max_value) / temperature);
+    sum += value;
+  }
+  for (auto& value : values) {
+    value /= sum;
+  }
+}
+
+} // namespace
+
+SpeculativeTokenGenerator::SpeculativeTokenGenerator(
+    ::tokenizers::Tokenizer* tokenizer,
+    TextDecoderRunner* text_decoder_runner,
+    std::unique_ptr<Module> draft_module,
+    std::unique_ptr<TextDecoderRunner> draft_decoder_runner,
+    std::unique_ptr<TextPrefiller> draft_prefiller,
+    int32_t num_draft_tokens,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    Stats* stats,
+    unsigned long long rng_seed)
+    : TextTokenGenerator(
+          tokenizer,
+          text_decoder_runner,
+          /*use_kv_cache=*/true,
+          std::move(eos_ids),
+          stats),
+      draft_module_(std::move(draft_module)),
+      draft_decoder_runner_(std::move(draft_decoder_runner)),
+      draft_prefiller_(std::move(draft_prefiller)),
+      num_draft_tokens_(num_draft_tokens),
+      rng_(rng_seed) {
+  ET_CHECK_MSG(num_draft_tokens > 0, "num_draft_tokens must be positive");
+}
+
+Result<int64_t> SpeculativeTokenGenerator::generate(
+    std::vector<uint64_t> tokens,
+    int64_t start_pos,
+    int32_t max_new_tokens,
+    float temperature,
+    const std::function<void(const std::string&)>& token_callback) {
+  ET_CHECK_MSG(
+      !tokens.empty(), "Token generation loop shouldn't take empty tokens");
+
+  // Bring the draft model up to the target model: everything but the last
+  // token, which is the first token fed below.
+  if (tokens.size() > 1) {
+    std::vector<uint64_t> context(tokens.begin(), tokens.end() - 1);
+    int64_t draft_pos = start_pos - static_cast<int64_t>(context.size());
+    ET_CHECK_OR_RETURN_ERROR(
+        draft_pos >= 0,
+        InvalidArgument,
+        "%zu context tokens do not fit before start_pos %" PRId64,
+        context.size(),
+        start_pos);
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        draft_prefiller_->prefill(context, draft_pos).error());
+  }
+
+  should_stop_ = false;
+  stats_->num_draft_tokens = 0;
+  stats_->num_accepted_draft_tokens = 0;
+  int64_t pos = start_pos; // position of cur_token
+  uint64_t cur_token = tokens.back();
+  int32_t num_generated = 0;
+  // Set when the last round accepted all its proposals. The draft model was
+  // not fed the last of them, lagging_token, which sits at pos - 1.
+  bool draft_lags = false;
+  uint64_t lagging_token = 0;
+  uint64_t draft_token = 0;
+  auto draft_input =
+      from_blob(&draft_token, {1, 1}, executorch::aten::ScalarType::Long);
+
+  // cur_token followed by this round's proposals.
+  std::vector<uint64_t> round_tokens;
+  // The draft distribution of each proposal, when sampling.
+  std::vector<std::vector<float>> draft_probs(num_draft_tokens_);
+  std::vector<float> row;
+
+  std::unique_ptr<AsyncDetokenizer> detokenizer;
+  if (async_detokenization_) {
+    detokenizer =
+        std::make_unique<AsyncDetokenizer>(tokenizer_, token_callback);
+  }
+
+  while (num_generated < max_new_tokens && !should_stop_) {
+    // Leave room for the token the target model adds.
+    const int32_t num_proposals =
+        std::min(num_draft_tokens_, max_new_tokens - num_generated - 1);
+    round_tokens.assign(1, cur_token);
+
+    if (num_proposals > 0 && draft_lags) {
+      draft_token = lagging_token;
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          draft_decoder_runner_->step(draft_input, pos - 1).error());
+    }
+    for (int32_t i = 0; i < num_proposals; ++i) {
+      draft_token = round_tokens.back();
+      auto draft_logits =
+          ET_UNWRAP(draft_decoder_runner_->step(draft_input, pos + i));
+      stats_->on_sampling_begin();
+      if (temperature > 0.0f) {
+        auto& probs = draft_probs[i];
+        logits_row(draft_logits, last_row(draft_logits), probs);
+        softmax(probs, temperature);
+        round_tokens.push_back(sample(probs));
+      } else {
+        logits_row(draft_logits, last_row(draft_logits), row);
+        round_tokens.push_back(argmax(row));
+      }
+      stats_->on_sampling_end();
+    }
+
+    auto verify_input = from_blob(
+        round_tokens.data(),
+        {1, static_cast<executorch::aten::SizesType>(round_tokens.size())},
+        executorch::aten::ScalarType::Long);
+    auto logits = ET_UNWRAP(text_decoder_runner_->step(verify_input, pos));
+    ET_CHECK_OR_RETURN_ERROR(
+        num_proposals == 0 ||
+            (logits.dim() == 3 && logits.size(1) == num_proposals + 1),
+        InvalidProgram,
+        "Verifying %" PRId32
+        " proposals needs the target model's logits for every input token",
+        num_proposals);
+
+    stats_->on_sampling_begin();
+    int32_t num_accepted = 0;
+    bool rejected = false;
+    uint64_t next_token = 0;
+    for (; num_accepted < num_proposals; ++num_accepted) {
+      const uint64_t proposal = round_tokens[num_accepted + 1];
+      logits_row(logits, num_accepted, row);
+      if (temperature > 0.0f) {
+        softmax(row, temperature);
+        // Accept with probability min(1, p(proposal) / q(proposal)).
+        const auto& probs = draft_probs[num_accepted];
+        std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+        if (coin(rng_) * probs[proposal] < row[proposal]) {
+          continue;
+        }
+        // Resample from the part of the target distribution the draft
+        // distribution does not cover. If rounding leaves none, the two
+        // distributions are the same, so sample from the target's.
+        float sum = 0.0f;
+        for (size_t t = 0; t < row.size(); ++t) {
+          sum += std::max(row[t] - probs[t], 0.0f);
+        }
+        if (sum > 0.0f) {
+          for (size_t t = 0; t < row.size(); ++t) {
+            row[t] = std::max(row[t] - probs[t], 0.0f) / sum;
+          }
+        }
+        next_token = sample(row);
+      } else {
+        next_token = argmax(row);
+        if (next_token == proposal) {
+          continue;
+        }
+      }
+      rejected = true;
+      break;
+    }
+    if (!rejected) {
+      logits_row(logits, num_proposals, row);
+      if (temperature > 0.0f) {
+        softmax(row, temperature);
+        next_token = sample(row);
+      } else {
+        next_token = argmax(row);
+      }
+    }
+    stats_->on_sampling_end();
+    stats_->num_draft_tokens += num_proposals;
+    stats_->num_accepted_draft_tokens += num_accepted;
+    draft_lags = !rejected && num_proposals > 0;
+    lagging_token = round_tokens.back();
+
+    // Emit the accepted proposals, then the target model's token.
+    round_tokens.resize(num_accepted + 1);
+    round_tokens.push_back(next_token);
+    bool reached_eos = false;
+    for (size_t i = 1; i < round_tokens.size(); ++i) {
+      const uint64_t prev_token = round_tokens[i - 1];
+      const uint64_t token = round_tokens[i];
+      num_generated++;
+      pos++;
+      if (detokenizer) {
+        detokenizer->push(prev_token, token);
+      } else {
+        token_callback(
+            ET_UNWRAP_TOKENIZER(tokenizer_->decode(prev_token, token)));
+      }
+      if (eos_ids_->find(token) != eos_ids_->end()) {
+        printf("\n");
+        ET_LOG(Info, "\nReached to the end of generation");
+        reached_eos = true;
+        break;
+      }
+    }
+    if (reached_eos) {
+      break;
+    }
+    cur_token = next_token;
+  }
+  if (detokenizer) {
+    ET_CHECK_OK_OR_RETURN_ERROR(detokenizer->finish());
+  }
+  return num_generated;
+}
+
+Error SpeculativeTokenGenerator::load() {
+  ET_CHECK_OK_OR_RETURN_ERROR(TextTokenGenerator::load());
+  return draft_decoder_runner_->load();
+}
+
+bool SpeculativeTokenGenerator::is_loaded() const {
+  return TextTokenGenerator::is_loaded() &&
+      draft_decoder_runner_->is_method_loaded();
+}
+
+uint64_t SpeculativeTokenGenerator::sample(const std::vector<float>& probs) {
+  std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+  const float target = coin(rng_);
+  float cdf = 0.0f;
+  for (size_t i = 0; i < probs.size(); ++i) {
+    cdf += probs[i];
+    if (target < cdf) {
+      return i;
+    }
+  }
+  return probs.size() - 1; // in case of rounding errors
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
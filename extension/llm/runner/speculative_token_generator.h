@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens in a loop, with a draft model proposing tokens for the
+// target model to verify.
+#pragma once
+
+#include <ctime>
+#include <random>
+
+#include <executorch/extension/llm/runner/text_prefiller.h>
+#include <executorch/extension/llm/runner/text_token_generator.h>
+#include <executorch/extension/module/module.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * A TextTokenGenerator that decodes with speculative decoding. Each round, a
+ * small draft model proposes up to `num_draft_tokens` tokens one at a time.
+ * The target model then scores the current token and all the proposals in a
+ * single forward pass. Proposals are accepted up to the first one the target
+ * model disagrees with. The round then emits the accepted proposals, plus
+ * one token sampled from the target model, so each target pass yields
+ * between 1 and num_draft_tokens + 1 tokens.
+ *
+ * The output follows the target model's distribution. With temperature 0 it
+ * is exactly the target model's greedy decode. With a higher temperature,
+ * proposals are accepted by rejection sampling against the full softmax,
+ * without the top-p cutoff that TextTokenGenerator applies.
+ *
+ * Rejected proposals are rolled back by moving the position back: both
+ * models then overwrite the rejected positions of their KV caches, and
+ * attention never reads past the current position. The KV caches must
+ * therefore be indexed by position, as with llama::update_cache.
+ *
+ * The target model must take several tokens per step (an exported dynamic
+ * sequence length) and return the logits of every input token, i.e. a
+ * [1, seq_len, vocab_size] output. The draft model must share the target
+ * model's tokenizer.
+ */
+class ET_EXPERIMENTAL SpeculativeTokenGenerator : public TextTokenGenerator {
+ public:
+  /**
+   * @param tokenizer Used to decode generated tokens for the callback.
+   * @param text_decoder_runner Runs the target model.
+   * @param draft_module The draft model's Module, kept alive for
+   * draft_decoder_runner. May be null if the runner does not need one.
+   * @param draft_decoder_runner Runs the draft model.
+   * @param draft_prefiller Prefills the draft model with the prompt.
+   * @param num_draft_tokens Maximum number of tokens proposed per round.
+   * @param eos_ids Tokens that end generation.
+   * @param stats Collects sampling time and the draft acceptance counts.
+   * @param rng_seed Seed for sampling when temperature > 0.
+   */
+  SpeculativeTokenGenerator(
+      ::tokenizers::Tokenizer* tokenizer,
+      TextDecoderRunner* text_decoder_runner,
+      std::unique_ptr<Module> draft_module,
+      std::unique_ptr<TextDecoderRunner> draft_decoder_runner,
+      std::unique_ptr<TextPrefiller> draft_prefiller,
+      int32_t num_draft_tokens,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      Stats* stats,
+      unsigned long long rng_seed = std::time(nullptr));
+
+  /**
+   * Token generation loop. Takes the same arguments as
+   * TextTokenGenerator::generate().
+   *
+   * The draft model is first prefilled with all of `tokens` but the last,
+   * ending right before `start_pos`. Honors set_async_detokenization().
+   */
+  ::executorch::runtime::Result<int64_t> generate(
+      std::vector<uint64_t> tokens,
+      int64_t start_pos,
+      int32_t max_new_tokens,
+      float temperature = 0.0f,
+      const std::function<void(const std::string&)>& token_callback =
+          {}) override;
+
+  ::executorch::runtime::Error load() override;
+
+  bool is_loaded() const override;
+
+ private:
+  // Draws a token from a normalized distribution.
+  uint64_t sample(const std::vector<float>& probs);
+
+  /**
+   * Note: draft_module_ is declared first so that it is destroyed after the
+   * draft runner and prefiller that use it.
+   */
+  std::unique_ptr<Module> draft_module_;
+  std::unique_ptr<TextDecoderRunner> draft_decoder_runner_;
+  std::unique_ptr<TextPrefiller> draft_prefiller_;
+  const int32_t num_draft_tokens_;
+  std::mt19937_64 rng_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -49,6 +49,16 @@ struct ET_EXPERIMENTAL Stats {
   int64_t num_prompt_tokens;
   // Token count from generated (total - prompt)
   int64_t num_generated_tokens;
+  // Prompt tokens restored from the prefix cache instead of prefilled.
+  int64_t num_prefix_cache_hit_tokens = 0;
+  // Time spent copying cached prefixes into the KV cache.
+  long prefix_cache_restore_ms = 0;
+  // Estimated prefill time saved by the prefix cache, net of the restore.
+  long prefix_cache_saved_ms = 0;
+  // Tokens proposed by the draft model in speculative decoding.
+  int64_t num_draft_tokens = 0;
+  // Draft tokens that the target model accepted.
+  int64_t num_accepted_draft_tokens = 0;
   inline void on_sampling_begin() {
     aggregate_sampling_timer_start_timestamp = time_in_ms();
   }
@@ -75,6 +85,11 @@ struct ET_EXPERIMENTAL Stats {
     aggregate_sampling_time_ms = 0;
     num_prompt_tokens = 0;
     num_generated_tokens = 0;
+    num_prefix_cache_hit_tokens = 0;
+    prefix_cache_restore_ms = 0;
+    prefix_cache_saved_ms = 0;
+    num_draft_tokens = 0;
+    num_accepted_draft_tokens = 0;
     aggregate_sampling_timer_start_timestamp = 0;
   }
 
@@ -93,7 +108,14 @@ inline std::string stats_to_json_string(const Stats& stats) {
      << "\"prompt_eval_end_ms\":" << stats.prompt_eval_end_ms << ","
      << "\"first_token_ms\":" << stats.first_token_ms << ","
      << "\"aggregate_sampling_time_ms\":" << stats.aggregate_sampling_time_ms
-     << "," << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
+     << ","
+     << "\"prefix_cache_hit_tokens\":" << stats.num_prefix_cache_hit_tokens
+     << ","
+     << "\"prefix_cache_restore_ms\":" << stats.prefix_cache_restore_ms << ","
+     << "\"prefix_cache_saved_ms\":" << stats.prefix_cache_saved_ms << ","
+     << "\"draft_tokens\":" << stats.num_draft_tokens << ","
+     << "\"accepted_draft_tokens\":" << stats.num_accepted_draft_tokens << ","
+     << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
      << stats.SCALING_FACTOR_UNITS_PER_SECOND << "}";
   return ss.str();
 }
@@ -156,6 +178,28 @@ inline void print_report(const Stats& stats) {
       stats.num_prompt_tokens + stats.num_generated_tokens,
       (double)stats.aggregate_sampling_time_ms /
           stats.SCALING_FACTOR_UNITS_PER_SECOND);
+
+  if (stats.num_prefix_cache_hit_tokens > 0) {
+    ET_LOG(
+        Info,
+        "\tPrefix cache hit rate:\t%f (%" PRId64 " of %" PRId64
+        " prompt tokens)\t\t Time saved: \t%f (seconds)",
+        (double)stats.num_prefix_cache_hit_tokens / stats.num_prompt_tokens,
+        stats.num_prefix_cache_hit_tokens,
+        stats.num_prompt_tokens,
+        (double)stats.prefix_cache_saved_ms /
+            stats.SCALING_FACTOR_UNITS_PER_SECOND);
+  }
+
+  if (stats.num_draft_tokens > 0) {
+    ET_LOG(
+        Info,
+        "\tDraft acceptance rate:\t%f (%" PRId64 " of %" PRId64
+        " draft tokens)",
+        (double)stats.num_accepted_draft_tokens / stats.num_draft_tokens,
+        stats.num_accepted_draft_tokens,
+        stats.num_draft_tokens);
+  }
 }
 
 } // namespace llm
@@ -22,6 +22,32 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "parallel_encoder",
+        exported_headers = ["parallel_encoder.h"],
+        srcs = ["parallel_encoder.cpp"],
+        visibility = [
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/platform:platform",
+            "//pytorch/tokenizers:headers",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "async_detokenizer",
+        exported_headers = ["async_detokenizer.h"],
+        srcs = ["async_detokenizer.cpp"],
+        visibility = [
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+            "//pytorch/tokenizers:headers",
+        ],
+    )
+
     for aten in (True, False):
         aten_suffix = "_aten" if aten else ""
 
@@ -63,6 +89,7 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
             exported_deps = [
+                ":async_detokenizer",
                 ":text_decoder_runner" + aten_suffix,
                 "//pytorch/tokenizers:headers",
                 "//executorch/extension/module:module" + aten_suffix,
@@ -70,6 +97,65 @@ def define_common_targets():
             ],
         )
 
+        runtime.cxx_library(
+            name = "kv_cache_block_allocator" + aten_suffix,
+            exported_headers = ["kv_cache_block_allocator.h"],
+            srcs = ["kv_cache_block_allocator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "prefix_cache" + aten_suffix,
+            exported_headers = ["prefix_cache.h"],
+            srcs = ["prefix_cache.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            deps = [
+                "//executorch/runtime/core:content_hash",
+            ],
+            exported_deps = [
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/runtime/core/exec_aten/util:tensor_util" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "batched_text_token_generator" + aten_suffix,
+            exported_headers = ["batched_text_token_generator.h"],
+            srcs = ["batched_text_token_generator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":kv_cache_block_allocator" + aten_suffix,
+                ":text_decoder_runner" + aten_suffix,
+                "//pytorch/tokenizers:headers",
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "speculative_token_generator" + aten_suffix,
+            exported_headers = ["speculative_token_generator.h"],
+            srcs = ["speculative_token_generator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":text_prefiller" + aten_suffix,
+                ":text_token_generator" + aten_suffix,
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
         runtime.cxx_library(
             name = "image_prefiller" + aten_suffix,
             exported_headers = ["image_prefiller.h", "image.h"],
@@ -97,8 +183,13 @@ def define_common_targets():
                 "-Wno-missing-prototypes",
             ],
             exported_deps = [
+                ":batched_text_token_generator" + aten_suffix,
                 ":image_prefiller" + aten_suffix,
                 ":irunner",
+                ":kv_cache_block_allocator" + aten_suffix,
+                ":parallel_encoder",
+                ":prefix_cache" + aten_suffix,
+                ":speculative_token_generator" + aten_suffix,
                 ":text_decoder_runner" + aten_suffix,
                 ":text_prefiller" + aten_suffix,
                 ":text_token_generator" + aten_suffix,
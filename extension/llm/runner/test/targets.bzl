@@ -7,6 +7,24 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
 
 def define_common_targets():
+    runtime.cxx_test(
+        name = "test_async_detokenizer",
+        srcs = ["test_async_detokenizer.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:async_detokenizer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_batched_text_token_generator",
+        srcs = ["test_batched_text_token_generator.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:runner_lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_generation_config",
         srcs = ["test_generation_config.cpp"],
@@ -18,6 +36,40 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "test_kv_cache_block_allocator",
+        srcs = ["test_kv_cache_block_allocator.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:kv_cache_block_allocator",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_parallel_encoder",
+        srcs = ["test_parallel_encoder.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:parallel_encoder",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_prefix_cache",
+        srcs = ["test_prefix_cache.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:prefix_cache",
+            "//executorch/extension/tensor:tensor",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_speculative_token_generator",
+        srcs = ["test_speculative_token_generator.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:speculative_token_generator",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_text_llm_runner",
         srcs = ["test_text_llm_runner.cpp"],
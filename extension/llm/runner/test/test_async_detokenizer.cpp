@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/async_detokenizer.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::llm::AsyncDetokenizer;
+using ::executorch::runtime::Error;
+
+namespace {
+
+// Decodes token t to pieces[t]. Fails on tokens past the end.
+class TableTokenizer : public ::tokenizers::Tokenizer {
+ public:
+  explicit TableTokenizer(std::vector<std::string> pieces)
+      : pieces_(std::move(pieces)) {}
+
+  ::tokenizers::Error load(const std::string&) override {
+    return ::tokenizers::Error::Ok;
+  }
+
+  ::tokenizers::Result<std::vector<uint64_t>>
+  encode(const std::string&, int8_t, int8_t) const override {
+    return std::vector<uint64_t>();
+  }
+
+  ::tokenizers::Result<std::string> decode(uint64_t, uint64_t token)
+      const override {
+    if (token >= pieces_.size()) {
+      return ::tokenizers::Error::DecodeFailure;
+    }
+    return pieces_[token];
+  }
+
+ private:
+  std::vector<std::string> pieces_;
+};
+
+} // namespace
+
+TEST(AsyncDetokenizerTest, CompleteUtf8Prefix) {
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix(""), 0);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("abc"), 3);
+  // "é" is C3 A9, "€" is E2 82 AC and "😀" is F0 9F 98 80.
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("a\xC3\xA9"), 3);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("a\xC3"), 1);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("a\xE2\x82"), 1);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("\xE2\x82\xAC"), 3);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("a\xF0\x9F\x98"), 1);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("\xF0\x9F\x98\x80"), 4);
+  // Stray continuation bytes are never held back.
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("a\x80\x80\x80\x80"), 5);
+  EXPECT_EQ(AsyncDetokenizer::complete_utf8_prefix("\xFF"), 1);
+}
+
+TEST(AsyncDetokenizerTest, AssemblesUtf8AcrossTokens) {
+  TableTokenizer tokenizer(
+      {"a", "\xE2", "\x82", "\xAC", "b", "\xF0\x9F", "\x98\x80", "\xC3"});
+  std::vector<std::string> pieces;
+  const auto main_thread = std::this_thread::get_id();
+  bool on_main_thread = false;
+  AsyncDetokenizer detokenizer(&tokenizer, [&](const std::string& piece) {
+    pieces.push_back(piece);
+    on_main_thread |= std::this_thread::get_id() == main_thread;
+  });
+  uint64_t prev = 0;
+  for (uint64_t token : {0, 1, 2, 3, 4, 5, 6, 7}) {
+    detokenizer.push(prev, token);
+    prev = token;
+  }
+  EXPECT_EQ(detokenizer.finish(), Error::Ok);
+
+  // The trailing lone lead byte is flushed as is.
+  EXPECT_EQ(
+      pieces,
+      std::vector<std::string>(
+          {"a", "\xE2\x82\xAC", "b", "\xF0\x9F\x98\x80", "\xC3"}));
+  EXPECT_FALSE(on_main_thread);
+}
+
+TEST(AsyncDetokenizerTest, KeepsOrderWhenTheQueueIsFull) {
+  std::vector<std::string> table;
+  for (int i = 0; i < 100; ++i) {
+    table.push_back(std::to_string(i) + " ");
+  }
+  TableTokenizer tokenizer(table);
+  std::string expected;
+  std::string text;
+  {
+    AsyncDetokenizer detokenizer(
+        &tokenizer,
+        [&](const std::string& piece) {
+          // Slower than the producer, so push() has to wait.
+          std::this_thread::sleep_for(std::chrono::microseconds(10));
+          text += piece;
+        },
+        /*capacity=*/3);
+    for (int round = 0; round < 10; ++round) {
+      for (uint64_t token = 0; token < table.size(); ++token) {
+        detokenizer.push(0, token);
+        expected += table[token];
+      }
+    }
+    // The destructor drains the queue.
+  }
+  EXPECT_EQ(text, expected);
+}
+
+TEST(AsyncDetokenizerTest, WakesTheWorkerForEachToken) {
+  TableTokenizer tokenizer({"a", "b", "c"});
+  std::atomic<int> num_pieces{0};
+  std::string text;
+  AsyncDetokenizer detokenizer(&tokenizer, [&](const std::string& piece) {
+    text += piece;
+    num_pieces.fetch_add(1);
+  });
+  // Each token is decoded before the next is pushed, so the worker goes back
+  // to waiting every time and push() has to wake it.
+  for (int token = 0; token < 3; ++token) {
+    detokenizer.push(0, token);
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (num_pieces.load() <= token &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(num_pieces.load(), token + 1);
+  }
+  EXPECT_EQ(detokenizer.finish(), Error::Ok);
+  EXPECT_EQ(text, "abc");
+}
+
+TEST(AsyncDetokenizerTest, ReportsDecodeErrors) {
+  // Decode errors are logged, so the PAL must be initialized first.
+  ::executorch::runtime::runtime_init();
+  TableTokenizer tokenizer({"a", "b"});
+  std::string text;
+  AsyncDetokenizer detokenizer(
+      &tokenizer, [&](const std::string& piece) { text += piece; });
+  detokenizer.push(0, 0);
+  detokenizer.push(0, 5);
+  detokenizer.push(5, 1);
+  EXPECT_EQ(detokenizer.finish(), Error::InvalidArgument);
+  EXPECT_EQ(detokenizer.finish(), Error::InvalidArgument);
+  EXPECT_EQ(text, "ab");
+}
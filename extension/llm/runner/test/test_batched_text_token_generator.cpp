@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ * @lint-ignore-every CLANGTIDY facebook-hte-Deprecated
+ */
+
+#include <executorch/extension/llm/runner/batched_text_token_generator.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::extension::TensorPtr;
+using executorch::extension::llm::BatchedTextTokenGenerator;
+using executorch::extension::llm::KVCacheBlockAllocator;
+using executorch::extension::llm::Stats;
+using executorch::extension::llm::TextDecoderRunner;
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int32_t kVocabSize = 16;
+constexpr uint64_t kEos = 15;
+
+class MockTokenizer : public ::tokenizers::Tokenizer {
+ public:
+  MOCK_METHOD(::tokenizers::Error, load, (const std::string&), ());
+  MOCK_METHOD(bool, is_loaded, (), (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::vector<uint64_t>>,
+      encode,
+      (const std::string&, int8_t, int8_t),
+      (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::string>,
+      decode,
+      (uint64_t, uint64_t),
+      (const));
+  MOCK_METHOD(uint64_t, bos_tok, (), (const));
+  MOCK_METHOD(uint64_t, eos_tok, (), (const));
+  MOCK_METHOD(uint64_t, vocab_size, (), (const));
+};
+
+/**
+ * A model whose next token is always the input token plus one. Records the
+ * tokens and positions of every step.
+ */
+class FakeBatchedDecoderRunner : public TextDecoderRunner {
+ public:
+  FakeBatchedDecoderRunner() : TextDecoderRunner(nullptr) {}
+
+  Result<executorch::aten::Tensor> step_batch(
+      TensorPtr& tokens,
+      TensorPtr& positions,
+      TensorPtr* block_table) override {
+    const int64_t batch_size = tokens->size(0);
+    std::vector<int64_t> step_tokens(
+        tokens->const_data_ptr<int64_t>(),
+        tokens->const_data_ptr<int64_t>() + batch_size);
+    std::vector<int64_t> step_positions(
+        positions->const_data_ptr<int64_t>(),
+        positions->const_data_ptr<int64_t>() + batch_size);
+    std::vector<float> logits(batch_size * kVocabSize, 0.0f);
+    for (int64_t b = 0; b < batch_size; ++b) {
+      logits[b * kVocabSize + (step_tokens[b] + 1) % kVocabSize] = 1.0f;
+    }
+    if (block_table != nullptr) {
+      block_tables_per_step.emplace_back(
+          (*block_table)->const_data_ptr<int64_t>(),
+          (*block_table)->const_data_ptr<int64_t>() + (*block_table)->numel());
+    }
+    tokens_per_step.push_back(std::move(step_tokens));
+    positions_per_step.push_back(std::move(step_positions));
+    logits_ = tf_.make({static_cast<int32_t>(batch_size), kVocabSize}, logits);
+    return logits_;
+  }
+
+  std::vector<std::vector<int64_t>> tokens_per_step;
+  std::vector<std::vector<int64_t>> positions_per_step;
+  std::vector<std::vector<int64_t>> block_tables_per_step;
+
+ private:
+  TensorFactory<executorch::aten::ScalarType::Float> tf_;
+  executorch::aten::Tensor logits_{nullptr};
+};
+
+} // namespace
+
+class BatchedTextTokenGeneratorTest : public Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    ON_CALL(tokenizer_, decode)
+        .WillByDefault([](uint64_t, uint64_t token) {
+          return ::tokenizers::Result<std::string>(std::to_string(token));
+        });
+    stats_.num_generated_tokens = 0;
+    stats_.aggregate_sampling_time_ms = 0;
+  }
+
+  std::unique_ptr<BatchedTextTokenGenerator> make_generator(
+      int32_t batch_size,
+      int64_t max_seq_len,
+      KVCacheBlockAllocator* block_allocator = nullptr) {
+    return std::make_unique<BatchedTextTokenGenerator>(
+        &tokenizer_,
+        &runner_,
+        batch_size,
+        max_seq_len,
+        std::make_unique<std::unordered_set<uint64_t>>(
+            std::unordered_set<uint64_t>{kEos}),
+        &stats_,
+        block_allocator);
+  }
+
+  NiceMock<MockTokenizer> tokenizer_;
+  FakeBatchedDecoderRunner runner_;
+  Stats stats_;
+};
+
+TEST_F(BatchedTextTokenGeneratorTest, SequencesAdvanceIndependently) {
+  auto generator = make_generator(/*batch_size=*/2, /*max_seq_len=*/32);
+  std::vector<std::string> out_a;
+  std::vector<std::string> out_b;
+  ASSERT_EQ(
+      generator
+          ->add_sequence(
+              {1, 2, 3},
+              /*max_new_tokens=*/2,
+              0.0f,
+              [&](const std::string& s) { out_a.push_back(s); })
+          .error(),
+      Error::Ok);
+  ASSERT_EQ(
+      generator
+          ->add_sequence(
+              {7},
+              /*max_new_tokens=*/4,
+              0.0f,
+              [&](const std::string& s) { out_b.push_back(s); })
+          .error(),
+      Error::Ok);
+
+  Result<int64_t> generated = generator->run();
+  ASSERT_EQ(generated.error(), Error::Ok);
+  EXPECT_EQ(generated.get(), 6);
+  EXPECT_EQ(stats_.num_generated_tokens, 6);
+  EXPECT_EQ(out_a, (std::vector<std::string>{"4", "5"}));
+  EXPECT_EQ(out_b, (std::vector<std::string>{"8", "9", "10", "11"}));
+
+  // Row 0 feeds its prompt while row 1 is already generating.
+  ASSERT_GE(runner_.tokens_per_step.size(), 4);
+  EXPECT_EQ(runner_.tokens_per_step[0], (std::vector<int64_t>{1, 7}));
+  EXPECT_EQ(runner_.positions_per_step[0], (std::vector<int64_t>{0, 0}));
+  EXPECT_EQ(runner_.tokens_per_step[1], (std::vector<int64_t>{2, 8}));
+  EXPECT_EQ(runner_.positions_per_step[1], (std::vector<int64_t>{1, 1}));
+  EXPECT_EQ(runner_.tokens_per_step[3], (std::vector<int64_t>{4, 10}));
+  EXPECT_EQ(runner_.positions_per_step[3], (std::vector<int64_t>{3, 3}));
+  EXPECT_EQ(generator->num_active(), 0);
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, FinishedSlotsAreReused) {
+  auto generator = make_generator(/*batch_size=*/1, /*max_seq_len=*/32);
+  ASSERT_EQ(generator->add_sequence({kEos - 2}, 10).error(), Error::Ok);
+  ASSERT_EQ(generator->add_sequence({3}, 1).error(), Error::Ok);
+  EXPECT_EQ(generator->num_pending(), 2);
+
+  // The first sequence stops at EOS after two tokens, then the second takes
+  // its slot from position 0.
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(generator->num_active(), 1);
+  EXPECT_EQ(generator->num_pending(), 1);
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(generator->num_active(), 0);
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(runner_.tokens_per_step[2], (std::vector<int64_t>{3}));
+  EXPECT_EQ(runner_.positions_per_step[2], (std::vector<int64_t>{0}));
+  EXPECT_EQ(generator->num_active(), 0);
+  EXPECT_EQ(generator->num_pending(), 0);
+  EXPECT_EQ(generator->step().get(), 0);
+  EXPECT_EQ(runner_.tokens_per_step.size(), 3);
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, IdleSlotsArePadded) {
+  auto generator = make_generator(/*batch_size=*/3, /*max_seq_len=*/32);
+  ASSERT_EQ(generator->add_sequence({5, 6}, 1).error(), Error::Ok);
+  EXPECT_EQ(generator->step().get(), 0);
+  EXPECT_EQ(runner_.tokens_per_step[0], (std::vector<int64_t>{5, 0, 0}));
+  EXPECT_EQ(runner_.positions_per_step[0], (std::vector<int64_t>{0, 0, 0}));
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, SequencesStopAtMaxSeqLen) {
+  auto generator = make_generator(/*batch_size=*/1, /*max_seq_len=*/4);
+  ASSERT_EQ(generator->add_sequence({1, 2}, 100).error(), Error::Ok);
+  EXPECT_EQ(generator->run().get(), 3);
+  EXPECT_EQ(runner_.positions_per_step.back(), (std::vector<int64_t>{3}));
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, CancelRemovesQueuedAndActiveSequences) {
+  auto generator = make_generator(/*batch_size=*/1, /*max_seq_len=*/32);
+  const int64_t active = generator->add_sequence({1}, 10).get();
+  const int64_t queued = generator->add_sequence({2}, 10).get();
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_TRUE(generator->cancel(queued));
+  EXPECT_EQ(generator->num_pending(), 0);
+  EXPECT_TRUE(generator->cancel(active));
+  EXPECT_EQ(generator->num_active(), 0);
+  EXPECT_FALSE(generator->cancel(active));
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, InvalidSequencesAreRejected) {
+  auto generator = make_generator(/*batch_size=*/1, /*max_seq_len=*/4);
+  EXPECT_EQ(generator->add_sequence({}, 1).error(), Error::InvalidArgument);
+  EXPECT_EQ(
+      generator->add_sequence({1, 2, 3, 4}, 1).error(), Error::InvalidArgument);
+  EXPECT_EQ(generator->add_sequence({1}, 0).error(), Error::InvalidArgument);
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, PagedCacheBlocksFollowSequences) {
+  // 3 blocks of 2 positions besides the scratch block, for 2 rows of up to
+  // 3 blocks each.
+  KVCacheBlockAllocator allocator(
+      /*num_blocks=*/4,
+      /*block_size=*/2,
+      /*batch_size=*/2,
+      /*max_blocks_per_seq=*/3);
+  auto generator =
+      make_generator(/*batch_size=*/2, /*max_seq_len=*/6, &allocator);
+  ASSERT_EQ(generator->add_sequence({1, 2}, 2).error(), Error::Ok);
+  ASSERT_EQ(generator->add_sequence({4}, 1).error(), Error::Ok);
+
+  // Each row gets a block for its first position; row 1 then finishes and
+  // gives its block back.
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(
+      runner_.block_tables_per_step[0],
+      (std::vector<int64_t>{1, 0, 0, 2, 0, 0}));
+  EXPECT_EQ(allocator.num_free_blocks(), 2);
+
+  // Row 0 moves on to position 2, which needs a second block.
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(generator->step().get(), 1);
+  EXPECT_EQ(
+      runner_.block_tables_per_step[2],
+      (std::vector<int64_t>{1, 2, 0, 0, 0, 0}));
+  EXPECT_EQ(generator->num_active(), 0);
+  EXPECT_EQ(allocator.num_free_blocks(), 3);
+}
+
+TEST_F(BatchedTextTokenGeneratorTest, SequencesEndWhenBlocksRunOut) {
+  KVCacheBlockAllocator allocator(
+      /*num_blocks=*/2,
+      /*block_size=*/2,
+      /*batch_size=*/1,
+      /*max_blocks_per_seq=*/4);
+  auto generator =
+      make_generator(/*batch_size=*/1, /*max_seq_len=*/8, &allocator);
+  ASSERT_EQ(generator->add_sequence({1}, 10).error(), Error::Ok);
+  // Positions 0 and 1 fit in the only block.
+  EXPECT_EQ(generator->run().get(), 2);
+  EXPECT_EQ(runner_.tokens_per_step.size(), 2);
+  EXPECT_EQ(allocator.num_free_blocks(), 1);
+}
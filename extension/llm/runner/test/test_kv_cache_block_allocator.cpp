@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ * @lint-ignore-every CLANGTIDY facebook-hte-Deprecated
+ */
+
+#include <executorch/extension/llm/runner/kv_cache_block_allocator.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace ::testing;
+using executorch::extension::llm::KVCacheBlockAllocator;
+using executorch::runtime::Error;
+
+namespace {
+
+std::vector<int64_t> table_of(KVCacheBlockAllocator& allocator) {
+  const auto& table = allocator.block_table();
+  return std::vector<int64_t>(
+      table->const_data_ptr<int64_t>(),
+      table->const_data_ptr<int64_t>() + table->numel());
+}
+
+} // namespace
+
+class KVCacheBlockAllocatorTest : public Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(KVCacheBlockAllocatorTest, RowsGrowBlockByBlock) {
+  KVCacheBlockAllocator allocator(
+      /*num_blocks=*/5,
+      /*block_size=*/4,
+      /*batch_size=*/2,
+      /*max_blocks_per_seq=*/3);
+  EXPECT_EQ(allocator.block_table()->size(0), 2);
+  EXPECT_EQ(allocator.block_table()->size(1), 3);
+  EXPECT_EQ(allocator.num_free_blocks(), 4);
+  EXPECT_EQ(table_of(allocator), (std::vector<int64_t>(6, 0)));
+
+  EXPECT_EQ(allocator.reserve(0, 1), Error::Ok);
+  EXPECT_EQ(allocator.reserve(0, 4), Error::Ok);
+  EXPECT_EQ(allocator.reserved_tokens(0), 4);
+  EXPECT_EQ(allocator.reserve(1, 5), Error::Ok);
+  EXPECT_EQ(allocator.reserve(0, 5), Error::Ok);
+  EXPECT_EQ(table_of(allocator), (std::vector<int64_t>{1, 4, 0, 2, 3, 0}));
+  EXPECT_EQ(allocator.num_free_blocks(), 0);
+}
+
+TEST_F(KVCacheBlockAllocatorTest, ReleasedBlocksAreReused) {
+  KVCacheBlockAllocator allocator(
+      /*num_blocks=*/3,
+      /*block_size=*/2,
+      /*batch_size=*/2,
+      /*max_blocks_per_seq=*/2);
+  ASSERT_EQ(allocator.reserve(0, 4), Error::Ok);
+  EXPECT_EQ(allocator.reserve(1, 1), Error::OutOfResources);
+  EXPECT_EQ(allocator.reserved_tokens(1), 0);
+
+  allocator.release(0);
+  EXPECT_EQ(allocator.reserved_tokens(0), 0);
+  EXPECT_EQ(allocator.num_free_blocks(), 2);
+  ASSERT_EQ(allocator.reserve(1, 3), Error::Ok);
+  EXPECT_EQ(table_of(allocator), (std::vector<int64_t>{0, 0, 1, 2}));
+}
+
+TEST_F(KVCacheBlockAllocatorTest, FailedReserveKeepsExistingBlocks) {
+  KVCacheBlockAllocator allocator(
+      /*num_blocks=*/3,
+      /*block_size=*/2,
+      /*batch_size=*/1,
+      /*max_blocks_per_seq=*/4);
+  ASSERT_EQ(allocator.reserve(0, 2), Error::Ok);
+  // Needs 3 blocks, but only one more is free.
+  EXPECT_EQ(allocator.reserve(0, 6), Error::OutOfResources);
+  EXPECT_EQ(allocator.reserved_tokens(0), 2);
+  EXPECT_EQ(allocator.num_free_blocks(), 1);
+  // More than the table can map.
+  EXPECT_EQ(allocator.reserve(0, 9), Error::InvalidArgument);
+  EXPECT_EQ(allocator.reserve(1, 1), Error::InvalidArgument);
+}
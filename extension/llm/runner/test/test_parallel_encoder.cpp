@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/parallel_encoder.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::llm::ParallelEncoder;
+
+namespace {
+
+constexpr uint64_t kBos = 1;
+constexpr uint64_t kEos = 2;
+
+// Encodes every byte as a token of its own, so any split is exact. Fails on
+// '!'.
+class ByteTokenizer : public ::tokenizers::Tokenizer {
+ public:
+  ::tokenizers::Error load(const std::string&) override {
+    return ::tokenizers::Error::Ok;
+  }
+
+  ::tokenizers::Result<std::vector<uint64_t>>
+  encode(const std::string& input, int8_t bos, int8_t eos) const override {
+    ++num_calls;
+    if (input.find('!') != std::string::npos) {
+      return ::tokenizers::Error::EncodeFailure;
+    }
+    std::vector<uint64_t> tokens(bos, kBos);
+    for (unsigned char c : input) {
+      tokens.push_back(c + 10);
+    }
+    tokens.insert(tokens.end(), eos, kEos);
+    return tokens;
+  }
+
+  ::tokenizers::Result<std::string> decode(uint64_t, uint64_t) const override {
+    return std::string();
+  }
+
+  mutable std::atomic<int> num_calls{0};
+};
+
+// 40 lines of 25 bytes; every 5th line is indented.
+std::string make_text() {
+  std::string text;
+  for (int i = 0; i < 40; ++i) {
+    std::string line = (i % 5 == 0 ? "  line " : "line ") + std::to_string(i);
+    line.resize(24, '.');
+    text += line + "\n";
+  }
+  return text;
+}
+
+} // namespace
+
+TEST(ParallelEncoderTest, ChunksStartAtUnindentedLines) {
+  ByteTokenizer tokenizer;
+  const std::string text = make_text();
+  ParallelEncoder encoder(&tokenizer, /*min_chunk_size=*/100, 4);
+
+  const auto starts = encoder.chunk_starts(text);
+  ASSERT_EQ(starts.size(), 4);
+  EXPECT_EQ(starts[0], 0);
+  for (size_t i = 1; i < starts.size(); ++i) {
+    EXPECT_GT(starts[i], starts[i - 1]);
+    EXPECT_EQ(text[starts[i] - 1], '\n');
+    EXPECT_NE(text[starts[i]], ' ');
+  }
+  // The last chunk is at least min_chunk_size long.
+  EXPECT_GE(text.size() - starts.back(), 100);
+}
+
+TEST(ParallelEncoderTest, ShortTextIsOneChunk) {
+  ByteTokenizer tokenizer;
+  const std::string text = make_text();
+  EXPECT_EQ(
+      ParallelEncoder(&tokenizer, text.size() / 2 + 1, 4).chunk_starts(text),
+      std::vector<size_t>{0});
+  EXPECT_EQ(
+      ParallelEncoder(&tokenizer, 100, 1).chunk_starts(text),
+      std::vector<size_t>{0});
+  // No line start to split at.
+  EXPECT_EQ(
+      ParallelEncoder(&tokenizer, 10, 4).chunk_starts(std::string(1000, 'a')),
+      std::vector<size_t>{0});
+}
+
+TEST(ParallelEncoderTest, MatchesSerialEncode) {
+  ByteTokenizer tokenizer;
+  const std::string text = make_text();
+  ParallelEncoder encoder(&tokenizer, /*min_chunk_size=*/100, 4);
+
+  auto expected = tokenizer.encode(text, 1, 1);
+  tokenizer.num_calls = 0;
+  auto tokens = encoder.encode(text, 1, 1);
+  ASSERT_TRUE(tokens.ok());
+  EXPECT_EQ(tokenizer.num_calls, 4);
+  EXPECT_EQ(tokens.get(), expected.get());
+  EXPECT_EQ(tokens.get().front(), kBos);
+  EXPECT_EQ(tokens.get().back(), kEos);
+}
+
+TEST(ParallelEncoderTest, PropagatesErrors) {
+  ByteTokenizer tokenizer;
+  std::string text = make_text();
+  text[text.size() - 3] = '!';
+  ParallelEncoder encoder(&tokenizer, /*min_chunk_size=*/100, 4);
+
+  auto tokens = encoder.encode(text, 1, 0);
+  EXPECT_FALSE(tokens.ok());
+  EXPECT_EQ(tokens.error(), ::tokenizers::Error::EncodeFailure);
+}
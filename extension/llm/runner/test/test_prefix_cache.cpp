@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ * @lint-ignore-every CLANGTIDY facebook-hte-Deprecated
+ */
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace ::testing;
+using executorch::extension::TensorPtr;
+using executorch::extension::make_tensor_ptr;
+using executorch::extension::llm::PrefixCache;
+
+namespace {
+
+// Writes `value + position` to every element of position `pos` of a
+// [batch, seq, dim] cache.
+void fill_position(TensorPtr& cache, int64_t pos, float value) {
+  const int64_t seq_len = cache->size(1);
+  const int64_t dim = cache->size(2);
+  float* data = cache->mutable_data_ptr<float>();
+  for (int64_t b = 0; b < cache->size(0); ++b) {
+    std::fill_n(data + (b * seq_len + pos) * dim, dim, value + pos);
+  }
+}
+
+float value_at(TensorPtr& cache, int64_t batch, int64_t pos) {
+  return cache->const_data_ptr<float>()
+      [(batch * cache->size(1) + pos) * cache->size(2)];
+}
+
+} // namespace
+
+class PrefixCacheTest : public Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    k_cache_ = make_tensor_ptr({2, 8, 3}, std::vector<float>(2 * 8 * 3, 0.f));
+    v_cache_ = make_tensor_ptr({2, 8, 3}, std::vector<float>(2 * 8 * 3, 0.f));
+  }
+
+  std::unique_ptr<PrefixCache> make_cache(size_t max_blocks) {
+    return std::make_unique<PrefixCache>(
+        std::vector<executorch::aten::Tensor>{*k_cache_, *v_cache_},
+        /*seq_dim=*/1,
+        /*block_size=*/2,
+        max_blocks);
+  }
+
+  // Simulates prefilling `tokens` from position 0.
+  void prefill(const std::vector<uint64_t>& tokens, float value) {
+    for (size_t pos = 0; pos < tokens.size(); ++pos) {
+      fill_position(k_cache_, pos, value);
+      fill_position(v_cache_, pos, -value);
+    }
+  }
+
+  void clobber() {
+    for (int64_t pos = 0; pos < k_cache_->size(1); ++pos) {
+      fill_position(k_cache_, pos, 1000.f);
+      fill_position(v_cache_, pos, 1000.f);
+    }
+  }
+
+  TensorPtr k_cache_;
+  TensorPtr v_cache_;
+};
+
+TEST_F(PrefixCacheTest, RestoresLongestSharedPrefix) {
+  auto cache = make_cache(/*max_blocks=*/8);
+  EXPECT_EQ(cache->block_nbytes(), 2 * (2 * 2 * 3 * sizeof(float)));
+
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4, 5};
+  prefill(prompt, 10.f);
+  cache->insert(prompt, prompt.size());
+  // The partial last block is not stored.
+  EXPECT_EQ(cache->num_blocks(), 2);
+
+  clobber();
+  EXPECT_EQ(cache->restore({1, 2, 3, 4, 9, 9}), 4);
+  for (int64_t b = 0; b < 2; ++b) {
+    for (int64_t pos = 0; pos < 4; ++pos) {
+      EXPECT_EQ(value_at(k_cache_, b, pos), 10.f + pos);
+      EXPECT_EQ(value_at(v_cache_, b, pos), -10.f + pos);
+    }
+    EXPECT_EQ(value_at(k_cache_, b, 4), 1004.f);
+  }
+
+  // Only the first block is shared.
+  EXPECT_EQ(cache->restore({1, 2, 4, 3, 5}), 2);
+  // Nothing is shared.
+  EXPECT_EQ(cache->restore({2, 1, 3, 4, 5}), 0);
+}
+
+TEST_F(PrefixCacheTest, LeavesATokenToPrefill) {
+  auto cache = make_cache(/*max_blocks=*/8);
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4};
+  prefill(prompt, 0.f);
+  cache->insert(prompt, prompt.size());
+  EXPECT_EQ(cache->num_blocks(), 2);
+
+  EXPECT_EQ(cache->restore(prompt), 2);
+  EXPECT_EQ(cache->restore({1}), 0);
+  EXPECT_EQ(cache->restore({}), 0);
+}
+
+TEST_F(PrefixCacheTest, PrefixesShareBlocks) {
+  auto cache = make_cache(/*max_blocks=*/8);
+  prefill({1, 2, 3, 4}, 0.f);
+  cache->insert({1, 2, 3, 4}, 4);
+  prefill({1, 2, 5, 6}, 0.f);
+  cache->insert({1, 2, 5, 6}, 4);
+  EXPECT_EQ(cache->num_blocks(), 3);
+
+  EXPECT_EQ(cache->restore({1, 2, 3, 4, 0}), 4);
+  EXPECT_EQ(cache->restore({1, 2, 5, 6, 0}), 4);
+  // The same block of tokens after a different prefix is a different block.
+  EXPECT_EQ(cache->restore({3, 4, 3, 4, 0}), 0);
+}
+
+TEST_F(PrefixCacheTest, EvictsLeastRecentlyUsedBlocksDeepestFirst) {
+  auto cache = make_cache(/*max_blocks=*/3);
+  prefill({1, 2, 3, 4}, 0.f);
+  cache->insert({1, 2, 3, 4}, 4);
+  prefill({7, 8}, 0.f);
+  cache->insert({7, 8}, 2);
+  EXPECT_EQ(cache->num_blocks(), 3);
+
+  // [1, 2] -> [3, 4] is older than [7, 8]; its last block goes first.
+  prefill({5, 6}, 0.f);
+  cache->insert({5, 6}, 2);
+  EXPECT_EQ(cache->num_blocks(), 3);
+  EXPECT_EQ(cache->restore({1, 2, 3, 4, 0}), 2);
+  EXPECT_EQ(cache->restore({7, 8, 0}), 2);
+  EXPECT_EQ(cache->restore({5, 6, 0}), 2);
+
+  // Inserting never evicts the blocks of the prefix being inserted.
+  auto tiny = make_cache(/*max_blocks=*/1);
+  tiny->insert({1, 2, 3, 4}, 4);
+  EXPECT_EQ(tiny->num_blocks(), 1);
+  EXPECT_EQ(tiny->restore({1, 2, 3, 4, 0}), 2);
+}
+
+TEST_F(PrefixCacheTest, InnerSeqDim) {
+  // [batch, heads, seq, dim] with the positions in dimension 2.
+  std::vector<float> data(2 * 2 * 4 * 2);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i;
+  }
+  auto cache_tensor = make_tensor_ptr({2, 2, 4, 2}, data);
+  PrefixCache cache(
+      {*cache_tensor}, /*seq_dim=*/2, /*block_size=*/2, /*max_blocks=*/4);
+  cache.insert({1, 2, 3, 4}, 4);
+  EXPECT_EQ(cache.num_blocks(), 2);
+
+  std::fill_n(cache_tensor->mutable_data_ptr<float>(), data.size(), -1.f);
+  EXPECT_EQ(cache.restore({1, 2, 3, 4, 5}), 4);
+  EXPECT_EQ(
+      std::vector<float>(
+          cache_tensor->const_data_ptr<float>(),
+          cache_tensor->const_data_ptr<float>() + data.size()),
+      data);
+}
+
+TEST_F(PrefixCacheTest, EstimatesPrefillTime) {
+  auto cache = make_cache(/*max_blocks=*/8);
+  EXPECT_EQ(cache->estimate_prefill_ms(10), 0.0);
+  cache->record_prefill(4, 20);
+  cache->record_prefill(6, 30);
+  EXPECT_DOUBLE_EQ(cache->estimate_prefill_ms(10), 50.0);
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ * @lint-ignore-every CLANGTIDY facebook-hte-Deprecated
+ */
+
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using namespace ::testing;
+using executorch::extension::TensorPtr;
+using executorch::extension::llm::SpeculativeTokenGenerator;
+using executorch::extension::llm::Stats;
+using executorch::extension::llm::TextDecoderRunner;
+using executorch::extension::llm::TextPrefiller;
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int32_t kVocabSize = 32;
+constexpr uint64_t kEos = 31;
+
+using NextTokenFn = std::function<uint64_t(const std::vector<uint64_t>&)>;
+
+// The target model: a deterministic function of everything before it.
+uint64_t target_next(const std::vector<uint64_t>& history) {
+  return (std::accumulate(history.begin(), history.end(), uint64_t(0)) +
+          history.size()) %
+      kEos;
+}
+
+// A draft model that gets every fourth token wrong.
+uint64_t draft_next(const std::vector<uint64_t>& history) {
+  const uint64_t token = target_next(history);
+  return history.size() % 4 == 0 ? (token + 1) % kEos : token;
+}
+
+class MockTokenizer : public ::tokenizers::Tokenizer {
+ public:
+  MOCK_METHOD(::tokenizers::Error, load, (const std::string&), ());
+  MOCK_METHOD(bool, is_loaded, (), (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::vector<uint64_t>>,
+      encode,
+      (const std::string&, int8_t, int8_t),
+      (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::string>,
+      decode,
+      (uint64_t, uint64_t),
+      (const));
+  MOCK_METHOD(uint64_t, bos_tok, (), (const));
+  MOCK_METHOD(uint64_t, eos_tok, (), (const));
+  MOCK_METHOD(uint64_t, vocab_size, (), (const));
+};
+
+/**
+ * A model whose KV cache holds the token fed at each position. The logits
+ * after position p pick next_token(cache[0, p]), so anything left in the
+ * cache by a rejected proposal that is not overwritten shows up in the
+ * output.
+ */
+class FakeDecoderRunner : public TextDecoderRunner {
+ public:
+  FakeDecoderRunner(NextTokenFn next_token, bool all_logits = true)
+      : TextDecoderRunner(nullptr),
+        next_token_(std::move(next_token)),
+        all_logits_(all_logits) {}
+
+  Result<executorch::aten::Tensor> step(TensorPtr& tokens, int64_t start_pos)
+      override {
+    const int64_t num_tokens = tokens->numel();
+    if (cache_.size() < static_cast<size_t>(start_pos + num_tokens)) {
+      cache_.resize(start_pos + num_tokens);
+    }
+    std::vector<float> logits(num_tokens * kVocabSize, 0.0f);
+    for (int64_t i = 0; i < num_tokens; ++i) {
+      cache_[start_pos + i] = tokens->const_data_ptr<int64_t>()[i];
+      const std::vector<uint64_t> history(
+          cache_.begin(), cache_.begin() + start_pos + i + 1);
+      logits[i * kVocabSize + next_token_(history)] = 10.0f;
+    }
+    num_steps++;
+    if (all_logits_) {
+      logits_ = tf_.make(
+          {1, static_cast<int32_t>(num_tokens), kVocabSize}, logits);
+    } else {
+      logits_ = tf_.make(
+          {1, kVocabSize},
+          std::vector<float>(logits.end() - kVocabSize, logits.end()));
+    }
+    return logits_;
+  }
+
+  Error load() override {
+    return Error::Ok;
+  }
+
+  bool is_method_loaded() override {
+    return true;
+  }
+
+  int32_t num_steps = 0;
+
+ private:
+  NextTokenFn next_token_;
+  bool all_logits_;
+  std::vector<uint64_t> cache_;
+  TensorFactory<executorch::aten::ScalarType::Float> tf_;
+  executorch::aten::Tensor logits_{nullptr};
+};
+
+} // namespace
+
+class SpeculativeTokenGeneratorTest : public Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    ON_CALL(tokenizer_, decode)
+        .WillByDefault([](uint64_t, uint64_t token) {
+          return ::tokenizers::Result<std::string>(std::to_string(token));
+        });
+    ON_CALL(tokenizer_, is_loaded).WillByDefault(Return(true));
+    stats_.reset();
+  }
+
+  std::unique_ptr<SpeculativeTokenGenerator> make_generator(
+      NextTokenFn target,
+      NextTokenFn draft,
+      int32_t num_draft_tokens,
+      bool all_logits = true) {
+    target_ =
+        std::make_unique<FakeDecoderRunner>(std::move(target), all_logits);
+    auto draft_runner = std::make_unique<FakeDecoderRunner>(std::move(draft));
+    draft_ = draft_runner.get();
+    auto draft_prefiller = std::make_unique<TextPrefiller>(
+        draft_runner.get(),
+        /*use_kv_cache=*/true,
+        /*enable_parallel_prefill=*/true,
+        /*max_seq_len=*/128);
+    return std::make_unique<SpeculativeTokenGenerator>(
+        &tokenizer_,
+        target_.get(),
+        /*draft_module=*/nullptr,
+        std::move(draft_runner),
+        std::move(draft_prefiller),
+        num_draft_tokens,
+        std::make_unique<std::unordered_set<uint64_t>>(
+            std::unordered_set<uint64_t>{kEos}),
+        &stats_,
+        /*rng_seed=*/42);
+  }
+
+  // Prefills the target model with `prompt` and returns the prompt followed
+  // by the first generated token, as TextLLMRunner would.
+  std::vector<uint64_t> prefill(std::vector<uint64_t> prompt) {
+    auto tokens = executorch::extension::from_blob(
+        prompt.data(),
+        {1, static_cast<int32_t>(prompt.size())},
+        executorch::aten::ScalarType::Long);
+    EXPECT_EQ(target_->step(tokens, 0).error(), Error::Ok);
+    prompt.push_back(target_next(prompt));
+    return prompt;
+  }
+
+  // What greedy decoding of the target model alone generates.
+  static std::vector<std::string> greedy(
+      std::vector<uint64_t> tokens,
+      int32_t max_new_tokens) {
+    std::vector<std::string> pieces;
+    for (int32_t i = 0; i < max_new_tokens; ++i) {
+      tokens.push_back(target_next(tokens));
+      pieces.push_back(std::to_string(tokens.back()));
+    }
+    return pieces;
+  }
+
+  NiceMock<MockTokenizer> tokenizer_;
+  std::unique_ptr<FakeDecoderRunner> target_;
+  FakeDecoderRunner* draft_ = nullptr;
+  Stats stats_;
+};
+
+TEST_F(SpeculativeTokenGeneratorTest, GreedyOutputMatchesTargetModel) {
+  auto generator =
+      make_generator(target_next, draft_next, /*num_draft_tokens=*/3);
+  const auto tokens = prefill({1, 2, 3});
+
+  std::vector<std::string> pieces;
+  auto res = generator->generate(
+      tokens, 3, /*max_new_tokens=*/20, 0.0f, [&](const std::string& piece) {
+        pieces.push_back(piece);
+      });
+  ASSERT_EQ(res.error(), Error::Ok);
+  EXPECT_EQ(res.get(), 20);
+  EXPECT_EQ(pieces, greedy(tokens, 20));
+
+  EXPECT_GT(stats_.num_accepted_draft_tokens, 0);
+  EXPECT_LT(stats_.num_accepted_draft_tokens, stats_.num_draft_tokens);
+  // One target step for the prefill, then fewer than one per token.
+  EXPECT_LT(target_->num_steps - 1, 20);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, MatchingDraftIsFullyAccepted) {
+  auto generator =
+      make_generator(target_next, target_next, /*num_draft_tokens=*/4);
+  const auto tokens = prefill({5, 6});
+
+  std::vector<std::string> pieces;
+  auto res = generator->generate(
+      tokens, 2, /*max_new_tokens=*/11, 0.0f, [&](const std::string& piece) {
+        pieces.push_back(piece);
+      });
+  ASSERT_EQ(res.error(), Error::Ok);
+  EXPECT_EQ(pieces, greedy(tokens, 11));
+  // 4 + 1 tokens, 4 + 1 tokens, then the last token alone.
+  EXPECT_EQ(stats_.num_draft_tokens, 8);
+  EXPECT_EQ(stats_.num_accepted_draft_tokens, 8);
+  EXPECT_EQ(target_->num_steps - 1, 3);
+  // The prefill, 4 proposals, catching up on the last accepted proposal,
+  // then 4 more proposals.
+  EXPECT_EQ(draft_->num_steps, 1 + 4 + 1 + 4);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, AsyncDetokenizationMatchesTargetModel) {
+  auto generator =
+      make_generator(target_next, draft_next, /*num_draft_tokens=*/3);
+  generator->set_async_detokenization(true);
+  const auto tokens = prefill({1, 2, 3});
+
+  std::vector<std::string> pieces;
+  auto res = generator->generate(
+      tokens, 3, /*max_new_tokens=*/20, 0.0f, [&](const std::string& piece) {
+        pieces.push_back(piece);
+      });
+  ASSERT_EQ(res.error(), Error::Ok);
+  EXPECT_EQ(res.get(), 20);
+  // generate() returns only after the last callback.
+  EXPECT_EQ(pieces, greedy(tokens, 20));
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, SamplingWithMatchingDraftAcceptsAll) {
+  auto generator =
+      make_generator(target_next, target_next, /*num_draft_tokens=*/2);
+  const auto tokens = prefill({7});
+
+  auto res = generator->generate(
+      tokens, 1, /*max_new_tokens=*/9, 1.0f, [](const std::string&) {});
+  ASSERT_EQ(res.error(), Error::Ok);
+  EXPECT_EQ(res.get(), 9);
+  EXPECT_GT(stats_.num_draft_tokens, 0);
+  EXPECT_EQ(stats_.num_accepted_draft_tokens, stats_.num_draft_tokens);
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, StopsAtEos) {
+  auto eos_at_8 = [](const std::vector<uint64_t>& history) {
+    return history.size() == 8 ? kEos : target_next(history);
+  };
+  auto generator = make_generator(eos_at_8, target_next, 3);
+  const auto tokens = prefill({1, 2, 3});
+
+  std::vector<std::string> pieces;
+  auto res = generator->generate(
+      tokens, 3, /*max_new_tokens=*/20, 0.0f, [&](const std::string& piece) {
+        pieces.push_back(piece);
+      });
+  ASSERT_EQ(res.error(), Error::Ok);
+  // Tokens 4 to 7 from the target model, then EOS.
+  EXPECT_EQ(res.get(), 5);
+  ASSERT_EQ(pieces.size(), 5);
+  EXPECT_EQ(pieces.back(), std::to_string(kEos));
+}
+
+TEST_F(SpeculativeTokenGeneratorTest, NeedsLogitsForEveryToken) {
+  auto generator = make_generator(
+      target_next, draft_next, /*num_draft_tokens=*/3, /*all_logits=*/false);
+  const auto tokens = prefill({1, 2, 3});
+
+  auto res = generator->generate(
+      tokens, 3, /*max_new_tokens=*/5, 0.0f, [](const std::string&) {});
+  EXPECT_EQ(res.error(), Error::InvalidProgram);
+}
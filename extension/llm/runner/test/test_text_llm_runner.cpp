@@ -15,6 +15,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 using namespace ::testing;
 using executorch::extension::llm::GenerationConfig;
 using executorch::extension::llm::Stats;
@@ -246,6 +248,49 @@ TEST_F(RunnerTest, GenerateCallsCallbackExactlyMaxNewTokensTimes) {
   EXPECT_EQ(err, Error::Ok);
 }
 
+// Test that with async detokenization the generator's tokens reach the
+// callback from another thread, all before generate() returns
+TEST_F(RunnerTest, GenerateWithAsyncDetokenization) {
+  auto tokenizer = createMockTokenizer();
+  auto text_decoder_runner = createMockTextDecoderRunner();
+  auto text_prefiller = createMockTextPrefiller(text_decoder_runner.get());
+  EXPECT_CALL(*text_prefiller, is_loaded()).WillRepeatedly(Return(true));
+
+  std::unique_ptr<executorch::llm::Stats> stats =
+      std::make_unique<executorch::llm::Stats>();
+  auto text_token_generator = createTextTokenGenerator(
+      tokenizer.get(), text_decoder_runner.get(), stats.get());
+
+  TextLLMRunner runner(
+      createDefaultMetadata(),
+      std::unique_ptr<::tokenizers::Tokenizer>(tokenizer.release()),
+      std::make_unique<MockModule>(),
+      std::move(text_decoder_runner),
+      std::unique_ptr<::executorch::extension::llm::TextPrefiller>(
+          text_prefiller.release()),
+      std::move(text_token_generator),
+      std::move(stats));
+  runner.set_async_detokenization(true);
+  runner.load();
+
+  GenerationConfig config;
+  config.max_new_tokens = 10;
+  config.echo = false;
+
+  const auto main_thread = std::this_thread::get_id();
+  int main_thread_calls = 0;
+  CallbackCounter counter;
+  Error err = runner.generate("test prompt", config, [&](const std::string& t) {
+    counter.callback(t);
+    main_thread_calls += std::this_thread::get_id() == main_thread;
+  });
+
+  EXPECT_EQ(err, Error::Ok);
+  EXPECT_EQ(counter.getCount(), config.max_new_tokens);
+  // Only the token from prefill is decoded on the calling thread.
+  EXPECT_EQ(main_thread_calls, 1);
+}
+
 // Test that warmup() calls generate with the warming flag set
 TEST_F(RunnerTest, WarmupCallsGenerateWithWarmingFlag) {
   // Create mock instances using helper functions
@@ -376,3 +421,64 @@ TEST_F(RunnerTest, GenerateFromPosErrorsWithNegativeMaxNewTokens) {
   // Verify that an InvalidArgument error is returned
   EXPECT_EQ(err, Error::InvalidArgument);
 }
+
+// Test that a prompt sharing a cached prefix only prefills the rest of it
+TEST_F(RunnerTest, GenerateRestoresCachedPrefix) {
+  auto tokenizer = createMockTokenizer();
+  auto text_decoder_runner = createMockTextDecoderRunner();
+  auto text_prefiller = createMockTextPrefiller(text_decoder_runner.get());
+
+  EXPECT_CALL(*tokenizer, encode(_, _, _))
+      .WillOnce(Return(::tokenizers::Result<std::vector<uint64_t>>(
+          std::vector<uint64_t>{1, 2, 3})))
+      .WillOnce(Return(::tokenizers::Result<std::vector<uint64_t>>(
+          std::vector<uint64_t>{1, 2, 5, 6})));
+
+  // The second prompt shares the block [1, 2] with the first one.
+  {
+    InSequence seq;
+    EXPECT_CALL(*text_prefiller, prefill(ElementsAre(1, 2, 3), Eq(0)))
+        .WillOnce(Return(Result<uint64_t>(4)));
+    EXPECT_CALL(*text_prefiller, prefill(ElementsAre(5, 6), Eq(2)))
+        .WillOnce(Return(Result<uint64_t>(4)));
+  }
+  EXPECT_CALL(*text_prefiller, is_loaded()).WillRepeatedly(Return(true));
+
+  std::unique_ptr<executorch::llm::Stats> stats =
+      std::make_unique<executorch::llm::Stats>();
+  auto text_token_generator = createTextTokenGenerator(
+      tokenizer.get(), text_decoder_runner.get(), stats.get());
+
+  TextLLMRunner runner(
+      createDefaultMetadata(),
+      std::unique_ptr<::tokenizers::Tokenizer>(tokenizer.release()),
+      std::make_unique<MockModule>(),
+      std::move(text_decoder_runner),
+      std::unique_ptr<::executorch::extension::llm::TextPrefiller>(
+          text_prefiller.release()),
+      std::move(text_token_generator),
+      std::move(stats));
+
+  TensorFactory<executorch::aten::ScalarType::Float> cache_tf;
+  executorch::aten::Tensor kv_cache = cache_tf.zeros({1, 8, 2});
+  runner.set_prefix_cache(
+      std::make_unique<::executorch::extension::llm::PrefixCache>(
+          std::vector<executorch::aten::Tensor>{kv_cache},
+          /*seq_dim=*/1,
+          /*block_size=*/2,
+          /*max_blocks=*/4));
+  runner.load();
+
+  GenerationConfig config;
+  config.max_new_tokens = 2;
+  config.echo = false;
+
+  int64_t hit_tokens = -1;
+  auto stats_callback = [&hit_tokens](const Stats& stats) {
+    hit_tokens = stats.num_prefix_cache_hit_tokens;
+  };
+  EXPECT_EQ(runner.generate("first", config, {}, stats_callback), Error::Ok);
+  EXPECT_EQ(hit_tokens, 0);
+  EXPECT_EQ(runner.generate("second", config, {}, stats_callback), Error::Ok);
+  EXPECT_EQ(hit_tokens, 2);
+}
@@ -14,6 +14,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <numeric>
+
 using namespace ::testing;
 using executorch::extension::llm::TextDecoderRunner;
 using executorch::extension::llm::TextPrefiller;
@@ -157,6 +159,8 @@ TEST_F(
           EXPECT_EQ(tokens[1], 2);
           EXPECT_EQ(tokens[2], 3);
           EXPECT_EQ(pos, 0);
+          // Like prefill_chunk(), advance past the chunk.
+          pos += tokens.size();
           return Result<uint64_t>(10);
         });
 
@@ -168,6 +172,7 @@ TEST_F(
           EXPECT_EQ(tokens[1], 5);
           EXPECT_EQ(tokens[2], 6);
           EXPECT_EQ(pos, 3);
+          pos += tokens.size();
           return Result<uint64_t>(20);
         });
 
@@ -178,6 +183,7 @@ TEST_F(
           EXPECT_EQ(tokens[0], 7);
           EXPECT_EQ(tokens[1], 8);
           EXPECT_EQ(pos, 6);
+          pos += tokens.size();
           return Result<uint64_t>(30);
         });
   }
@@ -213,6 +219,7 @@ TEST_F(TextPrefillerTest, PrefillHandlesEdgeCasesCorrectly) {
           EXPECT_EQ(tokens.size(), 1);
           EXPECT_EQ(tokens[0], 1);
           EXPECT_EQ(pos, 5);
+          pos += tokens.size();
           return Result<uint64_t>(10);
         });
 
@@ -222,6 +229,7 @@ TEST_F(TextPrefillerTest, PrefillHandlesEdgeCasesCorrectly) {
           EXPECT_EQ(tokens.size(), 1);
           EXPECT_EQ(tokens[0], 2);
           EXPECT_EQ(pos, 6);
+          pos += tokens.size();
           return Result<uint64_t>(20);
         });
 
@@ -231,6 +239,7 @@ TEST_F(TextPrefillerTest, PrefillHandlesEdgeCasesCorrectly) {
           EXPECT_EQ(tokens.size(), 1);
           EXPECT_EQ(tokens[0], 3);
           EXPECT_EQ(pos, 7);
+          pos += tokens.size();
           return Result<uint64_t>(30);
         });
   }
@@ -303,3 +312,101 @@ TEST_F(TextPrefillerTest, PrefillChunkWorksWithParallelPrefill) {
   // Verify that start_pos has been updated correctly
   EXPECT_EQ(start_pos, prompt_tokens.size());
 }
+
+// Test that parallel prefill feeds every chunk through the same input tensor
+TEST_F(TextPrefillerTest, PrefillChunkReusesTokenTensor) {
+  auto prefiller = createTextPrefiller(4, true, true);
+
+  std::vector<executorch::aten::TensorImpl*> impls;
+  std::vector<std::vector<int64_t>> inputs;
+  EXPECT_CALL(text_decoder_runner_, step(_, _))
+      .Times(3)
+      .WillRepeatedly([&](executorch::extension::TensorPtr& tokens, int64_t) {
+        impls.push_back(tokens->unsafeGetTensorImpl());
+        const auto* data = tokens->const_data_ptr<int64_t>();
+        inputs.emplace_back(data, data + tokens->numel());
+        return Result<executorch::aten::Tensor>(tensor);
+      });
+
+  std::vector<uint64_t> prompt_tokens = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  int64_t start_pos = 0;
+  auto result = prefiller->prefill(prompt_tokens, start_pos);
+
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_EQ(start_pos, 9);
+  EXPECT_EQ(
+      inputs,
+      std::vector<std::vector<int64_t>>({{1, 2, 3, 4}, {5, 6, 7, 8}, {9}}));
+  EXPECT_EQ(impls[0], impls[1]);
+  EXPECT_EQ(impls[1], impls[2]);
+}
+
+// Test that adaptive chunk sizes follow the measured time per token
+TEST_F(TextPrefillerTest, NextChunkSizeFollowsMeasuredThroughput) {
+  auto prefiller = createTextPrefiller(512);
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 0), 512);
+
+  prefiller->set_target_chunk_ms(10.0, /*min_chunk_size=*/8);
+  // Nothing measured yet: calibrate with the smallest chunk.
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 0), 8);
+  EXPECT_EQ(prefiller->next_chunk_size(5, 0), 5);
+
+  // Per token, 0.1 ms plus 0.001 ms per cached position, so at position p
+  // n tokens take n * (0.1 + 0.001 * p) + 0.0005 * n^2 ms. One chunk says
+  // nothing about the position yet.
+  prefiller->record_chunk(8, 0, 8 * (0.1 + 0.001 * 3.5));
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 8), 96);
+
+  // Two do: chunks get smaller as the cache fills.
+  prefiller->record_chunk(101, 100, 101 * (0.1 + 0.001 * 150));
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 0), 73);
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 1000), 9);
+  // Never below the minimum, or above max_seq_len.
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 100000), 8);
+  prefiller->set_target_chunk_ms(1e6, 8);
+  EXPECT_EQ(prefiller->next_chunk_size(1000, 0), 512);
+}
+
+// Test that adaptive prefill chunks prompts that fit in max_seq_len, and calls
+// the chunk callback between chunks
+TEST_F(TextPrefillerTest, AdaptivePrefillChunksAndCallsChunkCallback) {
+  auto prefiller = createMockTextPrefiller(64);
+  prefiller->set_target_chunk_ms(1e6, /*min_chunk_size=*/4);
+  int callbacks = 0;
+  prefiller->set_chunk_callback([&callbacks]() {
+    callbacks++;
+    return Error::Ok;
+  });
+
+  std::vector<size_t> sizes;
+  EXPECT_CALL(*prefiller, prefill_chunk(_, _))
+      .WillRepeatedly([&](std::vector<uint64_t>& tokens, int64_t& pos) {
+        EXPECT_EQ(pos, 10 + std::accumulate(sizes.begin(), sizes.end(), 0));
+        EXPECT_EQ(static_cast<int64_t>(tokens[0]), pos - 10);
+        sizes.push_back(tokens.size());
+        pos += tokens.size();
+        return Result<uint64_t>(pos);
+      });
+
+  std::vector<uint64_t> prompt_tokens(30);
+  std::iota(prompt_tokens.begin(), prompt_tokens.end(), 0);
+  int64_t start_pos = 10;
+  auto result = prefiller->prefill(prompt_tokens, start_pos);
+
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_EQ(result.get(), 40);
+  EXPECT_EQ(start_pos, 40);
+  // The first chunk calibrates; a chunk that fast lets the second one take
+  // the rest.
+  EXPECT_EQ(sizes, std::vector<size_t>({4, 26}));
+  EXPECT_EQ(callbacks, 1);
+
+  // An error from the callback stops the prefill.
+  prefiller->set_target_chunk_ms(1e-9, /*min_chunk_size=*/4);
+  prefiller->set_chunk_callback([]() { return Error::Internal; });
+  sizes.clear();
+  start_pos = 10;
+  EXPECT_EQ(
+      prefiller->prefill(prompt_tokens, start_pos).error(), Error::Internal);
+  EXPECT_EQ(sizes, std::vector<size_t>({4}));
+}
@@ -99,6 +99,39 @@ TextDecoderRunner::TextDecoderRunner(Module* module) : module_(module) {}
   }
 }
 
+::executorch::runtime::Result<executorch::aten::Tensor>
+TextDecoderRunner::step_batch(
+    TensorPtr& tokens,
+    TensorPtr& positions,
+    TensorPtr* block_table) {
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens->dim() == 2 && tokens->size(1) == 1,
+      InvalidArgument,
+      "Batched decoding takes one token per sequence, got %zu dims",
+      (size_t)tokens->dim());
+  ET_CHECK_OR_RETURN_ERROR(
+      positions->dim() == 1 && positions->size(0) == tokens->size(0),
+      InvalidArgument,
+      "Expected one position per sequence");
+  auto method_meta = ET_UNWRAP(module_->method_meta("forward"));
+  ET_CHECK_OR_RETURN_ERROR(
+      method_meta.num_inputs() > 1,
+      InvalidProgram,
+      "Batched decoding requires a model with a KV cache");
+
+  auto outputs_res = block_table != nullptr
+      ? module_->forward({tokens, positions, *block_table})
+      : module_->forward({tokens, positions});
+  ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+  ET_CHECK_MSG(
+      outputs_res.get().size() == 1,
+      "More then one output returned from executing LLM.");
+  ET_CHECK_MSG(
+      outputs_res.get()[0].isTensor(),
+      "Non Tensor Output returned from executing LLM");
+  return outputs_res.get()[0].toTensor();
+}
+
 } // namespace llm
 } // namespace extension
 } // namespace executorch
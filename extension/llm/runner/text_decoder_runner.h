@@ -36,6 +36,25 @@ class ET_EXPERIMENTAL TextDecoderRunner {
       TensorPtr& input,
       int64_t start_pos);
 
+  /**
+   * Run LLM text decoder on a batch of independent sequences, one token each.
+   * Requires a Module exported with a batch dimension and per-row input
+   * positions, e.g. one using llama::custom_sdpa_with_positions and
+   * llama::update_cache_with_indices.
+   * @param tokens The input tokens, of shape [batch, 1].
+   * @param positions The position in KV cache of each row's token, of shape
+   * [batch].
+   * @param block_table For a Module exported with a paged KV cache, the
+   * [batch, max_blocks_per_seq] block table, passed as a third input; see
+   * KVCacheBlockAllocator. Null otherwise.
+   * @return The output of the LLM Module. This will be a tensor of logits
+   * with one row per sequence; see logits_to_token().
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor> step_batch(
+      TensorPtr& tokens,
+      TensorPtr& positions,
+      TensorPtr* block_table = nullptr);
+
   /**
    * Load the Module for text decode purpose.
    * @return The error code.
@@ -61,11 +80,13 @@ class ET_EXPERIMENTAL TextDecoderRunner {
    * @param logits_tensor The logits tensor.
    * @param temperature The temperature parameter used to control randomness in
    * sampling.
+   * @param batch_index Which row of batched logits to sample from.
    * @return The next token.
    */
   inline int32_t logits_to_token(
       const executorch::aten::Tensor& logits_tensor,
-      const float temperature = 0.0f) {
+      const float temperature = 0.0f,
+      const int32_t batch_index = 0) {
     int32_t result = 0;
     ET_SWITCH_THREE_TYPES(
         Float,
@@ -81,6 +102,14 @@ class ET_EXPERIMENTAL TextDecoderRunner {
           // outputs the last logit, directly sample and return.
           auto* logits = logits_tensor.mutable_data_ptr<CTYPE>();
           ssize_t vocab_size = logits_tensor.size(logits_tensor.dim() - 1);
+          if (batch_index > 0) {
+            ET_CHECK_MSG(
+                logits_tensor.dim() > 1 && batch_index < logits_tensor.size(0),
+                "batch_index %d is out of range",
+                (int)batch_index);
+            logits += batch_index *
+                (logits_tensor.numel() / logits_tensor.size(0));
+          }
           if (logits_tensor.dim() == 3) {
             auto num_tokens = logits_tensor.size(1);
             logits += (num_tokens - 1) * vocab_size;
@@ -10,6 +10,7 @@
 // A simple llama2 runner that includes preprocessing and post processing logic.
 // The module takes in a string as input and emits a string as output.
 
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
 #include <executorch/extension/llm/runner/text_llm_runner.h>
 #include <executorch/extension/llm/runner/util.h>
 #include <executorch/runtime/platform/runtime.h>
@@ -116,10 +117,11 @@ Error TextLLMRunner::generate_from_pos(
   stats_->inference_start_ms = time_in_ms();
   shouldStop_ = false;
 
-  ::tokenizers::Result<std::vector<uint64_t>> encode_res = tokenizer_->encode(
-      prompt,
-      /*bos=*/config.num_bos,
-      /*eos=*/config.num_eos);
+  ::tokenizers::Result<std::vector<uint64_t>> encode_res = parallel_encoder_
+      ? parallel_encoder_->encode(
+            prompt, /*bos=*/config.num_bos, /*eos=*/config.num_eos)
+      : tokenizer_->encode(
+            prompt, /*bos=*/config.num_bos, /*eos=*/config.num_eos);
 
   ET_CHECK_TK_OK_OR_RETURN_ERROR(
       encode_res.error(), "Failed to encode prompt %s", prompt.c_str());
@@ -169,9 +171,33 @@ Error TextLLMRunner::generate_from_pos(
     wrapped_callback(prompt);
   }
   int64_t pos = start_pos;
-  auto prefill_res = text_prefiller_->prefill(prompt_tokens, pos);
+  // A cached prefix is only valid for a prompt that starts the sequence.
+  const bool use_prefix_cache = prefix_cache_ != nullptr && start_pos == 0;
+  int64_t num_cached_tokens = 0;
+  stats_->prefix_cache_restore_ms = 0;
+  stats_->prefix_cache_saved_ms = 0;
+  if (use_prefix_cache) {
+    const long restore_start_ms = time_in_ms();
+    num_cached_tokens = prefix_cache_->restore(prompt_tokens);
+    stats_->prefix_cache_restore_ms = time_in_ms() - restore_start_ms;
+    pos += num_cached_tokens;
+  }
+  stats_->num_prefix_cache_hit_tokens = num_cached_tokens;
+  std::vector<uint64_t> uncached_tokens(
+      prompt_tokens.begin() + num_cached_tokens, prompt_tokens.end());
+  const long prefill_start_ms = time_in_ms();
+  auto prefill_res = text_prefiller_->prefill(uncached_tokens, pos);
   ET_CHECK_OK_OR_RETURN_ERROR(prefill_res.error());
   uint64_t cur_token = prefill_res.get();
+  if (use_prefix_cache) {
+    prefix_cache_->record_prefill(
+        uncached_tokens.size(), time_in_ms() - prefill_start_ms);
+    if (num_cached_tokens > 0) {
+      stats_->prefix_cache_saved_ms = static_cast<long>(
+          prefix_cache_->estimate_prefill_ms(num_cached_tokens) -
+          stats_->prefix_cache_restore_ms);
+    }
+  }
   stats_->first_token_ms = time_in_ms();
   stats_->prompt_eval_end_ms = time_in_ms();
 
@@ -195,6 +221,11 @@ Error TextLLMRunner::generate_from_pos(
       wrapped_callback));
 
   stats_->inference_end_ms = time_in_ms();
+  if (use_prefix_cache) {
+    // Generation only wrote positions past the prompt, so the cache still
+    // holds the prompt at [0, num_prompt_tokens).
+    prefix_cache_->insert(prompt_tokens, num_prompt_tokens);
+  }
   if (!config.warming) {
     printf("\n");
   }
@@ -425,4 +456,125 @@ std::unique_ptr<TextLLMRunner> create_text_llm_runner(
       temperature);
 }
 
+namespace {
+
+// The vocabulary size of a model: the last dimension of its logits.
+Result<int64_t> logits_vocab_size(Module* module) {
+  auto method_meta = ET_UNWRAP(module->method_meta("forward"));
+  auto logits_meta = ET_UNWRAP(method_meta.output_tensor_meta(0));
+  ET_CHECK_OR_RETURN_ERROR(
+      !logits_meta.sizes().empty(), InvalidProgram, "Logits have no sizes");
+  return logits_meta.sizes()[logits_meta.sizes().size() - 1];
+}
+
+} // namespace
+
+Result<std::unique_ptr<TextLLMRunner>> create_speculative_text_llm_runner(
+    const std::string& model_path,
+    const std::string& draft_model_path,
+    std::unique_ptr<::tokenizers::Tokenizer> tokenizer,
+    int32_t num_draft_tokens,
+    std::optional<const std::string> data_path,
+    float temperature) {
+  // Sanity check tokenizer
+  ET_CHECK_OR_RETURN_ERROR(
+      tokenizer && tokenizer->is_loaded(),
+      InvalidArgument,
+      "Tokenizer is null or not loaded");
+  ET_CHECK_OR_RETURN_ERROR(
+      num_draft_tokens > 0,
+      InvalidArgument,
+      "num_draft_tokens must be positive");
+
+  // Create the Modules
+  std::unique_ptr<Module> module;
+  if (data_path.has_value()) {
+    module = std::make_unique<Module>(
+        model_path, data_path.value(), Module::LoadMode::File);
+  } else {
+    module = std::make_unique<Module>(model_path, Module::LoadMode::File);
+  }
+  auto draft_module =
+      std::make_unique<Module>(draft_model_path, Module::LoadMode::File);
+
+  // Get metadata from the Modules
+  ET_LOG(Info, "Reading metadata from model");
+  auto metadata = llm::get_llm_metadata(tokenizer.get(), module.get());
+  ET_LOG(Info, "Reading metadata from draft model");
+  auto draft_metadata =
+      llm::get_llm_metadata(tokenizer.get(), draft_module.get());
+  ET_CHECK_OR_RETURN_ERROR(
+      metadata.at(kUseKVCache) && draft_metadata.at(kUseKVCache),
+      InvalidArgument,
+      "Speculative decoding needs models with a KV cache");
+  ET_CHECK_OR_RETURN_ERROR(
+      metadata.at(kEnableDynamicShape),
+      InvalidArgument,
+      "Speculative decoding needs a target model with dynamic shapes");
+  ET_CHECK_OR_RETURN_ERROR(
+      draft_metadata.at(kMaxSeqLen) == metadata.at(kMaxSeqLen),
+      InvalidArgument,
+      "Draft model max_seq_len %" PRId64 " does not match the model's %" PRId64,
+      draft_metadata.at(kMaxSeqLen),
+      metadata.at(kMaxSeqLen));
+  // The draft model runs at the same positions as the target model.
+  ET_CHECK_OR_RETURN_ERROR(
+      draft_metadata.at(kMaxContextLen) >= metadata.at(kMaxContextLen),
+      InvalidArgument,
+      "Draft model max_context_len %" PRId64
+      " is less than the model's %" PRId64,
+      draft_metadata.at(kMaxContextLen),
+      metadata.at(kMaxContextLen));
+  // Proposals are scored by token id, so both models must produce logits
+  // over the same vocabulary.
+  const auto vocab_size = ET_UNWRAP(logits_vocab_size(module.get()));
+  const auto draft_vocab_size =
+      ET_UNWRAP(logits_vocab_size(draft_module.get()));
+  ET_CHECK_OR_RETURN_ERROR(
+      draft_vocab_size == vocab_size,
+      InvalidArgument,
+      "Draft model vocab size %" PRId64 " does not match the model's %" PRId64,
+      draft_vocab_size,
+      vocab_size);
+
+  auto eos_ids = std::make_unique<std::unordered_set<uint64_t>>(
+      llm::get_eos_ids(tokenizer.get(), module.get()));
+
+  auto text_decoder_runner = std::make_unique<TextDecoderRunner>(module.get());
+  auto text_prefiller = std::make_unique<TextPrefiller>(
+      text_decoder_runner.get(),
+      metadata.at(kUseKVCache),
+      metadata.at(kEnableDynamicShape),
+      metadata.at(kMaxSeqLen));
+
+  auto draft_decoder_runner =
+      std::make_unique<TextDecoderRunner>(draft_module.get());
+  auto draft_prefiller = std::make_unique<TextPrefiller>(
+      draft_decoder_runner.get(),
+      draft_metadata.at(kUseKVCache),
+      draft_metadata.at(kEnableDynamicShape),
+      draft_metadata.at(kMaxSeqLen));
+
+  auto stats = std::make_unique<Stats>();
+  auto text_token_generator = std::make_unique<SpeculativeTokenGenerator>(
+      tokenizer.get(),
+      text_decoder_runner.get(),
+      std::move(draft_module),
+      std::move(draft_decoder_runner),
+      std::move(draft_prefiller),
+      num_draft_tokens,
+      std::move(eos_ids),
+      stats.get());
+
+  return std::make_unique<TextLLMRunner>(
+      std::move(metadata),
+      std::move(tokenizer),
+      std::move(module),
+      std::move(text_decoder_runner),
+      std::move(text_prefiller),
+      std::move(text_token_generator),
+      std::move(stats),
+      temperature);
+}
+
 } // namespace executorch::extension::llm
@@ -18,6 +18,8 @@
 #include <unordered_map>
 
 #include <executorch/extension/llm/runner/irunner.h>
+#include <executorch/extension/llm/runner/parallel_encoder.h>
+#include <executorch/extension/llm/runner/prefix_cache.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/runner/text_prefiller.h>
@@ -141,6 +143,52 @@ class ET_EXPERIMENTAL TextLLMRunner : public IRunner {
    */
   void stop() override;
 
+  /**
+   * @brief Reuses the KV cache of prompt prefixes across generate() calls
+   *
+   * When set, generation from position 0 restores the longest cached prefix
+   * of the prompt and only prefills the rest, then caches the prompt for the
+   * next call. Hit tokens and time saved are reported in Stats.
+   *
+   * @param prefix_cache A cache over this runner's Module, e.g. from
+   * create_prefix_cache(). Null disables prefix caching.
+   */
+  void set_prefix_cache(std::unique_ptr<PrefixCache> prefix_cache) {
+    prefix_cache_ = std::move(prefix_cache);
+  }
+
+  /**
+   * @brief Encodes long prompts on several threads
+   *
+   * Only exact for tokenizers that never merge text across a line start,
+   * like tiktoken and byte-level BPE; see ParallelEncoder. Off by default.
+   *
+   * @param enabled Whether to encode prompts in parallel.
+   * @param min_chunk_size Prompts shorter than two chunks of this many bytes
+   * are encoded on the calling thread.
+   * @param max_threads Maximum number of threads. 0 uses the number of
+   * hardware threads.
+   */
+  void set_parallel_encoding(
+      bool enabled,
+      size_t min_chunk_size = ParallelEncoder::kDefaultMinChunkSize,
+      size_t max_threads = 0) {
+    parallel_encoder_ = enabled
+        ? std::make_unique<ParallelEncoder>(
+              tokenizer_.get(), min_chunk_size, max_threads)
+        : nullptr;
+  }
+
+  /**
+   * @brief Decodes generated tokens and calls the token callback on a
+   * separate thread
+   *
+   * See TextTokenGenerator::set_async_detokenization(). Off by default.
+   */
+  void set_async_detokenization(bool enabled) {
+    text_token_generator_->set_async_detokenization(enabled);
+  }
+
  private:
   bool shouldStop_{false};
 
@@ -156,6 +204,8 @@ class ET_EXPERIMENTAL TextLLMRunner : public IRunner {
                             // text_token_generator_.
   std::unique_ptr<TextPrefiller> text_prefiller_;
   std::unique_ptr<TextTokenGenerator> text_token_generator_;
+  std::unique_ptr<PrefixCache> prefix_cache_;
+  std::unique_ptr<ParallelEncoder> parallel_encoder_;
 
   // Stats
   std::unique_ptr<Stats> stats_;
@@ -206,4 +256,35 @@ ET_EXPERIMENTAL std::unique_ptr<TextLLMRunner> create_text_llm_runner(
     std::optional<const std::string> data_path = std::nullopt,
     float temperature = -1.0f);
 
+/**
+ * @brief Creates a TextLLMRunner that decodes with speculative decoding
+ *
+ * Like create_text_llm_runner(), but a draft model proposes tokens that the
+ * model at model_path verifies several at a time; see
+ * SpeculativeTokenGenerator. The model must be exported with a dynamic
+ * sequence length and return the logits of every input token. Both models
+ * must use a KV cache, share the tokenizer and vocabulary, and have the same
+ * max_seq_len, and the draft model's max_context_len must cover the model's.
+ *
+ * @param model_path Path to the target model file
+ * @param draft_model_path Path to the draft model file
+ * @param tokenizer Initialized tokenizer instance
+ * @param num_draft_tokens Maximum number of tokens the draft model proposes
+ * per target model step
+ * @param data_path Optional path to additional data required by the target
+ * model
+ * @param temperature Optional temperature parameter for controlling randomness
+ * (deprecated)
+ * @return The initialized TextLLMRunner, or Error::InvalidArgument if the
+ * arguments or models are not suitable
+ */
+ET_EXPERIMENTAL ::executorch::runtime::Result<std::unique_ptr<TextLLMRunner>>
+create_speculative_text_llm_runner(
+    const std::string& model_path,
+    const std::string& draft_model_path,
+    std::unique_ptr<::tokenizers::Tokenizer> tokenizer,
+    int32_t num_draft_tokens = 4,
+    std::optional<const std::string> data_path = std::nullopt,
+    float temperature = -1.0f);
+
 } // namespace executorch::extension::llm
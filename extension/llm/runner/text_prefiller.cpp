@@ -11,11 +11,21 @@
 
 #include <executorch/extension/llm/runner/text_prefiller.h>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 namespace executorch {
 namespace extension {
 namespace llm {
 
+namespace {
+
+// Weight kept by earlier chunks each time a chunk is recorded, so the
+// estimate follows changes in load.
+constexpr double kDecay = 0.75;
+
+} // namespace
+
 TextPrefiller::TextPrefiller(
     TextDecoderRunner* text_decoder_runner,
     bool use_kv_cache,
@@ -24,7 +34,14 @@ TextPrefiller::TextPrefiller(
     : text_decoder_runner_(text_decoder_runner),
       use_kv_cache_(use_kv_cache),
       enable_parallel_prefill_(enable_parallel_prefill),
-      max_seq_len_(max_seq_len > 0 ? max_seq_len : 128) {}
+      max_seq_len_(max_seq_len > 0 ? max_seq_len : 128),
+      token_data_(max_seq_len_) {
+  tokens_ = from_blob(
+      token_data_.data(),
+      {1, static_cast<executorch::aten::SizesType>(max_seq_len_)},
+      executorch::aten::ScalarType::Long);
+  chunk_tokens_.reserve(max_seq_len_);
+}
 
 ::executorch::runtime::Result<uint64_t> TextPrefiller::prefill(
     std::vector<uint64_t>& prompt_tokens,
@@ -34,40 +51,43 @@ TextPrefiller::TextPrefiller(
     ET_CHECK_OK_OR_RETURN_ERROR(text_decoder_runner_->load());
   }
 
-  // Check if we need to chunk the prompt tokens
-  int32_t num_prompt_tokens = prompt_tokens.size();
-
-  // If prompt tokens exceed max_seq_len_, we need to chunk them
-  if (num_prompt_tokens > max_seq_len_) {
-    uint64_t cur_token = 0;
-    int num_tokens_to_process = 0;
+  const int64_t num_prompt_tokens = prompt_tokens.size();
+  const bool adaptive = target_chunk_ms_ > 0;
 
-    while (num_tokens_to_process < num_prompt_tokens) {
-      auto num_tokens_to_prefill_with = std::min<int>(
-          num_prompt_tokens - num_tokens_to_process, max_seq_len_);
+  // If prompt tokens don't exceed max_seq_len_, process them directly
+  if (!adaptive && num_prompt_tokens <= max_seq_len_) {
+    return prefill_chunk(prompt_tokens, start_pos);
+  }
 
-      std::vector<uint64_t> prompt_tokens_to_process(
-          num_tokens_to_prefill_with);
-      std::copy(
-          prompt_tokens.begin() + num_tokens_to_process,
-          prompt_tokens.begin() + num_tokens_to_process +
-              num_tokens_to_prefill_with,
-          prompt_tokens_to_process.begin());
-
-      // Process this chunk
-      auto chunk_result = prefill_chunk(prompt_tokens_to_process, start_pos);
-      ET_CHECK_OK_OR_RETURN_ERROR(chunk_result.error());
-      cur_token = chunk_result.get();
-
-      start_pos += num_tokens_to_prefill_with;
-      num_tokens_to_process += num_tokens_to_prefill_with;
+  uint64_t cur_token = 0;
+  int64_t num_prefilled = 0;
+  while (num_prefilled < num_prompt_tokens) {
+    if (num_prefilled > 0 && chunk_callback_) {
+      ET_CHECK_OK_OR_RETURN_ERROR(chunk_callback_());
     }
-
-    return cur_token;
-  } else {
-    // If prompt tokens don't exceed max_seq_len_, process them directly
-    return prefill_chunk(prompt_tokens, start_pos);
+    const int64_t chunk_size =
+        next_chunk_size(num_prompt_tokens - num_prefilled, start_pos);
+    chunk_tokens_.assign(
+        prompt_tokens.begin() + num_prefilled,
+        prompt_tokens.begin() + num_prefilled + chunk_size);
+
+    // Process this chunk. It advances start_pos.
+    const int64_t chunk_start_pos = start_pos;
+    const auto chunk_begin = std::chrono::steady_clock::now();
+    auto chunk_result = prefill_chunk(chunk_tokens_, start_pos);
+    ET_CHECK_OK_OR_RETURN_ERROR(chunk_result.error());
+    if (adaptive) {
+      record_chunk(
+          chunk_size,
+          chunk_start_pos,
+          std::chrono::duration<double, std::milli>(
+              std::chrono::steady_clock::now() - chunk_begin)
+              .count());
+    }
+    cur_token = chunk_result.get();
+    num_prefilled += chunk_size;
   }
+  return cur_token;
 }
 
 ::executorch::runtime::Result<uint64_t> TextPrefiller::prefill_chunk(
@@ -80,13 +100,23 @@ TextPrefiller::TextPrefiller(
   // store the token
   uint64_t cur_token;
   if (enable_parallel_prefill_ || !use_kv_cache_) {
-    // initialize tensor wrappers
-    auto tokens = from_blob(
-        prompt_tokens.data(),
-        {1, num_prompt_tokens},
-        executorch::aten::ScalarType::Long);
+    // Chunks that fit reuse the input tensor; longer ones get their own.
+    TensorPtr* tokens = &tokens_;
+    TensorPtr long_tokens;
+    if (num_prompt_tokens <= max_seq_len_) {
+      std::copy(
+          prompt_tokens.begin(), prompt_tokens.end(), token_data_.begin());
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          resize_tensor_ptr(tokens_, {1, num_prompt_tokens}));
+    } else {
+      long_tokens = from_blob(
+          prompt_tokens.data(),
+          {1, num_prompt_tokens},
+          executorch::aten::ScalarType::Long);
+      tokens = &long_tokens;
+    }
 
-    auto outputs_res = text_decoder_runner_->step(tokens, start_pos);
+    auto outputs_res = text_decoder_runner_->step(*tokens, start_pos);
 
     ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
     ET_LOG(
@@ -96,17 +126,14 @@ TextPrefiller::TextPrefiller(
     cur_token = text_decoder_runner_->logits_to_token(outputs_res.get());
   } else { // sequential prefill
     int64_t pos = 0; // position in the sequence
+    ET_CHECK_OK_OR_RETURN_ERROR(resize_tensor_ptr(tokens_, {1, 1}));
     // NOLINTNEXTLINE(facebook-hte-ParameterUncheckedArrayBounds)
-    cur_token = prompt_tokens[0];
-
-    // initialize tensor wrappers
-    auto tokens =
-        from_blob(&cur_token, {1, 1}, executorch::aten::ScalarType::Long);
+    token_data_[0] = prompt_tokens[0];
 
     // run the first token and get back logits tensor. Assuming the first token
     // is bos so don't callback.
     auto logits_tensor =
-        ET_UNWRAP(text_decoder_runner_->step(tokens, start_pos));
+        ET_UNWRAP(text_decoder_runner_->step(tokens_, start_pos));
 
     pos += 1; // start the loop from index 1
     start_pos += 1;
@@ -114,9 +141,10 @@ TextPrefiller::TextPrefiller(
     while (pos < num_prompt_tokens) {
       // Run the model
       // NOLINTNEXTLINE(facebook-hte-ParameterUncheckedArrayBounds)
-      cur_token = prompt_tokens[pos];
+      token_data_[0] = prompt_tokens[pos];
 
-      logits_tensor = ET_UNWRAP(text_decoder_runner_->step(tokens, start_pos));
+      logits_tensor =
+          ET_UNWRAP(text_decoder_runner_->step(tokens_, start_pos));
 
       pos++;
       start_pos++;
@@ -127,6 +155,65 @@ TextPrefiller::TextPrefiller(
   return cur_token;
 }
 
+void TextPrefiller::set_target_chunk_ms(
+    double target_chunk_ms,
+    int64_t min_chunk_size) {
+  target_chunk_ms_ = target_chunk_ms;
+  min_chunk_size_ = std::max<int64_t>(min_chunk_size, 1);
+}
+
+int64_t TextPrefiller::next_chunk_size(int64_t num_remaining, int64_t start_pos)
+    const {
+  if (target_chunk_ms_ <= 0) {
+    return std::min(num_remaining, max_seq_len_);
+  }
+  int64_t chunk_size = min_chunk_size_;
+  if (sum_weight_ > 0) {
+    const double mean_pos = sum_pos_ / sum_weight_;
+    const double mean_ms = sum_ms_ / sum_weight_;
+    const double var_pos = sum_pos_pos_ / sum_weight_ - mean_pos * mean_pos;
+    const double cov = sum_pos_ms_ / sum_weight_ - mean_pos * mean_ms;
+    // Attention gets slower as the cache fills, never faster; a negative
+    // slope is noise.
+    double slope = 0.0;
+    if (var_pos > 1e-6 * (mean_pos * mean_pos + 1)) {
+      slope = std::max(cov / var_pos, 0.0);
+    }
+    // Time per token at the start of the chunk. Over a chunk of n tokens it
+    // grows by slope * n, so the chunk takes n * (ms + slope * n / 2).
+    const double ms = mean_ms + slope * (start_pos - mean_pos);
+    double size;
+    if (ms <= 0) {
+      size = static_cast<double>(max_seq_len_);
+    } else if (slope > 0) {
+      size = (std::sqrt(ms * ms + 2 * slope * target_chunk_ms_) - ms) / slope;
+    } else {
+      size = target_chunk_ms_ / ms;
+    }
+    chunk_size = static_cast<int64_t>(
+        std::min(size, static_cast<double>(max_seq_len_)));
+  }
+  chunk_size = std::max(std::min(chunk_size, max_seq_len_), min_chunk_size_);
+  return std::min(chunk_size, num_remaining);
+}
+
+void TextPrefiller::record_chunk(
+    int64_t num_tokens,
+    int64_t start_pos,
+    double elapsed_ms) {
+  if (num_tokens <= 0) {
+    return;
+  }
+  // Attributed to the middle of the chunk.
+  const double pos = start_pos + (num_tokens - 1) / 2.0;
+  const double ms = elapsed_ms / num_tokens;
+  sum_weight_ = sum_weight_ * kDecay + 1;
+  sum_pos_ = sum_pos_ * kDecay + pos;
+  sum_ms_ = sum_ms_ * kDecay + ms;
+  sum_pos_pos_ = sum_pos_pos_ * kDecay + pos * pos;
+  sum_pos_ms_ = sum_pos_ms_ * kDecay + pos * ms;
+}
+
 } // namespace llm
 } // namespace extension
 } // namespace executorch
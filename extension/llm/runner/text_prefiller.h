@@ -11,7 +11,11 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/tensor/tensor.h>
 
 namespace executorch {
 namespace extension {
@@ -19,6 +23,8 @@ namespace llm {
 
 class ET_EXPERIMENTAL TextPrefiller {
  public:
+  static constexpr int64_t kDefaultMinChunkSize = 16;
+
   TextPrefiller(
       TextDecoderRunner* text_decoder_runner,
       bool use_kv_cache,
@@ -49,6 +55,46 @@ class ET_EXPERIMENTAL TextPrefiller {
       std::vector<uint64_t>& prompt_tokens,
       int64_t& start_pos);
 
+  /**
+   * Sizes prefill chunks by time instead of always using max_seq_len. Each
+   * chunk gets as many tokens as are predicted to run in `target_chunk_ms`,
+   * from the time per token measured on earlier chunks and how it grows with
+   * the KV cache position. This bounds how long a single chunk blocks, e.g.
+   * the chunk callback, however long the prompt is. Prompts are then chunked
+   * even if they fit in max_seq_len, which needs a Module exported with
+   * dynamic shapes.
+   *
+   * @param target_chunk_ms Target duration of a chunk. 0 disables adaptive
+   * sizing.
+   * @param min_chunk_size Smallest chunk, except for the end of a prompt.
+   * Also the size of the first chunk, which calibrates the estimate.
+   */
+  void set_target_chunk_ms(
+      double target_chunk_ms,
+      int64_t min_chunk_size = kDefaultMinChunkSize);
+
+  /**
+   * Sets a function to call between two chunks of a prompt, e.g. to run a
+   * decode step of another sequence, so that ongoing generations keep going
+   * while a long prompt is prefilled. An error from it aborts the prefill.
+   */
+  void set_chunk_callback(std::function<::executorch::runtime::Error()> fn) {
+    chunk_callback_ = std::move(fn);
+  }
+
+  /**
+   * The size of the next chunk to prefill, out of `num_remaining` tokens
+   * starting at KV cache position `start_pos`.
+   */
+  int64_t next_chunk_size(int64_t num_remaining, int64_t start_pos) const;
+
+  /**
+   * Records that prefilling `num_tokens` tokens at KV cache position
+   * `start_pos` took `elapsed_ms`. prefill() calls this for every chunk when
+   * adaptive sizing is on.
+   */
+  void record_chunk(int64_t num_tokens, int64_t start_pos, double elapsed_ms);
+
   /**
    * Load the necessary resources for the TextPrefiller.
    * This method should be called before using the prefill methods.
@@ -77,6 +123,26 @@ class ET_EXPERIMENTAL TextPrefiller {
   bool use_kv_cache_;
   bool enable_parallel_prefill_;
   int64_t max_seq_len_;
+
+  // Input buffer and the tensor over it, sized for max_seq_len_ tokens and
+  // reused across chunks.
+  std::vector<uint64_t> token_data_;
+  TensorPtr tokens_;
+  // The chunk of the prompt passed to prefill_chunk(), reused across chunks.
+  std::vector<uint64_t> chunk_tokens_;
+
+  std::function<::executorch::runtime::Error()> chunk_callback_;
+
+  // Adaptive chunk sizing. Time per token is modeled as a + b * position,
+  // fitted by least squares over exponentially decaying sums of the
+  // recorded chunks.
+  double target_chunk_ms_ = 0.0;
+  int64_t min_chunk_size_ = kDefaultMinChunkSize;
+  double sum_weight_ = 0.0;
+  double sum_pos_ = 0.0;
+  double sum_ms_ = 0.0;
+  double sum_pos_pos_ = 0.0;
+  double sum_pos_ms_ = 0.0;
 };
 
 } // namespace llm
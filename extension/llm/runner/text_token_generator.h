@@ -9,6 +9,10 @@
 // Generate tokens in a loop.
 #pragma once
 
+#include <atomic>
+#include <memory>
+
+#include <executorch/extension/llm/runner/async_detokenizer.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/tensor/tensor.h>
@@ -48,7 +52,7 @@ class ET_EXPERIMENTAL TextTokenGenerator {
    * @param token_callback what to do after a token is generated.
    * @return how many tokens are generated.
    */
-  inline ::executorch::runtime::Result<int64_t> generate(
+  virtual ::executorch::runtime::Result<int64_t> generate(
       std::vector<uint64_t> tokens,
       int64_t start_pos,
       int32_t max_new_tokens,
@@ -81,6 +85,12 @@ class ET_EXPERIMENTAL TextTokenGenerator {
 
     should_stop_ = false;
 
+    std::unique_ptr<AsyncDetokenizer> detokenizer;
+    if (async_detokenization_) {
+      detokenizer =
+          std::make_unique<AsyncDetokenizer>(tokenizer_, token_callback);
+    }
+
     // Generate our tokens
     while (pos < start_pos + max_new_tokens) {
       // Run the model
@@ -110,8 +120,12 @@ class ET_EXPERIMENTAL TextTokenGenerator {
       }
 
       // print the token as string, decode it with the Tokenizer object
-      token_callback(
-          ET_UNWRAP_TOKENIZER(tokenizer_->decode(prev_token, cur_token)));
+      if (detokenizer) {
+        detokenizer->push(prev_token, cur_token);
+      } else {
+        token_callback(
+            ET_UNWRAP_TOKENIZER(tokenizer_->decode(prev_token, cur_token)));
+      }
 
       if (should_stop_) {
         break;
@@ -119,26 +133,44 @@ class ET_EXPERIMENTAL TextTokenGenerator {
 
       // data-dependent terminating condition: we have n_eos_ number of EOS
       if (eos_ids_->find(cur_token) != eos_ids_->end()) {
+        if (detokenizer) {
+          ET_CHECK_OK_OR_RETURN_ERROR(detokenizer->finish());
+        }
         printf("\n");
         ET_LOG(Info, "\nReached to the end of generation");
         break;
       }
     }
+    if (detokenizer) {
+      ET_CHECK_OK_OR_RETURN_ERROR(detokenizer->finish());
+    }
     return pos - start_pos;
   }
 
   /**
-   * Stop the generation loop.
+   * Stop the generation loop. Safe to call from the token callback, also
+   * with asynchronous detokenization, where it takes effect a few steps
+   * late.
    */
   inline void stop() {
     should_stop_ = true;
   }
 
+  /**
+   * Decode tokens and call the token callback on a separate thread, so
+   * neither sits between two steps of the model. The callback then receives
+   * whole UTF-8 characters and may get fewer calls than there are tokens.
+   * generate() returns only after the last callback. Off by default.
+   */
+  void set_async_detokenization(bool enabled) {
+    async_detokenization_ = enabled;
+  }
+
   /**
    * Load the necessary resources for TextTokenGenerator.
    * This method should be called before using the generate() method.
    */
-  ::executorch::runtime::Error load() {
+  virtual ::executorch::runtime::Error load() {
     return text_decoder_runner_->load();
   }
 
@@ -146,12 +178,12 @@ class ET_EXPERIMENTAL TextTokenGenerator {
    * Check if the TextTokenGenerator has been successfully loaded.
    * @return True if the resources are loaded, false otherwise.
    */
-  bool inline is_loaded() const {
+  virtual bool is_loaded() const {
     // Implementation to check if resources are loaded
     return tokenizer_->is_loaded() && text_decoder_runner_->is_method_loaded();
   }
 
- private:
+ protected:
   /**
    * Note: TextTokenGenerator does not own the tokenizer_ and
    * text_decoder_runner_. The lifecycle of these objects should be managed
@@ -163,8 +195,10 @@ class ET_EXPERIMENTAL TextTokenGenerator {
   std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
   bool use_kv_cache_;
 
+  bool async_detokenization_ = false;
+
   // state machine
-  bool should_stop_ = false;
+  std::atomic<bool> should_stop_{false};
 
   // stats
   Stats* stats_;
@@ -1,4 +1,9 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+load(
+    "@fbsource//xplat/executorch/kernels/optimized:lib_defs.bzl",
+    "get_vec_deps",
+    "get_vec_preprocessor_flags",
+)
 
 def define_common_targets():
     for aten in (True, False):
@@ -26,3 +31,28 @@ def define_common_targets():
                 "//executorch/runtime/platform:compiler",
             ],
         )
+
+        runtime.cxx_library(
+            name = "vectorized_sampler" + aten_suffix,
+            exported_headers = [
+                "vectorized_sampler.h",
+            ],
+            preprocessor_flags = get_vec_preprocessor_flags() + ([
+                "-DUSE_ATEN_LIB",
+            ] if aten else []),
+            srcs = [
+                "vectorized_sampler.cpp",
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            deps = [
+                "//executorch/kernels/optimized:libvec",
+                "//executorch/runtime/platform:platform",
+            ] + get_vec_deps(),
+            exported_deps = [
+                ":sampler" + aten_suffix,
+                "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
+                "//executorch/runtime/platform:compiler",
+            ],
+        )
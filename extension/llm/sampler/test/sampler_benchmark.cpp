@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Compares the per-token latency of Sampler and VectorizedSampler on random
+ * logits, for a few vocabulary sizes and sampling settings.
+ *
+ * Usage: sampler_benchmark [iterations]
+ */
+
+#include <executorch/extension/llm/sampler/vectorized_sampler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using ::executorch::extension::llm::Sampler;
+using ::executorch::extension::llm::SamplingParams;
+using ::executorch::extension::llm::VectorizedSampler;
+
+namespace {
+
+struct Setting {
+  const char* name;
+  float temperature;
+  float top_p;
+  int32_t top_k;
+};
+
+template <typename Fn>
+double measure_us(size_t iterations, Fn&& fn) {
+  // Warm up the caches and the scratch buffers.
+  fn();
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    fn();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+      iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+  const Setting settings[] = {
+      {"greedy", 0.0f, 0.9f, 0},
+      {"temperature", 0.8f, 1.0f, 0},
+      {"top-p 0.9", 0.8f, 0.9f, 0},
+      {"top-k 50", 0.8f, 1.0f, 50},
+  };
+
+  std::printf(
+      "%-8s %-12s %14s %14s %8s\n",
+      "vocab",
+      "setting",
+      "Sampler us",
+      "Vectorized us",
+      "speedup");
+  for (int32_t vocab_size : {32000, 128256, 256000}) {
+    std::mt19937 gen(vocab_size);
+    std::normal_distribution<float> dist(0.0f, 3.0f);
+    std::vector<float> logits(vocab_size);
+    for (auto& logit : logits) {
+      logit = dist(gen);
+    }
+    // Sampler overwrites its input, so it gets a fresh copy every call. The
+    // copy is timed too; it is what callers that keep their logits pay.
+    std::vector<float> scratch(vocab_size);
+
+    for (const auto& setting : settings) {
+      Sampler sampler(vocab_size, setting.temperature, setting.top_p, 0);
+      SamplingParams params;
+      params.temperature = setting.temperature;
+      params.top_p = setting.top_p;
+      params.top_k = setting.top_k;
+      VectorizedSampler vectorized(vocab_size, params, 0);
+
+      volatile int32_t sink = 0;
+      const double vectorized_us = measure_us(
+          iterations, [&] { sink = vectorized.sample(logits.data()); });
+      if (setting.top_k > 0) {
+        // Sampler has no top-k.
+        std::printf(
+            "%-8d %-12s %14s %14.1f %8s\n",
+            vocab_size,
+            setting.name,
+            "-",
+            vectorized_us,
+            "-");
+      } else {
+        const double sampler_us = measure_us(iterations, [&] {
+          scratch = logits;
+          sink = sampler.sample(scratch.data());
+        });
+        std::printf(
+            "%-8d %-12s %14.1f %14.1f %7.1fx\n",
+            vocab_size,
+            setting.name,
+            sampler_us,
+            vectorized_us,
+            sampler_us / vectorized_us);
+      }
+    }
+  }
+  return 0;
+}
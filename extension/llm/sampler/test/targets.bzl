@@ -22,3 +22,23 @@ def define_common_targets():
             "//caffe2:torch-cpp",
         ],
     )
+
+    runtime.cxx_test(
+        name = "test_vectorized_sampler",
+        srcs = [
+            "test_vectorized_sampler.cpp",
+        ],
+        deps = [
+            "//executorch/extension/llm/sampler:vectorized_sampler",
+        ],
+    )
+
+    runtime.cxx_binary(
+        name = "sampler_benchmark",
+        srcs = [
+            "sampler_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/extension/llm/sampler:vectorized_sampler",
+        ],
+    )
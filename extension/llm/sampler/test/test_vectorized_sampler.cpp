@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/vectorized_sampler.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::extension::llm::Sampler;
+using ::executorch::extension::llm::SamplingParams;
+using ::executorch::extension::llm::VectorizedSampler;
+
+namespace {
+
+// Not a multiple of any vector width, and more than a few CDF blocks.
+constexpr int32_t kVocabSize = 5003;
+
+std::vector<float> random_logits(int32_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist(0.0f, 3.0f);
+  std::vector<float> logits(size);
+  for (auto& logit : logits) {
+    logit = dist(gen);
+  }
+  return logits;
+}
+
+SamplingParams params(float temperature) {
+  SamplingParams params;
+  params.temperature = temperature;
+  return params;
+}
+
+} // namespace
+
+TEST(VectorizedSamplerTest, GreedyMatchesSampler) {
+  VectorizedSampler sampler(kVocabSize, SamplingParams());
+  Sampler reference(kVocabSize, 0.0f);
+  for (unsigned seed = 0; seed < 10; ++seed) {
+    auto logits = random_logits(kVocabSize, seed);
+    const auto original = logits;
+    EXPECT_EQ(sampler.sample(logits.data()), reference.sample(logits.data()));
+    EXPECT_EQ(logits, original);
+  }
+  // The maximum in the scalar tail.
+  std::vector<float> logits(kVocabSize, 0.0f);
+  logits[kVocabSize - 1] = 1.0f;
+  EXPECT_EQ(sampler.sample(logits.data()), kVocabSize - 1);
+}
+
+TEST(VectorizedSamplerTest, GreedyWithHalf) {
+  VectorizedSampler sampler(kVocabSize, SamplingParams());
+  std::vector<executorch::aten::Half> logits(kVocabSize);
+  for (int32_t i = 0; i < kVocabSize; ++i) {
+    logits[i] = static_cast<float>(i % 100) / 100.0f;
+  }
+  logits[396] = 2.0f;
+  EXPECT_EQ(sampler.sample(logits.data()), 396);
+}
+
+TEST(VectorizedSamplerTest, TopPMatchesSampler) {
+  int mismatches = 0;
+  for (unsigned seed = 0; seed < 50; ++seed) {
+    SamplingParams top_p = params(0.8f);
+    top_p.top_p = 0.9f;
+    VectorizedSampler sampler(kVocabSize, top_p, seed);
+    Sampler reference(kVocabSize, 0.8f, 0.9f, seed);
+    auto logits = random_logits(kVocabSize, seed);
+    const int32_t token = sampler.sample(logits.data());
+    mismatches += token != reference.sample(logits.data());
+  }
+  // Sampler normalizes before summing, so the two can round differently
+  // right at the edge of a token's share of the CDF.
+  EXPECT_LE(mismatches, 1);
+}
+
+TEST(VectorizedSamplerTest, MultinomialMatchesSampler) {
+  for (unsigned seed = 0; seed < 50; ++seed) {
+    VectorizedSampler sampler(kVocabSize, params(1.0f), seed);
+    Sampler reference(kVocabSize, 1.0f, /*topp=*/1.0f, seed);
+    auto logits = random_logits(kVocabSize, seed);
+    const int32_t token = sampler.sample(logits.data());
+    EXPECT_EQ(token, reference.sample(logits.data())) << "seed " << seed;
+  }
+}
+
+TEST(VectorizedSamplerTest, TopKSamplesOnlyTheTopK) {
+  auto logits = random_logits(kVocabSize, 0);
+  std::vector<int32_t> order(kVocabSize);
+  for (int32_t i = 0; i < kVocabSize; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return logits[a] > logits[b];
+  });
+
+  SamplingParams top_k = params(100.0f);
+  top_k.top_k = 3;
+  VectorizedSampler sampler(kVocabSize, top_k, /*rng_seed=*/1);
+  std::set<int32_t> seen;
+  for (int i = 0; i < 300; ++i) {
+    seen.insert(sampler.sample(logits.data()));
+  }
+  EXPECT_EQ(seen, std::set<int32_t>(order.begin(), order.begin() + 3));
+
+  top_k.top_k = 1;
+  VectorizedSampler greedy(kVocabSize, top_k, /*rng_seed=*/1);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(greedy.sample(logits.data()), order[0]);
+  }
+}
+
+TEST(VectorizedSamplerTest, MinPDropsUnlikelyTokens) {
+  std::vector<float> logits(kVocabSize, -100.0f);
+  logits[7] = 0.0f;
+  logits[8] = std::log(0.5f);
+  logits[9] = std::log(0.05f);
+
+  for (int32_t top_k : {0, 10}) {
+    SamplingParams min_p = params(1.0f);
+    min_p.min_p = 0.1f;
+    min_p.top_k = top_k;
+    VectorizedSampler sampler(kVocabSize, min_p, /*rng_seed=*/3);
+    std::set<int32_t> seen;
+    for (int i = 0; i < 300; ++i) {
+      seen.insert(sampler.sample(logits.data()));
+    }
+    EXPECT_EQ(seen, std::set<int32_t>({7, 8})) << "top_k " << top_k;
+  }
+}
+
+TEST(VectorizedSamplerTest, RepetitionPenalty) {
+  std::vector<float> logits(kVocabSize, -1.0f);
+  logits[5] = 2.0f;
+  logits[6] = 1.5f;
+  const auto original = logits;
+
+  SamplingParams penalty;
+  penalty.repetition_penalty = 2.0f;
+  VectorizedSampler sampler(kVocabSize, penalty);
+  EXPECT_EQ(sampler.sample(logits.data()), 5);
+  // 2 / 2 < 1.5
+  EXPECT_EQ(sampler.sample(logits.data(), {5}), 6);
+  // Repeated tokens are penalized once: 2 / 2 > 1.5 / 2.
+  EXPECT_EQ(sampler.sample(logits.data(), {5, 6, 5, 6}), 5);
+  // Out of range tokens are ignored.
+  EXPECT_EQ(sampler.sample(logits.data(), {kVocabSize + 1}), 5);
+  EXPECT_EQ(logits, original);
+
+  // Negative logits are multiplied: -0.6 * 2 < -1.
+  std::vector<float> negative(kVocabSize, -1.0f);
+  negative[3] = -0.6f;
+  negative[4] = -0.8f;
+  EXPECT_EQ(sampler.sample(negative.data()), 3);
+  EXPECT_EQ(sampler.sample(negative.data(), {3}), 4);
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/vectorized_sampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <ATen/cpu/vec/vec.h>
+#include <executorch/runtime/platform/assert.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// Candidates sorted in the first round of top-p sampling. Later rounds
+// double it.
+constexpr size_t kFirstTopPChunk = 64;
+// Block size of the sum that skips ahead when sampling the full vocabulary.
+constexpr int32_t kCdfBlock = 1024;
+
+float reduce_max(const float* x, int32_t size) {
+  float max_value = -std::numeric_limits<float>::infinity();
+  int32_t i = 0;
+  if (size >= Vec::size()) {
+    Vec vec_max = Vec::loadu(x);
+    for (i = Vec::size(); i + Vec::size() <= size; i += Vec::size()) {
+      vec_max = at::vec::maximum(vec_max, Vec::loadu(x + i));
+    }
+    max_value = at::vec::vec_reduce_all<float>(
+        [](Vec& a, Vec& b) { return at::vec::maximum(a, b); }, vec_max);
+  }
+  for (; i < size; ++i) {
+    max_value = std::max(max_value, x[i]);
+  }
+  return max_value;
+}
+
+float reduce_sum(const float* x, int32_t size) {
+  Vec vec_sum(0.0f);
+  int32_t i = 0;
+  for (; i + Vec::size() <= size; i += Vec::size()) {
+    vec_sum = vec_sum + Vec::loadu(x + i);
+  }
+  float sum = at::vec::vec_reduce_all<float>(
+      [](Vec& a, Vec& b) { return a + b; }, vec_sum);
+  for (; i < size; ++i) {
+    sum += x[i];
+  }
+  return sum;
+}
+
+// Fused temperature and softmax numerator:
+// out[i] = exp((x[i] - max_value) * scale). Returns the sum of out.
+float exp_reduce_sum(
+    const float* x,
+    int32_t size,
+    float max_value,
+    float scale,
+    float* out) {
+  const Vec vec_max(max_value);
+  const Vec vec_scale(scale);
+  Vec vec_sum(0.0f);
+  int32_t i = 0;
+  for (; i + Vec::size() <= size; i += Vec::size()) {
+    const Vec e = ((Vec::loadu(x + i) - vec_max) * vec_scale).exp();
+    e.store(out + i);
+    vec_sum = vec_sum + e;
+  }
+  float sum = at::vec::vec_reduce_all<float>(
+      [](Vec& a, Vec& b) { return a + b; }, vec_sum);
+  for (; i < size; ++i) {
+    out[i] = std::exp((x[i] - max_value) * scale);
+    sum += out[i];
+  }
+  return sum;
+}
+
+// The same xorshift generator as Sampler, so both draw the same coins from
+// the same seed.
+unsigned int random_u32(unsigned long long* state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (*state * 0x2545F4914F6CDD1Dull) >> 32;
+}
+
+float random_f32(unsigned long long* state) { // random float32 in [0,1)
+  return (random_u32(state) >> 8) / 16777216.0f;
+}
+
+} // namespace
+
+VectorizedSampler::VectorizedSampler(
+    int32_t vocab_size,
+    SamplingParams params,
+    unsigned long long rng_seed)
+    : vocab_size_(vocab_size),
+      params_(params),
+      inv_temperature_(
+          params.temperature > 0.0f ? 1.0f / params.temperature : 0.0f),
+      rng_state_(rng_seed) {
+  ET_CHECK_MSG(vocab_size > 0, "vocab_size must be positive");
+}
+
+template <typename T>
+int32_t VectorizedSampler::sample(
+    const T* logits,
+    const std::vector<uint64_t>& previous_tokens) {
+  const bool penalize =
+      params_.repetition_penalty != 1.0f && !previous_tokens.empty();
+  const float* x = nullptr;
+  if constexpr (std::is_same_v<T, float>) {
+    x = logits;
+  }
+  if (x == nullptr || penalize) {
+    logits_.resize(vocab_size_);
+    for (int32_t i = 0; i < vocab_size_; ++i) {
+      logits_[i] = static_cast<float>(logits[i]);
+    }
+    x = logits_.data();
+  }
+  if (penalize) {
+    penalized_.resize(vocab_size_);
+    for (uint64_t token : previous_tokens) {
+      if (token >= static_cast<uint64_t>(vocab_size_) || penalized_[token]) {
+        continue;
+      }
+      penalized_[token] = true;
+      float& logit = logits_[token];
+      logit = logit > 0.0f ? logit / params_.repetition_penalty
+                           : logit * params_.repetition_penalty;
+    }
+    for (uint64_t token : previous_tokens) {
+      if (token < static_cast<uint64_t>(vocab_size_)) {
+        penalized_[token] = false;
+      }
+    }
+  }
+
+  if (inv_temperature_ == 0.0f) {
+    return argmax(x);
+  }
+  const float coin = random_f32(&rng_state_);
+  if (params_.top_k > 0 && params_.top_k < vocab_size_) {
+    return sample_top_k(x, coin);
+  }
+  return sample_full(x, coin);
+}
+
+int32_t VectorizedSampler::argmax(const float* logits) const {
+  const float max_value = reduce_max(logits, vocab_size_);
+  const float* it = std::find(logits, logits + vocab_size_, max_value);
+  return it == logits + vocab_size_ ? 0 : it - logits;
+}
+
+int32_t VectorizedSampler::sample_top_k(const float* logits, float coin) {
+  // Keep a min-heap of the k largest logits; most logits fail the
+  // comparison with its top and cost one compare.
+  const size_t k = params_.top_k;
+  auto greater = [](const ProbIndex<float>& a, const ProbIndex<float>& b) {
+    return a.prob > b.prob;
+  };
+  candidates_.clear();
+  for (int32_t i = 0; i < vocab_size_; ++i) {
+    if (candidates_.size() < k) {
+      candidates_.push_back({logits[i], i});
+      std::push_heap(candidates_.begin(), candidates_.end(), greater);
+    } else if (logits[i] > candidates_.front().prob) {
+      std::pop_heap(candidates_.begin(), candidates_.end(), greater);
+      candidates_.back() = {logits[i], i};
+      std::push_heap(candidates_.begin(), candidates_.end(), greater);
+    }
+  }
+  // Descending order.
+  std::sort_heap(candidates_.begin(), candidates_.end(), greater);
+
+  const float max_value = candidates_.front().prob;
+  float total = 0.0f;
+  for (auto& candidate : candidates_) {
+    candidate.prob = std::exp((candidate.prob - max_value) * inv_temperature_);
+    total += candidate.prob;
+  }
+  return sample_sorted(candidates_.size(), total, coin);
+}
+
+int32_t VectorizedSampler::sample_full(const float* logits, float coin) {
+  probs_.resize(vocab_size_);
+  const float max_value = reduce_max(logits, vocab_size_);
+  // The most likely token gets probability exp(0) = 1 before normalization.
+  const float total = exp_reduce_sum(
+      logits, vocab_size_, max_value, inv_temperature_, probs_.data());
+  const bool top_p = params_.top_p > 0.0f && params_.top_p < 1.0f;
+
+  if (!top_p && params_.min_p <= 0.0f) {
+    // Skip whole blocks of the CDF at a time.
+    float r = coin * total;
+    int32_t start = 0;
+    for (; start + kCdfBlock < vocab_size_; start += kCdfBlock) {
+      const float block_sum = reduce_sum(probs_.data() + start, kCdfBlock);
+      if (r < block_sum) {
+        break;
+      }
+      r -= block_sum;
+    }
+    float cdf = 0.0f;
+    for (int32_t i = start; i < vocab_size_; ++i) {
+      cdf += probs_[i];
+      if (r < cdf) {
+        return i;
+      }
+    }
+    return vocab_size_ - 1; // in case of rounding errors
+  }
+
+  // Drop the tokens that cannot make it through min-p or top-p before
+  // sorting anything. Tokens less likely than (1 - top_p) / (n - 1) are never
+  // part of the nucleus. Capping at 1 keeps the most likely token.
+  float cutoff = std::max(params_.min_p, 0.0f);
+  if (top_p) {
+    cutoff = std::max(
+        cutoff, (1.0f - params_.top_p) * total / (vocab_size_ - 1));
+  }
+  cutoff = std::min(cutoff, 1.0f);
+  candidates_.clear();
+  for (int32_t i = 0; i < vocab_size_; ++i) {
+    if (probs_[i] >= cutoff) {
+      candidates_.push_back({probs_[i], i});
+    }
+  }
+
+  if (!top_p) {
+    // min-p alone needs no ordering.
+    float mass = 0.0f;
+    for (const auto& candidate : candidates_) {
+      mass += candidate.prob;
+    }
+    const float r = coin * mass;
+    float cdf = 0.0f;
+    for (const auto& candidate : candidates_) {
+      cdf += candidate.prob;
+      if (r < cdf) {
+        return candidate.index;
+      }
+    }
+    return candidates_.back().index; // in case of rounding errors
+  }
+
+  // Sort only as many candidates as the nucleus needs, in growing chunks.
+  auto greater = [](const ProbIndex<float>& a, const ProbIndex<float>& b) {
+    return a.prob > b.prob;
+  };
+  const size_t num_candidates = candidates_.size();
+  const float limit = params_.top_p * total;
+  size_t sorted = 0;
+  size_t chunk = kFirstTopPChunk;
+  float cumulative = 0.0f;
+  while (sorted < num_candidates && cumulative <= limit) {
+    const size_t end = std::min(num_candidates, sorted + chunk);
+    std::partial_sort(
+        candidates_.begin() + sorted,
+        candidates_.begin() + end,
+        candidates_.end(),
+        greater);
+    for (; sorted < end && cumulative <= limit; ++sorted) {
+      cumulative += candidates_[sorted].prob;
+    }
+    chunk *= 2;
+  }
+  return sample_sorted(sorted, total, coin);
+}
+
+int32_t VectorizedSampler::sample_sorted(
+    size_t size,
+    float total,
+    float coin) {
+  // min-p, relative to the most likely token.
+  const float min_prob = params_.min_p * candidates_.front().prob;
+  while (size > 1 && candidates_[size - 1].prob < min_prob) {
+    --size;
+  }
+  // top-p: stop at the first token that takes the mass past top_p.
+  const bool top_p = params_.top_p > 0.0f && params_.top_p < 1.0f;
+  const float limit = top_p ? params_.top_p * total : total;
+  size_t last = size - 1; // in case of rounding errors consider all elements
+  float cumulative = 0.0f;
+  for (size_t i = 0; i < size; ++i) {
+    cumulative += candidates_[i].prob;
+    if (top_p && cumulative > limit) {
+      last = i;
+      break;
+    }
+  }
+
+  const float r = coin * cumulative;
+  float cdf = 0.0f;
+  for (size_t i = 0; i <= last; ++i) {
+    cdf += candidates_[i].prob;
+    if (r < cdf) {
+      return candidates_[i].index;
+    }
+  }
+  return candidates_[last].index; // in case of rounding errors
+}
+
+template int32_t VectorizedSampler::sample<float>(
+    const float* logits,
+    const std::vector<uint64_t>& previous_tokens);
+template int32_t VectorizedSampler::sample<executorch::aten::Half>(
+    const executorch::aten::Half* logits,
+    const std::vector<uint64_t>& previous_tokens);
+template int32_t VectorizedSampler::sample<executorch::aten::BFloat16>(
+    const executorch::aten::BFloat16* logits,
+    const std::vector<uint64_t>& previous_tokens);
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
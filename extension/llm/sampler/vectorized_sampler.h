@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Parameters of VectorizedSampler. Every filter is disabled by default, so
+ * the default parameters sample greedily.
+ */
+struct ET_EXPERIMENTAL SamplingParams {
+  // 0 samples greedily.
+  float temperature = 0.0f;
+  // Keep only the k most likely tokens. 0 disables.
+  int32_t top_k = 0;
+  // Keep the smallest set of tokens whose probability exceeds top_p. Values
+  // outside (0, 1) disable.
+  float top_p = 1.0f;
+  // Drop tokens less likely than min_p times the most likely token. 0
+  // disables.
+  float min_p = 0.0f;
+  // Divides positive logits and multiplies negative logits of tokens seen
+  // before, as in CTRL. 1 disables.
+  float repetition_penalty = 1.0f;
+};
+
+/**
+ * A sampler for large vocabularies. Compared to Sampler, it
+ * - never sorts the whole vocabulary: top-k keeps a heap of k candidates,
+ *   and top-p sorts the candidates in growing chunks until their cumulative
+ *   probability exceeds top_p,
+ * - computes the maximum and the temperature-scaled softmax with SIMD, in a
+ *   single fused pass after the maximum, and skips the normalization pass,
+ * - skips the softmax entirely when sampling greedily,
+ * - supports top-k, min-p and repetition penalty.
+ *
+ * The repetition penalty and top-k apply to the logits, then temperature.
+ * min-p and top-p both look at the resulting distribution, and a token must
+ * pass both. With only temperature and top-p set, the token drawn for a
+ * given seed matches Sampler's up to floating point rounding.
+ *
+ * Logits are never modified. Instances keep scratch buffers and are not
+ * thread safe.
+ */
+class ET_EXPERIMENTAL VectorizedSampler {
+ public:
+  VectorizedSampler(
+      int32_t vocab_size,
+      SamplingParams params,
+      unsigned long long rng_seed = std::time(nullptr));
+
+  /**
+   * Samples a token from `logits`, which holds vocab_size values.
+   *
+   * @param previous_tokens Tokens that the repetition penalty applies to.
+   * @return The sampled token.
+   */
+  template <typename T>
+  int32_t sample(
+      const T* logits,
+      const std::vector<uint64_t>& previous_tokens = {});
+
+  const SamplingParams& params() const {
+    return params_;
+  }
+
+ private:
+  int32_t argmax(const float* logits) const;
+  int32_t sample_top_k(const float* logits, float coin);
+  int32_t sample_full(const float* logits, float coin);
+  // Samples from candidates_[0, size), sorted by descending probability,
+  // after applying min-p and top-p. `total` is the unnormalized probability
+  // mass of the distribution they come from.
+  int32_t sample_sorted(size_t size, float total, float coin);
+
+  int32_t vocab_size_;
+  SamplingParams params_;
+  float inv_temperature_;
+  unsigned long long rng_state_;
+
+  // Float copy of the logits, when they need converting or penalizing.
+  std::vector<float> logits_;
+  // Unnormalized probabilities.
+  std::vector<float> probs_;
+  std::vector<ProbIndex<float>> candidates_;
+  // Marks tokens already penalized in this call.
+  std::vector<bool> penalized_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
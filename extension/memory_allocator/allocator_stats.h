@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Allocation counters for one call site.
+ */
+struct AllocationSiteStats {
+  /// Number of log2-sized histogram buckets. Bucket `i` counts allocations of
+  /// [2^i, 2^(i+1)) bytes; bucket 0 also counts zero-byte allocations.
+  static constexpr size_t kNumBuckets = 32;
+
+  /// Number of allocations made from this site.
+  size_t num_allocations = 0;
+  /// Total bytes requested from this site.
+  size_t total_bytes = 0;
+  /// Largest single allocation from this site.
+  size_t max_allocation = 0;
+  /// Allocation count per size bucket.
+  std::array<size_t, kNumBuckets> histogram{};
+
+  void record(size_t size) {
+    num_allocations++;
+    total_bytes += size;
+    if (size > max_allocation) {
+      max_allocation = size;
+    }
+    size_t bucket = 0;
+    while (bucket + 1 < kNumBuckets && (size >> (bucket + 1)) != 0) {
+      bucket++;
+    }
+    histogram[bucket]++;
+  }
+};
+
+/**
+ * Usage telemetry shared by the allocators in this directory.
+ *
+ * Tracks bytes in use and their high-water mark, allocation histograms per
+ * call site, and the peak usage of every reset epoch. Method resets its temp
+ * allocator after every instruction, so for a temp allocator the epochs are
+ * the instructions of an execution and `epoch_peaks()` gives the scratch
+ * memory each instruction needed, indexed like the instruction debug handles
+ * that the EventTracer reports.
+ */
+class AllocatorStats final {
+ public:
+  AllocatorStats() {
+    set_tag(kDefaultTag);
+  }
+
+  /// Tag used for allocations made outside of any set_tag() scope.
+  static constexpr const char* kDefaultTag = "untagged";
+
+  /**
+   * Attributes subsequent allocations to `tag`, e.g. an operator name.
+   * Prefer AllocationTagGuard to scope the change.
+   *
+   * @returns The previous tag.
+   */
+  const char* set_tag(const char* tag) {
+    const char* previous = tag_;
+    tag_ = tag;
+    current_site_ = &sites_[tag];
+    return previous;
+  }
+
+  /// The tag that allocations are currently attributed to.
+  const char* tag() const {
+    return tag_;
+  }
+
+  /// Records an allocation of `size` bytes that occupies `footprint` bytes of
+  /// the allocator, including alignment and size-class padding.
+  void record_allocation(size_t size, size_t footprint) {
+    current_site_->record(size);
+    used_bytes_ += footprint;
+    if (used_bytes_ > peak_bytes_) {
+      peak_bytes_ = used_bytes_;
+    }
+    if (used_bytes_ > epoch_peak_) {
+      epoch_peak_ = used_bytes_;
+    }
+  }
+
+  /// Records that the allocator was reset, closing the current epoch.
+  void record_reset() {
+    if (epoch_peaks_.size() < max_epochs_) {
+      epoch_peaks_.push_back(epoch_peak_);
+    }
+    used_bytes_ = 0;
+    epoch_peak_ = 0;
+  }
+
+  /**
+   * Starts a new sequence of epochs, e.g. before Method::execute(), so that
+   * `epoch_peaks()[i]` refers to instruction `i` of that execution.
+   */
+  void begin_epochs() {
+    epoch_peaks_.clear();
+    epoch_peak_ = used_bytes_;
+  }
+
+  /// Bytes currently allocated.
+  size_t used_bytes() const {
+    return used_bytes_;
+  }
+
+  /// Highest value of used_bytes() since construction or clear().
+  size_t peak_bytes() const {
+    return peak_bytes_;
+  }
+
+  /// Peak usage of each completed epoch since begin_epochs().
+  const std::vector<size_t>& epoch_peaks() const {
+    return epoch_peaks_;
+  }
+
+  /// Per-tag counters, ordered by tag.
+  const std::map<std::string, AllocationSiteStats>& sites() const {
+    return sites_;
+  }
+
+  /// Caps how many epoch peaks are retained, to bound memory use.
+  void set_max_epochs(size_t max_epochs) {
+    max_epochs_ = max_epochs;
+  }
+
+  /// Forgets all recorded data, but keeps the current tag.
+  void clear() {
+    sites_.clear();
+    current_site_ = &sites_[tag_];
+    epoch_peaks_.clear();
+    peak_bytes_ = used_bytes_;
+    epoch_peak_ = used_bytes_;
+  }
+
+  /// Writes a summary to the log at Info level.
+  void log(const char* name) const {
+    ET_LOG(
+        Info,
+        "%s: in use %zu B, high-water mark %zu B",
+        name,
+        used_bytes_,
+        peak_bytes_);
+    for (const auto& site : sites_) {
+      if (site.second.num_allocations == 0) {
+        continue;
+      }
+      ET_LOG(
+          Info,
+          "  %s: %zu allocations, %zu B total, largest %zu B",
+          site.first.c_str(),
+          site.second.num_allocations,
+          site.second.total_bytes,
+          site.second.max_allocation);
+    }
+  }
+
+ private:
+  const char* tag_ = nullptr;
+  AllocationSiteStats* current_site_ = nullptr;
+  std::map<std::string, AllocationSiteStats> sites_;
+  size_t used_bytes_ = 0;
+  size_t peak_bytes_ = 0;
+  size_t epoch_peak_ = 0;
+  size_t max_epochs_ = 1 << 20;
+  std::vector<size_t> epoch_peaks_;
+};
+
+/**
+ * RAII helper that attributes the allocations made during its lifetime to a
+ * tag, then restores the previous tag.
+ */
+class AllocationTagGuard final {
+ public:
+  AllocationTagGuard(AllocatorStats& stats, const char* tag)
+      : stats_(stats), previous_(stats.set_tag(tag)) {}
+
+  ~AllocationTagGuard() {
+    stats_.set_tag(previous_);
+  }
+
+  AllocationTagGuard(const AllocationTagGuard&) = delete;
+  AllocationTagGuard& operator=(const AllocationTagGuard&) = delete;
+
+ private:
+  AllocatorStats& stats_;
+  const char* previous_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <executorch/extension/memory_allocator/allocator_stats.h>
+#include <executorch/runtime/core/memory_allocator.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A growable bump allocator. Memory comes from the heap in chunks of at least
+ * `chunk_size` bytes, and allocations are carved out of the current chunk.
+ * Unlike MallocMemoryAllocator, which calls malloc() for every allocation, this
+ * calls it once per chunk, and unlike MemoryAllocator it never runs out of
+ * space as long as the heap does not.
+ *
+ * reset() keeps the first chunk and frees the rest. See ScratchMemoryAllocator
+ * for a variant that keeps all of its memory across resets.
+ *
+ * Usage is recorded in stats(), so that a run with this allocator can be used
+ * to size a fixed MemoryAllocator buffer for production.
+ */
+class ArenaMemoryAllocator : public executorch::runtime::MemoryAllocator {
+ public:
+  static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+  /**
+   * @param[in] chunk_size Minimum size of each chunk requested from the heap.
+   *     Larger allocations get a chunk of their own size.
+   */
+  explicit ArenaMemoryAllocator(size_t chunk_size = kDefaultChunkSize)
+      : MemoryAllocator(0, nullptr), chunk_size_(chunk_size) {}
+
+  ArenaMemoryAllocator(const ArenaMemoryAllocator&) = delete;
+  ArenaMemoryAllocator& operator=(const ArenaMemoryAllocator&) = delete;
+
+  ~ArenaMemoryAllocator() override {
+    for (auto& chunk : chunks_) {
+      std::free(chunk.data);
+    }
+  }
+
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    if (!isPowerOf2(alignment)) {
+      ET_LOG(Error, "Alignment %zu is not a power of 2", alignment);
+      return nullptr;
+    }
+    // Try the current chunk, then any chunk kept from before the last reset.
+    for (; current_ < chunks_.size(); ++current_) {
+      void* ptr = allocate_from(chunks_[current_], size, alignment);
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
+    // Reserve room to align the start of a fresh chunk.
+    const size_t needed = size + alignment;
+    const size_t new_size = needed > chunk_size_ ? needed : chunk_size_;
+    void* data = std::malloc(new_size);
+    if (data == nullptr) {
+      ET_LOG(Error, "Failed to allocate a %zu B arena chunk", new_size);
+      return nullptr;
+    }
+    chunks_.push_back({static_cast<uint8_t*>(data), new_size, 0});
+    current_ = chunks_.size() - 1;
+    return allocate_from(chunks_[current_], size, alignment);
+  }
+
+  void reset() override {
+    stats_.record_reset();
+    for (size_t i = 1; i < chunks_.size(); ++i) {
+      std::free(chunks_[i].data);
+    }
+    if (chunks_.size() > 1) {
+      chunks_.resize(1);
+    }
+    rewind();
+  }
+
+  /// Total bytes obtained from the heap.
+  size_t capacity() const {
+    size_t capacity = 0;
+    for (const auto& chunk : chunks_) {
+      capacity += chunk.size;
+    }
+    return capacity;
+  }
+
+  /// Number of chunks obtained from the heap.
+  size_t num_chunks() const {
+    return chunks_.size();
+  }
+
+  /// Usage telemetry.
+  AllocatorStats& stats() {
+    return stats_;
+  }
+
+  const AllocatorStats& stats() const {
+    return stats_;
+  }
+
+ protected:
+  struct Chunk {
+    uint8_t* data;
+    size_t size;
+    size_t used;
+  };
+
+  /// Marks every chunk as empty without freeing any of them.
+  void rewind() {
+    for (auto& chunk : chunks_) {
+      chunk.used = 0;
+    }
+    current_ = 0;
+  }
+
+  void* allocate_from(Chunk& chunk, size_t size, size_t alignment) {
+    uint8_t* cur = chunk.data + chunk.used;
+    uint8_t* start = alignPointer(cur, alignment);
+    if (start + size > chunk.data + chunk.size) {
+      return nullptr;
+    }
+    const size_t footprint = static_cast<size_t>(start + size - cur);
+    EXECUTORCH_TRACK_ALLOCATION(prof_id(), footprint);
+    stats_.record_allocation(size, footprint);
+    chunk.used += footprint;
+    return start;
+  }
+
+  const size_t chunk_size_;
+  std::vector<Chunk> chunks_;
+  size_t current_ = 0;
+  AllocatorStats stats_;
+};
+
+/**
+ * An arena for memory that only lives until the next reset(), such as the
+ * temp allocator that Method resets after every instruction.
+ *
+ * reset() rewinds the arena without returning anything to the heap. If the
+ * epoch that just ended spilled over into more than one chunk, the chunks are
+ * replaced by a single one large enough for the high-water mark, so that in
+ * steady state every epoch is served from one contiguous block and reset()
+ * costs no heap traffic at all.
+ */
+class ScratchMemoryAllocator final : public ArenaMemoryAllocator {
+ public:
+  explicit ScratchMemoryAllocator(size_t chunk_size = kDefaultChunkSize)
+      : ArenaMemoryAllocator(chunk_size) {}
+
+  void reset() override {
+    const bool spilled = current_ > 0;
+    stats_.record_reset();
+    if (spilled) {
+      // Round up to a whole number of chunks, with one chunk of slack for
+      // alignment padding that may land differently in the new layout.
+      const size_t peak = stats_.peak_bytes();
+      const size_t new_size = (peak / chunk_size_ + 2) * chunk_size_;
+      void* data = std::malloc(new_size);
+      if (data != nullptr) {
+        for (auto& chunk : chunks_) {
+          std::free(chunk.data);
+        }
+        chunks_.clear();
+        chunks_.push_back({static_cast<uint8_t*>(data), new_size, 0});
+      }
+      // On failure, keep the existing chunks; they are still usable.
+    }
+    rewind();
+  }
+};
+
+} // namespace extension
+} // namespace executorch
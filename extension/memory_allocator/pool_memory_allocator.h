@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <executorch/extension/memory_allocator/allocator_stats.h>
+#include <executorch/runtime/core/memory_allocator.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * An allocator that rounds requests up to power-of-two size classes and
+ * recycles blocks of each class through a free list.
+ *
+ * reset() returns every outstanding block to its free list instead of the
+ * heap, so after the first execution a Method whose allocations repeat from
+ * run to run is served without touching the heap. Requests larger than
+ * `max_block_size` are not pooled: they are malloc()ed directly and freed on
+ * reset().
+ */
+class PoolMemoryAllocator final : public executorch::runtime::MemoryAllocator {
+ public:
+  /// Size of the smallest class. Smaller requests are rounded up to it.
+  static constexpr size_t kMinBlockSize = 64;
+  static constexpr size_t kDefaultMaxBlockSize = 1 << 20;
+
+  /**
+   * @param[in] max_block_size Size of the largest pooled class. Rounded up to
+   *     a power of two.
+   */
+  explicit PoolMemoryAllocator(size_t max_block_size = kDefaultMaxBlockSize)
+      : MemoryAllocator(0, nullptr),
+        max_class_(size_class(max_block_size)) {}
+
+  PoolMemoryAllocator(const PoolMemoryAllocator&) = delete;
+  PoolMemoryAllocator& operator=(const PoolMemoryAllocator&) = delete;
+
+  ~PoolMemoryAllocator() override {
+    reset();
+    for (auto& free_list : free_lists_) {
+      for (void* block : free_list) {
+        std::free(block);
+      }
+    }
+  }
+
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    if (!isPowerOf2(alignment)) {
+      ET_LOG(Error, "Alignment %zu is not a power of 2", alignment);
+      return nullptr;
+    }
+    // malloc() only guarantees alignof(max_align_t), so over-allocate for
+    // anything stricter.
+    const size_t padded =
+        alignment > alignof(std::max_align_t) ? size + alignment : size;
+    const size_t cls = size_class(padded);
+    void* block = nullptr;
+    size_t footprint = 0;
+    if (cls > max_class_) {
+      block = std::malloc(padded);
+      if (block == nullptr) {
+        ET_LOG(Error, "Failed to allocate %zu bytes", padded);
+        return nullptr;
+      }
+      large_blocks_.push_back(block);
+      footprint = padded;
+    } else {
+      auto& free_list = free_lists_[cls];
+      footprint = kMinBlockSize << cls;
+      if (!free_list.empty()) {
+        block = free_list.back();
+        free_list.pop_back();
+      } else {
+        block = std::malloc(footprint);
+        if (block == nullptr) {
+          ET_LOG(Error, "Failed to allocate %zu bytes", footprint);
+          return nullptr;
+        }
+        pooled_bytes_ += footprint;
+      }
+      in_use_.push_back({block, cls});
+    }
+    EXECUTORCH_TRACK_ALLOCATION(prof_id(), footprint);
+    stats_.record_allocation(size, footprint);
+    return alignPointer(block, alignment);
+  }
+
+  void reset() override {
+    stats_.record_reset();
+    for (const auto& entry : in_use_) {
+      free_lists_[entry.cls].push_back(entry.block);
+    }
+    in_use_.clear();
+    for (void* block : large_blocks_) {
+      std::free(block);
+    }
+    large_blocks_.clear();
+  }
+
+  /// Bytes held in pooled blocks, whether in use or on a free list.
+  size_t pooled_bytes() const {
+    return pooled_bytes_;
+  }
+
+  /// Usage telemetry.
+  AllocatorStats& stats() {
+    return stats_;
+  }
+
+  const AllocatorStats& stats() const {
+    return stats_;
+  }
+
+ private:
+  static constexpr size_t kNumClasses = 40;
+
+  struct Block {
+    void* block;
+    size_t cls;
+  };
+
+  /// Index of the smallest class that holds `size` bytes.
+  static size_t size_class(size_t size) {
+    size_t cls = 0;
+    while (cls + 1 < kNumClasses && (kMinBlockSize << cls) < size) {
+      cls++;
+    }
+    return cls;
+  }
+
+  const size_t max_class_;
+  std::array<std::vector<void*>, kNumClasses> free_lists_;
+  std::vector<Block> in_use_;
+  std::vector<void*> large_blocks_;
+  size_t pooled_bytes_ = 0;
+  AllocatorStats stats_;
+};
+
+} // namespace extension
+} // namespace executorch
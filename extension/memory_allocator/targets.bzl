@@ -20,3 +20,47 @@ def define_common_targets():
             "@EXECUTORCH_CLIENTS",
         ],
     )
+
+    runtime.cxx_library(
+        name = "allocator_stats",
+        exported_headers = [
+            "allocator_stats.h",
+        ],
+        exported_deps = [
+            "//executorch/runtime/platform:platform",
+        ],
+        visibility = [
+            "//executorch/extension/memory_allocator/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "arena_memory_allocator",
+        exported_headers = [
+            "arena_memory_allocator.h",
+        ],
+        exported_deps = [
+            ":allocator_stats",
+            "//executorch/runtime/core:memory_allocator",
+        ],
+        visibility = [
+            "//executorch/extension/memory_allocator/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "pool_memory_allocator",
+        exported_headers = [
+            "pool_memory_allocator.h",
+        ],
+        exported_deps = [
+            ":allocator_stats",
+            "//executorch/runtime/core:memory_allocator",
+        ],
+        visibility = [
+            "//executorch/extension/memory_allocator/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
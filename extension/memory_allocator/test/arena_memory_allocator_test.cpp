@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/arena_memory_allocator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace ::testing;
+using executorch::extension::AllocationTagGuard;
+using executorch::extension::ArenaMemoryAllocator;
+using executorch::extension::ScratchMemoryAllocator;
+
+class ArenaMemoryAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+static bool is_aligned(const void* ptr, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST_F(ArenaMemoryAllocatorTest, AllocationsAreAlignedAndDisjoint) {
+  ArenaMemoryAllocator allocator(/*chunk_size=*/256);
+
+  auto* a = static_cast<uint8_t*>(allocator.allocate(10, 4));
+  auto* b = static_cast<uint8_t*>(allocator.allocate(20, 64));
+  auto* c = static_cast<uint8_t*>(allocator.allocate(30, 16));
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  ASSERT_NE(c, nullptr);
+  EXPECT_TRUE(is_aligned(a, 4));
+  EXPECT_TRUE(is_aligned(b, 64));
+  EXPECT_TRUE(is_aligned(c, 16));
+
+  // Writing every allocation must not clobber the others.
+  memset(a, 0xa, 10);
+  memset(b, 0xb, 20);
+  memset(c, 0xc, 30);
+  EXPECT_EQ(a[9], 0xa);
+  EXPECT_EQ(b[19], 0xb);
+  EXPECT_EQ(c[29], 0xc);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, GrowsByChunks) {
+  ArenaMemoryAllocator allocator(/*chunk_size=*/256);
+
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(allocator.allocate(100), nullptr);
+  }
+  EXPECT_GT(allocator.num_chunks(), 1);
+
+  // Allocations larger than a chunk get a chunk of their own.
+  ASSERT_NE(allocator.allocate(4096), nullptr);
+  EXPECT_GE(allocator.capacity(), 4096 + 8 * 100);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, ResetKeepsFirstChunk) {
+  ArenaMemoryAllocator allocator(/*chunk_size=*/256);
+
+  void* first = allocator.allocate(100);
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(allocator.allocate(100), nullptr);
+  }
+  allocator.reset();
+  EXPECT_EQ(allocator.num_chunks(), 1);
+  EXPECT_EQ(allocator.capacity(), 256);
+  EXPECT_EQ(allocator.allocate(100), first);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, InvalidAlignmentFails) {
+  ArenaMemoryAllocator allocator;
+  EXPECT_EQ(allocator.allocate(8, 3), nullptr);
+  EXPECT_EQ(allocator.stats().used_bytes(), 0);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, TracksHighWaterMark) {
+  ArenaMemoryAllocator allocator;
+
+  ASSERT_NE(allocator.allocate(64, 8), nullptr);
+  ASSERT_NE(allocator.allocate(64, 8), nullptr);
+  EXPECT_EQ(allocator.stats().used_bytes(), 128);
+  allocator.reset();
+  ASSERT_NE(allocator.allocate(32, 8), nullptr);
+
+  EXPECT_EQ(allocator.stats().used_bytes(), 32);
+  EXPECT_EQ(allocator.stats().peak_bytes(), 128);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, RecordsPerTagHistograms) {
+  ArenaMemoryAllocator allocator;
+  {
+    AllocationTagGuard guard(allocator.stats(), "aten::add");
+    ASSERT_NE(allocator.allocate(16), nullptr);
+    ASSERT_NE(allocator.allocate(1000), nullptr);
+  }
+  ASSERT_NE(allocator.allocate(8), nullptr);
+
+  const auto& sites = allocator.stats().sites();
+  ASSERT_EQ(sites.count("aten::add"), 1);
+  const auto& add = sites.at("aten::add");
+  EXPECT_EQ(add.num_allocations, 2);
+  EXPECT_EQ(add.total_bytes, 1016);
+  EXPECT_EQ(add.max_allocation, 1000);
+  EXPECT_EQ(add.histogram[4], 1); // [16, 32)
+  EXPECT_EQ(add.histogram[9], 1); // [512, 1024)
+
+  // The guard restored the default tag.
+  EXPECT_STREQ(allocator.stats().tag(), "untagged");
+  EXPECT_EQ(sites.at("untagged").num_allocations, 1);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, RecordsEpochPeaks) {
+  ArenaMemoryAllocator allocator;
+  allocator.stats().begin_epochs();
+
+  ASSERT_NE(allocator.allocate(64), nullptr);
+  allocator.reset();
+  ASSERT_NE(allocator.allocate(256), nullptr);
+  ASSERT_NE(allocator.allocate(256), nullptr);
+  allocator.reset();
+  allocator.reset();
+
+  const auto& peaks = allocator.stats().epoch_peaks();
+  ASSERT_EQ(peaks.size(), 3);
+  EXPECT_EQ(peaks[0], 64);
+  EXPECT_EQ(peaks[1], 512);
+  EXPECT_EQ(peaks[2], 0);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, ScratchReusesMemoryAcrossResets) {
+  ScratchMemoryAllocator allocator(/*chunk_size=*/256);
+
+  void* first = allocator.allocate(100);
+  ASSERT_NE(first, nullptr);
+  allocator.reset();
+  EXPECT_EQ(allocator.allocate(100), first);
+  EXPECT_EQ(allocator.num_chunks(), 1);
+}
+
+TEST_F(ArenaMemoryAllocatorTest, ScratchConsolidatesToHighWaterMark) {
+  ScratchMemoryAllocator allocator(/*chunk_size=*/256);
+
+  // Spill over several chunks.
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(allocator.allocate(100), nullptr);
+  }
+  EXPECT_GT(allocator.num_chunks(), 1);
+  allocator.reset();
+
+  // The same workload now fits in a single chunk.
+  EXPECT_EQ(allocator.num_chunks(), 1);
+  EXPECT_GE(allocator.capacity(), allocator.stats().peak_bytes());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(allocator.allocate(100), nullptr);
+  }
+  EXPECT_EQ(allocator.num_chunks(), 1);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/pool_memory_allocator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace ::testing;
+using executorch::extension::PoolMemoryAllocator;
+
+class PoolMemoryAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+static bool is_aligned(const void* ptr, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST_F(PoolMemoryAllocatorTest, AllocationsAreAligned) {
+  PoolMemoryAllocator allocator;
+
+  for (size_t alignment : {1, 8, 16, 64, 256}) {
+    void* p = allocator.allocate(100, alignment);
+    ASSERT_NE(p, nullptr);
+    EXPECT_TRUE(is_aligned(p, alignment));
+    memset(p, 0x55, 100);
+  }
+}
+
+TEST_F(PoolMemoryAllocatorTest, RoundsUpToSizeClasses) {
+  PoolMemoryAllocator allocator;
+
+  ASSERT_NE(allocator.allocate(1), nullptr);
+  EXPECT_EQ(allocator.pooled_bytes(), PoolMemoryAllocator::kMinBlockSize);
+  ASSERT_NE(allocator.allocate(100), nullptr);
+  EXPECT_EQ(allocator.pooled_bytes(), 64 + 128);
+
+  // The footprint includes the rounding, the site stats do not.
+  EXPECT_EQ(allocator.stats().used_bytes(), 64 + 128);
+  EXPECT_EQ(allocator.stats().sites().at("untagged").total_bytes, 101);
+}
+
+TEST_F(PoolMemoryAllocatorTest, ResetRecyclesBlocks) {
+  PoolMemoryAllocator allocator;
+
+  void* a = allocator.allocate(100);
+  void* b = allocator.allocate(1000);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  const size_t pooled = allocator.pooled_bytes();
+  allocator.reset();
+
+  // The same sequence is served from the free lists.
+  void* b2 = allocator.allocate(1000);
+  void* a2 = allocator.allocate(100);
+  EXPECT_EQ(a2, a);
+  EXPECT_EQ(b2, b);
+  EXPECT_EQ(allocator.pooled_bytes(), pooled);
+}
+
+TEST_F(PoolMemoryAllocatorTest, LargeAllocationsAreNotPooled) {
+  PoolMemoryAllocator allocator(/*max_block_size=*/1024);
+
+  void* p = allocator.allocate(4096);
+  ASSERT_NE(p, nullptr);
+  memset(p, 0, 4096);
+  EXPECT_EQ(allocator.pooled_bytes(), 0);
+  EXPECT_EQ(allocator.stats().peak_bytes(), 4096);
+  allocator.reset();
+  EXPECT_EQ(allocator.stats().used_bytes(), 0);
+}
+
+TEST_F(PoolMemoryAllocatorTest, InvalidAlignmentFails) {
+  PoolMemoryAllocator allocator;
+  EXPECT_EQ(allocator.allocate(8, 3), nullptr);
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/method_pool.h>
+
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+
+namespace executorch {
+namespace extension {
+namespace ET_MODULE_NAMESPACE {
+
+namespace {
+
+/**
+ * A MallocMemoryAllocator that remembers how many bytes it handed out, so the
+ * pool can report the footprint of an instance.
+ */
+class SizeTrackingMallocAllocator final : public MallocMemoryAllocator {
+ public:
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    allocated_size_ += size;
+    return MallocMemoryAllocator::allocate(size, alignment);
+  }
+
+  void reset() override {
+    allocated_size_ = 0;
+    MallocMemoryAllocator::reset();
+  }
+
+  size_t allocated_size() const {
+    return allocated_size_;
+  }
+
+ private:
+  size_t allocated_size_ = 0;
+};
+
+} // namespace
+
+/**
+ * Forwards to another NamedDataMap, but loads each data buffer once and hands
+ * out non-owning views of it, so every instance reads the same copy of the
+ * weights.
+ */
+class MethodPool::SharedDataMap final : public NamedDataMap {
+ public:
+  explicit SharedDataMap(const NamedDataMap* data_map) : data_map_(data_map) {}
+
+  ET_NODISCARD runtime::Result<const runtime::TensorLayout> get_tensor_layout(
+      executorch::aten::string_view key) const override {
+    return data_map_->get_tensor_layout(key);
+  }
+
+  ET_NODISCARD runtime::Result<runtime::FreeableBuffer> get_data(
+      executorch::aten::string_view key) const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string key_string(key.data(), key.size());
+    auto it = buffers_.find(key_string);
+    if (it == buffers_.end()) {
+      auto buffer = data_map_->get_data(key);
+      if (!buffer.ok()) {
+        return buffer.error();
+      }
+      it = buffers_.emplace(std::move(key_string), std::move(buffer.get()))
+               .first;
+    }
+    return runtime::FreeableBuffer(
+        it->second.data(), it->second.size(), /*free_fn=*/nullptr);
+  }
+
+  ET_NODISCARD runtime::Error load_data_into(
+      executorch::aten::string_view key,
+      void* buffer,
+      size_t size) const override {
+    return data_map_->load_data_into(key, buffer, size);
+  }
+
+  ET_NODISCARD runtime::Result<uint32_t> get_num_keys() const override {
+    return data_map_->get_num_keys();
+  }
+
+  ET_NODISCARD runtime::Result<const char*> get_key(
+      uint32_t index) const override {
+    return data_map_->get_key(index);
+  }
+
+ private:
+  const NamedDataMap* data_map_;
+  mutable std::mutex mutex_;
+  mutable std::unordered_map<std::string, runtime::FreeableBuffer> buffers_;
+};
+
+struct MethodPool::Instance {
+  std::vector<std::vector<uint8_t>> planned_buffers;
+  std::vector<runtime::Span<uint8_t>> planned_spans;
+  std::unique_ptr<runtime::HierarchicalAllocator> planned_memory;
+  SizeTrackingMallocAllocator method_allocator;
+  MallocMemoryAllocator temp_allocator;
+  std::unique_ptr<runtime::MemoryManager> memory_manager;
+  std::unique_ptr<Method> method;
+};
+
+struct MethodPool::State {
+  State(std::shared_ptr<Program> program, const NamedDataMap* data_map)
+      : program(std::move(program)),
+        data_map(
+            data_map ? std::make_unique<SharedDataMap>(data_map) : nullptr) {}
+
+  // Returns a leased instance to the pool, or with nullptr, gives up the slot
+  // of a discarded or failed one.
+  void release(std::unique_ptr<Instance> instance) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (instance) {
+        idle.push_back(std::move(instance));
+      } else {
+        num_instances--;
+      }
+    }
+    instance_returned.notify_one();
+  }
+
+  const std::shared_ptr<Program> program;
+  const std::unique_ptr<SharedDataMap> data_map;
+
+  std::mutex mutex;
+  std::condition_variable instance_returned;
+  // Declared after program and data_map, which the instances reference, so
+  // that they are destroyed first.
+  std::vector<std::unique_ptr<Instance>> idle;
+  size_t num_instances = 0;
+};
+
+MethodPool::Lease::Lease(
+    std::shared_ptr<State> state,
+    std::unique_ptr<Instance> instance)
+    : state_(std::move(state)), instance_(std::move(instance)) {}
+
+MethodPool::Lease::Lease(Lease&& rhs) noexcept
+    : state_(std::move(rhs.state_)), instance_(std::move(rhs.instance_)) {}
+
+MethodPool::Lease::~Lease() {
+  if (state_ != nullptr && instance_ != nullptr) {
+    state_->release(std::move(instance_));
+  }
+}
+
+Method& MethodPool::Lease::method() const {
+  ET_CHECK_MSG(instance_ != nullptr, "Lease is empty");
+  return *instance_->method;
+}
+
+void MethodPool::Lease::discard() {
+  if (state_ != nullptr && instance_ != nullptr) {
+    instance_.reset();
+    state_->release(nullptr);
+  }
+}
+
+MethodPool::MethodPool(
+    std::shared_ptr<Program> program,
+    std::string method_name,
+    const NamedDataMap* data_map,
+    size_t max_instances)
+    : method_name_(std::move(method_name)),
+      max_instances_(max_instances),
+      state_(std::make_shared<State>(std::move(program), data_map)) {}
+
+MethodPool::~MethodPool() = default;
+
+runtime::Result<std::unique_ptr<MethodPool>> MethodPool::load(
+    std::shared_ptr<Program> program,
+    const std::string& method_name,
+    const NamedDataMap* data_map,
+    size_t max_instances,
+    size_t num_initial_instances) {
+  ET_CHECK_OR_RETURN_ERROR(
+      program != nullptr, InvalidArgument, "program must not be null");
+  ET_CHECK_OR_RETURN_ERROR(
+      max_instances == 0 || num_initial_instances <= max_instances,
+      InvalidArgument,
+      "num_initial_instances %zu exceeds max_instances %zu",
+      num_initial_instances,
+      max_instances);
+  std::unique_ptr<MethodPool> pool(new MethodPool(
+      std::move(program), method_name, data_map, max_instances));
+  for (size_t i = 0; i < num_initial_instances; ++i) {
+    auto instance = ET_UNWRAP(pool->load_instance());
+    std::lock_guard<std::mutex> lock(pool->state_->mutex);
+    pool->state_->idle.push_back(std::move(instance));
+    pool->state_->num_instances++;
+  }
+  return pool;
+}
+
+runtime::Result<std::unique_ptr<MethodPool::Instance>>
+MethodPool::load_instance() {
+  std::lock_guard<std::mutex> lock(load_mutex_);
+  const auto method_meta =
+      ET_UNWRAP(state_->program->method_meta(method_name_.c_str()));
+  auto instance = std::make_unique<Instance>();
+  const auto planned_buffers_count = method_meta.num_memory_planned_buffers();
+  instance->planned_buffers.reserve(planned_buffers_count);
+  instance->planned_spans.reserve(planned_buffers_count);
+  size_t planned_size = 0;
+  for (size_t index = 0; index < planned_buffers_count; ++index) {
+    const auto buffer_size =
+        method_meta.memory_planned_buffer_size(index).get();
+    instance->planned_buffers.emplace_back(buffer_size);
+    instance->planned_spans.emplace_back(
+        instance->planned_buffers.back().data(), buffer_size);
+    planned_size += buffer_size;
+  }
+  instance->planned_memory =
+      std::make_unique<runtime::HierarchicalAllocator>(runtime::Span(
+          instance->planned_spans.data(), instance->planned_spans.size()));
+  instance->memory_manager = std::make_unique<runtime::MemoryManager>(
+      &instance->method_allocator,
+      instance->planned_memory.get(),
+      &instance->temp_allocator);
+  auto method = state_->program->load_method(
+      method_name_.c_str(),
+      instance->memory_manager.get(),
+      /*event_tracer=*/nullptr,
+      state_->data_map.get());
+  if (!method.ok()) {
+    return method.error();
+  }
+  instance->method = std::make_unique<Method>(std::move(method.get()));
+  instance_memory_size_ =
+      planned_size + instance->method_allocator.allocated_size();
+  return instance;
+}
+
+runtime::Result<MethodPool::Lease> MethodPool::checkout() {
+  return checkout(/*wait=*/true);
+}
+
+runtime::Result<MethodPool::Lease> MethodPool::try_checkout() {
+  return checkout(/*wait=*/false);
+}
+
+runtime::Result<MethodPool::Lease> MethodPool::checkout(bool wait) {
+  {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    const auto can_proceed = [this] {
+      return !state_->idle.empty() || max_instances_ == 0 ||
+          state_->num_instances < max_instances_;
+    };
+    if (!can_proceed()) {
+      ET_CHECK_OR_RETURN_ERROR(
+          wait,
+          OutOfResources,
+          "All %zu instances of %s are leased",
+          state_->num_instances,
+          method_name_.c_str());
+      state_->instance_returned.wait(lock, can_proceed);
+    }
+    if (!state_->idle.empty()) {
+      auto instance = std::move(state_->idle.back());
+      state_->idle.pop_back();
+      return Lease(state_, std::move(instance));
+    }
+    // Reserve the slot before loading outside of the lock.
+    state_->num_instances++;
+  }
+  auto instance = load_instance();
+  if (!instance.ok()) {
+    state_->release(nullptr);
+    return instance.error();
+  }
+  return Lease(state_, std::move(instance.get()));
+}
+
+size_t MethodPool::num_instances() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->num_instances;
+}
+
+size_t MethodPool::num_idle() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->idle.size();
+}
+
+} // namespace ET_MODULE_NAMESPACE
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <executorch/extension/module/module.h>
+
+namespace executorch {
+namespace extension {
+namespace ET_MODULE_NAMESPACE {
+
+/**
+ * A pool of executable instances of a single method, all created from one
+ * shared Program.
+ *
+ * Every instance has its own planned memory, method allocator and temp
+ * allocator, so leased instances can execute concurrently. All instances share
+ * the Program (and therefore its constant segment) and read external weights
+ * through a single cache, so each weight in the NamedDataMap is loaded once
+ * for the whole pool rather than once per instance.
+ *
+ * Nothing else is shared. In particular, kernel tables and delegate handles
+ * are not: every instance resolves its own kernels and initializes its own
+ * delegates, since a Method owns both. A delegate that packs its weights at
+ * init time keeps one packed copy per instance unless the backend dedupes
+ * them itself.
+ *
+ * Leases may outlive the pool. An instance leased when the pool is destroyed
+ * is freed, together with the Program it references, once its lease is
+ * destroyed.
+ */
+class MethodPool final {
+  struct Instance;
+  struct State;
+
+ public:
+  /**
+   * Exclusive access to one instance of the method. The instance returns to
+   * the pool when the lease is destroyed.
+   */
+  class Lease final {
+   public:
+    Lease(Lease&& rhs) noexcept;
+    Lease& operator=(Lease&&) = delete;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    ~Lease();
+
+    /// The leased method.
+    Method& method() const;
+
+    inline Method* operator->() const {
+      return &method();
+    }
+
+    inline Method& operator*() const {
+      return method();
+    }
+
+    /**
+     * Destroys the instance instead of returning it to the pool. Use this
+     * when execution failed part way, since such a Method cannot be reset.
+     */
+    void discard();
+
+   private:
+    friend class MethodPool;
+    Lease(std::shared_ptr<State> state, std::unique_ptr<Instance> instance);
+
+    std::shared_ptr<State> state_;
+    std::unique_ptr<Instance> instance_;
+  };
+
+  /**
+   * Creates a pool and eagerly loads its first instances.
+   *
+   * @param[in] program The program to create instances from. Must be loaded.
+   * @param[in] method_name The name of the method to instantiate.
+   * @param[in] data_map Optional external weights. Must outlive the pool and
+   *     its leases.
+   * @param[in] max_instances Maximum number of instances. checkout() blocks
+   *     once all of them are leased. Zero means unbounded.
+   * @param[in] num_initial_instances Number of instances to load up front, so
+   *     that the first checkouts do not pay for method initialization.
+   *
+   * @returns The pool, or an error if an instance failed to load.
+   */
+  ET_NODISCARD static runtime::Result<std::unique_ptr<MethodPool>> load(
+      std::shared_ptr<Program> program,
+      const std::string& method_name,
+      const NamedDataMap* data_map = nullptr,
+      size_t max_instances = 0,
+      size_t num_initial_instances = 1);
+
+  MethodPool(const MethodPool&) = delete;
+  MethodPool& operator=(const MethodPool&) = delete;
+  MethodPool(MethodPool&&) = delete;
+  MethodPool& operator=(MethodPool&&) = delete;
+  ~MethodPool();
+
+  /**
+   * Leases an idle instance, loading a new one if none is idle and the pool
+   * is below `max_instances`. Otherwise blocks until an instance is returned.
+   *
+   * @returns A lease on the instance, or an error if loading failed.
+   */
+  ET_NODISCARD runtime::Result<Lease> checkout();
+
+  /**
+   * Like checkout(), but fails with Error::OutOfResources instead of
+   * blocking when every instance is leased and no more may be created.
+   */
+  ET_NODISCARD runtime::Result<Lease> try_checkout();
+
+  /// The name of the pooled method.
+  inline const std::string& method_name() const {
+    return method_name_;
+  }
+
+  /// Number of instances created so far.
+  size_t num_instances() const;
+
+  /// Number of instances waiting in the pool.
+  size_t num_idle() const;
+
+  /**
+   * Bytes of memory owned by one instance: its planned buffers plus what
+   * Method initialization allocated from its method allocator. Shared weights
+   * and the Program are not included.
+   */
+  inline size_t instance_memory_size() const {
+    return instance_memory_size_;
+  }
+
+ private:
+  class SharedDataMap;
+  friend class Lease;
+
+  MethodPool(
+      std::shared_ptr<Program> program,
+      std::string method_name,
+      const NamedDataMap* data_map,
+      size_t max_instances);
+
+  ET_NODISCARD runtime::Result<std::unique_ptr<Instance>> load_instance();
+  ET_NODISCARD runtime::Result<Lease> checkout(bool wait);
+
+  const std::string method_name_;
+  const size_t max_instances_;
+  std::atomic<size_t> instance_memory_size_{0};
+  // The Program, the weights and the idle instances, which leases keep alive
+  // after the pool is gone.
+  const std::shared_ptr<State> state_;
+  // Serializes instance loading, since backend init() is not required to be
+  // thread-safe.
+  std::mutex load_mutex_;
+};
+
+} // namespace ET_MODULE_NAMESPACE
+} // namespace extension
+} // namespace executorch
+
+namespace executorch {
+namespace extension {
+using ::executorch::extension::ET_MODULE_NAMESPACE::MethodPool;
+} // namespace extension
+} // namespace executorch
@@ -8,11 +8,24 @@
 
 #include <executorch/extension/module/module.h>
 
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/data_loader/mmap_data_loader.h>
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+#include <executorch/extension/data_loader/streaming_data_loader.h>
 #include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
+#include <executorch/extension/flat_tensor/serialize/flat_tensor_generated.h>
+#include <executorch/extension/flat_tensor/serialize/flat_tensor_header.h>
 #include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/extension/module/method_pool.h>
+#include <executorch/extension/threadpool/worker_pool.h>
 #include <executorch/runtime/platform/runtime.h>
+#include <executorch/schema/extended_header.h>
+#include <executorch/schema/program_generated.h>
 
 /**
  * Unwrap a Result to obtain its value (direct object, not a pointer).
@@ -42,9 +55,120 @@ using ET_RUNTIME_NAMESPACE::MethodMeta;
 using ET_RUNTIME_NAMESPACE::Program;
 
 namespace {
+using SegmentInfo = runtime::DataLoader::SegmentInfo;
+
+/**
+ * Queues reads of every segment of a .pte file except the mutable ones, which
+ * are only ever copied out of with load_into() and would stay resident.
+ */
+runtime::Error prefetch_program_segments(PrefetchingDataLoader& loader) {
+  auto header = loader.load(
+      /*offset=*/0,
+      runtime::ExtendedHeader::kNumHeadBytes,
+      SegmentInfo(SegmentInfo::Type::Program));
+  if (!header.ok()) {
+    return header.error();
+  }
+  auto extended_header =
+      runtime::ExtendedHeader::Parse(header->data(), header->size());
+  if (!extended_header.ok()) {
+    // Without a header there are no segments.
+    return extended_header.error() == runtime::Error::NotFound
+        ? runtime::Error::Ok
+        : extended_header.error();
+  }
+  // The flatbuffer is small next to the segments; it is read again, in full,
+  // by Program::load() while the segments stream in.
+  auto program_data = loader.load(
+      /*offset=*/0,
+      extended_header->program_size,
+      SegmentInfo(SegmentInfo::Type::Program));
+  if (!program_data.ok()) {
+    return program_data.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      executorch_flatbuffer::ProgramBufferHasIdentifier(program_data->data()),
+      InvalidProgram,
+      "Unexpected program identifier");
+  const auto* program = executorch_flatbuffer::GetProgram(program_data->data());
+  const auto* segments = program->segments();
+  if (segments == nullptr) {
+    return runtime::Error::Ok;
+  }
+  std::vector<bool> is_mutable(segments->size(), false);
+  if (const auto* mutable_segments = program->mutable_data_segments()) {
+    for (const auto* segment : *mutable_segments) {
+      if (segment->segment_index() < is_mutable.size()) {
+        is_mutable[segment->segment_index()] = true;
+      }
+    }
+  }
+  const auto* constant_segment = program->constant_segment();
+  for (size_t i = 0; i < segments->size(); ++i) {
+    if (is_mutable[i]) {
+      continue;
+    }
+    const bool is_constant =
+        constant_segment != nullptr && constant_segment->segment_index() == i;
+    ET_CHECK_OK_OR_RETURN_ERROR(loader.prefetch(
+        extended_header->segment_base_offset + segments->Get(i)->offset(),
+        segments->Get(i)->size(),
+        SegmentInfo(
+            is_constant ? SegmentInfo::Type::Constant
+                        : SegmentInfo::Type::Backend,
+            i)));
+  }
+  return runtime::Error::Ok;
+}
+
+/**
+ * Queues reads of every segment of a .ptd file.
+ */
+runtime::Error prefetch_data_map_segments(PrefetchingDataLoader& loader) {
+  auto header = loader.load(
+      /*offset=*/0,
+      FlatTensorHeader::kNumHeadBytes,
+      SegmentInfo(SegmentInfo::Type::External));
+  if (!header.ok()) {
+    return header.error();
+  }
+  auto flat_tensor_header =
+      FlatTensorHeader::Parse(header->data(), header->size());
+  if (!flat_tensor_header.ok()) {
+    return flat_tensor_header.error();
+  }
+  auto flat_tensor_data = loader.load(
+      /*offset=*/0,
+      flat_tensor_header->flatbuffer_offset +
+          flat_tensor_header->flatbuffer_size,
+      SegmentInfo(SegmentInfo::Type::External));
+  if (!flat_tensor_data.ok()) {
+    return flat_tensor_data.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      flat_tensor_flatbuffer::FlatTensorBufferHasIdentifier(
+          flat_tensor_data->data()),
+      InvalidExternalData,
+      "Unexpected flat tensor identifier");
+  const auto* segments =
+      flat_tensor_flatbuffer::GetFlatTensor(flat_tensor_data->data())
+          ->segments();
+  if (segments == nullptr) {
+    return runtime::Error::Ok;
+  }
+  for (size_t i = 0; i < segments->size(); ++i) {
+    ET_CHECK_OK_OR_RETURN_ERROR(loader.prefetch(
+        flat_tensor_header->segment_base_offset + segments->Get(i)->offset(),
+        segments->Get(i)->size(),
+        SegmentInfo(SegmentInfo::Type::External, i)));
+  }
+  return runtime::Error::Ok;
+}
+
 runtime::Result<std::unique_ptr<runtime::DataLoader>> load_file(
     const std::string& file_path,
-    Module::LoadMode mode) {
+    Module::LoadMode mode,
+    runtime::Error (*prefetch_segments)(PrefetchingDataLoader&)) {
   std::unique_ptr<runtime::DataLoader> res = nullptr;
   switch (mode) {
     case Module::LoadMode::File:
@@ -62,11 +186,94 @@ runtime::Result<std::unique_ptr<runtime::DataLoader>> load_file(
           file_path.c_str(),
           MmapDataLoader::MlockConfig::UseMlockIgnoreErrors));
       break;
+    case Module::LoadMode::FilePrefetch: {
+      auto prefetching_loader = std::make_unique<PrefetchingDataLoader>(
+          ET_UNWRAP_UNIQUE(FileDataLoader::from(file_path.c_str())));
+      const auto error = prefetch_segments(*prefetching_loader);
+      if (error != runtime::Error::Ok) {
+        // Not fatal: whatever was not queued is read on demand, and a file
+        // that is actually malformed fails to load with a proper error.
+        ET_LOG(
+            Info,
+            "Prefetching %s failed with 0x%" PRIx32,
+            file_path.c_str(),
+            static_cast<uint32_t>(error));
+      }
+      res = std::move(prefetching_loader);
+      break;
+    }
+    case Module::LoadMode::FileStreaming:
+      res = std::make_unique<StreamingDataLoader>(
+          ET_UNWRAP_UNIQUE(FileDataLoader::from(file_path.c_str())));
+      break;
   }
   return res;
 }
 } // namespace
 
+/**
+ * State shared between the submitting thread and the workers of
+ * execute_async().
+ */
+struct Module::AsyncState {
+  explicit AsyncState(const AsyncConfig& config) : workers(config.num_threads) {
+    max_in_flight = config.max_in_flight > 0 ? config.max_in_flight
+                                             : workers.num_threads();
+  }
+
+  /// Blocks until a request slot is available and claims it.
+  void acquire_slot() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slot_released.wait(lock, [this] { return in_flight < max_in_flight; });
+    ++in_flight;
+  }
+
+  /// Releases a request slot.
+  void release_slot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    --in_flight;
+    // Notify while holding the lock so that ~Module() cannot destroy this
+    // state between the decrement and the notification.
+    slot_released.notify_all();
+  }
+
+  /// Blocks until every request has completed and its outputs are released.
+  void wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    slot_released.wait(lock, [this] { return in_flight == 0; });
+  }
+
+  /// Returns the instance pool for the method, creating it if needed.
+  runtime::Result<MethodPool*> pool(
+      const std::shared_ptr<Program>& program,
+      const std::string& method_name,
+      const NamedDataMap* data_map) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pools.find(method_name);
+    if (it == pools.end()) {
+      // Every request holds at most one instance, so the pool never needs
+      // more than max_in_flight of them.
+      auto method_pool = ET_UNWRAP(MethodPool::load(
+          program,
+          method_name,
+          data_map,
+          max_in_flight,
+          /*num_initial_instances=*/0));
+      it = pools.emplace(method_name, std::move(method_pool)).first;
+    }
+    return it->second.get();
+  }
+
+  std::mutex mutex;
+  std::condition_variable slot_released;
+  size_t in_flight = 0;
+  size_t max_in_flight = 0;
+  std::unordered_map<std::string, std::unique_ptr<MethodPool>> pools;
+  // Declared last so that the workers are joined before the fields above are
+  // destroyed.
+  threadpool::WorkerPool workers;
+};
+
 Module::Module(
     const std::string& file_path,
     const LoadMode load_mode,
@@ -135,11 +342,25 @@ Module::Module(
   runtime::runtime_init();
 }
 
+Module::~Module() {
+  if (async_state_) {
+    async_state_->wait_idle();
+    async_state_.reset();
+  }
+  // Members are destroyed in reverse order, which would destroy data_loader_
+  // before program_. The program frees its segments through the loader, e.g.
+  // StreamingDataLoader's in-flight constant buffers, so release the methods
+  // and the program first.
+  methods_.clear();
+  program_.reset();
+}
+
 runtime::Error Module::load(const Program::Verification verification) {
   if (!is_loaded()) {
     // Load the program
     if (!data_loader_) {
-      auto res = load_file(file_path_, load_mode_);
+      auto res =
+          load_file(file_path_, load_mode_, prefetch_program_segments);
       if (!res.ok()) {
         return res.error();
       }
@@ -147,7 +368,8 @@ runtime::Error Module::load(const Program::Verification verification) {
     }
     // If a .ptd path was given load it.
     if (data_map_path_ != "") {
-      auto res = load_file(data_map_path_, load_mode_);
+      auto res =
+          load_file(data_map_path_, load_mode_, prefetch_data_map_segments);
       if (!res.ok()) {
         return res.error();
       }
@@ -279,6 +501,102 @@ runtime::Result<std::vector<runtime::EValue>> Module::execute(
   return outputs;
 }
 
+runtime::Error Module::configure_async(const AsyncConfig& config) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !async_state_,
+      InvalidState,
+      "async execution is already running with a fixed configuration");
+  async_config_ = config;
+  return runtime::Error::Ok;
+}
+
+runtime::Error Module::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values,
+    AsyncCallback callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      callback != nullptr, InvalidArgument, "callback must not be null");
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+  const auto method_metadata =
+      ET_UNWRAP(program_->method_meta(method_name.c_str()));
+  ET_CHECK_OR_RETURN_ERROR(
+      input_values.size() == method_metadata.num_inputs(),
+      InvalidArgument,
+      "input size: %zu does not match method input size: %zu",
+      input_values.size(),
+      method_metadata.num_inputs());
+  for (size_t i = 0; i < input_values.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        !input_values[i].isNone(), InvalidArgument, "input %zu is none", i);
+  }
+  if (!async_state_) {
+    async_state_ = std::make_unique<AsyncState>(async_config_);
+  }
+  AsyncState* state = async_state_.get();
+  state->acquire_slot();
+  state->workers.submit([state,
+                         program = program_,
+                         data_map = data_map_.get(),
+                         method_name,
+                         input_values = std::move(input_values),
+                         callback = std::move(callback)]() {
+    auto pool = state->pool(program, method_name, data_map);
+    if (!pool.ok()) {
+      state->release_slot();
+      callback(pool.error());
+      return;
+    }
+    auto lease = pool.get()->checkout();
+    if (!lease.ok()) {
+      state->release_slot();
+      callback(lease.error());
+      return;
+    }
+    auto& method = *lease.get();
+    auto error = method.set_inputs(executorch::aten::ArrayRef<runtime::EValue>(
+        input_values.data(), input_values.size()));
+    if (error == runtime::Error::Ok) {
+      error = method.execute();
+    }
+    std::vector<runtime::EValue> outputs(method.outputs_size());
+    if (error == runtime::Error::Ok) {
+      error = method.get_outputs(outputs.data(), outputs.size());
+    }
+    if (error != runtime::Error::Ok) {
+      // A method that failed mid-execution cannot be reset, so drop it.
+      lease->discard();
+      state->release_slot();
+      callback(error);
+      return;
+    }
+    std::shared_ptr<void> output_lease(
+        new MethodPool::Lease(std::move(lease.get())), [state](void* pointer) {
+          delete static_cast<MethodPool::Lease*>(pointer);
+          state->release_slot();
+        });
+    callback(AsyncOutputs(std::move(outputs), std::move(output_lease)));
+  });
+  return runtime::Error::Ok;
+}
+
+std::future<runtime::Result<Module::AsyncOutputs>> Module::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values) {
+  auto promise =
+      std::make_shared<std::promise<runtime::Result<AsyncOutputs>>>();
+  auto future = promise->get_future();
+  const auto error = execute_async(
+      method_name,
+      std::move(input_values),
+      [promise](runtime::Result<AsyncOutputs> outputs) {
+        promise->set_value(std::move(outputs));
+      });
+  if (error != runtime::Error::Ok) {
+    promise->set_value(error);
+  }
+  return future;
+}
+
 runtime::Error Module::set_input(
     const std::string& method_name,
     const runtime::EValue& input_value,
@@ -303,6 +621,23 @@ runtime::Error Module::set_inputs(
   return runtime::Error::Ok;
 }
 
+runtime::Result<runtime::EValue> Module::get_input(
+    const std::string& method_name,
+    size_t input_index) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  auto& method = methods_.at(method_name).method;
+  const auto inputs_size = method->inputs_size();
+  ET_CHECK_OR_RETURN_ERROR(
+      input_index < inputs_size,
+      InvalidArgument,
+      "input index: %zu is out of range for method input size: %zu",
+      input_index,
+      inputs_size);
+  std::vector<runtime::EValue> inputs(inputs_size);
+  ET_CHECK_OK_OR_RETURN_ERROR(method->get_inputs(inputs.data(), inputs_size));
+  return inputs[input_index];
+}
+
 runtime::Error Module::set_output(
     const std::string& method_name,
     runtime::EValue output_value,
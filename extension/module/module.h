@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -50,8 +52,77 @@ class Module {
     MmapUseMlock,
     /// Use memory locking and ignore errors.
     MmapUseMlockIgnoreErrors,
+    /// Like File, but read every segment listed in the program and data map
+    /// headers up front, in parallel. See PrefetchingDataLoader.
+    FilePrefetch,
+    /// Like File, but read constant weights in the background, so that
+    /// execution starts before they are all resident and each instruction
+    /// only waits for the weights it reads. See StreamingDataLoader.
+    FileStreaming,
   };
 
+  /**
+   * Configuration for asynchronous execution via execute_async().
+   */
+  struct AsyncConfig {
+    /// Number of worker threads that run submitted requests. Zero means one
+    /// per hardware thread.
+    size_t num_threads = 0;
+    /// Maximum number of requests in flight across all methods, which is also
+    /// the maximum number of method instances that are created per method.
+    /// Submitting beyond this blocks the caller until a request completes and
+    /// its outputs are released. Zero means `num_threads`.
+    size_t max_in_flight = 0;
+  };
+
+  /**
+   * Outputs of an asynchronous execution.
+   *
+   * The output tensors alias the planned memory of the method instance that
+   * produced them. That instance is not handed to another request until this
+   * object is destroyed, so it counts towards `AsyncConfig::max_in_flight`
+   * until then. Must not outlive the Module.
+   */
+  class AsyncOutputs final {
+   public:
+    AsyncOutputs() = default;
+    AsyncOutputs(AsyncOutputs&&) = default;
+    AsyncOutputs& operator=(AsyncOutputs&&) = default;
+    AsyncOutputs(const AsyncOutputs&) = delete;
+    AsyncOutputs& operator=(const AsyncOutputs&) = delete;
+
+    /// The method outputs.
+    inline const std::vector<runtime::EValue>& values() const {
+      return values_;
+    }
+
+    /// Shorthand for `values()[index]`.
+    inline const runtime::EValue& operator[](size_t index) const {
+      return values_[index];
+    }
+
+    /// Number of outputs.
+    inline size_t size() const {
+      return values_.size();
+    }
+
+   private:
+    friend class Module;
+    AsyncOutputs(
+        std::vector<runtime::EValue> values,
+        std::shared_ptr<void> lease)
+        : values_(std::move(values)), lease_(std::move(lease)) {}
+
+    std::vector<runtime::EValue> values_;
+    std::shared_ptr<void> lease_;
+  };
+
+  /**
+   * Callback invoked on a worker thread when an asynchronous execution
+   * finishes.
+   */
+  using AsyncCallback = std::function<void(runtime::Result<AsyncOutputs>)>;
+
   /**
    * Constructs an instance by loading a program from a file with specified
    * memory locking behavior.
@@ -119,7 +190,7 @@ class Module {
   Module& operator=(const Module&) = delete;
   Module(Module&&) = delete;
   Module& operator=(Module&&) = delete;
-  virtual ~Module() = default;
+  virtual ~Module();
   /**
    * Loads the program if needed.
    *
@@ -442,6 +513,36 @@ class Module {
     return set_inputs("forward", input_values);
   }
 
+  /**
+   * Retrieves the Method's own value for an input of a specific method. For
+   * a memory-planned tensor input, the returned Tensor refers to the planned
+   * input buffer: writing input data into it and passing it back through
+   * set_input() or execute() binds the input without copying it.
+   *
+   * @param[in] method_name The name of the method.
+   * @param[in] input_index Zero-based index of the input to retrieve.
+   *
+   * @returns The input value, or an error if the method could not be loaded
+   * or the index is out of range.
+   */
+  ET_NODISCARD
+  runtime::Result<runtime::EValue> get_input(
+      const std::string& method_name,
+      size_t input_index);
+
+  /**
+   * Retrieves the Method's own value for an input of the "forward" method.
+   *
+   * @param[in] input_index Zero-based index of the input to retrieve.
+   *
+   * @returns The input value, or an error if the method could not be loaded
+   * or the index is out of range.
+   */
+  ET_NODISCARD
+  inline runtime::Result<runtime::EValue> get_input(size_t input_index) {
+    return get_input("forward", input_index);
+  }
+
   /**
    * Sets the output tensor for a specific method.
    *
@@ -478,6 +579,71 @@ class Module {
     return set_output("forward", std::move(output_value), output_index);
   }
 
+  /**
+   * Configures asynchronous execution. Must be called before the first
+   * execute_async() call; afterwards the configuration is fixed.
+   *
+   * @param[in] config The worker and in-flight limits to use.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_NODISCARD
+  runtime::Error configure_async(const AsyncConfig& config);
+
+  /**
+   * Submits a method for asynchronous execution and returns immediately,
+   * unless `AsyncConfig::max_in_flight` requests are already in flight, in
+   * which case it blocks until one of them completes.
+   *
+   * Each in-flight request runs on its own instance of the method, with its
+   * own planned memory and temporary allocator, so several requests for the
+   * same or different methods execute concurrently. Instances are created on
+   * demand and reused. They do not share inputs set with set_input(), and
+   * they are not traced by the Module's EventTracer.
+   *
+   * Tensor inputs must stay valid until the request completes.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[in] input_values Values for all of the method inputs.
+   * @param[in] callback Called on a worker thread with the outputs or the
+   * error once execution finishes.
+   *
+   * @returns An Error if the request could not be submitted. Errors during
+   * execution are passed to `callback`.
+   */
+  ET_NODISCARD
+  runtime::Error execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values,
+      AsyncCallback callback);
+
+  /**
+   * Submits a method for asynchronous execution. See the callback overload
+   * for details.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[in] input_values Values for all of the method inputs.
+   *
+   * @returns A future that becomes ready with the outputs or an error once
+   * execution finishes.
+   */
+  std::future<runtime::Result<AsyncOutputs>> execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values);
+
+  /**
+   * Submits the 'forward' method for asynchronous execution.
+   *
+   * @param[in] input_values Values for all of the 'forward' method inputs.
+   *
+   * @returns A future that becomes ready with the outputs or an error once
+   * execution finishes.
+   */
+  inline std::future<runtime::Result<AsyncOutputs>> forward_async(
+      std::vector<runtime::EValue> input_values) {
+    return execute_async("forward", std::move(input_values));
+  }
+
   /**
    * Retrieves the EventTracer instance being used by the Module.
    * EventTracer is used for tracking and logging events during the execution
@@ -504,6 +670,7 @@ class Module {
     std::unique_ptr<Method> method;
     std::vector<runtime::EValue> inputs;
   };
+  struct AsyncState;
 
   std::string file_path_;
   std::string data_map_path_;
@@ -516,6 +683,8 @@ class Module {
   std::unique_ptr<runtime::DataLoader> data_map_loader_;
   std::unique_ptr<NamedDataMap> data_map_;
   std::vector<uint8_t> debug_buffer_;
+  AsyncConfig async_config_;
+  std::unique_ptr<AsyncState> async_state_;
 
  protected:
   std::unordered_map<std::string, MethodHolder> methods_;
@@ -13,9 +13,11 @@ def define_common_targets():
         runtime.cxx_library(
             name = "module" + aten_suffix,
             srcs = [
+                "method_pool.cpp",
                 "module.cpp",
             ],
             exported_headers = [
+                "method_pool.h",
                 "module.h",
             ],
             visibility = [
@@ -25,7 +27,12 @@ def define_common_targets():
                 "//executorch/extension/memory_allocator:malloc_memory_allocator",
                 "//executorch/extension/data_loader:file_data_loader",
                 "//executorch/extension/data_loader:mmap_data_loader",
+                "//executorch/extension/data_loader:prefetching_data_loader",
+                "//executorch/extension/data_loader:streaming_data_loader",
                 "//executorch/extension/flat_tensor:flat_tensor_data_map" + aten_suffix,
+                "//executorch/extension/threadpool:worker_pool",
+                "//executorch/schema:extended_header",
+                "//executorch/schema:program",
             ],
             exported_deps = [
                 "//executorch/runtime/executor:program_no_prim_ops" + aten_suffix,
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Reports the memory owned by each additional MethodPool instance and the
+ * checkout/return latency of the pool under contention.
+ *
+ * Usage: method_pool_benchmark <model.pte> [method] [max_threads]
+ */
+
+#include <executorch/extension/module/method_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace ::executorch::extension;
+using ::executorch::runtime::Error;
+
+namespace {
+
+constexpr size_t kIterationsPerThread = 10000;
+
+double measure_checkout_ns(MethodPool& pool, size_t num_threads) {
+  std::vector<std::thread> threads;
+  std::vector<double> per_thread_ns(num_threads);
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&pool, &per_thread_ns, t] {
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < kIterationsPerThread; ++i) {
+        auto lease = pool.checkout();
+        if (!lease.ok()) {
+          std::abort();
+        }
+      }
+      const auto end = std::chrono::steady_clock::now();
+      per_thread_ns[t] =
+          std::chrono::duration<double, std::nano>(end - start).count() /
+          kIterationsPerThread;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return *std::max_element(per_thread_ns.begin(), per_thread_ns.end());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(
+        stderr, "Usage: %s <model.pte> [method] [max_threads]\n", argv[0]);
+    return 1;
+  }
+  const std::string method_name = argc > 2 ? argv[2] : "forward";
+  const size_t max_threads = argc > 3 ? std::atoi(argv[3]) : 8;
+
+  Module module(argv[1]);
+  if (module.load() != Error::Ok) {
+    std::fprintf(stderr, "Failed to load %s\n", argv[1]);
+    return 1;
+  }
+  for (size_t num_instances : {1, 2, 4}) {
+    auto pool = MethodPool::load(
+        module.program(),
+        method_name,
+        /*data_map=*/nullptr,
+        num_instances,
+        num_instances);
+    if (!pool.ok()) {
+      std::fprintf(stderr, "Failed to load %s\n", method_name.c_str());
+      return 1;
+    }
+    std::printf(
+        "instances=%zu memory_per_instance_bytes=%zu\n",
+        num_instances,
+        (*pool)->instance_memory_size());
+    for (size_t num_threads = 1; num_threads <= max_threads;
+         num_threads *= 2) {
+      std::printf(
+          "  threads=%zu checkout_return_ns=%.1f\n",
+          num_threads,
+          measure_checkout_ns(**pool, num_threads));
+    }
+  }
+  return 0;
+}
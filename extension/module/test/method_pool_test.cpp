@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/method_pool.h>
+
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::runtime;
+
+class MethodPoolTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("ET_MODULE_ADD_PATH");
+    add_mul_path_ = std::getenv("ET_MODULE_ADD_MUL_PROGRAM_PATH");
+    add_mul_data_path_ = std::getenv("ET_MODULE_ADD_MUL_DATA_PATH");
+  }
+
+  // The Program reads through its Module's data loader, so the Module is
+  // kept alive for the rest of the test.
+  std::shared_ptr<Program> load_program(const std::string& path) {
+    modules_.push_back(std::make_unique<Module>(path));
+    EXPECT_EQ(modules_.back()->load(), Error::Ok);
+    return modules_.back()->program();
+  }
+
+  std::vector<std::unique_ptr<Module>> modules_;
+
+  static inline std::string model_path_;
+  static inline std::string add_mul_path_;
+  static inline std::string add_mul_data_path_;
+};
+
+TEST_F(MethodPoolTest, LoadCreatesInitialInstances) {
+  auto pool = MethodPool::load(
+      load_program(model_path_),
+      "forward",
+      /*data_map=*/nullptr,
+      /*max_instances=*/4,
+      /*num_initial_instances=*/2);
+  ASSERT_EQ(pool.error(), Error::Ok);
+  EXPECT_EQ((*pool)->num_instances(), 2);
+  EXPECT_EQ((*pool)->num_idle(), 2);
+  EXPECT_EQ((*pool)->method_name(), "forward");
+  EXPECT_GT((*pool)->instance_memory_size(), 0);
+}
+
+TEST_F(MethodPoolTest, LoadRejectsInvalidArguments) {
+  EXPECT_NE(MethodPool::load(nullptr, "forward").error(), Error::Ok);
+  EXPECT_NE(
+      MethodPool::load(load_program(model_path_), "nonexistent").error(),
+      Error::Ok);
+  EXPECT_EQ(
+      MethodPool::load(
+          load_program(model_path_),
+          "forward",
+          /*data_map=*/nullptr,
+          /*max_instances=*/1,
+          /*num_initial_instances=*/2)
+          .error(),
+      Error::InvalidArgument);
+}
+
+TEST_F(MethodPoolTest, CheckoutExecutesAndReturns) {
+  auto pool = MethodPool::load(load_program(model_path_), "forward");
+  ASSERT_EQ(pool.error(), Error::Ok);
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  {
+    auto lease = (*pool)->checkout();
+    ASSERT_EQ(lease.error(), Error::Ok);
+    EXPECT_EQ((*pool)->num_idle(), 0);
+
+    auto& method = *lease.get();
+    std::vector<EValue> inputs = {tensor, tensor, 1.0};
+    ASSERT_EQ(method.set_inputs({inputs.data(), inputs.size()}), Error::Ok);
+    ASSERT_EQ(method.execute(), Error::Ok);
+
+    const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+    EXPECT_TENSOR_CLOSE(method.get_output(0).toTensor(), *expected.get());
+  }
+  EXPECT_EQ((*pool)->num_idle(), 1);
+  EXPECT_EQ((*pool)->num_instances(), 1);
+}
+
+TEST_F(MethodPoolTest, TryCheckoutFailsWhenExhausted) {
+  auto pool = MethodPool::load(
+      load_program(model_path_),
+      "forward",
+      /*data_map=*/nullptr,
+      /*max_instances=*/2);
+  ASSERT_EQ(pool.error(), Error::Ok);
+
+  auto lease1 = (*pool)->try_checkout();
+  auto lease2 = (*pool)->try_checkout();
+  ASSERT_EQ(lease1.error(), Error::Ok);
+  ASSERT_EQ(lease2.error(), Error::Ok);
+  EXPECT_EQ((*pool)->num_instances(), 2);
+  EXPECT_EQ((*pool)->try_checkout().error(), Error::OutOfResources);
+
+  lease1->discard();
+  EXPECT_EQ((*pool)->num_instances(), 1);
+  EXPECT_EQ((*pool)->try_checkout().error(), Error::Ok);
+}
+
+TEST_F(MethodPoolTest, ConcurrentCheckouts) {
+  auto pool = MethodPool::load(
+      load_program(model_path_),
+      "forward",
+      /*data_map=*/nullptr,
+      /*max_instances=*/2);
+  ASSERT_EQ(pool.error(), Error::Ok);
+
+  auto worker = [&pool](float offset) {
+    for (int i = 0; i < 20; ++i) {
+      std::array<float, 4> input = {offset, offset + 1, offset + 2, i * 1.f};
+      auto tensor = from_blob(input.data(), {2, 2});
+      auto lease = (*pool)->checkout();
+      ASSERT_EQ(lease.error(), Error::Ok);
+      std::vector<EValue> inputs = {tensor, tensor, 1.0};
+      auto& method = *lease.get();
+      ASSERT_EQ(method.set_inputs({inputs.data(), inputs.size()}), Error::Ok);
+      ASSERT_EQ(method.execute(), Error::Ok);
+      const auto data = method.get_output(0).toTensor().const_data_ptr<float>();
+      EXPECT_NEAR(data[0], offset * 2, 1e-5);
+      EXPECT_NEAR(data[3], i * 2.f, 1e-5);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 5; ++i) {
+    threads.emplace_back(worker, i * 10.f);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE((*pool)->num_instances(), 2);
+  EXPECT_EQ((*pool)->num_idle(), (*pool)->num_instances());
+}
+
+TEST_F(MethodPoolTest, InstancesShareExternalWeights) {
+  auto data_loader = FileDataLoader::from(add_mul_data_path_.c_str());
+  ASSERT_EQ(data_loader.error(), Error::Ok);
+  auto data_map = FlatTensorDataMap::load(&data_loader.get());
+  ASSERT_EQ(data_map.error(), Error::Ok);
+
+  auto pool = MethodPool::load(
+      load_program(add_mul_path_),
+      "forward",
+      &data_map.get(),
+      /*max_instances=*/0,
+      /*num_initial_instances=*/3);
+  ASSERT_EQ(pool.error(), Error::Ok);
+  EXPECT_EQ((*pool)->num_instances(), 3);
+
+  auto tensor = make_tensor_ptr({2, 2}, {2.f, 3.f, 4.f, 2.f});
+  std::vector<EValue> inputs = {tensor};
+  auto lease1 = (*pool)->checkout();
+  auto lease2 = (*pool)->checkout();
+  ASSERT_EQ(lease1.error(), Error::Ok);
+  ASSERT_EQ(lease2.error(), Error::Ok);
+  for (auto* lease : {&lease1.get(), &lease2.get()}) {
+    ASSERT_EQ((*lease)->set_inputs({inputs.data(), inputs.size()}), Error::Ok);
+    ASSERT_EQ((*lease)->execute(), Error::Ok);
+  }
+  EXPECT_TENSOR_CLOSE(
+      (*lease1)->get_output(0).toTensor(), (*lease2)->get_output(0).toTensor());
+}
+
+TEST_F(MethodPoolTest, LeaseOutlivesPool) {
+  auto pool = MethodPool::load(load_program(model_path_), "forward");
+  ASSERT_EQ(pool.error(), Error::Ok);
+  auto lease = (*pool)->checkout();
+  ASSERT_EQ(lease.error(), Error::Ok);
+  pool.get().reset();
+
+  // The leased instance stays usable, and is freed with the lease.
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  std::vector<EValue> inputs = {tensor, tensor, 1.0};
+  ASSERT_EQ((*lease)->set_inputs({inputs.data(), inputs.size()}), Error::Ok);
+  ASSERT_EQ((*lease)->execute(), Error::Ok);
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  EXPECT_TENSOR_CLOSE((*lease)->get_output(0).toTensor(), *expected.get());
+}
@@ -8,7 +8,9 @@
 
 #include <executorch/extension/module/module.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -444,6 +446,26 @@ TEST_F(ModuleTest, TestUnsetInputs) {
   EXPECT_NE(result.error(), Error::Ok);
 }
 
+TEST_F(ModuleTest, TestGetInputWritesInPlace) {
+  Module module(model_path_);
+
+  auto input = module.get_input(0);
+  ASSERT_EQ(input.error(), Error::Ok);
+  ASSERT_TRUE(input->isTensor());
+  auto tensor = input->toTensor();
+  float* data = tensor.mutable_data_ptr<float>();
+  ASSERT_EQ(tensor.numel(), 4);
+  std::copy_n(std::array<float, 4>{1.f, 2.f, 3.f, 4.f}.data(), 4, data);
+
+  auto tensor2 = make_tensor_ptr({2, 2}, {2.f, 3.f, 4.f, 5.f});
+  const auto result = module.forward({*input, tensor2, 1.0});
+  ASSERT_EQ(result.error(), Error::Ok);
+
+  const auto expected = make_tensor_ptr({2, 2}, {3.f, 5.f, 7.f, 9.f});
+  EXPECT_TENSOR_CLOSE(result->at(0).toTensor(), *expected.get());
+  EXPECT_EQ(module.get_input(3).error(), Error::InvalidArgument);
+}
+
 TEST_F(ModuleTest, TestSetOutputInvalidIndex) {
   Module module(model_path_);
 
@@ -466,3 +488,109 @@ TEST_F(ModuleTest, TestPTD) {
   auto tensor = make_tensor_ptr({2, 2}, {2.f, 3.f, 4.f, 2.f});
   ASSERT_EQ(module.forward(tensor).error(), Error::Ok);
 }
+
+TEST_F(ModuleTest, TestPTDFilePrefetch) {
+  Module module(
+      add_mul_path_, add_mul_data_path_, Module::LoadMode::FilePrefetch);
+
+  ASSERT_EQ(module.load_method("forward"), Error::Ok);
+
+  auto tensor = make_tensor_ptr({2, 2}, {2.f, 3.f, 4.f, 2.f});
+  ASSERT_EQ(module.forward(tensor).error(), Error::Ok);
+}
+
+TEST_F(ModuleTest, TestFileStreaming) {
+  Module module(model_path_, Module::LoadMode::FileStreaming);
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+
+  const auto result = module.execute("forward", {tensor, tensor, 1.0});
+  ASSERT_EQ(result.error(), Error::Ok);
+
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  EXPECT_TENSOR_CLOSE(result->at(0).toTensor(), *expected.get());
+}
+
+TEST_F(ModuleTest, TestExecuteAsync) {
+  Module module(model_path_);
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+
+  auto future = module.execute_async("forward", {tensor, tensor, 1.0});
+  const auto result = future.get();
+  ASSERT_EQ(result.error(), Error::Ok);
+  ASSERT_EQ(result->size(), 1);
+
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  EXPECT_TENSOR_CLOSE((*result)[0].toTensor(), *expected.get());
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncInvalidInputs) {
+  Module module(model_path_);
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+
+  EXPECT_NE(module.execute_async("forward", {tensor}).get().error(), Error::Ok);
+  EXPECT_NE(
+      module.execute_async("nonexistent", {tensor, tensor, 1.0}).get().error(),
+      Error::Ok);
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncManyInFlight) {
+  Module module(model_path_);
+  ASSERT_EQ(
+      module.configure_async({/*num_threads=*/4, /*max_in_flight=*/3}),
+      Error::Ok);
+
+  constexpr size_t kNumRequests = 32;
+  std::vector<std::array<float, 4>> inputs(kNumRequests);
+  std::vector<TensorPtr> tensors;
+  for (size_t i = 0; i < kNumRequests; ++i) {
+    inputs[i] = {float(i), float(i + 1), float(i + 2), float(i + 3)};
+    tensors.push_back(from_blob(inputs[i].data(), {2, 2}));
+  }
+  std::atomic<size_t> completed{0};
+  for (size_t i = 0; i < kNumRequests; ++i) {
+    const auto error = module.execute_async(
+        "forward",
+        {tensors[i], tensors[i], 1.0},
+        [&completed, i](Result<Module::AsyncOutputs> result) {
+          ASSERT_EQ(result.error(), Error::Ok);
+          const auto data = (*result)[0].toTensor().const_data_ptr<float>();
+          EXPECT_NEAR(data[0], i * 2, 1e-5);
+          EXPECT_NEAR(data[3], (i + 3) * 2, 1e-5);
+          completed.fetch_add(1);
+        });
+    ASSERT_EQ(error, Error::Ok);
+  }
+  // Reconfiguring is not allowed once async execution has started.
+  EXPECT_EQ(module.configure_async({}), Error::InvalidState);
+
+  std::vector<std::future<Result<Module::AsyncOutputs>>> futures;
+  futures.push_back(module.forward_async({tensors[0], tensors[0], 1.0}));
+  futures.push_back(module.forward_async({tensors[1], tensors[1], 1.0}));
+  for (auto& future : futures) {
+    EXPECT_EQ(future.get().error(), Error::Ok);
+  }
+  while (completed.load() < kNumRequests) {
+    std::this_thread::yield();
+  }
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncOutputsStayValidUntilReleased) {
+  Module module(model_path_);
+  ASSERT_EQ(
+      module.configure_async({/*num_threads=*/2, /*max_in_flight=*/2}),
+      Error::Ok);
+  auto tensor1 = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  auto tensor2 = make_tensor_ptr({2, 2}, {5.f, 6.f, 7.f, 8.f});
+
+  auto result1 = module.forward_async({tensor1, tensor1, 1.0}).get();
+  auto result2 = module.forward_async({tensor2, tensor2, 1.0}).get();
+  ASSERT_EQ(result1.error(), Error::Ok);
+  ASSERT_EQ(result2.error(), Error::Ok);
+
+  // Both requests are still holding their instances, so the outputs must not
+  // alias each other.
+  const auto expected1 = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  const auto expected2 = make_tensor_ptr({2, 2}, {10.f, 12.f, 14.f, 16.f});
+  EXPECT_TENSOR_CLOSE((*result1)[0].toTensor(), *expected1.get());
+  EXPECT_TENSOR_CLOSE((*result2)[0].toTensor(), *expected2.get());
+}
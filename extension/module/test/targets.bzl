@@ -43,6 +43,34 @@ def define_common_targets(is_fbcode=False):
                 ],
             )
 
+            runtime.cxx_test(
+                name = "method_pool_test" + aten_suffix,
+                srcs = [
+                    "method_pool_test.cpp",
+                ],
+                deps = [
+                    "//executorch/kernels/portable:generated_lib" + aten_suffix,
+                    "//executorch/extension/data_loader:file_data_loader",
+                    "//executorch/extension/flat_tensor:flat_tensor_data_map" + aten_suffix,
+                    "//executorch/extension/module:module" + aten_suffix,
+                    "//executorch/extension/tensor:tensor" + aten_suffix,
+                    "//executorch/runtime/core/exec_aten/testing_util:tensor_util" + aten_suffix,
+                ],
+                env = modules_env,
+                platforms = [CXX, ANDROID],  # Cannot bundle resources on Apple platform.
+            )
+
+            runtime.cxx_binary(
+                name = "method_pool_benchmark" + aten_suffix,
+                srcs = [
+                    "method_pool_benchmark.cpp",
+                ],
+                deps = [
+                    "//executorch/kernels/portable:generated_lib" + aten_suffix,
+                    "//executorch/extension/module:module" + aten_suffix,
+                ],
+            )
+
             runtime.cxx_test(
                 name = "bundled_test" + aten_suffix,
                 srcs = [
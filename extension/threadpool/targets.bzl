@@ -77,6 +77,17 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "worker_pool",
+        exported_headers = [
+            "worker_pool.h",
+        ],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
     runtime.cxx_library(
         name = "cpuinfo_utils",
         srcs = [
@@ -30,3 +30,13 @@ def define_common_targets():
             "//executorch/runtime/platform:platform",
         ],
     )
+
+    runtime.cxx_test(
+        name = "worker_pool_test",
+        srcs = [
+            "worker_pool_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/threadpool:worker_pool",
+        ],
+    )
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/threadpool/worker_pool.h>
+
+#include <atomic>
+#include <future>
+
+#include <gtest/gtest.h>
+
+using ::executorch::extension::threadpool::WorkerPool;
+
+TEST(WorkerPoolTest, DefaultThreadCountIsPositive) {
+  WorkerPool pool;
+  EXPECT_GT(pool.num_threads(), 0);
+}
+
+TEST(WorkerPoolTest, RunsAllTasks) {
+  std::atomic<int> counter{0};
+  {
+    WorkerPool pool(4);
+    EXPECT_EQ(pool.num_threads(), 4);
+    for (int i = 0; i < 1000; ++i) {
+      pool.submit([&counter] { counter.fetch_add(1); });
+    }
+    // The destructor drains the queue.
+  }
+  EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(WorkerPoolTest, TasksRunConcurrently) {
+  WorkerPool pool(2);
+  std::promise<void> first_started;
+  std::promise<void> release_first;
+  auto release = release_first.get_future().share();
+
+  pool.submit([&first_started, release] {
+    first_started.set_value();
+    release.wait();
+  });
+  first_started.get_future().wait();
+
+  // The second task must be able to run while the first one is blocked.
+  std::promise<int> second_result;
+  auto second = second_result.get_future();
+  pool.submit([&second_result] { second_result.set_value(42); });
+  EXPECT_EQ(second.get(), 42);
+
+  release_first.set_value();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace executorch::extension::threadpool {
+
+/**
+ * A fixed set of worker threads that run submitted tasks in FIFO order.
+ *
+ * Unlike ThreadPool, whose run() is a blocking parallel-for, tasks submitted
+ * here are fire-and-forget: submit() returns immediately and the task runs
+ * later on one of the workers. This makes it suitable for pipelining work
+ * (e.g. overlapping I/O or whole-method execution) rather than splitting a
+ * single kernel across cores.
+ *
+ * Destroying the pool runs all tasks that are still queued, then joins the
+ * workers.
+ */
+class WorkerPool final {
+ public:
+  /**
+   * @param[in] num_threads Number of workers to spawn. Zero means
+   *     std::thread::hardware_concurrency(), or one if that is unknown.
+   */
+  explicit WorkerPool(size_t num_threads = 0) {
+    if (num_threads == 0) {
+      num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0) {
+      num_threads = 1;
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] { worker_loop(); });
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  WorkerPool(WorkerPool&&) = delete;
+  WorkerPool& operator=(WorkerPool&&) = delete;
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Enqueues a task to be run on one of the workers.
+   */
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    task_available_.notify_one();
+  }
+
+  /**
+   * Returns the number of worker threads.
+   */
+  size_t num_threads() const {
+    return workers_.size();
+  }
+
+ private:
+  void worker_loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_available_.wait(
+            lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          // Only reachable when stopping and fully drained.
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace executorch::extension::threadpool
@@ -37,16 +37,19 @@ Tensor& sub_out(
       InvalidArgument,
       out);
 
-  // Check Dim Order
-  ET_KERNEL_CHECK(
-      ctx, tensors_have_same_dim_order(a, b, out), InvalidArgument, out);
-
-  // Resize
-  ET_KERNEL_CHECK(
-      ctx,
-      resize_to_broadcast_target_size(a, b, out) == Error::Ok,
-      InvalidArgument,
-      out);
+  // Skip the shape checks if the runtime already validated these arguments.
+  if (!ctx.args_validated()) {
+    // Check Dim Order
+    ET_KERNEL_CHECK(
+        ctx, tensors_have_same_dim_order(a, b, out), InvalidArgument, out);
+
+    // Resize
+    ET_KERNEL_CHECK(
+        ctx,
+        resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+        InvalidArgument,
+        out);
+  }
 
   // Compute Dtype
   ScalarType compute_type = utils::get_compute_type(common_type);
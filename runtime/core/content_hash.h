@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Fast non-cryptographic hashing of buffer contents.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace executorch {
+namespace runtime {
+namespace internal {
+
+/// Finalizes a 64-bit hash so that every input bit affects every output bit.
+inline uint64_t hash_mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+/// Combines `value` into the running hash `seed`.
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return hash_mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6)));
+}
+
+/**
+ * A fast non-cryptographic 64-bit hash of `size` bytes at `data`. Four
+ * independent lanes keep the multiplier busy on large buffers. This is not
+ * collision resistant: callers that dedupe by hash must also compare the
+ * contents. Hashes with different `seed`s are unrelated, so a second seed
+ * gives a check value for when the contents are not available to compare.
+ */
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+  constexpr uint64_t kPrime = 0x9e3779b97f4a7c15ULL;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t lanes[4] = {
+      kPrime ^ seed, kPrime * 3 ^ seed, kPrime * 5 ^ seed, kPrime * 7 ^ seed};
+  size_t i = 0;
+  for (; i + sizeof(lanes) <= size; i += sizeof(lanes)) {
+    for (size_t lane = 0; lane < 4; ++lane) {
+      uint64_t word;
+      std::memcpy(&word, bytes + i + lane * sizeof(word), sizeof(word));
+      lanes[lane] = (lanes[lane] ^ word) * kPrime;
+      lanes[lane] = (lanes[lane] << 31) | (lanes[lane] >> 33);
+    }
+  }
+  uint64_t hash = size * kPrime ^ seed;
+  for (uint64_t lane : lanes) {
+    hash = hash_mix(hash ^ lane);
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * kPrime;
+  }
+  return hash_mix(hash);
+}
+
+} // namespace internal
+} // namespace runtime
+} // namespace executorch
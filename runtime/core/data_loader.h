@@ -127,6 +127,35 @@ class DataLoader {
    * Returns the length of the underlying data source, typically the file size.
    */
   ET_NODISCARD virtual Result<size_t> size() const = 0;
+
+  /**
+   * EXPERIMENTAL: Returns true if the buffers that load() returns for
+   * `Constant` segments may still be being filled when load() returns.
+   *
+   * Method then calls wait_for_data() before each instruction that reads
+   * constant data it has not waited for yet, so that execution can start
+   * before all weights are resident.
+   */
+  virtual bool loads_constants_asynchronously() const {
+    return false;
+  }
+
+  /**
+   * EXPERIMENTAL: Blocks until the `size` bytes at `data` hold the contents of
+   * the data source. `data` must point into a buffer returned by load(), or
+   * this returns immediately.
+   *
+   * NOTE: This must be thread-safe.
+   *
+   * @returns an Error if reading the data failed.
+   */
+  ET_NODISCARD virtual Error wait_for_data(const void* data, size_t size)
+      const {
+    // Data returned by load() is complete unless the loader says otherwise.
+    (void)data;
+    (void)size;
+    return Error::Ok;
+  }
 };
 
 } // namespace runtime
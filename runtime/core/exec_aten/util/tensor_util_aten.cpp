@@ -167,6 +167,10 @@ Error copy_tensor_data(const at::Tensor& t_dst, const at::Tensor& t_src) {
         "t_dst.nbytes() %lu != t_src.nbytes(). %lu",
         t_dst.nbytes(),
         t_src.nbytes());
+    // Sources written into the destination's own memory need no copy
+    if (t_src.const_data_ptr() == dst_data_ptr) {
+      return Error::Ok;
+    }
     // Copy the source data to the preallocated memory of the destination, which
     // must be the same size as the source.
     std::memcpy(dst_data_ptr, t_src.const_data_ptr(), t_src.nbytes());
@@ -172,6 +172,10 @@ Error copy_tensor_data(
         "t_dst.nbytes() %zu != t_src.nbytes(). %zu",
         t_dst.nbytes(),
         t_src.nbytes());
+    // inputs written into the destination's own memory need no copy
+    if (t_src.const_data_ptr() == t_dst.const_data_ptr()) {
+      return Error::Ok;
+    }
     std::memcpy(
         t_dst.mutable_data_ptr(), t_src.const_data_ptr(), t_src.nbytes());
   }
@@ -606,3 +606,25 @@ TEST_F(TensorUtilTest, SameShapesDifferentDimOrder) {
   EXPECT_FALSE(tensors_have_same_dim_order(a, c, b));
   EXPECT_FALSE(tensors_have_same_dim_order(c, b, a));
 }
+
+TEST_F(TensorUtilTest, CopyTensorDataChecksSizeOfAliasedSource) {
+  using executorch::ET_RUNTIME_NAMESPACE::internal::copy_tensor_data;
+  using executorch::ET_RUNTIME_NAMESPACE::internal::share_tensor_data;
+  using executorch::runtime::Error;
+
+  Tensor dst = tf_float_.make({4}, {1.0f, 2.0f, 3.0f, 4.0f});
+  Tensor src = tf_float_.zeros(
+      {4}, executorch::runtime::TensorShapeDynamism::DYNAMIC_BOUND);
+  ASSERT_EQ(share_tensor_data(src, dst), Error::Ok);
+
+  // A source that already is the destination's memory needs no copy.
+  EXPECT_EQ(copy_tensor_data(dst, src), Error::Ok);
+  EXPECT_EQ(dst.const_data_ptr<float>()[3], 4.0f);
+
+  // It must still be the destination's size.
+  executorch::aten::SizesType new_sizes[] = {2};
+  ASSERT_EQ(
+      executorch::ET_RUNTIME_NAMESPACE::resize_tensor(src, {new_sizes, 1}),
+      Error::Ok);
+  EXPECT_EQ(copy_tensor_data(dst, src), Error::InvalidArgument);
+}
@@ -56,6 +56,17 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "content_hash",
+        exported_headers = [
+            "content_hash.h",
+        ],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
     runtime.cxx_library(
         name = "tensor_shape_dynamism",
         exported_headers = [
@@ -13,6 +13,7 @@
 #include <cinttypes> // @donotremove
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/event_tracer_hooks.h>
@@ -212,6 +213,51 @@ class BackendDelegate final {
   DelegateHandle* handle_;
 };
 
+/**
+ * An instruction decoded from the flatbuffer at init time. Executing it only
+ * reads this record, so the hot loop never touches the serialized program,
+ * and every index in it has already been validated.
+ */
+struct InstructionRecord {
+  struct JumpFalse {
+    /// Index of the condition value in values_.
+    size_t cond_value_index;
+    /// Instruction to jump to when the condition is false.
+    size_t destination;
+  };
+  struct Move {
+    size_t from;
+    size_t to;
+  };
+
+  executorch_flatbuffer::InstructionArguments type;
+  /// Parameters of a kernel or delegate call. Empty for other instructions.
+  InstructionArgs args;
+  union {
+    /// KernelCall: the resolved kernel.
+    OpFunction kernel;
+    /// DelegateCall: index into delegates_.
+    size_t delegate_index;
+    /// JumpFalseCall
+    JumpFalse jump_false;
+    /// MoveCall
+    Move move;
+    /// FreeCall: index of the tensor value whose data should be released.
+    size_t free_value_index;
+  };
+};
+
+/**
+ * Constant data that an instruction reads, for programs whose constants are
+ * loaded asynchronously.
+ */
+struct ConstantRange {
+  const void* data;
+  size_t size;
+  /// True once the DataLoader has reported the data as resident.
+  bool resident;
+};
+
 /**
  * Runtime state for a chain of instructions.
  */
@@ -219,10 +265,12 @@ struct Chain {
   /// Pointer to the associated flatbuffer chain.
   const executorch_flatbuffer::Chain* s_chain_;
 
-  /// Each entry is a list of parameters for a kernel or delegate call.
-  Span<InstructionArgs> argument_lists_;
-  /// Each instruction will have one kernel (not for delegate).
-  OpFunction* kernels_;
+  /// The instructions of the chain, decoded at init time.
+  Span<InstructionRecord> instructions_;
+
+  /// For each instruction, the asynchronously loaded constants it reads. Null
+  /// if the program's constants are resident.
+  Span<ConstantRange>* constant_waits_ = nullptr;
 };
 
 namespace {
@@ -666,8 +714,7 @@ Error populate_operator_name(
 
 Error Method::resolve_operator(
     int32_t op_index,
-    OpFunction* kernels,
-    size_t kernel_index,
+    OpFunction* kernel,
     InstructionArgs args,
     size_t n_args) {
   // TODO(T153505381, T153506819) Investigate optimizing this function for both
@@ -735,7 +782,7 @@ Error Method::resolve_operator(
         operator_name);
     return op_function.error();
   }
-  kernels[kernel_index] = op_function.get();
+  *kernel = op_function.get();
   return Error::Ok;
 }
 
@@ -881,19 +928,14 @@ Error Method::init(
           "Missing instructions in chain %" ET_PRIsize_t,
           i);
       auto num_instructions = s_instructions->size();
-      auto chain_instruction_kernels =
-          method_allocator->allocateList<OpFunction>(num_instructions);
-      if (chain_instruction_kernels == nullptr) {
-        return Error::MemoryAllocationFailed;
-      }
-      auto chain_instruction_arg_lists =
-          method_allocator->allocateList<InstructionArgs>(num_instructions);
-      if (chain_instruction_arg_lists == nullptr) {
+      auto records =
+          method_allocator->allocateList<InstructionRecord>(num_instructions);
+      if (records == nullptr) {
         return Error::MemoryAllocationFailed;
       }
 
-      // Set up the argument lists ahead of time and store pointers to them to
-      // use when the instructions are called
+      // Decode every instruction ahead of time, including its argument list,
+      // so that execution does not need to read the flatbuffer.
       for (size_t instr_idx = 0; instr_idx < s_instructions->size();
            ++instr_idx) {
         const auto instruction = s_instructions->Get(instr_idx);
@@ -904,6 +946,9 @@ Error Method::init(
             "Null instruction at index %" ET_PRIsize_t,
             instr_idx);
 
+        InstructionRecord& record = records[instr_idx];
+        new (&record) InstructionRecord();
+        record.type = instruction->instr_args_type();
         const void* instr_args = instruction->instr_args();
         switch (instruction->instr_args_type()) {
           case executorch_flatbuffer::InstructionArguments::KernelCall: {
@@ -922,11 +967,10 @@ Error Method::init(
             if (!res.ok()) {
               return res.error();
             }
-            chain_instruction_arg_lists[instr_idx] = res.get();
+            record.args = res.get();
             auto err = resolve_operator(
                 instr_args_as_KernelCall->op_index(),
-                chain_instruction_kernels,
-                instr_idx,
+                &record.kernel,
                 res.get(),
                 arg_idxs->size());
             if (err == Error::OperatorMissing) {
@@ -938,14 +982,24 @@ Error Method::init(
             }
           } break;
           case executorch_flatbuffer::InstructionArguments::DelegateCall: {
-            const auto arg_idxs =
+            const auto* delegate_call =
                 static_cast<const executorch_flatbuffer::DelegateCall*>(
-                    instr_args)
-                    ->args();
+                    instr_args);
+            const auto arg_idxs = delegate_call->args();
             ET_CHECK_OR_RETURN_ERROR(
                 arg_idxs != nullptr,
                 InvalidProgram,
                 "DelegateCall args missing");
+            auto delegate_idx = delegate_call->delegate_index();
+            ET_CHECK_OR_RETURN_ERROR(
+                delegate_idx >= 0 &&
+                    static_cast<size_t>(delegate_idx) < n_delegate_,
+                InvalidProgram,
+                "DELEGATE_CALL index %zd negative or >= num delegates "
+                "%" ET_PRIsize_t " at instruction %" ET_PRIsize_t,
+                static_cast<ssize_t>(delegate_idx),
+                n_delegate_,
+                instr_idx);
             auto res = gen_instruction_arguments(
                 method_allocator,
                 n_value_,
@@ -955,32 +1009,64 @@ Error Method::init(
             if (!res.ok()) {
               return res.error();
             }
-            chain_instruction_arg_lists[instr_idx] = res.get();
+            record.args = res.get();
+            record.delegate_index = static_cast<size_t>(delegate_idx);
           } break;
           case executorch_flatbuffer::InstructionArguments::JumpFalseCall: {
             // Validate the index at load time so we can trust it during
             // execution.
-            auto index =
+            const auto* jf_call =
                 static_cast<const executorch_flatbuffer::JumpFalseCall*>(
-                    instr_args)
-                    ->cond_value_index();
+                    instr_args);
+            auto index = jf_call->cond_value_index();
             ET_CHECK_OR_RETURN_ERROR(
                 index >= 0 && static_cast<size_t>(index) < n_value_,
                 InvalidProgram,
                 "Index %zd negative or >= %" ET_PRIsize_t,
                 static_cast<ssize_t>(index),
                 n_value_);
-            chain_instruction_arg_lists[instr_idx] = InstructionArgs();
+            record.jump_false = InstructionRecord::JumpFalse{
+                static_cast<size_t>(index),
+                static_cast<size_t>(jf_call->destination_instruction())};
+          } break;
+          case executorch_flatbuffer::InstructionArguments::MoveCall: {
+            const auto* move_call =
+                static_cast<const executorch_flatbuffer::MoveCall*>(
+                    instr_args);
+            auto from = move_call->move_from();
+            auto to = move_call->move_to();
+            ET_CHECK_OR_RETURN_ERROR(
+                from >= 0 && static_cast<size_t>(from) < n_value_ && to >= 0 &&
+                    static_cast<size_t>(to) < n_value_,
+                InvalidProgram,
+                "Move from %zd to %zd out of range for %" ET_PRIsize_t
+                " values",
+                static_cast<ssize_t>(from),
+                static_cast<ssize_t>(to),
+                n_value_);
+            record.move = InstructionRecord::Move{
+                static_cast<size_t>(from), static_cast<size_t>(to)};
+          } break;
+          case executorch_flatbuffer::InstructionArguments::FreeCall: {
+            auto index = static_cast<const executorch_flatbuffer::FreeCall*>(
+                             instr_args)
+                             ->value_index();
+            ET_CHECK_OR_RETURN_ERROR(
+                index >= 0 && static_cast<size_t>(index) < n_value_,
+                InvalidProgram,
+                "Index %zd negative or >= %" ET_PRIsize_t,
+                static_cast<ssize_t>(index),
+                n_value_);
+            record.free_value_index = static_cast<size_t>(index);
           } break;
           default: {
-            chain_instruction_arg_lists[instr_idx] = InstructionArgs();
+            // Reported as an error if the instruction is ever executed.
           } break;
         }
       }
       chains_[i] = Chain{
           s_chain,
-          Span<InstructionArgs>(chain_instruction_arg_lists, num_instructions),
-          chain_instruction_kernels,
+          Span<InstructionRecord>(records, num_instructions),
       };
     }
     ET_CHECK_OR_RETURN_ERROR(
@@ -994,12 +1080,164 @@ Error Method::init(
     }
   }
 
+  {
+    Error err = init_constant_waits();
+    if (err != Error::Ok) {
+      return err;
+    }
+  }
+
   step_state_ = StepState{0, 0};
 
   init_state_ = InitializationState::Initialized;
   return Error::Ok;
 }
 
+namespace {
+
+/// Returns true if `s_value` is a tensor whose data is in the constant segment.
+bool is_segment_constant(const executorch_flatbuffer::EValue* s_value) {
+  if (s_value == nullptr ||
+      s_value->val_type() != executorch_flatbuffer::KernelTypes::Tensor) {
+    return false;
+  }
+  const auto* s_tensor = s_value->val_as_Tensor();
+  return s_tensor != nullptr && s_tensor->data_buffer_idx() > 0 &&
+      s_tensor->allocation_info() == nullptr &&
+      (s_tensor->extra_tensor_info() == nullptr ||
+       s_tensor->extra_tensor_info()->location() !=
+           executorch_flatbuffer::TensorDataLocation::EXTERNAL);
+}
+
+} // namespace
+
+Error Method::init_constant_waits() {
+  const DataLoader* loader = program_->loader_;
+  if (loader == nullptr || !loader->loads_constants_asynchronously() ||
+      program_->constant_segment_data_.data() == nullptr) {
+    return Error::Ok;
+  }
+  const auto* s_values = serialization_plan_->values();
+
+  // Calls `fn` with the index of every segment constant that value
+  // `value_index` holds, directly or in a tensor list.
+  auto for_each_constant = [&](size_t value_index, auto&& fn) {
+    const auto* s_value = s_values->Get(value_index);
+    const flatbuffers::Vector<int32_t>* items = nullptr;
+    if (const auto* list = s_value->val_as_TensorList()) {
+      items = list->items();
+    } else if (
+        const auto* optional_list = s_value->val_as_OptionalTensorList()) {
+      items = optional_list->items();
+    } else if (is_segment_constant(s_value)) {
+      fn(value_index);
+    }
+    if (items != nullptr) {
+      for (int32_t item : *items) {
+        if (item >= 0 && static_cast<size_t>(item) < n_value_ &&
+            is_segment_constant(s_values->Get(item))) {
+          fn(static_cast<size_t>(item));
+        }
+      }
+    }
+  };
+  auto for_each_instruction_constant = [&](const InstructionRecord& record,
+                                           auto&& fn) {
+    switch (record.type) {
+      case executorch_flatbuffer::InstructionArguments::KernelCall:
+      case executorch_flatbuffer::InstructionArguments::DelegateCall:
+        for (EValue* arg : record.args) {
+          for_each_constant(static_cast<size_t>(arg - values_), fn);
+        }
+        break;
+      case executorch_flatbuffer::InstructionArguments::JumpFalseCall:
+        // Reads the condition tensor's data.
+        for_each_constant(record.jump_false.cond_value_index, fn);
+        break;
+      case executorch_flatbuffer::InstructionArguments::MoveCall:
+        // Later instructions reach the moved constant through the
+        // destination, which is not a constant itself, so wait here.
+        for_each_constant(record.move.from, fn);
+        for_each_constant(record.move.to, fn);
+        break;
+      default:
+        break;
+    }
+  };
+
+  // Count, then fill.
+  size_t n_ranges = 0;
+  auto count = [&n_ranges](size_t) { n_ranges++; };
+  for (size_t i = 0; i < n_chains_; ++i) {
+    for (const InstructionRecord& record : chains_[i].instructions_) {
+      for_each_instruction_constant(record, count);
+    }
+  }
+  const size_t n_outputs = outputs_size();
+  for (size_t i = 0; i < n_outputs; ++i) {
+    for_each_constant(get_output_index(i), count);
+  }
+  if (n_ranges == 0) {
+    return Error::Ok;
+  }
+
+  auto method_allocator = memory_manager_->method_allocator();
+  ConstantRange* ranges =
+      method_allocator->allocateList<ConstantRange>(n_ranges);
+  if (ranges == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  size_t next = 0;
+  auto append = [this, ranges, &next](size_t value_index) {
+    const auto& tensor = values_[value_index].toTensor();
+    ranges[next++] =
+        ConstantRange{tensor.const_data_ptr(), tensor.nbytes(), false};
+  };
+  for (size_t i = 0; i < n_chains_; ++i) {
+    Chain& chain = chains_[i];
+    chain.constant_waits_ =
+        method_allocator->allocateList<Span<ConstantRange>>(
+            chain.instructions_.size());
+    if (chain.constant_waits_ == nullptr) {
+      return Error::MemoryAllocationFailed;
+    }
+    for (size_t j = 0; j < chain.instructions_.size(); ++j) {
+      const size_t begin = next;
+      for_each_instruction_constant(chain.instructions_[j], append);
+      chain.constant_waits_[j] =
+          Span<ConstantRange>(ranges + begin, next - begin);
+    }
+  }
+  const size_t outputs_begin = next;
+  for (size_t i = 0; i < n_outputs; ++i) {
+    for_each_constant(get_output_index(i), append);
+  }
+  output_constants_ =
+      Span<ConstantRange>(ranges + outputs_begin, next - outputs_begin);
+  n_pending_constants_ = n_ranges;
+  return Error::Ok;
+}
+
+Error Method::wait_for_constants(Span<ConstantRange> ranges) {
+  for (ConstantRange& range : ranges) {
+    if (range.resident) {
+      continue;
+    }
+    Error err = program_->loader_->wait_for_data(range.data, range.size);
+    if (err != Error::Ok) {
+      ET_LOG(
+          Error,
+          "Loading %" ET_PRIsize_t " bytes of constant data failed: 0x%x",
+          range.size,
+          static_cast<unsigned int>(err));
+      return err;
+    }
+    range.resident = true;
+    n_pending_constants_--;
+  }
+  return Error::Ok;
+}
+
 ET_NODISCARD Error
 Method::set_input(const EValue& input_evalue, size_t input_idx) {
   ET_CHECK_OR_RETURN_ERROR(
@@ -1294,38 +1532,54 @@ ET_NODISCARD Error Method::get_inputs(EValue* input_evalues, size_t length) {
   return Error::Ok;
 }
 
+template <bool kTraced>
 Error Method::execute_instruction() {
+  // A constant null when untraced, so that the hooks below compile away.
+  EventTracer* const event_tracer = kTraced ? event_tracer_ : nullptr;
   auto& chain = chains_[step_state_.chain_idx];
-  auto instructions = chain.s_chain_->instructions();
 
   ET_CHECK_OR_RETURN_ERROR(
-      step_state_.instr_idx < instructions->size(),
+      step_state_.instr_idx < chain.instructions_.size(),
       Internal,
       "Instr index %" ET_PRIsize_t " >= chain[%" ET_PRIsize_t
       "] instr count %" ET_PRIsize_t,
       step_state_.instr_idx,
       step_state_.chain_idx,
-      (size_t)instructions->size());
+      chain.instructions_.size());
+
+  if ET_UNLIKELY (n_pending_constants_ > 0) {
+    Error wait_err =
+        wait_for_constants(chain.constant_waits_[step_state_.instr_idx]);
+    if (wait_err != Error::Ok) {
+      return wait_err;
+    }
+  }
 
-  auto instruction = instructions->Get(step_state_.instr_idx);
+  const InstructionRecord& instruction =
+      chain.instructions_[step_state_.instr_idx];
   size_t next_instr_idx = step_state_.instr_idx + 1;
   Error err = Error::Ok;
 
-  switch (instruction->instr_args_type()) {
+  switch (instruction.type) {
     case executorch_flatbuffer::InstructionArguments::KernelCall: {
       EXECUTORCH_SCOPE_PROF("OPERATOR_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "OPERATOR_CALL");
+          internal::EventTracerProfileOpScope(event_tracer, "OPERATOR_CALL");
       // TODO(T147221312): Also expose tensor resizer via the context.
-      KernelRuntimeContext context(event_tracer_, temp_allocator_);
-      auto args = chain.argument_lists_[step_state_.instr_idx];
-      chain.kernels_[step_state_.instr_idx](context, args.data());
+      KernelRuntimeContext context(
+          event_tracer, temp_allocator_, args_validated_);
+      auto args = instruction.args;
+      instruction.kernel(context, args.data());
       // We reset the temp_allocator after the switch statement
       err = context.failure_state();
       if (err != Error::Ok) {
-        // We know that instr_args_as_KernelCall is non-null because it was
-        // checked at init time.
-        auto op_index = instruction->instr_args_as_KernelCall()->op_index();
+        // This is a failure path, so it is fine to go back to the flatbuffer
+        // for the operator name. instr_args_as_KernelCall is non-null because
+        // it was checked at init time.
+        auto op_index = chain.s_chain_->instructions()
+                            ->Get(step_state_.instr_idx)
+                            ->instr_args_as_KernelCall()
+                            ->op_index();
         ET_UNUSED auto op = serialization_plan_->operators()->Get(op_index);
         ET_LOG(
             Error,
@@ -1351,26 +1605,15 @@ Error Method::execute_instruction() {
     case executorch_flatbuffer::InstructionArguments::DelegateCall: {
       EXECUTORCH_SCOPE_PROF("DELEGATE_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "DELEGATE_CALL");
-      // We know that instr_args_as_DelegateCall is non-null because it was
-      // checked at init time.
-      auto delegate_idx =
-          instruction->instr_args_as_DelegateCall()->delegate_index();
-      ET_CHECK_OR_RETURN_ERROR(
-          static_cast<size_t>(delegate_idx) < n_delegate_,
-          Internal,
-          "DELEGATE_CALL index %" PRIu32 " >= num delegates %" ET_PRIsize_t
-          " at instruction %" ET_PRIsize_t,
-          delegate_idx,
-          n_delegate_,
-          step_state_.instr_idx);
+          internal::EventTracerProfileOpScope(event_tracer, "DELEGATE_CALL");
+      // We know that delegate_index is in range because it was checked at init
+      // time.
       BackendExecutionContext backend_execution_context(
-          /*event_tracer=*/event_tracer_,
+          /*event_tracer=*/event_tracer,
           /*temp_allocator=*/temp_allocator_,
           /*method_name=*/serialization_plan_->name()->c_str());
-      err = delegates_[delegate_idx].Execute(
-          backend_execution_context,
-          chain.argument_lists_[step_state_.instr_idx].data());
+      err = delegates_[instruction.delegate_index].Execute(
+          backend_execution_context, instruction.args.data());
       if (err != Error::Ok) {
         ET_LOG(
             Error,
@@ -1386,28 +1629,25 @@ Error Method::execute_instruction() {
       // log everything. This will be changed in the future when the inputs and
       // ouputs are separate lists.
 #ifdef ET_EVENT_TRACER_ENABLED
-      for (size_t i = 0;
-           i < chain.argument_lists_[step_state_.instr_idx].size();
-           i++) {
-        EValue* arg = chain.argument_lists_[step_state_.instr_idx].data()[i];
-        internal::event_tracer_log_evalue(event_tracer_, *arg);
+      if (kTraced) {
+        for (size_t i = 0; i < instruction.args.size(); i++) {
+          EValue* arg = instruction.args.data()[i];
+          internal::event_tracer_log_evalue(event_tracer, *arg);
+        }
       }
 #endif
     } break;
     case executorch_flatbuffer::InstructionArguments::JumpFalseCall: {
       EXECUTORCH_SCOPE_PROF("JF_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "JF_CALL");
-      // We know that instr_args_as_JumpFalseCall is non-null because it was
-      // checked at init time.
-      auto jf_call = instruction->instr_args_as_JumpFalseCall();
+          internal::EventTracerProfileOpScope(event_tracer, "JF_CALL");
       // We know that index is a valid values_ index because it was checked at
       // init time.
-      auto index = jf_call->cond_value_index();
-      Result<bool> jf_result = parse_cond_value(values_[index]);
+      Result<bool> jf_result =
+          parse_cond_value(values_[instruction.jump_false.cond_value_index]);
       if (jf_result.ok()) {
         if (!jf_result.get()) {
-          next_instr_idx = jf_call->destination_instruction();
+          next_instr_idx = instruction.jump_false.destination;
         }
       } else {
         err = jf_result.error();
@@ -1416,27 +1656,24 @@ Error Method::execute_instruction() {
     case executorch_flatbuffer::InstructionArguments::MoveCall: {
       EXECUTORCH_SCOPE_PROF("MOVE_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "MOVE_CALL");
-      // We know that instr_args_as_MoveCall is non-null because it was checked
-      // at init time.
-      auto move_call = instruction->instr_args_as_MoveCall();
-      mutable_value(move_call->move_to()) = get_value(move_call->move_from());
+          internal::EventTracerProfileOpScope(event_tracer, "MOVE_CALL");
+      // We know that both indices are valid because they were checked at init
+      // time.
+      values_[instruction.move.to] = values_[instruction.move.from];
     } break;
     case executorch_flatbuffer::InstructionArguments::FreeCall: {
       EXECUTORCH_SCOPE_PROF("FREE_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "FREE_CALL");
-      // We know that instr_args_as_FreeCall is non-null because it was checked
-      // at init time.
-      auto free_call = instruction->instr_args_as_FreeCall();
-      auto t = values_[free_call->value_index()].toTensor();
+          internal::EventTracerProfileOpScope(event_tracer, "FREE_CALL");
+      // We know that the index is valid because it was checked at init time.
+      auto t = values_[instruction.free_value_index].toTensor();
       internal::reset_data_ptr(t);
     } break;
     default:
       ET_LOG(
           Error,
           "Unknown instruction: %hhu",
-          static_cast<uint8_t>(instruction->instr_args_type()));
+          static_cast<uint8_t>(instruction.type));
       err = Error::InvalidProgram;
   }
   // Reset the temp allocator for every instruction.
@@ -1462,6 +1699,87 @@ Error Method::experimental_reset_execution() {
   return reset_execution(); // @lint-ignore CLANGTIDY facebook-hte-Deprecated
 }
 
+Error Method::set_shape_guard_enabled(bool enabled) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Cannot enable the shape guard until method has been initialized.");
+  shape_guard_valid_ = false;
+  if (enabled && shape_guard_key_ == nullptr) {
+    // One entry per scalar input, and the rank plus a size and a dim order
+    // entry per dimension for each tensor input.
+    size_t key_size = 0;
+    for (size_t i = 0; i < inputs_size(); ++i) {
+      const EValue& input = values_[get_input_index(i)];
+      if (input.isTensor()) {
+        key_size += 1 + 2 * input.toTensor().dim();
+      } else if (input.isInt() || input.isDouble() || input.isBool()) {
+        key_size += 1;
+      }
+    }
+    if (key_size > 0) {
+      shape_guard_key_ =
+          memory_manager_->method_allocator()->allocateList<int64_t>(key_size);
+      if (shape_guard_key_ == nullptr) {
+        return Error::MemoryAllocationFailed;
+      }
+    }
+    shape_guard_key_size_ = key_size;
+  }
+  shape_guard_enabled_ = enabled;
+  return Error::Ok;
+}
+
+bool Method::update_shape_guard() {
+  bool match = shape_guard_valid_;
+  size_t pos = 0;
+  auto record = [this, &match, &pos](int64_t value) {
+    if (pos < shape_guard_key_size_ && shape_guard_key_[pos] != value) {
+      shape_guard_key_[pos] = value;
+      match = false;
+    }
+    pos++;
+  };
+  for (size_t i = 0; i < inputs_size(); ++i) {
+    const EValue& input = values_[get_input_index(i)];
+    if (input.isTensor()) {
+      const auto& tensor = input.toTensor();
+      record(tensor.dim());
+      for (ssize_t d = 0; d < tensor.dim(); ++d) {
+        record(tensor.size(d));
+      }
+      executorch::aten::DimOrderType dim_order[kTensorDimensionLimit];
+      if (static_cast<size_t>(tensor.dim()) <= kTensorDimensionLimit &&
+          get_dim_order(tensor, dim_order, tensor.dim()) == Error::Ok) {
+        for (ssize_t d = 0; d < tensor.dim(); ++d) {
+          record(dim_order[d]);
+        }
+      } else {
+        // Without a dim order the kernels must check the arguments.
+        match = false;
+        pos += tensor.dim();
+      }
+    } else if (input.isInt()) {
+      record(input.toInt());
+    } else if (input.isDouble()) {
+      double value = input.toDouble();
+      int64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      record(bits);
+    } else if (input.isBool()) {
+      record(input.toBool());
+    }
+  }
+  // Only reachable with ATen tensors, whose rank can change.
+  if (pos != shape_guard_key_size_) {
+    shape_guard_valid_ = false;
+    return false;
+  }
+  // Not valid again until this execution succeeds.
+  shape_guard_valid_ = false;
+  return match;
+}
+
 // Log all the outputs of this method to the event tracer.
 void Method::log_outputs() {
 #ifdef ET_EVENT_TRACER_ENABLED
@@ -1493,14 +1811,16 @@ Error Method::step() {
       initialized(),
       InvalidState,
       "Cannot execute until method has been initialized.");
+  // The shape guard only covers whole executions.
+  args_validated_ = false;
+  shape_guard_valid_ = false;
 
   // If chain_step_ is on n_chains_, then we have no instructions run.
   if (step_state_.chain_idx == n_chains_) {
     return Error::EndOfMethod;
   }
 
-  auto num_instructions =
-      chains_[step_state_.chain_idx].s_chain_->instructions()->size();
+  auto num_instructions = chains_[step_state_.chain_idx].instructions_.size();
 
   // Special case chains with no instructions. These appear for example in a
   // model that just returns the input/a constant.
@@ -1509,7 +1829,7 @@ Error Method::step() {
     return Error::Ok;
   }
 
-  auto status = execute_instruction();
+  auto status = execute_instruction</*kTraced=*/true>();
   if (status != Error::Ok) {
     return status;
   }
@@ -1519,6 +1839,12 @@ Error Method::step() {
   if (step_state_.instr_idx == num_instructions) {
     step_state_.instr_idx = 0;
     step_state_.chain_idx += 1;
+    if ET_UNLIKELY (n_pending_constants_ > 0) {
+      Error err = wait_for_constants(output_constants_);
+      if (err != Error::Ok) {
+        return err;
+      }
+    }
     log_outputs();
   }
   return Error::Ok;
@@ -1540,33 +1866,50 @@ Error Method::execute() {
       "Cannot execute until method has been initialized.");
   ET_LOG(Debug, "Executing method: %s.", method_meta().name());
 
+  args_validated_ = shape_guard_enabled_ && update_shape_guard();
+
   // Chains are executed sequentially today, but future async designs may
   // branch and run many in parallel or out of order.
   for (step_state_.chain_idx = 0; step_state_.chain_idx < n_chains_;
        ++step_state_.chain_idx) {
-    Chain& chain = chains_[step_state_.chain_idx];
-    auto instructions = chain.s_chain_->instructions();
-    ET_CHECK_OR_RETURN_ERROR(
-        instructions != nullptr,
-        Internal,
-        "chain %" ET_PRIsize_t " has no instructions field",
-        step_state_.chain_idx);
+    const size_t num_instructions =
+        chains_[step_state_.chain_idx].instructions_.size();
 
     // Loop over instructions
     step_state_.instr_idx = 0;
-    while (step_state_.instr_idx < chain.s_chain_->instructions()->size()) {
-      EXECUTORCH_PROFILE_INSTRUCTION_SCOPE(
-          static_cast<int32_t>(step_state_.chain_idx),
-          static_cast<uint32_t>(step_state_.instr_idx));
-      internal::EventTracerProfileInstructionScope event_tracer_instr_scope =
-          internal::EventTracerProfileInstructionScope(
-              event_tracer_,
-              static_cast<ChainID>(step_state_.chain_idx),
-              static_cast<DebugHandle>(step_state_.instr_idx));
-      auto status = execute_instruction();
-      if (status != Error::Ok) {
-        return status;
+    if (event_tracer_ == nullptr) {
+      while (step_state_.instr_idx < num_instructions) {
+        EXECUTORCH_PROFILE_INSTRUCTION_SCOPE(
+            static_cast<int32_t>(step_state_.chain_idx),
+            static_cast<uint32_t>(step_state_.instr_idx));
+        auto status = execute_instruction</*kTraced=*/false>();
+        if (status != Error::Ok) {
+          return status;
+        }
       }
+    } else {
+      while (step_state_.instr_idx < num_instructions) {
+        EXECUTORCH_PROFILE_INSTRUCTION_SCOPE(
+            static_cast<int32_t>(step_state_.chain_idx),
+            static_cast<uint32_t>(step_state_.instr_idx));
+        internal::EventTracerProfileInstructionScope event_tracer_instr_scope =
+            internal::EventTracerProfileInstructionScope(
+                event_tracer_,
+                static_cast<ChainID>(step_state_.chain_idx),
+                static_cast<DebugHandle>(step_state_.instr_idx));
+        auto status = execute_instruction</*kTraced=*/true>();
+        if (status != Error::Ok) {
+          return status;
+        }
+      }
+    }
+  }
+  args_validated_ = false;
+  shape_guard_valid_ = shape_guard_enabled_;
+  if ET_UNLIKELY (n_pending_constants_ > 0) {
+    Error err = wait_for_constants(output_constants_);
+    if (err != Error::Ok) {
+      return err;
     }
   }
   internal::event_tracer_end_profiling_event(event_tracer_, event_tracer_entry);
@@ -47,6 +47,7 @@ class Program;
 // Forward declare internal types.
 class BackendDelegate;
 struct Chain;
+struct ConstantRange;
 class KernelRuntimeContext;
 using OpFunction = void (*)(KernelRuntimeContext&, EValue**);
 /// A list of pointers into the master values table that together compose the
@@ -80,6 +81,12 @@ class Method final {
         merged_data_map_(std::move(rhs.merged_data_map_)),
         external_constants_(rhs.external_constants_),
         n_external_constants_(rhs.n_external_constants_),
+        shape_guard_key_(rhs.shape_guard_key_),
+        shape_guard_key_size_(rhs.shape_guard_key_size_),
+        shape_guard_enabled_(rhs.shape_guard_enabled_),
+        shape_guard_valid_(rhs.shape_guard_valid_),
+        n_pending_constants_(rhs.n_pending_constants_),
+        output_constants_(rhs.output_constants_),
         init_state_(rhs.init_state_) {
     // Required: clear out fields that the dtor looks at, so that we don't free
     // anything twice.
@@ -102,6 +109,10 @@ class Method final {
     rhs.event_tracer_ = nullptr;
     rhs.n_chains_ = 0;
     rhs.chains_ = nullptr;
+    rhs.shape_guard_key_ = nullptr;
+    rhs.shape_guard_key_size_ = 0;
+    rhs.shape_guard_enabled_ = false;
+    rhs.shape_guard_valid_ = false;
   }
 
   /**
@@ -244,6 +255,31 @@ class Method final {
   /// DEPRECATED: Use `reset_execution()` instead.
   ET_DEPRECATED ET_NODISCARD Error experimental_reset_execution();
 
+  /**
+   * EXPERIMENTAL: Enables or disables the shape guard, which is disabled by
+   * default.
+   *
+   * While it is enabled, execute() compares the shapes and dim orders of the
+   * tensor inputs and the values of the scalar inputs with those of the
+   * previous successful execution. If they all match, every kernel sees the
+   * same argument shapes as last time and its outputs are already sized, so
+   * kernels are told through KernelRuntimeContext::args_validated() that they
+   * may skip argument checks and output resizing. This pays off when the same
+   * shapes are executed over and over, e.g. in streaming inference.
+   *
+   * Only enable this for methods whose shapes are determined by their input
+   * shapes and scalar inputs alone, i.e. that have no operators with
+   * data-dependent output shapes.
+   *
+   * @param[in] enabled Whether to enable the shape guard.
+   *
+   * @retval Error::Ok on success.
+   * @retval Error::InvalidState if the method is not initialized.
+   * @retval Error::MemoryAllocationFailed if the method allocator could not
+   *     hold the guard state.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error set_shape_guard_enabled(bool enabled);
+
   /**
    * Returns the MethodMeta that corresponds to the calling Method.
    */
@@ -350,7 +386,14 @@ class Method final {
   size_t get_input_index(size_t i) const;
   size_t get_output_index(size_t i) const;
 
-  // Executes a single instruction using the state in step_state_
+  // Records the current input shapes and scalar input values in the shape
+  // guard. Returns true if they match those of the last successful execution.
+  bool update_shape_guard();
+
+  // Executes a single instruction using the state in step_state_. When
+  // kTraced is false, the EventTracer hooks are compiled out; only use that
+  // when event_tracer_ is null.
+  template <bool kTraced>
   ET_NODISCARD Error execute_instruction();
 
   StepState step_state_;
@@ -373,6 +416,21 @@ class Method final {
   NamedData* external_constants_;
   size_t n_external_constants_ = 0;
 
+  // Shape guard state; see set_shape_guard_enabled().
+  int64_t* shape_guard_key_ = nullptr;
+  size_t shape_guard_key_size_ = 0;
+  bool shape_guard_enabled_ = false;
+  // True if shape_guard_key_ describes the inputs of a successful execution.
+  bool shape_guard_valid_ = false;
+  // True while execute() runs with inputs that matched the shape guard.
+  bool args_validated_ = false;
+
+  // Constant data that is loaded asynchronously and not yet waited for; see
+  // init_constant_waits(). Zero for programs whose constants are resident.
+  size_t n_pending_constants_ = 0;
+  // Pending constants that are method outputs.
+  Span<ConstantRange> output_constants_;
+
   InitializationState init_state_;
 
   /**
@@ -402,10 +460,19 @@ class Method final {
    */
   ET_NODISCARD Error parse_values(const NamedDataMap* named_data_map);
 
+  /**
+   * If the program's DataLoader loads constants asynchronously, records for
+   * every instruction the constant data it reads, so that execution only
+   * blocks on weights that are not resident yet.
+   */
+  ET_NODISCARD Error init_constant_waits();
+
+  /// Waits for every range in `ranges` that has not been waited for yet.
+  ET_NODISCARD Error wait_for_constants(Span<ConstantRange> ranges);
+
   ET_NODISCARD Error resolve_operator(
       int32_t op_index,
-      OpFunction* kernels,
-      size_t kernel_index,
+      OpFunction* kernel,
       InstructionArgs args,
       size_t n_args);
 
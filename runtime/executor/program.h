@@ -104,7 +104,9 @@ class Program final {
    * Get the constant buffer inside Program with index buffer_idx.
    * @param[in] buffer_idx the index of the buffer in the constant_buffer.
    * @param[in] nbytes the number of bytes to read from the buffer.
-   * @return The buffer with corresponding index.
+   * @return The buffer with corresponding index. If the program's DataLoader
+   *     loads constants asynchronously, call its wait_for_data() before
+   *     reading the buffer.
    */
   Result<const void*> get_constant_buffer_data(size_t buffer_idx, size_t nbytes)
       const;
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Measures the per-instruction overhead of Method execution: builds a program
+ * whose only chain is a long run of calls to a kernel that does nothing, and
+ * reports the time per instruction for execute() and for step().
+ *
+ * Usage: method_dispatch_benchmark [num_instructions] [iterations]
+ */
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/executor/program.h>
+#include <executorch/runtime/kernel/operator_registry.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <executorch/schema/program_generated.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using executorch::extension::BufferDataLoader;
+using executorch::extension::MallocMemoryAllocator;
+using executorch::runtime::Error;
+using executorch::runtime::EValue;
+using executorch::runtime::HierarchicalAllocator;
+using executorch::runtime::Kernel;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::MemoryManager;
+using executorch::runtime::Method;
+using executorch::runtime::Program;
+using executorch::runtime::register_kernel;
+using executorch::runtime::Result;
+using executorch::runtime::Span;
+
+namespace {
+
+constexpr const char* kNoopOpName = "et_bench::noop";
+
+void noop(KernelRuntimeContext&, EValue**) {}
+
+/**
+ * Serializes a program with one method, "forward", that calls the no-op
+ * kernel `num_instructions` times on a single Int value.
+ */
+std::vector<std::max_align_t> make_noop_program(size_t num_instructions) {
+  namespace fb = executorch_flatbuffer;
+  flatbuffers::FlatBufferBuilder builder;
+
+  std::vector<flatbuffers::Offset<fb::EValue>> values = {fb::CreateEValue(
+      builder, fb::KernelTypes::Int, fb::CreateInt(builder, 0).Union())};
+  const std::vector<int32_t> args = {0};
+  const std::vector<int32_t> no_values;
+
+  std::vector<flatbuffers::Offset<fb::Instruction>> instructions;
+  instructions.reserve(num_instructions);
+  for (size_t i = 0; i < num_instructions; ++i) {
+    auto call = fb::CreateKernelCallDirect(builder, /*op_index=*/0, &args);
+    instructions.push_back(fb::CreateInstruction(
+        builder, fb::InstructionArguments::KernelCall, call.Union()));
+  }
+  std::vector<flatbuffers::Offset<fb::Chain>> chains = {fb::CreateChainDirect(
+      builder, &no_values, &no_values, &instructions)};
+  std::vector<flatbuffers::Offset<fb::Operator>> operators = {
+      fb::CreateOperatorDirect(builder, kNoopOpName, "")};
+  std::vector<flatbuffers::Offset<fb::BackendDelegate>> delegates;
+  // Entry zero is reserved; there are no planned buffers.
+  const std::vector<int64_t> buffer_sizes = {0};
+
+  std::vector<flatbuffers::Offset<fb::ExecutionPlan>> plans = {
+      fb::CreateExecutionPlanDirect(
+          builder,
+          "forward",
+          /*container_meta_type=*/0,
+          &values,
+          &no_values,
+          &no_values,
+          &chains,
+          &operators,
+          &delegates,
+          &buffer_sizes)};
+  fb::FinishProgramBuffer(
+      builder, fb::CreateProgramDirect(builder, /*version=*/0, &plans));
+
+  // Program::load() requires the flatbuffer data to be aligned.
+  std::vector<std::max_align_t> data(
+      (builder.GetSize() + sizeof(std::max_align_t) - 1) /
+      sizeof(std::max_align_t));
+  std::memcpy(data.data(), builder.GetBufferPointer(), builder.GetSize());
+  return data;
+}
+
+template <typename Fn>
+double measure_ns_per_instruction(
+    Fn&& run,
+    size_t num_instructions,
+    size_t iterations) {
+  // Warm up caches and the branch predictor.
+  run();
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    run();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      (static_cast<double>(iterations) * num_instructions);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_instructions =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+  if (num_instructions == 0 || iterations == 0) {
+    std::fprintf(
+        stderr, "Usage: %s [num_instructions] [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  executorch::runtime::runtime_init();
+  if (register_kernel(Kernel(kNoopOpName, noop)) != Error::Ok) {
+    std::fprintf(stderr, "Failed to register %s\n", kNoopOpName);
+    return 1;
+  }
+
+  const auto program_data = make_noop_program(num_instructions);
+  BufferDataLoader loader(
+      program_data.data(), program_data.size() * sizeof(std::max_align_t));
+  Result<Program> program = Program::load(&loader);
+  if (!program.ok()) {
+    std::fprintf(
+        stderr, "Program::load failed: 0x%x\n", (unsigned)program.error());
+    return 1;
+  }
+
+  MallocMemoryAllocator method_allocator;
+  HierarchicalAllocator planned_memory(Span<Span<uint8_t>>{});
+  MemoryManager memory_manager(&method_allocator, &planned_memory);
+  Result<Method> method = program->load_method("forward", &memory_manager);
+  if (!method.ok()) {
+    std::fprintf(
+        stderr, "load_method failed: 0x%x\n", (unsigned)method.error());
+    return 1;
+  }
+
+  const double execute_ns = measure_ns_per_instruction(
+      [&method] {
+        if (method->execute() != Error::Ok) {
+          std::abort();
+        }
+      },
+      num_instructions,
+      iterations);
+  const double step_ns = measure_ns_per_instruction(
+      [&method] {
+        Error err;
+        while ((err = method->step()) == Error::Ok) {
+        }
+        if (err != Error::EndOfMethod ||
+            method->reset_execution() != Error::Ok) {
+          std::abort();
+        }
+      },
+      num_instructions,
+      iterations);
+
+  std::printf(
+      "%zu no-op instructions x %zu iterations\n",
+      num_instructions,
+      iterations);
+  std::printf("execute(): %.2f ns/instruction\n", execute_ns);
+  std::printf("step():    %.2f ns/instruction\n", step_ns);
+  return 0;
+}
@@ -7,9 +7,11 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 
 #include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/extension/data_loader/streaming_data_loader.h>
 #include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
 #include <executorch/extension/runner_util/inputs.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
@@ -24,6 +26,7 @@ using namespace ::testing;
 using executorch::aten::ArrayRef;
 using executorch::extension::FlatTensorDataMap;
 using executorch::extension::prepare_input_tensors;
+using executorch::extension::StreamingDataLoader;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
 using executorch::runtime::Method;
@@ -76,6 +79,7 @@ class MethodTest : public ::testing::Test {
 
     load_program(std::getenv("ET_MODULE_ADD_PATH"), "add");
     load_program(std::getenv("ET_MODULE_INDEX_PATH"), "index");
+    load_program(std::getenv("ET_MODULE_DYNAMIC_ADD_PATH"), "dynamic_add");
     load_program(
         std::getenv("ET_MODULE_DYNAMIC_CAT_UNALLOCATED_IO_PATH"), "cat");
     load_program(std::getenv("ET_MODULE_ADD_MUL_PATH"), "add_mul");
@@ -214,6 +218,173 @@ TEST_F(MethodTest, SetPrimInputTest) {
   EXPECT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, ShapeGuardTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["cat"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ASSERT_EQ(method->set_shape_guard_enabled(true), Error::Ok);
+
+  float input_buffer[12] = {};
+  float output_buffer[16] = {};
+  int32_t sizes[2] = {2, 4};
+  uint8_t dim_order[2] = {0, 1};
+  int32_t strides[2] = {4, 1};
+  executorch::aten::TensorImpl impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      sizes,
+      input_buffer,
+      dim_order,
+      strides);
+  ASSERT_EQ(
+      method->set_output_data_ptr(output_buffer, sizeof(output_buffer), 0),
+      Error::Ok);
+
+  // The first execution resizes the output; the second one hits the guard and
+  // must leave it sized the same.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&impl)), 0),
+        Error::Ok);
+    ASSERT_EQ(method->execute(), Error::Ok);
+    EXPECT_EQ(method->get_output(0).toTensor().size(0), 3);
+  }
+
+  // A new input shape misses the guard, so the output is resized again.
+  sizes[0] = 1;
+  ASSERT_EQ(
+      method->set_input(EValue(executorch::aten::Tensor(&impl)), 0),
+      Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+  EXPECT_EQ(method->get_output(0).toTensor().size(0), 2);
+
+  // Disabling the guard keeps execution working.
+  ASSERT_EQ(method->set_shape_guard_enabled(false), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+  EXPECT_EQ(method->get_output(0).toTensor().size(0), 2);
+}
+
+TEST_F(MethodTest, ShapeGuardSkipsKernelChecks) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["dynamic_add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ASSERT_EQ(method->set_shape_guard_enabled(true), Error::Ok);
+
+  float x_buffer[12];
+  float y_buffer[12];
+  for (int i = 0; i < 12; ++i) {
+    x_buffer[i] = static_cast<float>(i);
+    y_buffer[i] = 100.f;
+  }
+  int32_t sizes[2] = {2, 4};
+  uint8_t dim_order[2] = {0, 1};
+  int32_t strides[2] = {4, 1};
+  executorch::aten::TensorImpl x_impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      sizes,
+      x_buffer,
+      dim_order,
+      strides);
+  executorch::aten::TensorImpl y_impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      sizes,
+      y_buffer,
+      dim_order,
+      strides);
+  auto set_inputs = [&]() {
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&x_impl)), 0),
+        Error::Ok);
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&y_impl)), 1),
+        Error::Ok);
+  };
+
+  // The first execution records the shapes.
+  set_inputs();
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // Swap in an output with the same sizes but a transposed dim order, which
+  // add's dim-order check rejects.
+  float out_buffer[12] = {};
+  int32_t out_sizes[2] = {2, 4};
+  uint8_t out_dim_order[2] = {1, 0};
+  int32_t out_strides[2] = {1, 2};
+  executorch::aten::TensorImpl out_impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      out_sizes,
+      out_buffer,
+      out_dim_order,
+      out_strides,
+      executorch::aten::TensorShapeDynamism::DYNAMIC_BOUND);
+  method->mutable_output(0) = EValue(executorch::aten::Tensor(&out_impl));
+
+  // The same shapes hit the guard, so add skips the check and runs.
+  set_inputs();
+  ASSERT_EQ(method->execute(), Error::Ok);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(out_buffer[i], x_buffer[i] + y_buffer[i]);
+  }
+
+  // A new shape misses the guard, so the check runs again and fails.
+  sizes[0] = 1;
+  set_inputs();
+  EXPECT_EQ(method->execute(), Error::InvalidArgument);
+}
+
+TEST_F(MethodTest, ShapeGuardKeysOnDimOrder) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["dynamic_add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ASSERT_EQ(method->set_shape_guard_enabled(true), Error::Ok);
+
+  float x_buffer[8] = {};
+  float y_buffer[8] = {};
+  int32_t sizes[2] = {2, 4};
+  uint8_t x_dim_order[2] = {0, 1};
+  int32_t x_strides[2] = {4, 1};
+  uint8_t y_dim_order[2] = {0, 1};
+  int32_t y_strides[2] = {4, 1};
+  executorch::aten::TensorImpl x_impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      sizes,
+      x_buffer,
+      x_dim_order,
+      x_strides);
+  executorch::aten::TensorImpl y_impl(
+      executorch::aten::ScalarType::Float,
+      2,
+      sizes,
+      y_buffer,
+      y_dim_order,
+      y_strides);
+  auto set_inputs = [&]() {
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&x_impl)), 0),
+        Error::Ok);
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&y_impl)), 1),
+        Error::Ok);
+  };
+  set_inputs();
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // Same sizes, but y is transposed. The guard misses, so add checks the dim
+  // orders and rejects the mismatch.
+  y_dim_order[0] = 1;
+  y_dim_order[1] = 0;
+  y_strides[0] = 1;
+  y_strides[1] = 2;
+  set_inputs();
+  EXPECT_EQ(method->execute(), Error::InvalidArgument);
+}
+
 TEST_F(MethodTest, MethodMetaTest) {
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
   Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
@@ -317,6 +488,48 @@ TEST_F(MethodTest, ConstantSegmentTest) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, StreamedConstantSegmentTest) {
+  // Load the constants in small chunks on one thread, so that execution
+  // starts while most of them are still being read.
+  Result<FileDataLoader> file_loader =
+      FileDataLoader::from(std::getenv("ET_MODULE_ADD_MUL_PATH"));
+  ASSERT_EQ(file_loader.error(), Error::Ok);
+  StreamingDataLoader loader(
+      std::make_unique<FileDataLoader>(std::move(file_loader.get())),
+      /*num_threads=*/1,
+      /*chunk_size=*/16);
+  Result<Program> program = Program::load(&loader);
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // The output matches that of the same program loaded up front.
+  ManagedMemoryManager reference_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> reference =
+      programs_["add_mul"]->load_method("forward", &reference_mmm.get());
+  ASSERT_EQ(reference.error(), Error::Ok);
+  auto reference_input_cleanup = prepare_input_tensors(*reference);
+  ASSERT_EQ(reference_input_cleanup.error(), Error::Ok);
+  ASSERT_EQ(reference->execute(), Error::Ok);
+
+  const auto& output = method->get_output(0).toTensor();
+  const auto& expected = reference->get_output(0).toTensor();
+  ASSERT_EQ(output.nbytes(), expected.nbytes());
+  EXPECT_EQ(
+      std::memcmp(
+          output.const_data_ptr(), expected.const_data_ptr(), output.nbytes()),
+      0);
+
+  // Later executions no longer wait.
+  ASSERT_EQ(method->execute(), Error::Ok);
+}
+
 TEST_F(MethodTest, ConstantBufferTest) {
   // Execute model with constants stored in the program flatbuffer.
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
@@ -36,11 +36,16 @@ class KernelRuntimeContext {
    * @param[in] temp_allocator The optional MemoryAllocator used to allocate
    *     temporary memory for the kernel. If not provided, an error will be
    *     returned when calling allocate_temp.
+   * @param[in] args_validated Whether the kernel may skip argument validation.
+   *     See args_validated().
    */
   KernelRuntimeContext(
       EventTracer* event_tracer = nullptr,
-      MemoryAllocator* temp_allocator = nullptr)
-      : event_tracer_(event_tracer), temp_allocator_(temp_allocator) {}
+      MemoryAllocator* temp_allocator = nullptr,
+      bool args_validated = false)
+      : event_tracer_(event_tracer),
+        temp_allocator_(temp_allocator),
+        args_validated_(args_validated) {}
   /**
    * Tells the runtime that the kernel call has failed. Prefer this over
    * ET_CHECK_*(), which fatally panics the process/system.
@@ -62,6 +67,19 @@ class KernelRuntimeContext {
     return failure_state_;
   }
 
+  /**
+   * Returns true if the runtime has established that the arguments of this
+   * call have the same dtypes, dim orders and shapes as in the previous call of
+   * the same instruction, which succeeded. The outputs are then already sized
+   * correctly, so the kernel may skip argument checks and output resizing.
+   *
+   * Kernels whose output shapes depend on the values in their inputs must not
+   * skip resizing based on this.
+   */
+  bool args_validated() const {
+    return args_validated_;
+  }
+
   /**
    * INTERNAL ONLY
    *
@@ -104,6 +122,7 @@ class KernelRuntimeContext {
  private:
   EventTracer* event_tracer_ = nullptr;
   MemoryAllocator* temp_allocator_ = nullptr;
+  bool args_validated_ = false;
   Error failure_state_ = Error::Ok;
 };
 
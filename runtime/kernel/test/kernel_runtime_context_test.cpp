@@ -61,6 +61,17 @@ TEST_F(KernelRuntimeContextTest, FailureStateReflectsFailure) {
   EXPECT_EQ(context.failure_state(), Error::Ok);
 }
 
+TEST_F(KernelRuntimeContextTest, ArgsValidatedDefaultsToFalse) {
+  KernelRuntimeContext context;
+  EXPECT_FALSE(context.args_validated());
+
+  KernelRuntimeContext validated_context(
+      /*event_tracer=*/nullptr,
+      /*temp_allocator=*/nullptr,
+      /*args_validated=*/true);
+  EXPECT_TRUE(validated_context.args_validated());
+}
+
 TEST_F(KernelRuntimeContextTest, FailureNoMemoryAllocatorProvided) {
   KernelRuntimeContext context;
   Result<void*> allocated_memory = context.allocate_temp(4);
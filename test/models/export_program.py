@@ -131,6 +131,21 @@ class ModuleDynamicCatUnallocatedIO(nn.Module):
         return {"capture_config": CaptureConfig(pt2_mode=True, enable_aot=True)}
 
 
+class ModuleDynamicAdd(nn.Module):
+    def __init__(self):
+        super(ModuleDynamicAdd, self).__init__()
+
+    def forward(self, x, y):
+        return torch.add(x, y)
+
+    def get_random_inputs(self):
+        return (torch.randn(3, 4), torch.randn(3, 4))
+
+    def get_dynamic_shapes(self):
+        dim0 = Dim("dim0", max=3)
+        return ({0: dim0}, {0: dim0})
+
+
 class ModuleAddMul(torch.nn.Module):
     def __init__(self):
         super().__init__()
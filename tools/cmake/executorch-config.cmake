@@ -165,6 +165,13 @@ if(TARGET optimized_native_cpu_ops_lib)
                "optimized_kernels;${_maybe_optimized_portable_kernels_lib}"
   )
 endif()
+if(TARGET extension_data_loader)
+  find_package(Threads REQUIRED)
+  set_target_properties(
+    extension_data_loader PROPERTIES INTERFACE_LINK_LIBRARIES
+                                     "executorch_core;Threads::Threads"
+  )
+endif()
 if(TARGET extension_threadpool)
   target_compile_definitions(extension_threadpool INTERFACE ET_USE_THREADPOOL)
   set_target_properties(
@@ -253,6 +253,14 @@ define_overridable_option(
   "Enable workspace sharing across different delegate instances"
   BOOL ON
 )
+# Delegate instances that share a workspace execute one at a time. Raising this
+# lets up to this many instances, e.g. of different models, execute in parallel
+# at the cost of one workspace each.
+define_overridable_option(
+  EXECUTORCH_XNNPACK_WORKSPACE_POOL_SIZE
+  "Number of workspaces shared by delegate instances"
+  STRING 1
+)
 # Keeping this OFF by default due to regressions in decode and model load with
 # kleidi kernels
 define_overridable_option(